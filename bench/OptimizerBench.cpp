@@ -0,0 +1,833 @@
+// bench/OptimizerBench.cpp - Hot-path benchmark suite for the optimizer core
+//
+// Built as RobloxOptimizerBench by the Linux host build:
+//   cmake -B build -DLINUX_BUILD=ON && cmake --build build --target RobloxOptimizerBench
+//   ./build/RobloxOptimizerBench --format json --output bench.json
+//
+// Parser benchmarks run on fixed fixtures so their numbers are comparable
+// between machines; "*.read" and "process.*" benchmarks hit the live /proc
+// of the host. Every benchmark is repeated and reports the median and the
+// fastest repetition, which is the number to diff between releases.
+#include "CacheCleaner.h"
+#include "Config.h"
+#include "Logger.h"
+#include "MemoryAccountant.h"
+#include "PageCachePrewarmer.h"
+#include "ProcFs.h"
+#include "ProcessWatcher.h"
+#include "RunqueueLatency.h"
+#include "SelfProfiler.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#ifndef OPTIMIZER_VERSION
+#define OPTIMIZER_VERSION "dev"
+#endif
+
+namespace {
+
+// Representative 8-core phone under load.
+const char kMemInfoFixture[] =
+    "MemTotal:        7802388 kB\n"
+    "MemFree:          412236 kB\n"
+    "MemAvailable:    2931756 kB\n"
+    "Buffers:            6244 kB\n"
+    "Cached:          2598312 kB\n"
+    "SwapCached:        64224 kB\n"
+    "Active:          3012684 kB\n"
+    "Inactive:        2123400 kB\n"
+    "Active(anon):    1706720 kB\n"
+    "Inactive(anon):   783204 kB\n"
+    "Active(file):    1305964 kB\n"
+    "Inactive(file):  1340196 kB\n"
+    "Unevictable:      238464 kB\n"
+    "Mlocked:          238464 kB\n"
+    "SwapTotal:       4194300 kB\n"
+    "SwapFree:        3211148 kB\n"
+    "Dirty:              1024 kB\n"
+    "Writeback:             0 kB\n"
+    "AnonPages:       2409488 kB\n"
+    "Mapped:          1233460 kB\n"
+    "Shmem:             41280 kB\n"
+    "KReclaimable:     331148 kB\n"
+    "Slab:             612352 kB\n"
+    "SReclaimable:     172300 kB\n"
+    "SUnreclaim:       440052 kB\n"
+    "KernelStack:       61056 kB\n"
+    "PageTables:       146340 kB\n"
+    "CommitLimit:     8095492 kB\n"
+    "Committed_AS:  126301144 kB\n"
+    "VmallocTotal:   263061440 kB\n"
+    "VmallocUsed:      267184 kB\n"
+    "CmaTotal:         270336 kB\n"
+    "CmaFree:            5424 kB\n";
+
+const char kCpuStatFixture[] =
+    "cpu  2212391 301212 1722381 20412338 40218 312011 120312 0 0 0\n"
+    "cpu0 412391 51212 322381 2212338 5218 102011 52312 0 0 0\n"
+    "cpu1 401321 50312 301281 2302318 5118 41011 12312 0 0 0\n"
+    "cpu2 398121 49212 298381 2352338 5018 39011 11312 0 0 0\n"
+    "cpu3 392391 48212 291381 2382338 4918 38011 10312 0 0 0\n"
+    "cpu4 212391 31212 182381 2712338 5218 31011 9312 0 0 0\n"
+    "cpu5 198391 29212 172381 2792338 4918 25011 8312 0 0 0\n"
+    "cpu6 118391 24212 102381 2812338 4818 21011 9312 0 0 0\n"
+    "cpu7 78985 17620 51814 2845992 4992 14845 7122 0 0 0\n"
+    "intr 412301231 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+    "ctxt 812301231\n"
+    "btime 1792211206\n"
+    "processes 2301231\n"
+    "procs_running 6\n"
+    "procs_blocked 0\n"
+    "softirq 31230123 1 8123012 31 1231201 0 0 1231 12312013 0 9412321\n";
+
+const char kTaskStatFixture[] =
+    "12873 (RobloxPlayer) S 612 612 0 0 -1 1077952832 812301 0 312 0 421398 81233 0 0 "
+    "10 -10 94 0 2283941 8203386880 412331 18446744073709551615 1 1 0 0 0 0 4612 1 1073775864 "
+    "0 0 0 17 6 0 0 0 0 0 0 0 0 0 0 0 0 0\n";
+
+const char kSmapsRollupFixture[] =
+    "12c00000-7ffd4c5f1000 ---p 00000000 00:00 0                          [rollup]\n"
+    "Rss:             1183420 kB\n"
+    "Pss:              961233 kB\n"
+    "Pss_Dirty:        812331 kB\n"
+    "Pss_Anon:         801223 kB\n"
+    "Pss_File:         143112 kB\n"
+    "Pss_Shmem:         16898 kB\n"
+    "Shared_Clean:     231004 kB\n"
+    "Shared_Dirty:       8124 kB\n"
+    "Private_Clean:     63112 kB\n"
+    "Private_Dirty:    881180 kB\n"
+    "Referenced:      1101223 kB\n"
+    "Anonymous:        812331 kB\n"
+    "LazyFree:              0 kB\n"
+    "AnonHugePages:         0 kB\n"
+    "ShmemPmdMapped:        0 kB\n"
+    "FilePmdMapped:         0 kB\n"
+    "Shared_Hugetlb:        0 kB\n"
+    "Private_Hugetlb:       0 kB\n"
+    "Swap:             212004 kB\n"
+    "SwapPss:          209113 kB\n"
+    "Locked:                0 kB\n";
+
+const char kConfigFixture[] =
+    "[optimizer]\n"
+    "enabled = true\n"
+    "level = 2\n"
+    "[scheduler]\n"
+    "interval_ms = 500\n"
+    "knob_min_interval_ms = 3000\n"
+    "thermal_limit_c = 75\n"
+    "[cpufreq]\n"
+    "governor = \"performance\"\n"
+    "little_min_floor_percent = 30\n"
+    "big_min_floor_percent = 50\n"
+    "[placement]\n"
+    "interval_ms = 1000\n"
+    "heavy_percent = 30\n"
+    "light_percent = 5\n";
+
+const char kSplitInput[] = "com.roblox.client,RobloxPlayer,RobloxPlayerBeta,RobloxStudio,"
+                           "Roblox,RobloxCrashHandler,RobloxPlayerLauncher,RobloxGameClient";
+const char kTrimInput[] = " \t  performance  \r\n";
+
+// Previous SystemManager implementations, kept verbatim for comparison.
+long legacyMemInfoValue(const char* key) {
+    std::ifstream meminfo("/proc/meminfo");
+    if (meminfo.is_open()) {
+        std::string line;
+        while (std::getline(meminfo, line)) {
+            if (line.find(key) == 0) {
+                size_t start = line.find_first_of("0123456789");
+                size_t end = line.find(" kB");
+                if (start != std::string::npos && end != std::string::npos) {
+                    long kb = std::stol(line.substr(start, end - start));
+                    return kb * 1024;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+std::string legacyGovernor() {
+    std::ifstream file("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    if (file.is_open()) {
+        std::string governor;
+        std::getline(file, governor);
+        return governor;
+    }
+    return "unknown";
+}
+
+std::vector<std::string> legacySplit(const std::string& str, char delimiter) {
+    std::vector<std::string> tokens;
+    std::stringstream ss(str);
+    std::string token;
+    while (std::getline(ss, token, delimiter)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations = 0;       // per repetition
+    double nsPerOp = 0.0;          // median over repetitions
+    double nsPerOpMin = 0.0;
+    double nsPerOpMax = 0.0;
+    std::map<std::string, double> counters;
+};
+
+struct BenchOptions {
+    std::string filter;
+    std::string format = "text";
+    std::string output;
+    uint32_t minTimeMs = 200;
+    uint32_t repetitions = 5;
+    bool list = false;
+};
+
+// An op returns a value folded into a volatile sink so the work can't be
+// optimised away. Setup/teardown are outside the timed region.
+using BenchOp = std::function<uint64_t()>;
+
+struct Benchmark {
+    std::string name;
+    std::function<bool(std::string& skipReason)> available;
+    std::function<BenchOp(BenchResult& result)> setup;
+};
+
+volatile uint64_t gSink = 0;
+
+double timeBatch(const BenchOp& op, uint64_t iterations) {
+    uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        sink += op();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    gSink = gSink + sink;
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+void runBenchmark(const Benchmark& bench, const BenchOptions& options, BenchResult& result) {
+    result.name = bench.name;
+    BenchOp op = bench.setup(result);
+
+    // Calibrate: grow the batch until one takes a tenth of the budget.
+    uint64_t iterations = 1;
+    const double targetNs = options.minTimeMs * 1e6;
+    for (;;) {
+        double ns = timeBatch(op, iterations);
+        if (ns >= targetNs / 10 || iterations >= (1ull << 32)) {
+            double perOp = std::max(ns / iterations, 1.0);
+            iterations = std::max<uint64_t>(1, static_cast<uint64_t>(targetNs / perOp));
+            break;
+        }
+        iterations *= ns < targetNs / 1000 ? 10 : 2;
+    }
+
+    std::vector<double> samples;
+    for (uint32_t rep = 0; rep < options.repetitions; rep++) {
+        samples.push_back(timeBatch(op, iterations) / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    result.iterations = iterations;
+    result.nsPerOp = samples[samples.size() / 2];
+    result.nsPerOpMin = samples.front();
+    result.nsPerOpMax = samples.back();
+}
+
+bool readable(const char* path, std::string& skipReason) {
+    if (access(path, R_OK) != 0) {
+        skipReason = std::string(path) + " not readable";
+        return false;
+    }
+    return true;
+}
+
+std::string benchLogPath() {
+    return "/tmp/roblox_optimizer_bench_" + std::to_string(getpid()) + ".log";
+}
+
+std::string benchTreePath() {
+    return "/tmp/roblox_optimizer_bench_" + std::to_string(getpid()) + ".tree";
+}
+
+// 16 subdirectories of 64 small files, roughly a game's shader/asset cache.
+bool buildBenchTree(std::string& skipReason) {
+    const std::string root = benchTreePath();
+    if (access(root.c_str(), F_OK) == 0) {
+        return true;
+    }
+    if (mkdir(root.c_str(), 0700) != 0) {
+        skipReason = root + ": " + strerror(errno);
+        return false;
+    }
+    for (int d = 0; d < 16; d++) {
+        std::string dir = root + "/d" + std::to_string(d);
+        mkdir(dir.c_str(), 0700);
+        for (int f = 0; f < 64; f++) {
+            std::string path = dir + "/f" + std::to_string(f) + (f % 2 ? ".tmp" : ".bin");
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (fd >= 0) {
+                ssize_t written = write(fd, "cache", 5);
+                (void)written;
+                close(fd);
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<Benchmark> buildSuite() {
+    std::vector<Benchmark> suite;
+    auto always = [](std::string&) { return true; };
+    auto needs = [](const char* path) {
+        return [path](std::string& skipReason) { return readable(path, skipReason); };
+    };
+
+    // --- procfs parsing -------------------------------------------------
+    suite.push_back({"meminfo.parse", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            MemInfo info;
+            ProcParser::parseMemInfo(kMemInfoFixture, info);
+            return info.memAvailable;
+        };
+    }});
+    suite.push_back({"meminfo.read", needs("/proc/meminfo"), [](BenchResult&) -> BenchOp {
+        auto reader = std::make_shared<ProcFsReader>();
+        return [reader] {
+            MemInfo info;
+            reader->readMemInfo(info);
+            return info.memTotal + info.memAvailable;
+        };
+    }});
+    suite.push_back({"meminfo.read_legacy", needs("/proc/meminfo"), [](BenchResult&) -> BenchOp {
+        return [] {
+            return static_cast<uint64_t>(legacyMemInfoValue("MemTotal:") + legacyMemInfoValue("MemAvailable:"));
+        };
+    }});
+    suite.push_back({"stat.parse", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            CpuStat stat;
+            ProcParser::parseCpuStat(kCpuStatFixture, stat);
+            return stat.aggregate.total() + stat.cpuCount;
+        };
+    }});
+    suite.push_back({"stat.read", needs("/proc/stat"), [](BenchResult& result) -> BenchOp {
+        auto reader = std::make_shared<ProcFsReader>();
+        CpuStat probe;
+        reader->readCpuStat(probe);
+        result.counters["cpus"] = probe.cpuCount;
+        return [reader] {
+            CpuStat stat;
+            reader->readCpuStat(stat);
+            return stat.aggregate.total();
+        };
+    }});
+    suite.push_back({"taskstat.parse", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            TaskStat stat;
+            ProcParser::parseTaskStat(kTaskStatFixture, stat);
+            return stat.utime + stat.rssPages;
+        };
+    }});
+    suite.push_back({"taskstat.read_self", needs("/proc/self/status"), [](BenchResult&) -> BenchOp {
+        auto self = std::make_shared<ProcessStatReader>(getpid());
+        return [self] {
+            TaskStat stat;
+            TaskStatus status;
+            self->readStat(stat);
+            self->readStatus(status);
+            return stat.utime + status.vmRss;
+        };
+    }});
+    suite.push_back({"snapshot.read", needs("/proc/stat"), [](BenchResult&) -> BenchOp {
+        auto reader = std::make_shared<ProcFsReader>();
+        return [reader] {
+            SystemSnapshot snapshot;
+            reader->readSnapshot(snapshot);
+            return snapshot.memory.memAvailable;
+        };
+    }});
+    suite.push_back({"cpufreq.read", needs("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq"),
+                     [](BenchResult&) -> BenchOp {
+        auto reader = std::make_shared<ProcFsReader>();
+        return [reader] {
+            CpuFreqInfo freq;
+            reader->readCpuFreq(0, freq);
+            return static_cast<uint64_t>(freq.curFreq);
+        };
+    }});
+    suite.push_back({"cpufreq.read_legacy", needs("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor"),
+                     [](BenchResult&) -> BenchOp {
+        return [] { return static_cast<uint64_t>(legacyGovernor().size()); };
+    }});
+
+    // --- process discovery ----------------------------------------------
+    // full_scan classifies every pid from scratch (what start() pays once);
+    // rescan is the steady-state incremental pass.
+    suite.push_back({"process.full_scan", needs("/proc/self/stat"), [](BenchResult& result) -> BenchOp {
+        size_t processes = 0;
+        if (DIR* dir = opendir("/proc")) {
+            while (struct dirent* entry = readdir(dir)) {
+                processes += entry->d_name[0] >= '1' && entry->d_name[0] <= '9';
+            }
+            closedir(dir);
+        }
+        result.counters["processes"] = static_cast<double>(processes);
+        return [] {
+            ProcessWatcher watcher;
+            watcher.addTarget("RobloxPlayer");
+            watcher.scanOnce();
+            return static_cast<uint64_t>(watcher.matchedPids().size());
+        };
+    }});
+    suite.push_back({"process.rescan", needs("/proc/self/stat"), [](BenchResult&) -> BenchOp {
+        auto watcher = std::make_shared<ProcessWatcher>();
+        watcher->addTarget("RobloxPlayer");
+        watcher->scanOnce();
+        return [watcher] {
+            watcher->scanOnce();
+            return static_cast<uint64_t>(watcher->isMatched(1));
+        };
+    }});
+
+    // --- memory accounting ------------------------------------------------
+    // first_pass reads stat/statm/status/smaps_rollup of every process;
+    // pass is the steady state, where only due processes are re-read.
+    suite.push_back({"memory.parse_rollup", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            SmapsRollup rollup;
+            ProcParser::parseSmapsRollup(kSmapsRollupFixture, rollup);
+            return rollup.pss;
+        };
+    }});
+    suite.push_back({"memory.first_pass", needs("/proc/self/smaps_rollup"), [](BenchResult& result) -> BenchOp {
+        MemoryAccountant probe;
+        probe.sample(1);
+        result.counters["processes"] = static_cast<double>(probe.getStats().processes);
+        return [] {
+            MemoryAccountant accountant;
+            MemoryAccountant::Options options;
+            options.maxDetailReadsPerPass = UINT32_MAX;
+            accountant.setOptions(options);
+            accountant.sample(1);
+            return static_cast<uint64_t>(accountant.getStats().detailReads);
+        };
+    }});
+    suite.push_back({"memory.pass", needs("/proc/self/smaps_rollup"), [](BenchResult& result) -> BenchOp {
+        auto accountant = std::make_shared<MemoryAccountant>();
+        accountant->setFocusPid(getpid());
+        accountant->sample(1);
+        result.counters["processes"] = static_cast<double>(accountant->getStats().processes);
+        // Advance a simulated clock by the scheduler's 500 ms tick so the
+        // background cadences come due as they would on a device.
+        auto nowMs = std::make_shared<uint64_t>(1);
+        return [accountant, nowMs] {
+            *nowMs += 500;
+            accountant->sample(*nowMs);
+            return accountant->getStats().cheapReads;
+        };
+    }});
+
+    // --- run-queue latency ------------------------------------------------
+    // sample reads every thread's schedstat; a window closes every tenth
+    // call on the simulated 100 ms clock.
+    suite.push_back({"runqueue.record", always, [](BenchResult&) -> BenchOp {
+        auto histogram = std::make_shared<LatencyHistogram>(3);
+        auto value = std::make_shared<uint64_t>(1);
+        return [histogram, value] {
+            *value = (*value * 1103515245 + 12345) & 0xffff;
+            histogram->record(*value, 3);
+            return histogram->count();
+        };
+    }});
+    suite.push_back({"runqueue.sample", needs("/proc/self/task"), [](BenchResult&) -> BenchOp {
+        auto probe = std::make_shared<RunqueueProbe>();
+        probe->attach(getpid());
+        probe->sample(1);
+        auto nowMs = std::make_shared<uint64_t>(1);
+        return [probe, nowMs] {
+            *nowMs += 100;
+            RunqueueStats stats;
+            probe->sample(*nowMs);
+            return probe->latest(stats) ? stats.events : 0;
+        };
+    }});
+    // Steady state of a learning session: /proc/self/maps plus one
+    // mincore() per mapped file (our own binary and libraries).
+    suite.push_back({"prewarm.sample", needs("/proc/self/maps"), [](BenchResult& result) -> BenchOp {
+        auto recorder = std::make_shared<PrewarmRecorder>();
+        PrewarmRecorder::Options options;
+        options.learnMs = UINT32_MAX;
+        recorder->setOptions(options);
+        recorder->attach(getpid(), 1);
+        recorder->sample(1);
+        result.counters["files"] = static_cast<double>(recorder->trackedFiles());
+        auto nowMs = std::make_shared<uint64_t>(1);
+        return [recorder, nowMs] {
+            *nowMs += 250;
+            recorder->sample(*nowMs);
+            return recorder->trackedFiles();
+        };
+    }});
+
+    // --- cache cleaner ----------------------------------------------------
+    // Dry runs over a scratch tree: the walk, statx and rule matching, with
+    // nothing deleted so every repetition sees the same tree.
+    for (unsigned threads : {1u, 4u}) {
+        std::string name = "cleaner.dry_run_" + std::to_string(threads) + "t";
+        suite.push_back({name, buildBenchTree, [threads](BenchResult& result) -> BenchOp {
+            auto options = std::make_shared<CleanOptions>();
+            options->roots.push_back(benchTreePath());
+            CleanRule temp;
+            temp.glob = "*.tmp";
+            options->rules.push_back(temp);
+            options->dryRun = true;
+            options->threads = threads;
+            options->idleIoPriority = false;
+            result.counters["files"] = 16 * 64;
+            return [options] {
+                CacheCleaner cleaner;
+                return cleaner.run(*options).filesMatched;
+            };
+        }});
+    }
+
+    // --- logging ----------------------------------------------------------
+    // Producer-side cost; the flusher drains to a scratch file. Drops mean
+    // the ring filled faster than the flusher could write.
+    suite.push_back({"log.format", always, [](BenchResult&) -> BenchOp {
+        Logger* logger = Logger::getInstance(benchLogPath());
+        logger->setConsoleOutput(false);
+        logger->setLevel(LogLevel::INFO);
+        auto counter = std::make_shared<uint64_t>(0);
+        return [counter] {
+            uint64_t n = ++*counter;
+            LOG_INFOF("tick %llu game cpu %.1f%% pid %d", static_cast<unsigned long long>(n), 42.5, 12873);
+            return n;
+        };
+    }});
+    suite.push_back({"log.string", always, [](BenchResult&) -> BenchOp {
+        Logger* logger = Logger::getInstance(benchLogPath());
+        logger->setConsoleOutput(false);
+        auto counter = std::make_shared<uint64_t>(0);
+        return [counter] {
+            uint64_t n = ++*counter;
+            LOG_INFO("tick " + std::to_string(n) + " game cpu 42.5% pid 12873");
+            return n;
+        };
+    }});
+    suite.push_back({"log.filtered", always, [](BenchResult&) -> BenchOp {
+        Logger::getInstance(benchLogPath())->setConsoleOutput(false);
+        return [] {
+            LOG_DEBUGF("tick %d", 1);
+            return static_cast<uint64_t>(1);
+        };
+    }});
+
+    // --- config -----------------------------------------------------------
+    suite.push_back({"config.get_int", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            return static_cast<uint64_t>(Config::getInstance()->getInt("scheduler.interval_ms", 500));
+        };
+    }});
+    suite.push_back({"config.get_string", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            return static_cast<uint64_t>(Config::getInstance()->getString("cpufreq.governor", "performance").size());
+        };
+    }});
+    suite.push_back({"config.key", always, [](BenchResult&) -> BenchOp {
+        static const ConfigKey<int> kInterval("scheduler.interval_ms", 500);
+        return [] { return static_cast<uint64_t>(kInterval.get()); };
+    }});
+    suite.push_back({"config.parse", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            std::unordered_map<std::string, ConfigValue> values;
+            Config::parse(kConfigFixture, values);
+            return static_cast<uint64_t>(values.size());
+        };
+    }});
+
+    // --- self profiling ---------------------------------------------------
+    // What one PROFILE_SCOPE / PROFILE_COUNT adds to an instrumented call.
+    suite.push_back({"profiler.scope", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            PROFILE_SCOPE("bench.scope");
+            return static_cast<uint64_t>(1);
+        };
+    }});
+    suite.push_back({"profiler.count", always, [](BenchResult&) -> BenchOp {
+        return [] {
+            PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+            return static_cast<uint64_t>(1);
+        };
+    }});
+    suite.push_back({"profiler.usage", always, [](BenchResult&) -> BenchOp {
+        auto baseline = std::make_shared<UsageBaseline>();
+        return [baseline] {
+            SelfUsage usage;
+            SelfProfiler::sampleUsage(usage, *baseline);
+            return usage.cpuTimeUs;
+        };
+    }});
+
+    // --- utils --------------------------------------------------------------
+    suite.push_back({"utils.split", always, [](BenchResult&) -> BenchOp {
+        auto input = std::make_shared<std::string>(kSplitInput);
+        return [input] { return static_cast<uint64_t>(Utils::split(*input, ',').size()); };
+    }});
+    suite.push_back({"utils.split_legacy", always, [](BenchResult&) -> BenchOp {
+        auto input = std::make_shared<std::string>(kSplitInput);
+        return [input] { return static_cast<uint64_t>(legacySplit(*input, ',').size()); };
+    }});
+    suite.push_back({"utils.trim", always, [](BenchResult&) -> BenchOp {
+        auto input = std::make_shared<std::string>(kTrimInput);
+        return [input] { return static_cast<uint64_t>(Utils::trim(*input).size()); };
+    }});
+
+    return suite;
+}
+
+void loadConfigFixture() {
+    std::string path = "/tmp/roblox_optimizer_bench_" + std::to_string(getpid()) + ".conf";
+    if (Utils::writeFile(path, kConfigFixture)) {
+        Config::getInstance()->loadFromFile(path);
+        unlink(path.c_str());
+    }
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                out += buffer;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+std::string formatNumber(double value) {
+    char buffer[32];
+    if (std::fabs(value - std::round(value)) < 1e-9 && std::fabs(value) < 1e15) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.2f", value);
+    }
+    return buffer;
+}
+
+void writeJson(std::ostream& out, const BenchOptions& options, const std::vector<BenchResult>& results,
+               const std::vector<std::pair<std::string, std::string>>& skipped) {
+    struct utsname host;
+    std::string kernel = uname(&host) == 0 ? std::string(host.release) : "unknown";
+    std::string machine = uname(&host) == 0 ? std::string(host.machine) : "unknown";
+
+    out << "{\n";
+    out << "  \"suite\": \"RobloxOptimizerBench\",\n";
+    out << "  \"version\": \"" << OPTIMIZER_VERSION << "\",\n";
+    out << "  \"timestamp\": \"" << jsonEscape(Utils::getCurrentTimestamp()) << "\",\n";
+    out << "  \"host\": {\"kernel\": \"" << jsonEscape(kernel) << "\", \"machine\": \"" << jsonEscape(machine)
+        << "\", \"cpus\": " << std::thread::hardware_concurrency() << "},\n";
+    out << "  \"min_time_ms\": " << options.minTimeMs << ",\n";
+    out << "  \"repetitions\": " << options.repetitions << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << jsonEscape(r.name) << "\""
+            << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << formatNumber(r.nsPerOp)
+            << ", \"ns_per_op_min\": " << formatNumber(r.nsPerOpMin)
+            << ", \"ns_per_op_max\": " << formatNumber(r.nsPerOpMax)
+            << ", \"ops_per_sec\": " << formatNumber(r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0.0);
+        if (!r.counters.empty()) {
+            out << ", \"counters\": {";
+            bool first = true;
+            for (const auto& counter : r.counters) {
+                out << (first ? "" : ", ") << "\"" << jsonEscape(counter.first) << "\": "
+                    << formatNumber(counter.second);
+                first = false;
+            }
+            out << "}";
+        }
+        out << "}";
+    }
+    out << (results.empty() ? "],\n" : "\n  ],\n");
+    out << "  \"skipped\": [";
+    for (size_t i = 0; i < skipped.size(); i++) {
+        out << (i ? ", " : "") << "{\"name\": \"" << jsonEscape(skipped[i].first) << "\", \"reason\": \""
+            << jsonEscape(skipped[i].second) << "\"}";
+    }
+    out << "]\n}\n";
+}
+
+void writeCsv(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "name,iterations,ns_per_op,ns_per_op_min,ns_per_op_max,ops_per_sec\n";
+    for (const BenchResult& r : results) {
+        out << r.name << "," << r.iterations << "," << formatNumber(r.nsPerOp) << ","
+            << formatNumber(r.nsPerOpMin) << "," << formatNumber(r.nsPerOpMax) << ","
+            << formatNumber(r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0.0) << "\n";
+    }
+}
+
+void writeText(std::ostream& out, const std::vector<BenchResult>& results) {
+    char line[160];
+    for (const BenchResult& r : results) {
+        std::snprintf(line, sizeof(line), "%-24s %12llu iters %12.1f ns/op  (min %.1f, max %.1f)\n",
+                      r.name.c_str(), static_cast<unsigned long long>(r.iterations),
+                      r.nsPerOp, r.nsPerOpMin, r.nsPerOpMax);
+        out << line;
+    }
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [options]\n"
+              << "  --filter <substring>    run only benchmarks whose name contains it\n"
+              << "  --format text|json|csv  output format (default text)\n"
+              << "  --output <file>         write results to a file instead of stdout\n"
+              << "  --min-time-ms <n>       time budget per repetition (default 200)\n"
+              << "  --repetitions <n>       repetitions per benchmark (default 5)\n"
+              << "  --quick                 --min-time-ms 20 --repetitions 3\n"
+              << "  --list                  print benchmark names and exit\n";
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&](std::string& out) {
+            if (i + 1 >= argc) {
+                return false;
+            }
+            out = argv[++i];
+            return true;
+        };
+        std::string text;
+        if (arg == "--filter") {
+            if (!value(options.filter)) return false;
+        } else if (arg == "--format") {
+            if (!value(options.format)) return false;
+            if (options.format != "text" && options.format != "json" && options.format != "csv") return false;
+        } else if (arg == "--output") {
+            if (!value(options.output)) return false;
+        } else if (arg == "--min-time-ms") {
+            if (!value(text)) return false;
+            options.minTimeMs = static_cast<uint32_t>(std::max(1, std::atoi(text.c_str())));
+        } else if (arg == "--repetitions") {
+            if (!value(text)) return false;
+            options.repetitions = static_cast<uint32_t>(std::max(1, std::atoi(text.c_str())));
+        } else if (arg == "--quick") {
+            options.minTimeMs = 20;
+            options.repetitions = 3;
+        } else if (arg == "--list") {
+            options.list = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Benchmark> suite = buildSuite();
+    if (options.list) {
+        for (const Benchmark& bench : suite) {
+            std::cout << bench.name << "\n";
+        }
+        return 0;
+    }
+
+    loadConfigFixture();
+
+    std::vector<BenchResult> results;
+    std::vector<std::pair<std::string, std::string>> skipped;
+    for (const Benchmark& bench : suite) {
+        if (!options.filter.empty() && bench.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        std::string reason;
+        if (!bench.available(reason)) {
+            std::cerr << "skip " << bench.name << ": " << reason << "\n";
+            skipped.emplace_back(bench.name, reason);
+            continue;
+        }
+        bool logBench = bench.name.compare(0, 4, "log.") == 0;
+        uint64_t dropsBefore = logBench ? Logger::getInstance(benchLogPath())->getDroppedCount() : 0;
+        BenchResult result;
+        runBenchmark(bench, options, result);
+        if (logBench) {
+            Logger* logger = Logger::getInstance();
+            logger->flush();
+            result.counters["drops"] = static_cast<double>(logger->getDroppedCount() - dropsBefore);
+        }
+        if (options.format != "text") {
+            std::cerr << "done " << bench.name << "\n";
+        }
+        results.push_back(result);
+    }
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << options.output << ": cannot open for writing\n";
+            return 1;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : file;
+    if (options.format == "json") {
+        writeJson(out, options, results, skipped);
+    } else if (options.format == "csv") {
+        writeCsv(out, results);
+    } else {
+        writeText(out, results);
+    }
+
+    unlink(benchLogPath().c_str());
+    CleanOptions cleanup;
+    cleanup.roots.push_back(benchTreePath());
+    cleanup.idleIoPriority = false;
+    CacheCleaner().run(cleanup);
+    rmdir(benchTreePath().c_str());
+    return 0;
+}
@@ -0,0 +1,185 @@
+// include/common/AdaptiveScheduler.h - Closed-loop optimization scheduler
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Inputs sampled once per scheduler tick.
+struct OptimizerSignals {
+    uint64_t timestampMs = 0;
+    bool gameRunning = false;
+    double gameCpuPercent = 0.0;        // percent of one core (can exceed 100)
+    double systemCpuPercent = 0.0;      // busy share of all online cores
+    double memAvailablePercent = 100.0;
+    double thermalCelsius = 0.0;        // hottest SoC zone, 0 when unknown
+    int memoryPressure = 0;             // PressureLevel: 0 none .. 3 critical
+    double gameFps = 0.0;               // render-thread cadence, 0 when unknown
+    double frameJitterMs = 0.0;
+    double runqueueP99Ms = 0.0;         // game threads' run-queue delay, last window
+};
+
+// Picks a discrete level from a continuous signal. Climbing to level i
+// needs value >= thresholds[i-1]; dropping below it needs the value to
+// fall under thresholds[i-1] - margin. Either move must be asked for on
+// `dwellTicks` consecutive updates before it is taken.
+class HysteresisLevel {
+private:
+    std::vector<double> thresholds;
+    double margin;
+    int dwellTicks;
+    int level;
+    int pendingLevel;
+    int pendingCount;
+
+public:
+    HysteresisLevel(std::vector<double> levelThresholds, double hysteresisMargin, int dwell);
+
+    int update(double value);
+    int current() const { return level; }
+    void reset();
+};
+
+// A policy maps signals to the level it wants for one knob. Level 0
+// always means "leave the system as it was".
+class OptimizationPolicy {
+public:
+    virtual ~OptimizationPolicy() = default;
+    virtual const char* name() const = 0;
+    virtual const char* knob() const = 0;
+    virtual int evaluate(const OptimizerSignals& signals) = 0;
+    virtual void reset() {}
+};
+
+// Raises the cpufreq floor with game CPU load; drops it to 0 while the
+// SoC is above the thermal limit so the floor never fights throttling.
+class CpuFloorPolicy : public OptimizationPolicy {
+private:
+    HysteresisLevel load;
+    HysteresisLevel thermal;
+
+public:
+    CpuFloorPolicy(double thermalLimitCelsius = 75.0);
+    const char* name() const override { return "cpu-floor"; }
+    const char* knob() const override { return "cpufreq.floor"; }
+    int evaluate(const OptimizerSignals& signals) override;
+    void reset() override;
+};
+
+// Turns on capacity-aware thread placement while the game is busy, or
+// while its threads wait on run queues longer than starvationP99Ms.
+class AffinityPolicy : public OptimizationPolicy {
+private:
+    HysteresisLevel load;
+    HysteresisLevel starvation;
+
+public:
+    AffinityPolicy(double starvationP99Ms = 4.0);
+    const char* name() const override { return "affinity"; }
+    const char* knob() const override { return "affinity"; }
+    int evaluate(const OptimizerSignals& signals) override;
+    void reset() override;
+};
+
+// Asks for background trimming as available memory runs low or PSI
+// reports memory stalls (medium -> light trim, critical -> heavy trim).
+class MemoryTrimPolicy : public OptimizationPolicy {
+private:
+    HysteresisLevel pressure;
+
+public:
+    MemoryTrimPolicy();
+    const char* name() const override { return "memory-trim"; }
+    const char* knob() const override { return "memory.trim"; }
+    int evaluate(const OptimizerSignals& signals) override;
+    void reset() override { pressure.reset(); }
+};
+
+// Samples signals at a fixed cadence, evaluates every policy and drives
+// each knob's actuator only when the winning (highest) level changes and
+// the knob's rate limit allows it. Stopping returns every knob to 0.
+class AdaptiveScheduler {
+public:
+    using SignalSource = std::function<bool(OptimizerSignals&)>;
+    using Actuator = std::function<bool(int level)>;
+    using TickListener = std::function<void(const OptimizerSignals& signals, uint64_t nowMs)>;
+
+    struct KnobStatus {
+        std::string name;
+        int level = 0;             // last level applied
+        int desired = 0;           // last level asked for by policies
+        uint64_t lastChangeMs = 0;
+        uint32_t changes = 0;
+        uint32_t failures = 0;
+    };
+
+private:
+    struct Knob {
+        std::string name;
+        Actuator actuator;
+        uint32_t minIntervalMs = 0;
+        int applied = 0;
+        int desired = 0;
+        uint64_t lastChangeMs = 0;
+        uint64_t lastAttemptMs = 0;
+        uint32_t changes = 0;
+        uint32_t failures = 0;
+    };
+
+    SignalSource source;
+    std::vector<std::unique_ptr<OptimizationPolicy>> policies;
+    std::vector<Knob> knobs;
+    std::vector<TickListener> listeners;
+    OptimizerSignals lastSignals;
+    uint64_t ticks;
+
+    std::atomic<bool> running;
+    std::atomic<uint32_t> intervalMs;
+    bool stopRequested;
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+
+    Knob* findKnob(const std::string& name);
+    void applyLocked(Knob& knob, int level, uint64_t nowMs, bool force);
+    void run();
+
+public:
+    AdaptiveScheduler();
+    ~AdaptiveScheduler();
+
+    AdaptiveScheduler(const AdaptiveScheduler&) = delete;
+    AdaptiveScheduler& operator=(const AdaptiveScheduler&) = delete;
+
+    void setSignalSource(SignalSource signalSource);
+    void addPolicy(std::unique_ptr<OptimizationPolicy> policy);
+    void addKnob(const std::string& name, Actuator actuator, uint32_t minIntervalMs = 2000);
+    // Runs on the scheduler thread after each tick's knobs are applied;
+    // for periodic work that is not a level (e.g. thread re-placement).
+    void addTickListener(TickListener listener);
+    bool isConfigured() const;
+
+    // spawnThread false: the caller drives tick() at getInterval() (e.g.
+    // from an EventLoop timer) and must stop doing so before stop().
+    bool start(uint32_t tickIntervalMs = 500, bool spawnThread = true);
+    void stop();
+    bool isRunning() const { return running.load(); }
+    void setInterval(uint32_t tickIntervalMs) { intervalMs.store(tickIntervalMs); }
+    uint32_t getInterval() const { return intervalMs.load(); }
+
+    // One sample/evaluate/apply pass; run() calls it, replays can too.
+    void tick(uint64_t nowMs);
+    void tick(uint64_t nowMs, const OptimizerSignals& signals);
+
+    std::vector<KnobStatus> getStatus() const;
+    OptimizerSignals getLastSignals() const;
+    uint64_t getTickCount() const;
+
+    static uint64_t nowMs();
+};
@@ -2,35 +2,193 @@
 #pragma once
 #ifdef ANDROID_BUILD
 
+#include "AdaptiveScheduler.h"
 #include "BaseOptimizer.h"
+#include "CacheCleaner.h"
+#include "CgroupManager.h"
+#include "CpuFreqController.h"
+#include "CpuSampler.h"
+#include "CpuTopology.h"
+#include "EventLoop.h"
+#include "FrameCadence.h"
+#include "InstanceManager.h"
+#include "IoPriority.h"
+#include "MemoryAccountant.h"
+#include "MetricsStore.h"
+#include "OptimizationPlan.h"
+#include "PageCachePrewarmer.h"
+#include "PressureMonitor.h"
+#include "ProcFs.h"
+#include "ProcessWatcher.h"
+#include "ProcTrace.h"
+#include "ReclaimEngine.h"
+#include "RunqueueLatency.h"
+#include "SelfProfiler.h"
+#include <atomic>
+#include <mutex>
 #include <jni.h>
+#include <sys/types.h>
 
 class AndroidOptimizer : public BaseOptimizer {
 private:
     JavaVM* jvm;
     jobject activityObject;
     std::string packageName;
-    
+    std::atomic<pid_t> robloxPid;
+
+    // Drives the watcher, the sampler, PSI and every periodic task below;
+    // optimization is "running" while the scheduler task is registered.
+    EventLoop eventLoop;
+    std::atomic<EventLoop::TaskId> schedulerTask;
+    std::atomic<EventLoop::TaskId> memoryTask;
+    std::atomic<bool> memorySampleQueued;
+    CpuSampler cpuSampler;
+    FrameCadenceEstimator frameCadence;
+    EventLoop::TaskId frameTask;
+    RunqueueProbe runqueueProbe;
+    EventLoop::TaskId runqueueTask;
+    ProcessWatcher processWatcher;
+    CpuFreqController cpuFreqController;
+    // optimizeCpuGovernor()'s settings with the scheduler's floor layered
+    // on top: dropping the floor goes back to them, not to the boot state.
+    std::vector<CpuFreqTarget> cpuFreqProfile;
+    int frequencyFloorLevel;
+    std::mutex cpuFreqMutex;
+
+    // Closed loop behind start/stopOptimization; the reader and previous
+    // /proc/stat are only touched from the scheduler task.
+    AdaptiveScheduler scheduler;
+    ProcFsReader signalReader;
+    CpuStat lastCpuStat;
+    bool haveCpuStat;
+    CpuTopology topology;
+    ThreadPlacement threadPlacement;
+    bool placementActive;
+    bool placementSuspended;            // while instances own the CPUs
+    uint64_t lastPlacementMs;
+    PressureMonitor pressureMonitor;
+    MetricsStore metrics;
+    std::vector<int> metricIds;
+    uint64_t lastOverheadCheckMs;
+    UsageBaseline overheadBaseline;     // checkOverhead()'s own recent-CPU window
+    bool overBudget;
+    TraceRecorder traceRecorder;
+    MemoryAccountant memoryAccountant;
+    ReclaimEngine reclaimEngine;
+    std::atomic<int> reclaimLevel;      // memory.trim knob
+    std::atomic<bool> reclaimBurst;     // one-off request, cleared once the target is met
+    std::atomic<bool> reclaimQueued;    // a pass is on the pool
+    CgroupManager cgroupManager;
+    IoPriorityManager ioPriority;
+    std::atomic<EventLoop::TaskId> ioPriorityTask;   // non-zero while the classes are applied
+    std::atomic<bool> ioPriorityQueued;
+    // Launches replay the learned profile; learning launches (no profile
+    // yet, a game update, every prewarm.relearn_every-th) run cold so our
+    // own reads are not learned back.
+    PrewarmRecorder prewarmRecorder;
+    std::atomic<EventLoop::TaskId> prewarmTask;
+    std::atomic<bool> prewarmQueued;
+    PageCachePrewarmer prewarmer;
+    PrewarmProfile prewarmProfile;      // guarded by prewarmMutex
+    std::mutex prewarmMutex;
+    std::atomic<bool> prewarmReady;     // a current profile is loaded
+    uint32_t prewarmLaunches;
+    // Every running client; with two or more, each gets a CPU partition
+    // of its own. robloxPid is the primary one, the one the per-game
+    // probes follow; when it exits the longest-running instance takes over.
+    InstanceManager instanceManager;
+    std::atomic<EventLoop::TaskId> instancesTask;
+    std::atomic<bool> instancesQueued;
+    uint64_t instanceReplans;           // last logged; update job only
+    CacheCleaner cacheCleaner;
+    std::atomic<uint64_t> lastCacheCleanMs;
+    StateCache planState;
+    std::mutex planMutex;
+    uint64_t configListener;
+
+    bool startEventLoop();
+    void applyConfig();
+    void onRobloxStarted(pid_t pid);
+    void onRobloxExited(pid_t pid);
+    void attachGame(pid_t pid);
+    void detachGame();
+    void configureInstances();
+    void onInstancesChanged();
+    void queueInstancesUpdate();
+    void configureScheduler();
+    bool sampleSignals(OptimizerSignals& out);
+    bool applyFrequencyFloor(int level);
+    bool applyFrequencyLocked(std::string* error);
+    bool applyGameAffinity(int level);
+    void updatePlacement(uint64_t nowMs);
+    void onPressureEvent(const PressureEvent& event);
+    void recordMetrics(const OptimizerSignals& signals, uint64_t nowMs);
+    void checkOverhead(uint64_t nowMs);
+    void sampleMemory(uint64_t nowMs);
+    void configureMemory();
+    void configureReclaim(int level);
+    void reclaimTick(const OptimizerSignals& signals, uint64_t nowMs);
+    CgroupLimits cgroupLimits() const;
+    void setupCgroups();
+    void configureIoPriority();
+    void setupIoPriority();
+    void queueIoPriorityRefresh();
+    void syncBackground();
+    void startPrewarmLearning(pid_t pid);
+    void finishPrewarmLearning();
+    OptimizationPlan buildPlan();
+
 public:
     AndroidOptimizer();
     ~AndroidOptimizer() override;
-    
-    // Inherited from BaseOptimizer  
+
+    // Inherited from BaseOptimizer
     bool findRobloxProcess() override;
     OptimizationResult optimizeProcessPriority() override;
     OptimizationResult optimizeMemory() override;
     OptimizationResult optimizeSystemSettings() override;
     ProcessInfo getProcessInfo() override;
-    
+    std::vector<ProcessInfo> getInstances() override;
+    void startOptimization() override;
+    void stopOptimization() override;
+    bool isRunning() const override { return schedulerTask.load() != 0; }
+
     // Android-specific methods
     bool setJavaVM(JavaVM* vm);
     bool setActivityObject(jobject activity);
     OptimizationResult optimizeCpuGovernor();
     OptimizationResult optimizeGpuFrequency();
     OptimizationResult clearCache();
+    // Reads the learned files ahead; also worth calling when a teleport
+    // starts loading a new place.
+    OptimizationResult prewarmGameFiles();
+    PrewarmResidency getPrewarmResidency();
     OptimizationResult optimizeBatterySettings();
-    
+    OptimizationResult disableAnimations();
+    std::string getSystemInfo();
+    // The one-shot optimizations as a dependency-ordered plan; steps
+    // already in their target state are skipped.
+    PlanResult applyProfile();
+
+    const CpuSampler& getCpuSampler() const { return cpuSampler; }
+    const FrameCadenceEstimator& getFrameCadence() const { return frameCadence; }
+    // resetCumulative() before a change and report() after shows its
+    // effect on the game's scheduling latency.
+    RunqueueProbe& getRunqueueProbe() { return runqueueProbe; }
+    CpuFreqController& getCpuFreqController() { return cpuFreqController; }
+    const AdaptiveScheduler& getScheduler() const { return scheduler; }
+    const CpuTopology& getTopology() const { return topology; }
+    const PressureMonitor& getPressureMonitor() const { return pressureMonitor; }
+    const MetricsStore& getMetrics() const { return metrics; }
+    const MemoryAccountant& getMemoryAccountant() const { return memoryAccountant; }
+    const CgroupManager& getCgroupManager() const { return cgroupManager; }
+    const IoPriorityManager& getIoPriority() const { return ioPriority; }
+    const InstanceManager& getInstanceManager() const { return instanceManager; }
+    const EventLoop& getEventLoop() const { return eventLoop; }
+
 private:
     JNIEnv* getJNIEnv();
     bool callJavaMethod(const char* methodName, const char* signature, ...);
 };
+
+#endif // ANDROID_BUILD
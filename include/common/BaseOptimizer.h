@@ -3,15 +3,21 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
 
 struct ProcessInfo {
     uint32_t pid;
     std::string name;
     uint64_t memoryUsage;
     double cpuUsage;
+    double frameRate;       // estimated render cadence, 0 when unknown
+    double frameJitterMs;
+    double runqueueP99Ms;   // run-queue delay of the game's threads, 0 when unknown
     bool isRunning;
     
-    ProcessInfo() : pid(0), memoryUsage(0), cpuUsage(0.0), isRunning(false) {}
+    ProcessInfo()
+        : pid(0), memoryUsage(0), cpuUsage(0.0), frameRate(0.0), frameJitterMs(0.0), runqueueP99Ms(0.0),
+          isRunning(false) {}
 };
 
 struct OptimizationResult {
@@ -25,11 +31,7 @@ struct OptimizationResult {
 };
 
 class BaseOptimizer {
-protected:
-    bool isOptimizing;
-    
 public:
-    BaseOptimizer() : isOptimizing(false) {}
     virtual ~BaseOptimizer() = default;
     
     // Pure virtual methods - platform specific
@@ -38,9 +40,16 @@ public:
     virtual OptimizationResult optimizeMemory() = 0;
     virtual OptimizationResult optimizeSystemSettings() = 0;
     virtual ProcessInfo getProcessInfo() = 0;
+    // Every client running, the one getProcessInfo() reports first; more
+    // than one only where the platform tracks concurrent instances.
+    virtual std::vector<ProcessInfo> getInstances() {
+        ProcessInfo info = getProcessInfo();
+        return info.pid != 0 ? std::vector<ProcessInfo>{info} : std::vector<ProcessInfo>();
+    }
     
-    // Common methods
-    virtual void startOptimization() { isOptimizing = true; }
-    virtual void stopOptimization() { isOptimizing = false; }
-    virtual bool isRunning() const { return isOptimizing; }
+    // Continuous optimization; each platform owns what keeps it going
+    // (on Android, tasks on an EventLoop) and reports it through isRunning().
+    virtual void startOptimization() = 0;
+    virtual void stopOptimization() = 0;
+    virtual bool isRunning() const = 0;
 };
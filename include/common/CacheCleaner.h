@@ -0,0 +1,66 @@
+// include/common/CacheCleaner.h - Parallel cache/temp directory cleaner
+#pragma once
+#if defined(__linux__)
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A file is removed when it matches any rule (or always, with no rules).
+struct CleanRule {
+    std::string glob;             // fnmatch() pattern on the file name; empty matches all
+    uint64_t minAgeSec = 0;       // untouched (newer of atime/mtime) for at least this long
+    uint64_t minSizeBytes = 0;
+};
+
+struct CleanOptions {
+    std::vector<std::string> roots;        // absolute directories; the roots themselves are kept
+    std::vector<CleanRule> rules;
+    std::vector<std::string> excludes;     // fnmatch() patterns; matching files and subtrees are skipped
+    bool dryRun = false;                   // count what would go, touch nothing
+    bool removeEmptyDirs = true;           // only directories this run emptied
+    unsigned threads = 0;                  // 0: min(4, hardware threads)
+    bool idleIoPriority = true;            // workers run at IOPRIO_CLASS_IDLE and nice 19
+    uint64_t maxBytes = 0;                 // stop once this much is freed (0: no limit)
+    int maxDepth = 64;
+};
+
+struct CleanStats {
+    uint64_t dirsScanned = 0;
+    uint64_t filesScanned = 0;
+    uint64_t filesMatched = 0;
+    uint64_t bytesMatched = 0;             // allocated size, i.e. what deleting frees
+    uint64_t filesDeleted = 0;
+    uint64_t bytesDeleted = 0;
+    uint64_t dirsRemoved = 0;
+    uint64_t errors = 0;
+    uint64_t elapsedMs = 0;
+    bool cancelled = false;
+};
+
+// Walks every root on a small pool of threads. Each worker keeps a deque
+// of pending subdirectories: it pops its own newest entry (depth first,
+// so few directories are open at once) and steals the oldest entry of
+// another worker when idle (the biggest untouched subtrees). Directories
+// are read with getdents64 into a 32 KB buffer, files are sized with
+// statx and removed with unlinkat relative to the held directory fd, so no
+// path is ever re-resolved. Symlinks are removed, never followed.
+class CacheCleaner {
+private:
+    std::atomic<bool> cancelRequested;
+    std::atomic<bool> running;
+
+public:
+    CacheCleaner();
+
+    CacheCleaner(const CacheCleaner&) = delete;
+    CacheCleaner& operator=(const CacheCleaner&) = delete;
+
+    // Blocks until every root is walked or cancel() is called.
+    CleanStats run(const CleanOptions& options);
+    void cancel() { cancelRequested.store(true, std::memory_order_relaxed); }
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+};
+
+#endif // __linux__
@@ -0,0 +1,119 @@
+// include/common/CgroupManager.h - cgroup v2 game/background partitioning
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+
+// Zero (or an empty percentage) leaves the kernel default in place.
+struct CgroupLimits {
+    // Game group
+    uint32_t gameCpuWeight = 1000;            // 1..10000, kernel default 100
+    double gameUclampMinPercent = 20.0;
+    uint64_t gameMemoryLowBytes = 0;
+    // Background group
+    uint32_t backgroundCpuWeight = 20;
+    double backgroundCpuMaxPercent = 200.0;   // of one core
+    uint32_t backgroundIoWeight = 10;         // 1..10000, kernel default 100
+    uint32_t cpuPeriodUs = 100000;
+};
+
+struct CgroupStatus {
+    bool active = false;
+    std::string path;                  // <mount>/<group>
+    std::string controllers;           // enabled for the children, e.g. "cpu memory io"
+    pid_t gamePid = 0;
+    size_t backgroundMembers = 0;
+    uint64_t failedMoves = 0;          // RT tasks, zombies, races with exit
+};
+
+// Owns <mount>/<group>/{game,background}. The game process is moved into
+// "game" (high cpu.weight, cpu.uclamp.min floor, memory.low protection);
+// the processes passed to syncBackground() into "background" (low
+// cpu.weight, a cpu.max cap, low io.weight). Every moved pid's original
+// cgroup is remembered and it is moved back there on teardown or when it
+// leaves the set; the origins are also kept in an optional state file so
+// a killed optimizer's groups can be drained by the next instance.
+//
+// Controllers the kernel lacks (Android keeps cpu on v1 cpuctl on many
+// builds) are skipped, not fatal. Controllers enabled in the root's
+// subtree_control are left enabled on teardown: other groups may use
+// them by then. Writes we lack permission for go through the root helper.
+class CgroupManager {
+public:
+    enum class Group {
+        Game,
+        Background
+    };
+
+private:
+    std::string root;
+    std::string mount;
+    std::string groupName;
+    std::string stateFile;
+    bool active;
+    pid_t gamePid;
+    uint64_t gameMemoryLow;
+    std::vector<std::string> controllers;
+    std::unordered_map<pid_t, std::string> origins;     // moved pid -> cgroup it came from
+    std::unordered_set<pid_t> background;
+    uint64_t failedMoves;
+    mutable std::mutex mutex;
+
+    std::string groupDir(Group group) const;
+    std::string relativePath(Group group) const;
+    bool writeValue(const std::string& path, const std::string& value);
+    bool makeDir(const std::string& path);
+    bool removeDir(const std::string& path);
+    std::string readValue(const std::string& path) const;
+    std::vector<pid_t> readMembers(const std::string& dir) const;
+    std::string cgroupOf(pid_t pid) const;
+    bool frozen(const std::string& cgroup) const;
+    void resetParentLocked();
+    bool movePid(pid_t pid, const std::string& cgroup);
+    bool enter(pid_t pid, Group group);
+    void leave(pid_t pid);
+    bool applyLimitsLocked(const CgroupLimits& limits);
+    void drainLocked(const std::unordered_map<pid_t, std::string>& knownOrigins);
+    void saveStateLocked() const;
+
+public:
+    explicit CgroupManager(const std::string& rootPrefix = "", const std::string& name = "roblox_optimizer",
+                           const std::string& stateFilePath = "");
+    ~CgroupManager();
+
+    CgroupManager(const CgroupManager&) = delete;
+    CgroupManager& operator=(const CgroupManager&) = delete;
+
+    // True when a cgroup v2 hierarchy is mounted under the root.
+    bool isAvailable() const;
+
+    // Creates both groups and applies the limits; idempotent.
+    bool setup(const CgroupLimits& limits, std::string* error = nullptr);
+    bool applyLimits(const CgroupLimits& limits);
+    // Moves every member back and removes the groups.
+    void teardown();
+    bool isActive() const;
+
+    // The previous game (if any) goes back to where it came from (0: none).
+    bool setGamePid(pid_t pid);
+    // Rewritten only when it moves by more than 5%.
+    bool setGameMemoryLow(uint64_t bytes);
+    // Makes `pids` the background set: newcomers are moved in, members no
+    // longer listed are moved back, and members that something else moved
+    // out are moved in again. Our own process and frozen ones are never
+    // moved in. Returns the number of pids moved.
+    int syncBackground(const std::vector<pid_t>& pids);
+
+    // Drains and removes groups left behind by a previous instance.
+    bool recoverFromStateFile();
+
+    CgroupStatus getStatus() const;
+};
+
+#endif // __linux__
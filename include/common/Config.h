@@ -2,43 +2,165 @@
 #pragma once
 
 #include <string>
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class EventLoop;
+
+// A value parsed once at load time into every type it can represent.
+struct ConfigValue {
+    std::string text;
+    int64_t intValue = 0;
+    double doubleValue = 0.0;
+    bool boolValue = false;
+    bool hasInt = false;
+    bool hasDouble = false;
+    bool hasBool = false;
+};
+
+// Immutable view of the whole configuration. A new snapshot is built on
+// every load or set and published atomically; readers keep using the one
+// they hold until they next observe the generation change.
+struct ConfigSnapshot {
+    uint64_t generation = 0;
+    std::unordered_map<std::string, ConfigValue> values;
+    std::vector<const ConfigValue*> byKeyId;   // indexed by registered key id
+};
 
 class Config {
 private:
-    static Config* instance;
-    static std::mutex mutex_;
-    std::map<std::string, std::string> settings;
+    std::shared_ptr<const ConfigSnapshot> snapshot;   // guarded by writeMutex
+    std::atomic<uint64_t> generation;
+    mutable std::mutex writeMutex;
     std::string configFile;
-    
+
+    // Hot reload
+    std::atomic<bool> watching;
+    int inotifyFd;
+    int watchWakePipe[2];
+    std::thread watchThread;
+    EventLoop* watchEventLoop;          // set when the watch is a task of a loop
+    uint64_t watchTask;
+    std::atomic<uint64_t> reloadTask;   // pending debounce timeout
+    std::vector<std::pair<uint64_t, std::function<void()>>> reloadListeners;
+    uint64_t nextListenerId;
+
+    void publish(std::unordered_map<std::string, ConfigValue>&& values);
+    const ConfigSnapshot* acquire() const;
+    const ConfigValue* find(const std::string& key) const;
+    void watchLoop();
+    bool openWatch();
+    bool drainWatch();                  // true when the config file changed
+    void notifyReload();
+
 protected:
     Config();
 
 public:
     static Config* getInstance();
     ~Config();
-    
+
+    // All or nothing: a file with a malformed line is rejected and the
+    // current values stay. A missing file is still remembered, so
+    // startWatching() picks it up once it is created.
     bool loadFromFile(const std::string& filename);
     bool saveToFile(const std::string& filename = "");
-    
+    bool reload();
+
+    // Parses "key = value" text: '#'/';' comments, [section] prefixes keys
+    // as "section.key", surrounding double quotes are stripped.
+    static bool parse(const std::string& text, std::unordered_map<std::string, ConfigValue>& out);
+    static ConfigValue makeValue(const std::string& text);
+
     // Getters
     std::string getString(const std::string& key, const std::string& defaultValue = "");
     int getInt(const std::string& key, int defaultValue = 0);
     bool getBool(const std::string& key, bool defaultValue = false);
     double getDouble(const std::string& key, double defaultValue = 0.0);
-    
+
     // Setters
     void setString(const std::string& key, const std::string& value);
     void setInt(const std::string& key, int value);
     void setBool(const std::string& key, bool value);
     void setDouble(const std::string& key, double value);
-    
+
     // Utility
     bool hasKey(const std::string& key) const;
     void removeKey(const std::string& key);
     void clear();
-    
+
+    // Precompiled keys: ids are dense and resolved into every snapshot, so
+    // a ConfigKey read is an array index instead of a string lookup.
+    static uint32_t registerKey(const std::string& key);
+    const ConfigValue* findById(uint32_t keyId, const std::string& key) const;
+    uint64_t getGeneration() const { return generation.load(std::memory_order_acquire); }
+
+    // Watches the loaded file with inotify (Linux/Android) and reloads it
+    // when it is rewritten or replaced. Listeners run on the watch thread
+    // after every reload that was accepted.
+    bool startWatching();
+    // Same, with the inotify fd on `loop` instead of a thread of its own;
+    // the reload and the listeners run on its pool. Stop before the loop
+    // is destroyed.
+    bool startWatching(EventLoop& loop);
+    void stopWatching();
+    uint64_t addReloadListener(std::function<void()> listener);
+    void removeReloadListener(uint64_t id);
+
     Config(Config &other) = delete;
     void operator=(const Config &) = delete;
 };
+
+// Typed handle for a hot configuration knob:
+//   static const ConfigKey<int> kSampleInterval("sampler.interval_ms", 100);
+//   int ms = kSampleInterval.get();
+template <typename T>
+class ConfigKey {
+private:
+    std::string key;
+    uint32_t keyId;
+    T defaultValue;
+
+public:
+    ConfigKey(const std::string& name, T fallback)
+        : key(name), keyId(Config::registerKey(name)), defaultValue(fallback) {}
+
+    T get() const;
+    const std::string& name() const { return key; }
+};
+
+template <>
+inline int ConfigKey<int>::get() const {
+    const ConfigValue* value = Config::getInstance()->findById(keyId, key);
+    return value && value->hasInt ? static_cast<int>(value->intValue) : defaultValue;
+}
+
+template <>
+inline int64_t ConfigKey<int64_t>::get() const {
+    const ConfigValue* value = Config::getInstance()->findById(keyId, key);
+    return value && value->hasInt ? value->intValue : defaultValue;
+}
+
+template <>
+inline bool ConfigKey<bool>::get() const {
+    const ConfigValue* value = Config::getInstance()->findById(keyId, key);
+    return value && value->hasBool ? value->boolValue : defaultValue;
+}
+
+template <>
+inline double ConfigKey<double>::get() const {
+    const ConfigValue* value = Config::getInstance()->findById(keyId, key);
+    return value && value->hasDouble ? value->doubleValue : defaultValue;
+}
+
+template <>
+inline std::string ConfigKey<std::string>::get() const {
+    const ConfigValue* value = Config::getInstance()->findById(keyId, key);
+    return value ? value->text : defaultValue;
+}
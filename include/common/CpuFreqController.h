@@ -0,0 +1,95 @@
+// include/common/CpuFreqController.h - Transactional cpufreq policy control
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct CpuFreqPolicyState {
+    std::string governor;
+    uint32_t minFreq = 0;    // kHz
+    uint32_t maxFreq = 0;    // kHz
+};
+
+// Desired settings for one policy; empty/zero fields are left unchanged.
+struct CpuFreqTarget {
+    std::string governor;
+    uint32_t minFreq = 0;
+    uint32_t maxFreq = 0;
+    int minFreqPercent = 0;  // floor as % of cpuinfo_max_freq, used when minFreq == 0
+};
+
+struct CpuFreqPolicy {
+    int id = -1;                       // N in policyN
+    int dirFd = -1;                    // cached O_PATH fd of the policy dir
+    std::string path;
+    std::vector<int> cpus;             // related_cpus
+    uint32_t cpuinfoMinFreq = 0;
+    uint32_t cpuinfoMaxFreq = 0;
+    std::vector<uint32_t> availableFrequencies;
+    std::vector<std::string> availableGovernors;
+};
+
+// Discovers every /sys/devices/system/cpu/cpufreq/policyN and applies
+// governor/min/max changes across all of them as one transaction: if any
+// write fails, every policy already touched is rolled back.
+//
+// The state found before the first change is kept in memory, optionally
+// persisted to a state file, and pre-rendered for an async-signal-safe
+// restore so a crashing optimizer does not leave clusters pinned.
+class CpuFreqController {
+private:
+    std::string root;
+    std::string stateFile;
+    std::vector<CpuFreqPolicy> policies;
+    std::vector<CpuFreqPolicyState> baseline;   // parallel to policies
+    bool haveBaseline;
+    mutable std::recursive_mutex mutex;
+
+    bool readState(const CpuFreqPolicy& policy, CpuFreqPolicyState& out) const;
+    bool writeAttribute(const CpuFreqPolicy& policy, const char* name, const std::string& value);
+    bool applyState(const CpuFreqPolicy& policy, const CpuFreqPolicyState& current,
+                    const CpuFreqPolicyState& wanted);
+    bool resolve(const CpuFreqPolicy& policy, const CpuFreqPolicyState& current,
+                 const CpuFreqTarget& target, CpuFreqPolicyState& out, std::string& error) const;
+    bool saveBaselineFile() const;
+    void prepareSignalRestore();
+    void closePolicies();
+
+public:
+    explicit CpuFreqController(const std::string& rootPrefix = "", const std::string& stateFilePath = "");
+    ~CpuFreqController();
+
+    CpuFreqController(const CpuFreqController&) = delete;
+    CpuFreqController& operator=(const CpuFreqController&) = delete;
+
+    int discover();
+    const std::vector<CpuFreqPolicy>& getPolicies() const { return policies; }
+    bool readPolicyState(int index, CpuFreqPolicyState& out) const;
+
+    // targets[i] applies to getPolicies()[i]; a shorter vector reuses its
+    // last entry for the remaining (bigger) clusters.
+    bool apply(const std::vector<CpuFreqTarget>& targets, std::string* error = nullptr);
+    bool applyAll(const CpuFreqTarget& target, std::string* error = nullptr);
+
+    // Restores the state captured before the first apply().
+    bool restore();
+    // Back to that state except for what `keep` sets (as in apply()), for
+    // dropping one layer of changes while another stays. The baseline is
+    // kept for a later restore().
+    bool revert(const std::vector<CpuFreqTarget>& keep);
+    bool hasChanges() const { return haveBaseline; }
+
+    // Restores a baseline left behind by a previous optimizer instance
+    // that died without restoring (SIGKILL, lowmemorykiller).
+    bool recoverFromStateFile();
+
+    // Installs fatal-signal handlers that restore the baseline of the
+    // controller with pending changes, then chain to the previous handler.
+    // SIGSEGV is left alone: ART uses it for implicit null checks.
+    static void installCrashRestore();
+};
+
+#endif // __linux__
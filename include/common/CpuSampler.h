@@ -0,0 +1,151 @@
+// include/common/CpuSampler.h - Background per-thread CPU usage sampler
+#pragma once
+#if defined(__linux__)
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/types.h>
+
+#include "EventLoop.h"
+#include "ProcFs.h"
+
+struct CpuSample {
+    uint64_t timestampNs = 0;
+    uint32_t utimeDelta = 0;     // clock ticks since previous sample
+    uint32_t stimeDelta = 0;
+    float usagePercent = 0.0f;   // percent of one core
+};
+
+struct ProcessCpuSample {
+    uint64_t timestampNs = 0;
+    uint64_t utime = 0;          // cumulative clock ticks
+    uint64_t stime = 0;
+    uint32_t utimeDelta = 0;
+    uint32_t stimeDelta = 0;
+    float usagePercent = 0.0f;   // percent of one core (can exceed 100)
+    float systemSharePercent = 0.0f; // percent of all online cores
+    uint64_t rssBytes = 0;
+    int32_t threadCount = 0;
+};
+
+struct ThreadCpuUsage {
+    int32_t tid = 0;
+    char comm[16] = {};
+    CpuSample latest;
+    uint64_t utime = 0;
+    uint64_t stime = 0;
+    int32_t lastCpu = -1;
+};
+
+// Samples /proc/<pid>/stat and every /proc/<pid>/task/<tid>/stat at a fixed
+// rate on its own thread, or as a periodic task of an EventLoop. Results live in fixed-size rings that readers
+// access without locks: each ring slot is written field by field through
+// relaxed atomics and published by a release store of the ring head.
+class CpuSampler {
+public:
+    static constexpr int kMaxThreads = 256;
+    static constexpr int kThreadHistory = 32;
+    static constexpr int kProcessHistory = 128;
+
+private:
+    struct RingEntry {
+        std::atomic<uint64_t> timestampNs{0};
+        std::atomic<uint32_t> utimeDelta{0};
+        std::atomic<uint32_t> stimeDelta{0};
+        std::atomic<float> usagePercent{0.0f};
+    };
+
+    struct ThreadSlot {
+        std::atomic<int32_t> tid{0};            // 0 = free
+        std::atomic<uint64_t> commWords[2] = {};
+        std::atomic<uint64_t> utime{0};
+        std::atomic<uint64_t> stime{0};
+        std::atomic<int32_t> lastCpu{-1};
+        std::atomic<uint32_t> head{0};          // entries written so far
+        RingEntry ring[kThreadHistory];
+
+        // Sampler-thread private state
+        ProcFile statFile;
+        bool seen = false;
+    };
+
+    struct ProcessEntry {
+        std::atomic<uint64_t> timestampNs{0};
+        std::atomic<uint64_t> utime{0};
+        std::atomic<uint64_t> stime{0};
+        std::atomic<uint32_t> utimeDelta{0};
+        std::atomic<uint32_t> stimeDelta{0};
+        std::atomic<float> usagePercent{0.0f};
+        std::atomic<float> systemSharePercent{0.0f};
+        std::atomic<uint64_t> rssBytes{0};
+        std::atomic<int32_t> threadCount{0};
+    };
+
+    std::unique_ptr<ThreadSlot[]> slots;
+    std::unique_ptr<ProcessEntry[]> processRing;
+    std::atomic<uint32_t> processHead;
+    std::atomic<pid_t> targetPid;
+    std::atomic<int> intervalMs;
+    std::atomic<bool> running;
+
+    // Sampler-thread private state
+    ProcessStatReader processReader;
+    std::string root;
+    uint64_t lastProcessUtime;
+    uint64_t lastProcessStime;
+    uint64_t lastProcessTimestampNs;
+    int32_t lastThreadCount;
+    uint32_t ticksSinceRescan;
+    long clockTicksPerSecond;
+    long pageSize;
+    int onlineCpus;
+    int taskDirFd;
+
+    std::thread worker;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    EventLoop* eventLoop;
+    std::atomic<EventLoop::TaskId> loopTask;
+
+    void run();
+    void rescanThreads();
+    ThreadSlot* findSlot(int32_t tid);
+    ThreadSlot* claimSlot(int32_t tid);
+    void sampleThread(ThreadSlot& slot, uint64_t nowNs, double elapsedSec);
+    void resetState();
+
+public:
+    explicit CpuSampler(const std::string& rootPrefix = "");
+    ~CpuSampler();
+
+    CpuSampler(const CpuSampler&) = delete;
+    CpuSampler& operator=(const CpuSampler&) = delete;
+
+    // Attaches to `pid` and starts the background thread.
+    bool start(pid_t pid, int samplingIntervalMs = 100);
+    // Same, sampling from `loop`'s thread instead of a thread of its own.
+    bool start(EventLoop& loop, pid_t pid, int samplingIntervalMs = 100);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    void setInterval(int samplingIntervalMs);
+
+    // Attaches without starting a thread; callers then drive sampleOnce()
+    // from their own loop.
+    bool attach(pid_t pid);
+    bool sampleOnce();
+
+    // Lock-free readers; safe from any thread while sampling continues.
+    pid_t pid() const { return targetPid.load(std::memory_order_acquire); }
+    double processCpuUsage() const;
+    bool latestProcessSample(ProcessCpuSample& out) const;
+    int processHistory(ProcessCpuSample* out, int maxSamples) const;
+    int threadUsage(ThreadCpuUsage* out, int maxThreads) const;
+    int threadHistory(int32_t tid, CpuSample* out, int maxSamples) const;
+};
+
+#endif // __linux__
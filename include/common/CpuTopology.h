@@ -0,0 +1,131 @@
+// include/common/CpuTopology.h - CPU topology model and thread placement
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sched.h>
+#include <sys/types.h>
+
+class CpuSampler;
+
+// Capacity is on the kernel's cpu_capacity scale: 1024 = biggest core.
+constexpr uint32_t kMaxCpuCapacity = 1024;
+
+struct CoreInfo {
+    int cpu = -1;
+    bool online = false;
+    uint32_t capacity = 0;
+    int clusterId = -1;
+    int packageId = -1;
+    std::vector<int> coreSiblings;
+    std::vector<int> threadSiblings;   // SMT threads of this core, itself included
+    uint32_t minFreq = 0;        // cpuinfo range, kHz
+    uint32_t maxFreq = 0;
+};
+
+struct ClusterInfo {
+    int id = -1;
+    std::vector<int> cpus;
+    uint32_t capacity = 0;       // of its biggest core
+    uint32_t maxFreq = 0;
+};
+
+// Reads cpu_capacity, topology/{cluster_id,physical_package_id,
+// core_siblings} and cpufreq/cpuinfo_{min,max}_freq for every core under
+// `root`. Kernels without cpu_capacity get it derived from max frequency;
+// kernels without cluster_id are grouped by capacity.
+class CpuTopology {
+private:
+    std::string root;
+    std::vector<CoreInfo> cores;
+    std::vector<ClusterInfo> clusters;  // ascending capacity: little first
+
+public:
+    explicit CpuTopology(const std::string& rootPrefix = "");
+
+    bool load();
+    bool isLoaded() const { return !cores.empty(); }
+
+    const std::vector<CoreInfo>& getCores() const { return cores; }
+    const std::vector<ClusterInfo>& getClusters() const { return clusters; }
+    const CoreInfo* core(int cpu) const;
+    bool isHeterogeneous() const { return clusters.size() > 1; }
+
+    // Online CPUs of clusters [firstCluster, lastCluster], little = 0.
+    cpu_set_t clusterMask(size_t firstCluster, size_t lastCluster) const;
+    cpu_set_t onlineMask() const;
+
+    static std::vector<int> parseCpuMask(const std::string& hexMask);
+    static std::vector<int> parseCpuList(const std::string& list);
+};
+
+struct ThreadDemand {
+    pid_t tid = 0;
+    double usagePercent = 0.0;   // percent of one core over the recent window
+};
+
+// Where a thread is allowed to run, from most to least capable.
+enum class PlacementTier {
+    Prime,          // biggest cluster only
+    Performance,    // every cluster but the little one
+    Any,
+    Little
+};
+
+struct ThreadAssignment {
+    pid_t tid = 0;
+    PlacementTier tier = PlacementTier::Any;
+    double demand = 0.0;
+    uint32_t migrations = 0;
+};
+
+// Ranks the game's threads by recent CPU demand and pins them: the
+// heaviest (main/render) to the biggest cores, light helpers to the little
+// cluster, the rest unrestricted. Incumbents are favoured by the migration
+// threshold: a thread only takes a big-core slot from another when its
+// demand is higher by at least that much, and a pinned thread keeps its
+// tier until its demand leaves the tier's band by the same margin.
+class ThreadPlacement {
+public:
+    using AffinitySetter = std::function<bool(pid_t tid, const cpu_set_t& mask)>;
+
+    struct Thresholds {
+        double heavyPercent = 30.0;         // demand to qualify for big cores
+        double lightPercent = 5.0;          // demand below this goes little
+        double migrationGainPercent = 10.0; // demand advantage needed to move
+    };
+
+private:
+    const CpuTopology& topology;
+    Thresholds thresholds;
+    AffinitySetter setter;
+    std::unordered_map<pid_t, ThreadAssignment> assignments;
+    uint64_t totalMigrations;
+
+    cpu_set_t maskFor(PlacementTier tier) const;
+
+public:
+    explicit ThreadPlacement(const CpuTopology& cpuTopology);
+
+    void setThresholds(const Thresholds& values) { thresholds = values; }
+    const Thresholds& getThresholds() const { return thresholds; }
+    void setAffinitySetter(AffinitySetter affinitySetter) { setter = std::move(affinitySetter); }
+
+    // Returns the number of threads moved.
+    int rebalance(const std::vector<ThreadDemand>& demands);
+    int rebalance(const CpuSampler& sampler, int windowSamples = 20);
+
+    // Gives every pinned thread its full online mask back.
+    void restore();
+
+    std::vector<ThreadAssignment> getAssignments() const;
+    uint64_t getTotalMigrations() const { return totalMigrations; }
+
+    static const char* tierName(PlacementTier tier);
+};
+
+#endif // __linux__
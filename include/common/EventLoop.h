@@ -0,0 +1,174 @@
+// include/common/EventLoop.h - Single-threaded epoll/timerfd reactor
+#pragma once
+#if defined(__linux__)
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <signal.h>
+#include <sys/signalfd.h>
+
+struct EventLoopStats {
+    uint64_t wakeups = 0;          // epoll_wait returns
+    uint64_t timerRuns = 0;
+    uint64_t coalescedRuns = 0;    // timer runs that rode on another timer's wakeup
+    uint64_t fdEvents = 0;
+    uint64_t signals = 0;
+    uint64_t posted = 0;
+    uint64_t offloaded = 0;
+};
+
+struct EventLoopTaskInfo {
+    uint64_t id = 0;
+    std::string name;
+    bool timer = false;
+    uint32_t intervalMs = 0;       // 0 for fd, signal and one-shot tasks
+    uint32_t slackMs = 0;
+    uint64_t runs = 0;
+    uint64_t totalNs = 0;
+};
+
+// One thread multiplexing every periodic and fd-driven task of the
+// optimizer: timers, PSI trigger fds, inotify, the proc connector socket
+// and a signalfd all go through a single epoll_wait.
+//
+// All timers share one timerfd. Each timer may run up to its slack after
+// its due time, so the loop arms the timerfd at the earliest
+// "due + slack" and then runs every timer that is due by then: timers
+// whose windows overlap fire on one wakeup instead of one each. Periodic
+// timers keep their phase (due += interval) so slack never accumulates
+// into drift. Times are CLOCK_MONOTONIC milliseconds (nowMs()).
+//
+// Callbacks run on the loop thread and must not block; work that can
+// (a /proc walk, a helper round trip) goes to offload(), a small worker
+// pool. Tasks can be added and removed from any thread; remove() from
+// another thread waits for a running callback of that task to return, so
+// its captures may be destroyed right after.
+class EventLoop {
+public:
+    using TaskId = uint64_t;
+    using TimerCallback = std::function<void(uint64_t nowMs)>;
+    using FdCallback = std::function<void(uint32_t events)>;
+    using SignalCallback = std::function<void(const signalfd_siginfo& info)>;
+    using Job = std::function<void()>;
+
+    // Slack used when none is given: a tenth of the interval, capped.
+    static constexpr uint32_t kAutoSlack = UINT32_MAX;
+    static constexpr uint32_t kMaxAutoSlackMs = 250;
+
+private:
+    enum class Kind {
+        Timer,
+        Fd,
+        Signal
+    };
+
+    struct Task {
+        TaskId id = 0;
+        std::string name;
+        Kind kind = Kind::Timer;
+        uint32_t intervalMs = 0;       // 0: one-shot
+        uint32_t slackMs = 0;
+        uint32_t requestedSlackMs = kAutoSlack;
+        uint64_t dueMs = 0;
+        int fd = -1;
+        uint32_t events = 0;
+        int signo = 0;
+        TimerCallback onTimer;
+        FdCallback onFd;
+        SignalCallback onSignal;
+        uint64_t runs = 0;
+        uint64_t totalNs = 0;
+    };
+
+    int epollFd;
+    int timerFd;
+    int wakeFd;
+    int signalFd;
+    sigset_t signalMask;
+    uint64_t armedMs;                  // timerfd expiry, 0 when disarmed
+
+    std::atomic<bool> running;
+    std::thread loopThread;
+    std::atomic<std::thread::id> loopThreadId;
+
+    mutable std::mutex mutex;
+    std::condition_variable taskDone;
+    std::unordered_map<TaskId, std::shared_ptr<Task>> tasks;
+    TaskId nextId;
+    TaskId currentTask;                // running callback, 0 when none
+    std::vector<Job> posted;
+    EventLoopStats stats;
+
+    std::mutex poolMutex;
+    std::condition_variable poolWake;
+    std::deque<Job> jobs;
+    std::vector<std::thread> pool;
+    Job poolInit;
+    bool poolStopping;
+
+    TaskId addTask(std::shared_ptr<Task> task);
+    void wake();
+    void run();
+    void rearmTimer();
+    void runTimers();
+    void runFd(TaskId id, uint32_t events);
+    void runSignals();
+    void runPosted();
+    void invoke(const std::shared_ptr<Task>& task, const std::function<void()>& call);
+    void poolWorker();
+
+public:
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Starts the loop thread and `workers` pool threads. Tasks added
+    // before start() are kept and run once it does. `workerInit` runs once
+    // on each pool thread before its first job (to lower its priority,
+    // say).
+    bool start(unsigned workers = 2, Job workerInit = nullptr);
+    // Stops the loop and the pool; running jobs finish, queued ones are
+    // dropped. Registered tasks stay registered.
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    bool inLoopThread() const;
+
+    // First run one interval from now.
+    TaskId addPeriodic(const std::string& name, uint32_t intervalMs, TimerCallback callback,
+                       uint32_t slackMs = kAutoSlack);
+    TaskId addTimeout(const std::string& name, uint32_t delayMs, TimerCallback callback,
+                      uint32_t slackMs = kAutoSlack);
+    // `events` as for epoll (EPOLLIN, EPOLLPRI, ...). The fd stays owned by
+    // the caller and must outlive the task.
+    TaskId addFd(const std::string& name, int fd, uint32_t events, FdCallback callback);
+    // Blocks `signo` in the calling thread and delivers it through a
+    // signalfd. Process-directed signals reach the loop only if every
+    // other thread blocks them too, so register before starting threads.
+    TaskId addSignal(const std::string& name, int signo, SignalCallback callback);
+    // Next run one new interval after the previous one.
+    bool setInterval(TaskId id, uint32_t intervalMs);
+    bool remove(TaskId id);
+
+    // Runs `job` on the loop thread at the next wakeup.
+    void post(Job job);
+    // Runs `job` on a pool thread; false when the pool is not running.
+    bool offload(Job job);
+
+    EventLoopStats getStats() const;
+    std::vector<EventLoopTaskInfo> getTasks() const;
+
+    static uint64_t nowMs();
+};
+
+#endif // __linux__
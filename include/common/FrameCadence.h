@@ -0,0 +1,137 @@
+// include/common/FrameCadence.h - Render-thread frame cadence from scheduler statistics
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+#include "ProcFs.h"
+
+struct FrameCadence {
+    bool valid = false;
+    int32_t tid = 0;
+    char comm[16] = {};
+    double fps = 0.0;
+    double frameTimeMs = 0.0;
+    double jitterMs = 0.0;         // stddev of the per-window mean frame time
+    double cpuPerFrameMs = 0.0;    // schedstat run time per frame
+    double waitPerFrameMs = 0.0;   // schedstat runqueue wait per frame
+    double cpuShare = 0.0;         // of one core over the history
+    double confidence = 0.0;       // 0..1, regularity times history fill
+    uint64_t timestampMs = 0;      // EventLoop::nowMs() of the last window
+};
+
+// Estimates the game's frame rate without touching the game: a render
+// loop blocks once per frame (vsync, a fence, eglSwapBuffers), so its
+// thread's voluntary context switches tick at the frame rate, and
+// /proc/<pid>/task/<tid>/schedstat gives the CPU time and runqueue wait
+// spent per tick.
+//
+// Every rescanIntervalMs the estimator ranks the process's threads by CPU
+// time consumed since the previous rescan (render-looking names get a
+// bonus) and keeps the top maxCandidates. Each candidate's wakeups are
+// counted over windows of windowMs; the render thread is the candidate
+// whose wakeup rate is both steady (low coefficient of variation across
+// windows) and backed by real CPU work, which rules out idle poll threads
+// ticking at a fixed rate and busy workers that are mostly preempted.
+//
+// A render thread that blocks several times per frame (waiting on a job
+// system, say) reads as a multiple of the true rate; confidence does not
+// catch that, so consumers should treat fps as a cadence signal and watch
+// its changes rather than its absolute value.
+//
+// sample() is driven by one thread (an EventLoop task); current() and
+// candidates() may be called from any thread.
+class FrameCadenceEstimator {
+public:
+    struct Options {
+        uint32_t windowMs = 250;
+        uint32_t historyWindows = 16;
+        uint32_t rescanIntervalMs = 2000;
+        uint32_t maxCandidates = 4;
+        double minFps = 5.0;
+        double maxFps = 240.0;
+    };
+
+private:
+    struct Window {
+        double durationMs = 0.0;
+        uint64_t frames = 0;
+        double runMs = 0.0;
+        double waitMs = 0.0;
+    };
+
+    struct Candidate {
+        int32_t tid = 0;
+        char comm[16] = {};
+        bool nameHint = false;
+        ProcFile schedstatFile;
+        ProcFile statusFile;
+        TaskSchedstat windowSched;
+        uint64_t windowVoluntary = 0;
+        uint64_t windowStartMs = 0;
+        std::vector<Window> history;   // ring of historyWindows
+        size_t historyHead = 0;        // windows written so far
+        FrameCadence estimate;
+        double score = 0.0;
+    };
+
+    struct ThreadSeen {
+        uint64_t runNs = 0;
+        char comm[16] = {};
+        bool nameHint = false;
+    };
+
+    std::string root;
+    Options options;
+    pid_t targetPid;
+    int taskDirFd;
+    uint64_t lastRescanMs;
+    std::vector<std::unique_ptr<Candidate>> tracked;
+    std::unordered_map<int32_t, ThreadSeen> seen;   // run time at the last rescan
+
+    mutable std::mutex mutex;                       // guards published
+    FrameCadence published;
+    std::vector<FrameCadence> publishedCandidates;
+
+    void rescan(uint64_t nowMs);
+    bool openCandidate(Candidate& candidate, uint64_t nowMs);
+    bool readCounters(Candidate& candidate, TaskSchedstat& sched, uint64_t& voluntary);
+    void closeWindow(Candidate& candidate, const TaskSchedstat& sched, uint64_t voluntary, uint64_t nowMs);
+    void evaluate(Candidate& candidate) const;
+
+public:
+    explicit FrameCadenceEstimator(const std::string& rootPrefix = "");
+    ~FrameCadenceEstimator();
+
+    FrameCadenceEstimator(const FrameCadenceEstimator&) = delete;
+    FrameCadenceEstimator& operator=(const FrameCadenceEstimator&) = delete;
+
+    // Takes effect on the next attach().
+    void setOptions(const Options& newOptions);
+    const Options& getOptions() const { return options; }
+
+    bool attach(pid_t pid);
+    void detach();
+    pid_t pid() const { return targetPid; }
+
+    // Call every 100 ms or so with EventLoop::nowMs(); windows close on
+    // the first call at least windowMs after they opened. Returns true
+    // when a window closed and the estimate was refreshed.
+    bool sample(uint64_t nowMs);
+
+    // Best candidate; valid stays false until one has a plausible rate
+    // over at least four windows.
+    FrameCadence current() const;
+    // Every tracked thread's own estimate, best first.
+    std::vector<FrameCadence> candidates() const;
+
+    static bool isRenderThreadName(const char* comm);
+};
+
+#endif // __linux__
@@ -0,0 +1,187 @@
+// include/common/InstanceManager.h - Concurrent game clients with per-instance CPU partitions
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <sched.h>
+#include <sys/types.h>
+
+#include "CpuTopology.h"
+#include "ProcFs.h"
+
+struct InstanceInfo {
+    pid_t pid = 0;
+    std::string name;
+    uint64_t startedMs = 0;
+    double cpuPercent = 0.0;           // of one core, over the last update
+    double demandCores = 0.0;          // smoothed; what partitions are sized by
+    uint64_t rssBytes = 0;
+    int32_t threads = 0;
+    // Main thread (the game loop) over the last update: share of its
+    // runnable time spent waiting for a CPU, and preemptions per second.
+    double waitShare = 0.0;
+    double preemptionsPerSec = 0.0;
+    int partition = -1;                // index into the plan, -1 when unpartitioned
+    std::vector<int> cpus;             // empty when unpartitioned
+};
+
+struct CpuPartition {
+    std::vector<int> cpus;
+    uint32_t capacity = 0;             // summed cpu_capacity; 1024 per big core
+    std::vector<pid_t> members;
+    double demandCores = 0.0;          // summed demand of the members
+
+    double capacityCores() const { return capacity / static_cast<double>(kMaxCpuCapacity); }
+    double load() const { return capacity ? demandCores / capacityCores() : 0.0; }
+};
+
+struct PartitionPlan {
+    std::vector<CpuPartition> partitions;   // disjoint
+    std::vector<int> reserved;              // left to the system and the optimizer
+
+    int partitionOf(pid_t pid) const;
+};
+
+// Splits the online CPUs into disjoint partitions for a set of instances.
+//
+// CPUs are grouped into units that are never split between partitions
+// (SMT siblings share a core's pipelines, so two instances on one core
+// interfere however the threads are spread) and ordered biggest first,
+// then by package, so a partition stays within one cluster and one LLC
+// where it can. reservedCpus worth of the smallest units are kept out
+// while there are more units than instances.
+//
+// With at least as many units as instances each instance gets a
+// partition of its own: instances in order of demand take consecutive
+// units until their share of the capacity (demand over total demand) is
+// covered, every instance at least one unit, the last one the rest, so
+// spare capacity is spread in proportion too. With more instances than
+// units, each unit is a partition and instances are packed into them
+// heaviest first onto the least loaded, staying in their previous
+// partition while it is within `stickiness` of the best choice.
+class PartitionPlanner {
+public:
+    struct Options {
+        uint32_t reservedCpus = 1;
+        double minDemandCores = 0.25;  // an idle instance still gets sized
+        double headroom = 1.25;
+        double stickiness = 0.25;
+    };
+
+    static PartitionPlan plan(const CpuTopology& topology, const std::map<pid_t, double>& demandCores,
+                              const PartitionPlan& previous, const Options& options);
+};
+
+struct InstanceStats {
+    size_t instances = 0;
+    size_t partitions = 0;
+    uint64_t replans = 0;
+    uint64_t threadsPinned = 0;
+    uint64_t pinFailures = 0;          // threads that exited first, or EPERM
+};
+
+// Tracks every running client as its own entity, with its own CPU, memory
+// and scheduling metrics, and keeps each one's threads on a CPU partition
+// of its own while at least minInstances run.
+//
+// A new plan is made when an instance starts or stops, or when one
+// outgrows its partition: its load (demand over capacity) above
+// overloadRatio while another partition of more than one unit sits under
+// underloadRatio, at most once per replanIntervalMs. After a start the
+// plan waits for the newcomer's first demand sample (its second update),
+// for at most replanIntervalMs, rather than size it at minDemandCores
+// and move everyone again once it is measured. Threads keep the
+// partition's mask; affinity is inherited, so threads created later
+// start there and update() only has to catch those that escaped the
+// walk. Below minInstances, or on restore(), every pinned thread gets the
+// full online mask back.
+//
+// All methods may be called from any thread; calls are serialised.
+class InstanceManager {
+public:
+    struct Options {
+        PartitionPlanner::Options planner;
+        uint32_t minInstances = 2;     // 0: track only, never partition
+        double demandSmoothing = 0.3;  // EWMA weight of the newest sample
+        double overloadRatio = 0.9;
+        double underloadRatio = 0.5;
+        uint32_t replanIntervalMs = 5000;
+    };
+    using AffinitySetter = std::function<bool(pid_t tid, const cpu_set_t& mask)>;
+
+private:
+    struct Instance {
+        InstanceInfo info;
+        ProcessStatReader reader;
+        ProcFile schedstat;
+        uint64_t lastTicks = 0;
+        uint64_t lastTimestampMs = 0;
+        TaskSchedstat lastSched;
+        uint64_t lastPreemptions = 0;
+        bool sampled = false;
+        bool measured = false;         // demandCores comes from a sample
+        std::unordered_set<pid_t> pinned;
+    };
+
+    std::string root;
+    const CpuTopology& topology;
+    Options options;
+    AffinitySetter setter;
+    std::map<pid_t, std::unique_ptr<Instance>> instances;
+    PartitionPlan plan;
+    bool membershipChanged;
+    uint64_t lastReplanMs;
+    long clockTicksPerSecond;
+    InstanceStats stats;
+    mutable std::mutex mutex;
+
+    void sampleLocked(Instance& instance, uint64_t nowMs);
+    bool outgrownLocked() const;
+    bool awaitingDemandLocked(uint64_t nowMs) const;
+    void replanLocked(uint64_t nowMs);
+    size_t pinLocked(Instance& instance, bool all);
+    void unpinLocked(Instance& instance);
+    std::vector<pid_t> listThreads(pid_t pid) const;
+
+public:
+    explicit InstanceManager(const CpuTopology& cpuTopology, const std::string& rootPrefix = "");
+    ~InstanceManager();
+
+    InstanceManager(const InstanceManager&) = delete;
+    InstanceManager& operator=(const InstanceManager&) = delete;
+
+    void setOptions(const Options& newOptions);
+    void setAffinitySetter(AffinitySetter affinitySetter);
+
+    // False if already tracked or gone.
+    bool add(pid_t pid, const std::string& name, uint64_t nowMs);
+    // For exits: the threads are gone, nothing is restored.
+    bool remove(pid_t pid);
+    bool contains(pid_t pid) const;
+    size_t count() const;
+    // Longest-running instance, 0 when none.
+    pid_t oldest() const;
+
+    // Samples every instance, replans when due and pins threads not yet on
+    // their partition. Call every second or so (EventLoop::nowMs()).
+    // Returns the number of threads pinned.
+    size_t update(uint64_t nowMs);
+    // Full online mask back to every pinned thread; the plan is dropped
+    // until the next update().
+    void restore();
+    bool isPartitioned() const;
+
+    std::vector<InstanceInfo> snapshot() const;
+    bool get(pid_t pid, InstanceInfo& out) const;
+    PartitionPlan getPlan() const;
+    InstanceStats getStats() const;
+};
+
+#endif // __linux__
@@ -0,0 +1,158 @@
+// include/common/IoPriority.h - I/O priority classes for the game, background apps and our own work
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+
+// ioprio(7) classes. None means "derived from the CPU nice value", which is
+// what every task starts with.
+enum class IoClass {
+    None = 0,
+    RealTime = 1,
+    BestEffort = 2,
+    Idle = 3
+};
+
+struct IoPriority {
+    IoClass ioClass = IoClass::None;
+    int level = 4;                 // 0 (highest) .. 7; Idle and None ignore it
+
+    IoPriority() = default;
+    IoPriority(IoClass cls, int lvl) : ioClass(cls), level(lvl) {}
+
+    int toRaw() const;
+    static IoPriority fromRaw(int raw);
+    // "rt:0", "be:4", "be" (level 4), "idle", "none"; false on anything else.
+    static bool parse(const std::string& text, IoPriority& out);
+    std::string toString() const;
+
+    // ioprio_get/ioprio_set on one thread (tid 0: the calling thread).
+    static bool get(pid_t tid, IoPriority& out);
+    static bool set(pid_t tid, const IoPriority& priority);
+};
+
+struct IoPriorityOptions {
+    // Real-time needs CAP_SYS_ADMIN and can starve the rest of the
+    // system's I/O, so the default is the top best-effort level.
+    IoPriority game{IoClass::BestEffort, 0};
+    IoPriority background{IoClass::Idle, 0};
+    bool allowHelper = true;       // route EPERM through the root helper
+};
+
+struct IoPriorityStatus {
+    pid_t gamePid = 0;
+    size_t gameThreads = 0;
+    size_t backgroundProcesses = 0;
+    size_t backgroundThreads = 0;
+    uint64_t applied = 0;          // thread priorities changed
+    uint64_t restored = 0;
+    uint64_t failed = 0;           // neither direct nor through the helper
+};
+
+// Gives every thread of the game the game class and every thread of the
+// background processes the background class. I/O priority is per thread
+// on Linux, so new threads start with their creator's class only if they
+// were created after it was set: refresh() walks the task lists again and
+// covers threads that appeared since. Each thread's original priority is
+// remembered and put back when its process leaves its set or on restore();
+// a thread that inherited our class from its creator gets the process's
+// original back.
+// Classes only matter to I/O schedulers that honour them (BFQ, and
+// mq-deadline since Linux 5.14); elsewhere this is a harmless no-op.
+//
+// Threads of other users' processes need CAP_SYS_NICE; without it the
+// changes go through the root helper in one batch per call.
+class IoPriorityManager {
+private:
+    // tgid -> tid -> original raw ioprio
+    using Origins = std::unordered_map<pid_t, std::unordered_map<pid_t, int>>;
+
+    std::string root;
+    IoPriorityOptions options;
+    pid_t gamePid;
+    std::unordered_set<pid_t> background;
+    Origins origins;
+    uint64_t applied;
+    uint64_t restored;
+    uint64_t failed;
+    mutable std::mutex mutex;
+
+    std::vector<pid_t> listThreads(pid_t pid) const;
+    // Sets `priority` on threads of `pid` not yet changed; returns how many.
+    size_t applyLocked(pid_t pid, const IoPriority& priority);
+    void restoreLocked(pid_t pid);
+    // Direct ioprio_set for each (tid, raw) pair, the helper for the rest.
+    size_t setAllLocked(const std::vector<std::pair<pid_t, int>>& changes);
+
+public:
+    explicit IoPriorityManager(const std::string& rootPrefix = "");
+    ~IoPriorityManager();
+
+    IoPriorityManager(const IoPriorityManager&) = delete;
+    IoPriorityManager& operator=(const IoPriorityManager&) = delete;
+
+    // Applies to threads changed from now on; call restore() first to
+    // re-apply everything.
+    void setOptions(const IoPriorityOptions& newOptions);
+
+    // The previous game (0: none) gets its threads' priorities back; the
+    // new one is covered by the next refresh().
+    void setGamePid(pid_t pid);
+    // Makes `pids` the background set: members no longer listed are
+    // restored, newcomers are covered by the next refresh().
+    void syncBackground(const std::vector<pid_t>& pids);
+    // Applies the classes to every thread not yet covered. Returns the
+    // number of threads changed.
+    size_t refresh();
+    // Puts every changed thread back and forgets both sets.
+    void restore();
+
+    IoPriorityStatus getStatus() const;
+
+    // For our own maintenance threads (cache cleaning, accounting passes).
+    static bool setCurrentThreadIdle();
+};
+
+struct IoLatencyOptions {
+    std::string path;                  // file to read; created when missing or short
+    uint64_t fileBytes = 64ull << 20;
+    uint32_t blockBytes = 4096;
+    uint32_t durationMs = 3000;
+    uint64_t maxReads = 0;             // 0: read until durationMs
+    // O_DIRECT where the filesystem allows it; otherwise each block is
+    // dropped from the page cache before it is read.
+    bool direct = true;
+    // Class the reads run at; None inherits. A class that cannot be set
+    // (rt without CAP_SYS_ADMIN) fails the run rather than time another.
+    IoPriority priority;
+};
+
+struct IoLatencyResult {
+    bool success = false;
+    std::string error;
+    bool direct = false;               // reads bypassed the page cache with O_DIRECT
+    uint64_t reads = 0;
+    double iops = 0.0;
+    double meanUs = 0.0;
+    double p50Us = 0.0;
+    double p90Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+// fio-style random-read latency probe: one thread issuing synchronous
+// block-sized reads at random aligned offsets (fio's rw=randread,
+// iodepth=1), timing each one. Running it at the game's class while
+// background work reads at its class shows what the classes buy.
+class IoLatencyProbe {
+public:
+    static IoLatencyResult run(const IoLatencyOptions& options);
+};
+
+#endif // __linux__
@@ -1,9 +1,17 @@
-// include/common/Logger.h - Logger class definition  
+// include/common/Logger.h - Logger class definition
 #pragma once
 
 #include <string>
 #include <fstream>
+#include <ostream>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <type_traits>
 
 enum class LogLevel {
     DEBUG = 0,
@@ -12,33 +20,173 @@ enum class LogLevel {
     ERROR = 3
 };
 
+// One raw argument captured by a producer; formatted later on the flusher
+// thread. Strings are copied into the record's payload.
+struct LogArg {
+    enum class Type : uint8_t { None, Int, UInt, Double, String };
+    Type type = Type::None;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        uint16_t stringOffset;
+    } value = {0};
+};
+
+struct LogRecord {
+    static constexpr int kMaxArgs = 6;
+    static constexpr int kPayloadSize = 160;
+
+    uint64_t timestampNs;          // system_clock, ns since epoch
+    uint32_t formatId;             // 0 = raw text in payload
+    uint32_t threadId;
+    LogLevel level;
+    uint8_t argCount;
+    uint16_t payloadUsed;
+    LogArg args[kMaxArgs];
+    char payload[kPayloadSize];
+};
+
+// Asynchronous logger: producers reserve a slot in a bounded lock-free
+// MPSC ring, copy a format id and raw arguments, and return. A background
+// thread formats and writes records in batches. When the ring is full the
+// record is dropped and counted instead of blocking the caller.
 class Logger {
+public:
+    static constexpr size_t kRingSize = 2048;   // power of two
+    static constexpr uint32_t kMaxFormats = 1024;
+
 private:
-    static Logger* instance;
-    static std::mutex mutex_;
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Cell[]> ring;
+    alignas(64) std::atomic<uint64_t> enqueuePos;
+    alignas(64) uint64_t dequeuePos;
+    std::atomic<uint64_t> droppedCount;
+    std::atomic<uint64_t> flushedSequence;
+    uint64_t reportedDrops;
+
     std::ofstream logFile;
-    LogLevel currentLevel;
-    
+    std::ofstream binaryFile;
+    std::atomic<LogLevel> currentLevel;
+    std::atomic<bool> consoleOutput;
+    std::atomic<bool> running;
+    bool binaryFormatsWritten[kMaxFormats];
+
+    std::thread flusher;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable flushedCondition;
+
+    LogRecord* beginRecord(LogLevel level, uint32_t formatId, uint64_t& position);
+    void commitRecord(uint64_t position, LogLevel level);
+    void flushLoop();
+    size_t drainBatch();
+    void writeText(const LogRecord& record);
+    void writeBinary(const LogRecord& record);
+
+    static uint32_t currentThreadId();
+    static uint64_t nowNanos();
+
+    static void encodeArg(LogRecord& r, LogArg& a, double v) { a.type = LogArg::Type::Double; a.value.d = v; (void)r; }
+    static void encodeArg(LogRecord& r, LogArg& a, const char* v);
+    static void encodeArg(LogRecord& r, LogArg& a, const std::string& v) { encodeArg(r, a, v.c_str()); }
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type encodeArg(LogRecord& r, LogArg& a, T v) {
+        (void)r;
+        if (std::is_signed<T>::value) {
+            a.type = LogArg::Type::Int;
+            a.value.i = static_cast<int64_t>(v);
+        } else {
+            a.type = LogArg::Type::UInt;
+            a.value.u = static_cast<uint64_t>(v);
+        }
+    }
+    template <typename T>
+    static typename std::enable_if<std::is_enum<T>::value>::type encodeArg(LogRecord& r, LogArg& a, T v) {
+        encodeArg(r, a, static_cast<typename std::underlying_type<T>::type>(v));
+    }
+    static void encodeArg(LogRecord& r, LogArg& a, float v) { encodeArg(r, a, static_cast<double>(v)); }
+
+    static void encodeArgs(LogRecord&) {}
+    template <typename T, typename... Rest>
+    static void encodeArgs(LogRecord& r, const T& first, const Rest&... rest) {
+        if (r.argCount < LogRecord::kMaxArgs) {
+            encodeArg(r, r.args[r.argCount], first);
+            r.argCount++;
+        }
+        encodeArgs(r, rest...);
+    }
+
 protected:
     Logger(const std::string& filename = "optimizer.log");
 
 public:
     static Logger* getInstance(const std::string& filename = "optimizer.log");
     ~Logger();
-    
+
     void setLevel(LogLevel level);
+    bool isEnabled(LogLevel level) const { return level >= currentLevel.load(std::memory_order_relaxed); }
     void log(LogLevel level, const std::string& message);
     void debug(const std::string& message);
     void info(const std::string& message);
     void warning(const std::string& message);
     void error(const std::string& message);
-    
+
+    // Format-id logging: `formatId` comes from registerFormat() with a
+    // string literal; only the id and the raw arguments are copied here.
+    template <typename... Args>
+    void logFormat(LogLevel level, uint32_t formatId, const Args&... args) {
+        if (!isEnabled(level)) {
+            return;
+        }
+        uint64_t position = 0;
+        LogRecord* record = beginRecord(level, formatId, position);
+        if (!record) {
+            return;
+        }
+        encodeArgs(*record, args...);
+        commitRecord(position, level);
+    }
+    static uint32_t registerFormat(const char* format);
+    static const char* formatString(uint32_t formatId);
+
+    // Sinks
+    void setConsoleOutput(bool enabled) { consoleOutput.store(enabled, std::memory_order_relaxed); }
+    bool enableBinaryOutput(const std::string& filename);
+
+    // Blocks until every record enqueued before the call has been written.
+    void flush();
+    uint64_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+
+    // Renders a record (or a binary log file) to text; used by the flusher
+    // and by the offline decoder.
+    static std::string formatRecord(const LogRecord& record, const char* format);
+    static bool decodeBinaryLog(const std::string& filename, std::ostream& out);
+
     Logger(Logger &other) = delete;
     void operator=(const Logger &) = delete;
 };
 
 // Convenience macros
 #define LOG_DEBUG(msg) Logger::getInstance()->debug(msg)
-#define LOG_INFO(msg) Logger::getInstance()->info(msg)  
+#define LOG_INFO(msg) Logger::getInstance()->info(msg)
 #define LOG_WARNING(msg) Logger::getInstance()->warning(msg)
 #define LOG_ERROR(msg) Logger::getInstance()->error(msg)
+
+// Deferred-format macros for hot paths: LOG_INFOF("tick %u took %llu us", n, us)
+#define LOG_FORMAT(level, fmt, ...)                                                  \
+    do {                                                                             \
+        Logger* logger_ = Logger::getInstance();                                     \
+        if (logger_->isEnabled(level)) {                                             \
+            static const uint32_t formatId_ = Logger::registerFormat(fmt);           \
+            logger_->logFormat(level, formatId_, ##__VA_ARGS__);                     \
+        }                                                                            \
+    } while (0)
+#define LOG_DEBUGF(fmt, ...) LOG_FORMAT(LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFOF(fmt, ...) LOG_FORMAT(LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARNINGF(fmt, ...) LOG_FORMAT(LogLevel::WARNING, fmt, ##__VA_ARGS__)
+#define LOG_ERRORF(fmt, ...) LOG_FORMAT(LogLevel::ERROR, fmt, ##__VA_ARGS__)
@@ -0,0 +1,159 @@
+// include/common/MemoryAccountant.h - Per-process memory accounting
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+#include "ProcFs.h"
+
+// One process, as of its last samples. Cheap fields come from
+// /proc/<pid>/{stat,statm} and are refreshed every few seconds; the detail
+// fields come from status, smaps_rollup and oom_score_adj and are only
+// valid when hasDetail is set. All sizes are in bytes.
+struct ProcessMemory {
+    pid_t pid = 0;
+    uint32_t uid = 0;
+    uint64_t startTime = 0;           // clock ticks since boot; with pid, the generation key
+    char comm[16] = {};
+    std::string name;                 // argv[0]: the package name for Android apps
+    bool focus = false;
+
+    // Cheap tier
+    uint64_t rss = 0;
+    uint64_t shared = 0;              // statm shared: file-backed + shmem
+    uint64_t minorFaults = 0;
+    uint64_t majorFaults = 0;
+    double majorFaultsPerSec = 0.0;   // between the last two cheap samples
+    uint64_t cheapSampleMs = 0;
+    uint64_t lastActiveMs = 0;        // last cheap sample that saw a new fault or RSS change
+
+    // Detail tier; without smaps_rollup access (another user's process,
+    // kernel < 4.14) pss falls back to rss and hasPss stays false.
+    bool hasDetail = false;
+    bool hasPss = false;
+    uint64_t rssAnon = 0;
+    uint64_t rssFile = 0;
+    uint64_t rssShmem = 0;
+    uint64_t pss = 0;
+    uint64_t pssAnon = 0;
+    uint64_t pssFile = 0;
+    uint64_t pssShmem = 0;
+    uint64_t swap = 0;
+    uint64_t swapPss = 0;
+    uint64_t zramEstimate = 0;        // swapPss at the zram compression ratio
+    int32_t oomScoreAdj = 0;
+    uint64_t detailSampleMs = 0;
+    uint64_t rssAtDetail = 0;
+
+    // PSS when known, RSS otherwise: what the process actually costs.
+    uint64_t footprint() const { return hasPss ? pss : rss; }
+};
+
+// /sys/block/zram*/mm_stat, summed over every device.
+struct ZramStats {
+    int devices = 0;
+    uint64_t origDataSize = 0;        // uncompressed bytes stored
+    uint64_t comprDataSize = 0;
+    uint64_t memUsedTotal = 0;        // including allocator overhead
+
+    double compressionRatio() const {
+        return comprDataSize ? static_cast<double>(origDataSize) / comprDataSize : 0.0;
+    }
+};
+
+struct MemoryAccountantStats {
+    size_t processes = 0;             // user processes tracked
+    size_t kernelThreads = 0;         // skipped: no address space
+    uint64_t passes = 0;
+    uint64_t cheapReads = 0;
+    uint64_t detailReads = 0;
+    uint64_t generations = 0;         // pid reuses detected
+    uint64_t lastPassNs = 0;
+};
+
+// Tracks every process under /proc in two tiers. stat and statm are a few
+// hundred bytes the kernel formats without walking the address space, so
+// they are read for every process each pass (background processes at a
+// slower cadence than the focus one). smaps_rollup walks every VMA and
+// page table of the target under its mmap lock - milliseconds for a large
+// game, and it stalls the game's own page faults meanwhile - so it is only
+// re-read when the cheap RSS moved by rssChangePercent or the detail is
+// older than the tier's interval, at most maxDetailReadsPerPass times per
+// pass, most urgent first.
+//
+// Files are opened relative to a held /proc directory fd and closed again,
+// so 300+ processes cost no descriptors between passes. Entries are keyed
+// by pid and invalidated when stat's starttime changes (pid reuse). Query
+// methods copy out under a lock and may be called from any thread.
+class MemoryAccountant {
+public:
+    struct Options {
+        uint32_t backgroundCheapIntervalMs = 5000;
+        uint32_t focusDetailIntervalMs = 2000;
+        uint32_t backgroundDetailIntervalMs = 30000;
+        uint32_t minDetailIntervalMs = 500;    // floor for RSS-triggered refreshes
+        double rssChangePercent = 10.0;
+        uint32_t maxDetailReadsPerPass = 8;
+    };
+
+private:
+    struct Entry {
+        ProcessMemory memory;
+        bool kernelThread = false;
+        bool seen = false;
+    };
+
+    std::string root;
+    Options options;
+    int procFd;
+    uint64_t pageSize;
+    pid_t focusPid;
+    ZramStats zram;
+    MemoryAccountantStats stats;
+
+    mutable std::mutex mutex;
+    std::unordered_map<pid_t, Entry> entries;
+    std::vector<char> buffer;
+    std::vector<std::pair<double, Entry*>> detailQueue;   // urgency, entry
+
+    bool openProcDir();
+    void discover();
+    bool sampleCheap(Entry& entry, uint64_t nowMs);
+    bool sampleDetail(Entry& entry, uint64_t nowMs);
+    void readName(ProcessMemory& memory);
+    double detailUrgency(const Entry& entry, uint64_t nowMs) const;
+    std::string_view readAt(int dirFd, const char* path);
+    void readZram();
+
+public:
+    explicit MemoryAccountant(const std::string& rootPrefix = "");
+    ~MemoryAccountant();
+
+    MemoryAccountant(const MemoryAccountant&) = delete;
+    MemoryAccountant& operator=(const MemoryAccountant&) = delete;
+
+    void setOptions(const Options& newOptions);
+    // Sampled with the focus cadence (0: none).
+    void setFocusPid(pid_t pid);
+
+    // One pass: discovery, cheap tier, then the due detail reads.
+    bool sample(uint64_t nowMs);
+    // Reads the detail tier of one tracked process now, outside the budget.
+    bool refreshDetail(pid_t pid, uint64_t nowMs);
+
+    bool get(pid_t pid, ProcessMemory& out) const;
+    // First process whose argv[0] or comm equals `name`.
+    bool findByName(const std::string& name, ProcessMemory& out) const;
+    // Largest footprint first.
+    std::vector<ProcessMemory> snapshot() const;
+    ZramStats getZramStats() const;
+    MemoryAccountantStats getStats() const;
+};
+
+#endif // __linux__
@@ -0,0 +1,132 @@
+// include/common/MetricsStore.h - Columnar metrics time-series store
+#pragma once
+#if defined(__linux__)
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct MetricPoint {
+    uint64_t timestampMs = 0;
+    float value = 0.0f;
+};
+
+struct RollupPoint {
+    uint64_t timestampMs = 0;    // bucket start
+    uint32_t count = 0;          // samples folded into the bucket
+    float min = 0.0f;
+    float max = 0.0f;
+    float avg = 0.0f;
+    float p95 = 0.0f;
+};
+
+struct MetricsStoreOptions {
+    uint32_t maxMetrics = 16;
+    uint32_t rawCapacity = 4096;            // ~7 min at 10 Hz
+    uint32_t tierCapacity[3] = {3600, 2160, 1440};  // 1 h of 1 s, 6 h of 10 s, 24 h of 1 min
+};
+
+// Fixed-size time-series store. Every tier is a ring with one timestamp
+// column plus one column per metric, so appends are O(1) and a range scan
+// of one metric walks contiguous memory. Samples roll up into 1 s, 10 s
+// and 1 min buckets (min/max/avg/p95) as they arrive; p95 is exact up to
+// kReservoirSize samples per bucket and reservoir-sampled beyond that.
+//
+// The rings live in a single region sized at open(): anonymous memory, or
+// a MAP_SHARED file so history survives an optimizer restart. Memory use
+// never depends on session length.
+class MetricsStore {
+public:
+    enum Tier {
+        Tier1s = 0,
+        Tier10s,
+        Tier1m,
+        kTierCount
+    };
+
+    static constexpr uint32_t kReservoirSize = 128;
+    static constexpr size_t kMaxNameLength = 32;
+
+private:
+    struct Header;
+    struct RollupValue {
+        float min;
+        float max;
+        float avg;
+        float p95;
+    };
+    struct Accumulator {
+        uint32_t count = 0;
+        float min = 0.0f;
+        float max = 0.0f;
+        double sum = 0.0;
+        std::vector<float> reservoir;
+    };
+    struct OpenBucket {
+        bool active = false;
+        uint64_t startMs = 0;
+        uint32_t rows = 0;
+        std::vector<Accumulator> metrics;
+    };
+
+    MetricsStoreOptions options;
+    std::string path;
+    uint8_t* region;
+    size_t regionSize;
+    bool fileBacked;
+    Header* header;
+    uint64_t* rawTimestamps;
+    float* rawValues;                       // [metric][rawCapacity]
+    uint64_t* tierTimestamps[kTierCount];
+    uint32_t* tierCounts[kTierCount];
+    RollupValue* tierValues[kTierCount];    // [metric][capacity]
+    OpenBucket buckets[kTierCount];
+    std::vector<float> scratch;
+    uint64_t randomState;
+    mutable std::mutex mutex;
+
+    size_t layoutSize() const;
+    void mapSections();
+    char* nameSlot(int metric) const;
+    int findLocked(const std::string& name) const;
+    bool headerMatches() const;
+    void initializeHeader();
+    void closeBucket(int tier);
+    uint64_t nextRandom();
+
+public:
+    explicit MetricsStore(const MetricsStoreOptions& storeOptions = MetricsStoreOptions());
+    ~MetricsStore();
+
+    MetricsStore(const MetricsStore&) = delete;
+    MetricsStore& operator=(const MetricsStore&) = delete;
+
+    // Empty path: anonymous memory. Otherwise the file is created or, if
+    // its layout matches, reopened with its history and metric names.
+    bool open(const std::string& filePath = "");
+    void close();
+    bool isOpen() const { return region != nullptr; }
+    void flush();
+
+    int registerMetric(const std::string& name);
+    int findMetric(const std::string& name) const;
+    size_t metricCount() const;
+    std::string metricName(int metric) const;
+
+    // values[i] belongs to metric i; NaN skips a metric for this row.
+    // A timestamp behind the newest row is clamped to it.
+    bool append(uint64_t timestampMs, const float* values, size_t count);
+
+    size_t queryRaw(int metric, uint64_t fromMs, uint64_t toMs, MetricPoint* out, size_t maxPoints) const;
+    size_t queryRollup(Tier tier, int metric, uint64_t fromMs, uint64_t toMs,
+                       RollupPoint* out, size_t maxPoints) const;
+    bool latest(int metric, MetricPoint& out) const;
+
+    uint64_t sampleCount() const;
+    size_t memoryBytes() const { return regionSize; }
+    static uint64_t bucketWidthMs(Tier tier);
+};
+
+#endif // __linux__
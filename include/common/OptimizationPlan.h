@@ -0,0 +1,95 @@
+// include/common/OptimizationPlan.h - Dependency-ordered, idempotent optimization steps
+#pragma once
+
+#include "BaseOptimizer.h"
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Memoized reads of small state files (sysfs attributes, /proc/meminfo)
+// shared by every step of a plan. Entries expire after maxAgeMs and are
+// dropped as soon as a step that may change them has applied.
+class StateCache {
+private:
+    struct Entry {
+        std::string value;
+        bool readable = false;
+        uint64_t readMs = 0;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    uint32_t maxAgeMs;
+    uint64_t hits;
+    uint64_t misses;
+    mutable std::mutex mutex;
+
+public:
+    explicit StateCache(uint32_t maxAgeMs = 1000);
+
+    bool read(const std::string& path, std::string& out);
+    // Drops every entry whose path starts with `prefix`.
+    void invalidate(const std::string& prefix);
+    void clear();
+    uint64_t hitCount() const;
+    uint64_t missCount() const;
+};
+
+// `path` already holds `value` (both compared with whitespace trimmed).
+struct PlanTarget {
+    std::string path;
+    std::string value;
+};
+
+// One idempotent step. It is skipped when it declares targets or a check
+// and all of them already hold; otherwise apply() runs once every step
+// in dependsOn has succeeded (or was skipped as already applied).
+struct PlanStep {
+    std::string name;
+    std::vector<std::string> dependsOn;
+    std::vector<PlanTarget> targets;
+    std::function<bool(StateCache& cache)> isSatisfied;
+    std::function<OptimizationResult()> apply;
+    // Path prefixes apply() may change besides the targets' own paths.
+    std::vector<std::string> invalidates;
+};
+
+struct StepResult {
+    std::string name;
+    OptimizationResult result;
+    bool skipped = false;      // already in the target state
+    bool blocked = false;      // a dependency failed, apply() never ran
+    uint64_t durationUs = 0;   // check plus apply
+};
+
+struct PlanResult {
+    bool success = false;
+    std::vector<StepResult> steps;   // in the order the steps were added
+    size_t applied = 0;
+    size_t skipped = 0;
+    uint64_t elapsedUs = 0;
+};
+
+// Runs steps in dependency order on up to maxParallel threads: a step
+// starts as soon as its last dependency finishes, so a plan of
+// independent steps takes as long as its slowest step, and re-applying
+// a plan whose targets all hold costs one cached read per target.
+class OptimizationPlan {
+private:
+    std::vector<PlanStep> steps;
+
+    bool satisfied(const PlanStep& step, StateCache& cache) const;
+
+public:
+    // False for a duplicate name or a step without apply().
+    bool addStep(PlanStep step);
+    // Unknown dependencies and cycles.
+    bool validate(std::string* error = nullptr) const;
+    PlanResult execute(StateCache& cache, unsigned maxParallel = 4) const;
+
+    size_t size() const { return steps.size(); }
+    void clear() { steps.clear(); }
+};
@@ -0,0 +1,225 @@
+// include/common/PageCachePrewarmer.h - Learned page-cache prewarming for game launches and teleports
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+
+#include "IoPriority.h"
+#include "ProcFs.h"
+
+struct PrewarmExtent {
+    uint64_t offset = 0;           // bytes, page aligned
+    uint64_t length = 0;
+    uint32_t firstSeenMs = 0;      // since the session started; earliest page of the extent
+    uint8_t heat = 0;              // 1..255: share of samples its pages were resident
+};
+
+struct PrewarmFile {
+    std::string path;
+    uint64_t size = 0;             // at learning time; a different size or mtime
+    int64_t mtimeSec = 0;          // means the file was replaced and is skipped
+    std::vector<PrewarmExtent> extents;   // ascending, non-overlapping
+
+    uint64_t bytes() const;
+    uint32_t firstSeenMs() const;
+};
+
+// What a game touched during its first seconds, file by file.
+//
+// On-disk layout (all integers LEB128 varints, strings varint length +
+// bytes, offsets and lengths in pages of pageSize):
+//   header : "RBXPWM1\0" pageShift sessions fileCount
+//   file   : path size mtimeSec extentCount, extentCount x
+//            { gap since the previous extent's end, length, firstSeenMs, heat }
+//   trailer: u32 FNV-1a of everything before it
+// A session of a few hundred extents takes a few kilobytes.
+struct PrewarmProfile {
+    uint32_t sessions = 0;         // learning runs merged into this profile
+    std::vector<PrewarmFile> files;
+
+    uint64_t bytes() const;
+    size_t extentCount() const;
+
+    bool save(const std::string& path, std::string* error = nullptr) const;
+    bool load(const std::string& path, std::string* error = nullptr);
+
+    // Folds an older profile into this one. Pages of both keep the higher
+    // of their new heat and their old heat scaled by `decay`; pages only
+    // the old one had fade the same way and go once under `minHeat`.
+    // Files whose size or mtime changed since are dropped from `older`.
+    void merge(const PrewarmProfile& older, double decay = 0.5, uint8_t minHeat = 16, uint32_t gapPages = 8);
+};
+
+// Learns a PrewarmProfile by sampling page-cache residency of every file
+// the game maps (and, optionally, holds open) with mincore() over our own
+// PROT_READ mapping of the file. Each sample marks the resident pages;
+// finish() turns pages into extents, bridging holes of up to gapPages so
+// prewarming issues few, long reads.
+//
+// mincore() shows residency, not access, so attach() takes a baseline:
+// pages of the files the game already has open or mapped, and of the
+// files in `known` (the profile being relearned), that are resident at
+// attach() are ignored until they have been seen evicted. Files the game
+// opens later and that were never learned have no baseline; what of them
+// was cached beforehand counts as touched, and merging sessions with
+// decay weeds out the pages that never come back. Since Linux 5.2
+// mincore() only reports the page cache of files we own or may write (or
+// as root); other files are skipped and counted in unreadableFiles().
+//
+// attach() and sample() may be called from any thread; calls are
+// serialised internally.
+class PrewarmRecorder {
+public:
+    struct Options {
+        uint32_t learnMs = 30000;
+        uint32_t gapPages = 8;
+        uint32_t maxFiles = 256;
+        uint64_t maxFileBytes = 1ull << 30;    // larger files are tracked up to this size
+        bool openFiles = true;                 // also files read through descriptors
+        // Shared system files are resident anyway and not ours to warm.
+        std::vector<std::string> excludePrefixes{"/dev/", "/proc/", "/sys/", "/system/", "/apex/", "/vendor/",
+                                                 "/product/"};
+    };
+
+private:
+    struct TrackedFile {
+        std::string path;
+        uint64_t size = 0;
+        int64_t mtimeSec = 0;
+        void* map = nullptr;
+        uint64_t mapped = 0;
+        std::vector<uint16_t> hits;            // samples each page was resident
+        std::vector<uint32_t> firstSeenMs;     // UINT32_MAX: never
+        std::vector<bool> warm;                // resident at attach() and not evicted since
+
+        ~TrackedFile();
+    };
+
+    std::string root;
+    Options options;
+    pid_t targetPid;
+    uint64_t startMs;
+    uint32_t samples;
+    ProcFile mapsFile;
+    std::unordered_map<std::string, std::unique_ptr<TrackedFile>> files;
+    std::unordered_set<std::string> rejected;          // paths looked at and not tracked
+    uint32_t unreadable;
+    std::vector<unsigned char> residency;             // mincore() scratch
+    mutable std::mutex mutex;
+
+    bool excluded(const std::string& path) const;
+    void track(const std::string& path);
+    void collectMapped(std::vector<std::string>& paths);
+    void collectOpen(std::vector<std::string>& paths);
+    void clearLocked();
+
+public:
+    explicit PrewarmRecorder(const std::string& rootPrefix = "");
+    ~PrewarmRecorder();
+
+    PrewarmRecorder(const PrewarmRecorder&) = delete;
+    PrewarmRecorder& operator=(const PrewarmRecorder&) = delete;
+
+    // Takes effect on the next attach().
+    void setOptions(const Options& newOptions);
+    const Options& getOptions() const { return options; }
+
+    // Call as the game starts, before it has read much.
+    bool attach(pid_t pid, uint64_t nowMs, const PrewarmProfile* known = nullptr);
+    void detach();
+    pid_t pid() const;
+    // Call every few hundred ms with EventLoop::nowMs(). False once
+    // learnMs has passed (or when not attached): time to finish().
+    bool sample(uint64_t nowMs);
+    // Summarises what was learned and detaches. Empty without samples.
+    PrewarmProfile finish();
+
+    size_t trackedFiles() const;
+    uint32_t unreadableFiles() const;
+};
+
+struct PrewarmOptions {
+    unsigned threads = 4;
+    uint64_t maxBytes = 512ull << 20;  // read budget, earliest-needed extents first
+    uint8_t minHeat = 0;
+    bool fadvise = false;              // posix_fadvise(WILLNEED) instead of readahead(2)
+    // mlock() budget for the hottest extents, kept until unlock(); needs
+    // CAP_IPC_LOCK or a matching RLIMIT_MEMLOCK.
+    uint64_t lockBytes = 0;
+    IoPriority priority;               // class the reads run at; None inherits
+};
+
+struct PrewarmResult {
+    bool success = false;
+    std::string error;
+    size_t files = 0;
+    size_t staleFiles = 0;             // replaced since learning
+    size_t missingFiles = 0;
+    size_t extents = 0;
+    uint64_t bytesRequested = 0;
+    uint64_t bytesLocked = 0;
+    uint64_t failures = 0;             // readahead or mlock calls that failed
+    uint64_t elapsedMs = 0;            // until every read was issued and locks taken
+};
+
+struct PrewarmResidency {
+    struct File {
+        std::string path;
+        uint64_t profileBytes = 0;
+        uint64_t residentBytes = 0;    // of the profile's extents
+        bool present = false;          // exists and matches the profile
+    };
+    std::vector<File> files;
+    uint64_t profileBytes = 0;
+    uint64_t residentBytes = 0;
+
+    double residentPercent() const { return profileBytes ? 100.0 * residentBytes / profileBytes : 0.0; }
+};
+
+// Replays a profile into the page cache: every extent of every file still
+// matching the profile is handed to readahead(2) by a few threads, in
+// order of first use, so the extents the game needs first are queued
+// first and the device sees several streams at once. Reads are issued,
+// not waited for; residency() shows how far they got.
+class PageCachePrewarmer {
+private:
+    struct LockedRange {
+        void* address = nullptr;
+        size_t length = 0;
+    };
+
+    std::vector<LockedRange> locked;
+    uint64_t lockedBytes;
+    mutable std::mutex mutex;
+
+    void lockHottest(const PrewarmProfile& profile, const std::vector<int>& fds, const PrewarmOptions& options,
+                     PrewarmResult& result);
+
+public:
+    PageCachePrewarmer();
+    ~PageCachePrewarmer();
+
+    PageCachePrewarmer(const PageCachePrewarmer&) = delete;
+    PageCachePrewarmer& operator=(const PageCachePrewarmer&) = delete;
+
+    // Blocks until every read is issued. Ranges locked by an earlier call
+    // stay locked; the budget covers both.
+    PrewarmResult warm(const PrewarmProfile& profile, const PrewarmOptions& options);
+    void unlock();
+    uint64_t getLockedBytes() const;
+
+    // Share of the profile's extents resident right now.
+    static PrewarmResidency residency(const PrewarmProfile& profile);
+    // Drops the profile's files from the page cache (clean pages only), to
+    // measure a cold launch. Returns the number of files evicted.
+    static size_t evict(const PrewarmProfile& profile);
+};
+
+#endif // __linux__
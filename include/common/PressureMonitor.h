@@ -0,0 +1,157 @@
+// include/common/PressureMonitor.h - PSI-triggered pressure monitor
+#pragma once
+#if defined(__linux__)
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EventLoop.h"
+#include "ProcFs.h"
+
+enum class PressureResource {
+    Memory,
+    Cpu,
+    Io
+};
+
+enum class PressureLevel {
+    None,
+    Low,
+    Medium,
+    Critical
+};
+
+// One PSI trigger: raise `level` when tasks stall for `stallUs` (some =
+// at least one task, full = all non-idle tasks) within `windowUs`.
+struct PressureTrigger {
+    PressureResource resource = PressureResource::Memory;
+    bool full = false;
+    uint32_t stallUs = 0;
+    uint32_t windowUs = 1000000;
+    PressureLevel level = PressureLevel::Medium;
+};
+
+// /proc/pressure/<resource> averages (percent) and totals (us).
+struct PressureStats {
+    double someAvg10 = 0.0;
+    double someAvg60 = 0.0;
+    double someAvg300 = 0.0;
+    uint64_t someTotal = 0;
+    double fullAvg10 = 0.0;
+    double fullAvg60 = 0.0;
+    double fullAvg300 = 0.0;
+    uint64_t fullTotal = 0;
+};
+
+struct PressureEvent {
+    uint64_t timestampMs = 0;
+    PressureResource resource = PressureResource::Memory;
+    PressureLevel level = PressureLevel::None;
+    bool fromPsi = false;                // false: meminfo fallback
+    PressureStats stats;                 // PSI averages at the time of the event
+    double memAvailablePercent = -1.0;   // filled by the fallback sampler
+};
+
+// Registers PSI triggers and blocks in epoll until one fires, so the idle
+// cost is one sleeping thread (or one fd on an EventLoop) and the
+// reaction time is the kernel's (tens of ms). Kernels without PSI, or without permission to create
+// triggers, fall back to sampling /proc/meminfo at a rate that speeds up
+// as available memory falls and relaxes when it is plentiful.
+class PressureMonitor {
+public:
+    using Callback = std::function<void(const PressureEvent& event)>;
+
+    enum class Mode {
+        Stopped,
+        Psi,
+        MeminfoFallback
+    };
+
+    struct FallbackThresholds {
+        double lowPercent = 20.0;        // MemAvailable % at or below which
+        double mediumPercent = 10.0;     // each level is raised
+        double criticalPercent = 5.0;
+        uint32_t minIntervalMs = 50;
+        uint32_t maxIntervalMs = 2000;
+    };
+
+private:
+    struct ArmedTrigger {
+        PressureTrigger trigger;
+        int fd = -1;
+    };
+
+    struct FallbackState {
+        uint32_t intervalMs = 250;
+        double previousPercent = -1.0;
+        PressureLevel previousLevel = PressureLevel::None;
+    };
+
+    std::string root;
+    std::vector<PressureTrigger> triggers;
+    std::vector<ArmedTrigger> armed;
+    FallbackThresholds fallback;
+    Callback callback;
+    std::atomic<Mode> mode;
+    // Per resource and level: until when (monotonic ms) the level holds.
+    std::atomic<uint64_t> levelExpiryMs[3][4];
+    std::atomic<uint64_t> eventCount;
+    int epollFd;
+    int wakeFd;
+    std::thread worker;
+    std::mutex mutex;
+    ProcFsReader fallbackReader;
+    FallbackState fallbackState;
+    EventLoop* eventLoop;
+    EventLoop::TaskId loopTask;
+
+    bool armTriggers();
+    void disarmTriggers();
+    void handleTrigger(uint32_t index, uint32_t events);
+    // One meminfo sample; returns the delay until the next one.
+    uint32_t sampleFallback();
+    void runPsi();
+    void runFallback();
+    void emit(PressureEvent& event);
+
+public:
+    explicit PressureMonitor(const std::string& rootPrefix = "");
+    ~PressureMonitor();
+
+    PressureMonitor(const PressureMonitor&) = delete;
+    PressureMonitor& operator=(const PressureMonitor&) = delete;
+
+    // Replaces the default trigger set (memory some/full, cpu, io).
+    void setTriggers(const std::vector<PressureTrigger>& values);
+    void setFallbackThresholds(const FallbackThresholds& values) { fallback = values; }
+    void setCallback(Callback eventCallback);
+
+    bool start(bool allowPsi = true);
+    // Same, with the trigger fds (or the meminfo timer) on `loop`
+    // instead of a thread of its own; callbacks then run on the loop.
+    bool start(EventLoop& loop, bool allowPsi = true);
+    void stop();
+    bool isRunning() const { return mode.load() != Mode::Stopped; }
+    Mode getMode() const { return mode.load(); }
+
+    // Highest level raised for `resource` within its trigger window.
+    PressureLevel getLevel(PressureResource resource) const;
+    uint64_t getEventCount() const { return eventCount.load(); }
+
+    bool readStats(PressureResource resource, PressureStats& out) const;
+    static bool parseStats(const std::string& text, PressureStats& out);
+    static std::vector<PressureTrigger> defaultTriggers();
+    // The level `triggers` would most likely have raised, judged from the
+    // avg10 averages; for offline replays where no trigger can fire.
+    static PressureLevel estimateLevel(PressureResource resource, const PressureStats& stats,
+                                       const std::vector<PressureTrigger>& triggers);
+    static const char* resourceName(PressureResource resource);
+    static const char* levelName(PressureLevel level);
+};
+
+#endif // __linux__
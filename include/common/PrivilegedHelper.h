@@ -0,0 +1,94 @@
+// include/common/PrivilegedHelper.h - Persistent privileged command helper
+#pragma once
+#if defined(__linux__)
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+struct HelperCommand {
+    enum class Type {
+        WriteFile,      // target = path, value = contents
+        PutSetting,     // target = "namespace/key", value = setting value
+        SetPriority,    // pid, priority (nice value)
+        SetIoPriority,  // pid = tid, priority = raw ioprio value (class << 13 | level)
+        Sync,
+        Shell           // value = raw shell command
+    };
+
+    Type type = Type::Shell;
+    std::string target;
+    std::string value;
+    pid_t pid = 0;
+    int priority = 0;
+
+    static HelperCommand writeFile(const std::string& path, const std::string& contents);
+    static HelperCommand putSetting(const std::string& nameSpace, const std::string& key, const std::string& value);
+    static HelperCommand setPriority(pid_t pid, int nice);
+    static HelperCommand setIoPriority(pid_t tid, int ioprio);
+    static HelperCommand sync();
+    static HelperCommand shell(const std::string& command);
+};
+
+struct HelperResult {
+    bool success = false;
+    int exitCode = -1;
+    bool inProcess = false;    // handled without the helper shell
+    std::string output;
+};
+
+// One long-lived shell, started once (through su when not already root),
+// that runs batches of typed commands and reports a result per command.
+// Commands that can be done directly from this process (sysfs writes we
+// have permission for, setpriority, sync) never reach the shell.
+class PrivilegedHelper {
+public:
+    enum class RootState {
+        Unknown,
+        Root,
+        NoRoot
+    };
+
+private:
+    pid_t childPid;
+    int channel;                       // socketpair end: child's stdin/stdout
+    std::string readBuffer;
+    std::atomic<RootState> rootState;
+    uint64_t batchCounter;
+    std::mutex mutex;
+
+    PrivilegedHelper();
+
+    bool startLocked();
+    void stopLocked();
+    bool spawn(const char* shell, bool viaSu);
+    bool writeAll(const std::string& data);
+    bool readLine(std::string& line, int timeoutMs);
+    bool tryInProcess(const HelperCommand& command, HelperResult& result);
+    std::string toShell(const HelperCommand& command) const;
+
+public:
+    static PrivilegedHelper* getInstance();
+    ~PrivilegedHelper();
+
+    bool start();
+    void stop();
+    bool isRunning();
+
+    // Cached after the first probe; never forks again once known.
+    bool hasRoot();
+    RootState getRootState() const { return rootState.load(std::memory_order_acquire); }
+
+    // Runs every command, in order, in a single round trip to the helper.
+    std::vector<HelperResult> execute(const std::vector<HelperCommand>& commands);
+    HelperResult execute(const HelperCommand& command);
+
+    static std::string shellQuote(const std::string& text);
+
+    PrivilegedHelper(const PrivilegedHelper&) = delete;
+    void operator=(const PrivilegedHelper&) = delete;
+};
+
+#endif // __linux__
@@ -0,0 +1,256 @@
+// include/common/ProcFs.h - Zero-allocation procfs/sysfs readers and parsers
+#pragma once
+#if defined(__linux__)
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+
+// Upper bound on CPUs tracked in a single /proc/stat or cpufreq snapshot.
+// Phones top out at 8-12 cores; the host build uses the same fixed arrays.
+constexpr int kMaxTrackedCpus = 64;
+
+struct MemInfo {
+    // All values in bytes (procfs reports kB, converted on parse)
+    uint64_t memTotal = 0;
+    uint64_t memFree = 0;
+    uint64_t memAvailable = 0;
+    uint64_t buffers = 0;
+    uint64_t cached = 0;
+    uint64_t swapCached = 0;
+    uint64_t active = 0;
+    uint64_t inactive = 0;
+    uint64_t activeFile = 0;
+    uint64_t inactiveFile = 0;
+    uint64_t swapTotal = 0;
+    uint64_t swapFree = 0;
+    uint64_t dirty = 0;
+    uint64_t shmem = 0;
+    uint64_t sReclaimable = 0;
+};
+
+struct CpuTimes {
+    // Jiffies (USER_HZ) as reported by /proc/stat
+    uint64_t user = 0;
+    uint64_t nice = 0;
+    uint64_t system = 0;
+    uint64_t idle = 0;
+    uint64_t iowait = 0;
+    uint64_t irq = 0;
+    uint64_t softirq = 0;
+    uint64_t steal = 0;
+
+    uint64_t busy() const { return user + nice + system + irq + softirq + steal; }
+    uint64_t total() const { return busy() + idle + iowait; }
+};
+
+struct CpuStat {
+    CpuTimes aggregate;
+    CpuTimes perCpu[kMaxTrackedCpus];
+    int cpuCount = 0;
+    uint64_t contextSwitches = 0;
+    uint64_t processesCreated = 0;
+    uint32_t procsRunning = 0;
+    uint32_t procsBlocked = 0;
+};
+
+// /proc/<pid>/stat and /proc/<pid>/task/<tid>/stat
+struct TaskStat {
+    int32_t pid = 0;
+    char comm[16] = {};          // TASK_COMM_LEN, NUL terminated
+    char state = '?';
+    int32_t ppid = 0;
+    uint64_t minorFaults = 0;
+    uint64_t majorFaults = 0;
+    uint64_t utime = 0;          // clock ticks
+    uint64_t stime = 0;          // clock ticks
+    int32_t priority = 0;
+    int32_t nice = 0;
+    int32_t numThreads = 0;
+    uint64_t startTime = 0;      // clock ticks since boot
+    uint64_t vsize = 0;          // bytes
+    uint64_t rssPages = 0;
+    int32_t processor = -1;      // CPU last run on
+};
+
+// /proc/<pid>/status (memory fields in bytes)
+struct TaskStatus {
+    char name[16] = {};
+    int32_t tgid = 0;
+    int32_t ppid = 0;
+    uint32_t uid = 0;
+    uint64_t vmRss = 0;
+    uint64_t vmHwm = 0;
+    uint64_t rssAnon = 0;
+    uint64_t rssFile = 0;
+    uint64_t rssShmem = 0;
+    uint64_t vmSwap = 0;
+    int32_t threads = 0;
+    uint64_t voluntaryCtxtSwitches = 0;
+    uint64_t nonvoluntaryCtxtSwitches = 0;
+};
+
+// /proc/<pid>/statm (pages)
+struct TaskStatm {
+    uint64_t sizePages = 0;
+    uint64_t residentPages = 0;
+    uint64_t sharedPages = 0;    // file-backed + shmem resident pages
+    uint64_t textPages = 0;
+    uint64_t dataPages = 0;
+};
+
+// /proc/<pid>/schedstat and /proc/<pid>/task/<tid>/schedstat
+struct TaskSchedstat {
+    uint64_t runNs = 0;          // time spent on a CPU
+    uint64_t waitNs = 0;         // time runnable but waiting on a runqueue
+    uint64_t timeslices = 0;     // times scheduled in (one per wakeup or preemption)
+};
+
+// /proc/<pid>/smaps_rollup (bytes): every mapping of the process summed
+// by the kernel in one pass. The Pss_* split needs Linux 5.7; on older
+// kernels those fields stay 0.
+struct SmapsRollup {
+    uint64_t rss = 0;
+    uint64_t pss = 0;
+    uint64_t pssAnon = 0;
+    uint64_t pssFile = 0;
+    uint64_t pssShmem = 0;
+    uint64_t sharedClean = 0;
+    uint64_t sharedDirty = 0;
+    uint64_t privateClean = 0;
+    uint64_t privateDirty = 0;
+    uint64_t anonymous = 0;
+    uint64_t swap = 0;
+    uint64_t swapPss = 0;
+    uint64_t locked = 0;
+};
+
+// /sys/devices/system/cpu/cpuN/cpufreq/* (frequencies in kHz)
+struct CpuFreqInfo {
+    bool online = false;
+    uint32_t curFreq = 0;
+    uint32_t minFreq = 0;
+    uint32_t maxFreq = 0;
+    uint32_t cpuinfoMinFreq = 0;
+    uint32_t cpuinfoMaxFreq = 0;
+    char governor[32] = {};
+};
+
+struct SystemSnapshot {
+    uint64_t timestampNs = 0;    // CLOCK_MONOTONIC at the start of the pass
+    MemInfo memory;
+    CpuStat cpu;
+    CpuFreqInfo freq[kMaxTrackedCpus];
+    int freqCount = 0;
+};
+
+// A procfs/sysfs file kept open for its whole lifetime and re-read with
+// pread() into a buffer that only grows, so steady-state sampling performs
+// no heap allocation and no open()/close() pair per sample.
+class ProcFile {
+private:
+    int fd;
+    std::vector<char> buffer;
+
+public:
+    ProcFile();
+    explicit ProcFile(const std::string& path, size_t initialCapacity = 4096);
+    ~ProcFile();
+
+    ProcFile(ProcFile&& other) noexcept;
+    ProcFile& operator=(ProcFile&& other) noexcept;
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    bool open(const std::string& path, size_t initialCapacity = 4096);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    int descriptor() const { return fd; }
+
+    // Returns the whole file contents; the view stays valid until the next
+    // read() or close(). Returns an empty view on error.
+    std::string_view read();
+};
+
+// Stateless parsers over string_view input. All return false if the input
+// is malformed or a mandatory field is missing.
+class ProcParser {
+public:
+    static bool parseUnsigned(std::string_view text, uint64_t& value);
+    static bool parseSigned(std::string_view text, int64_t& value);
+
+    static bool parseMemInfo(std::string_view text, MemInfo& out);
+    static bool parseCpuStat(std::string_view text, CpuStat& out);
+    static bool parseTaskStat(std::string_view text, TaskStat& out);
+    static bool parseTaskStatus(std::string_view text, TaskStatus& out);
+    static bool parseTaskStatm(std::string_view text, TaskStatm& out);
+    static bool parseSchedstat(std::string_view text, TaskSchedstat& out);
+    static bool parseSmapsRollup(std::string_view text, SmapsRollup& out);
+
+    // Single-value sysfs files ("1804800\n", "schedutil\n")
+    static bool parseSysfsUnsigned(std::string_view text, uint64_t& value);
+    static std::string_view trimLine(std::string_view text);
+};
+
+// Keeps every system-wide file open and fills a SystemSnapshot in one pass.
+// `root` prefixes every path so the reader can run against a fake tree.
+class ProcFsReader {
+private:
+    struct CpuFreqFiles {
+        ProcFile cur;
+        ProcFile min;
+        ProcFile max;
+        ProcFile infoMin;
+        ProcFile infoMax;
+        ProcFile governor;
+    };
+
+    std::string root;
+    ProcFile memInfoFile;
+    ProcFile statFile;
+    std::vector<CpuFreqFiles> cpuFreqFiles;
+    bool cpuFreqProbed;
+    std::vector<ProcFile> thermalFiles;
+    bool thermalProbed;
+
+    void probeCpuFreq();
+    void probeThermal();
+
+public:
+    explicit ProcFsReader(const std::string& rootPrefix = "");
+
+    bool readMemInfo(MemInfo& out);
+    bool readCpuStat(CpuStat& out);
+    bool readCpuFreq(int cpu, CpuFreqInfo& out);
+    int cpuFreqCount();
+    // Hottest /sys/class/thermal zone, skipping battery/charger sensors.
+    bool readMaxThermal(int32_t& milliCelsius);
+    int thermalZoneCount();
+
+    bool readSnapshot(SystemSnapshot& out);
+    const std::string& rootPrefix() const { return root; }
+};
+
+// Per-process reader; opens /proc/<pid>/{stat,status} once and re-reads them.
+class ProcessStatReader {
+private:
+    pid_t pid;
+    ProcFile statFile;
+    ProcFile statusFile;
+
+public:
+    ProcessStatReader();
+    explicit ProcessStatReader(pid_t processId, const std::string& rootPrefix = "");
+
+    bool attach(pid_t processId, const std::string& rootPrefix = "");
+    void detach();
+    pid_t processId() const { return pid; }
+    bool isAttached() const { return pid > 0 && statFile.isOpen(); }
+
+    bool readStat(TaskStat& out);
+    bool readStatus(TaskStatus& out);
+};
+
+#endif // __linux__
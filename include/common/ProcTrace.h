@@ -0,0 +1,130 @@
+// include/common/ProcTrace.h - Record/replay of procfs/sysfs inputs
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "ProcFs.h"
+
+// Trace layout (host byte order; the header records it):
+//   header : "RBXTRC1\0" u32 byteOrderMark
+//   'P'    : path id, path                       (first use of a path)
+//   'F'    : timestamp delta ms, game pid        (starts a frame)
+//   'R'    : path id, content                    (full contents)
+//   'D'    : path id, line count, count x { line delta, prefix, suffix, middle }
+//   'X'    : path id                             (file went away)
+//   'E'    :                                     (ends the frame)
+// Integers are LEB128 varints, strings are varint length + bytes. A 'D'
+// record rewrites only the changed lines of a file, keeping each line's
+// common prefix and suffix, so a counter that ticked costs a few bytes.
+class TraceRecorder {
+private:
+    struct Source {
+        uint32_t id = 0;
+        ProcFile file;
+        std::string content;
+        bool present = false;
+        bool seen = false;      // still listed this frame (task files)
+    };
+
+    std::string root;
+    FILE* out;
+    std::map<std::string, std::unique_ptr<Source>> sources;   // keyed by path without root
+    uint32_t nextId;
+    uint64_t lastTimestampMs;
+    pid_t gamePid;
+    uint64_t frames;
+    uint64_t bytesWritten;
+    std::string frameBuffer;
+
+    void addSource(const std::string& path);
+    void discoverStatic();
+    void refreshTaskSources();
+    void captureSource(const std::string& path, Source& source);
+
+public:
+    explicit TraceRecorder(const std::string& rootPrefix = "");
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    bool open(const std::string& tracePath);
+    void close();
+    bool isOpen() const { return out != nullptr; }
+
+    // Per-task files of this pid are captured too (0: none).
+    void setGamePid(pid_t pid);
+    // Reads every source and writes the ones that changed as one frame.
+    bool capture(uint64_t timestampMs);
+
+    uint64_t frameCount() const { return frames; }
+    uint64_t bytesRecorded() const { return bytesWritten; }
+};
+
+struct TraceFrame {
+    uint64_t timestampMs = 0;
+    int32_t gamePid = 0;
+    std::vector<uint32_t> changed;   // path ids written this frame
+    std::vector<uint32_t> removed;
+};
+
+class TraceReader {
+private:
+    FILE* in;
+    std::vector<std::string> paths;
+    std::vector<std::string> contents;
+    std::vector<bool> present;
+    uint64_t timestampMs;
+    bool corrupt;
+
+    bool readVarint(uint64_t& value);
+    bool readString(std::string& value);
+    bool applyDelta(uint32_t id);
+
+public:
+    TraceReader();
+    ~TraceReader();
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    bool open(const std::string& tracePath);
+    void close();
+
+    // False at the end of the trace or on a malformed record.
+    bool next(TraceFrame& frame);
+    bool isCorrupt() const { return corrupt; }
+
+    size_t pathCount() const { return paths.size(); }
+    const std::string& path(uint32_t id) const { return paths[id]; }
+    const std::string& content(uint32_t id) const { return contents[id]; }
+    bool isPresent(uint32_t id) const { return id < present.size() && present[id]; }
+};
+
+// Writes each frame of a trace into a directory tree, so the regular
+// root-prefixed readers (ProcFsReader, CpuTopology, ...) see the device
+// exactly as it was recorded. No pacing: frames apply as fast as asked.
+class TraceReplayer {
+private:
+    TraceReader reader;
+    std::string root;
+
+    bool writeFile(const std::string& path, const std::string& content);
+
+public:
+    explicit TraceReplayer(const std::string& rootDir);
+
+    bool open(const std::string& tracePath) { return reader.open(tracePath); }
+    bool step(TraceFrame& frame);
+    const std::string& rootPrefix() const { return root; }
+    const TraceReader& getReader() const { return reader; }
+};
+
+#endif // __linux__
@@ -0,0 +1,95 @@
+// include/common/ProcessWatcher.h - Event-driven process discovery
+#pragma once
+#if defined(__linux__)
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+
+#include "EventLoop.h"
+
+// Watches for processes whose comm or argv[0] matches a target set.
+//
+// Primary source is the netlink proc connector (cn_proc), which reports
+// fork/exec/comm/exit events as they happen; this needs CAP_NET_ADMIN.
+// Without it the watcher falls back to an incremental /proc scan that only
+// inspects PIDs it has not classified before.
+class ProcessWatcher {
+public:
+    enum class Mode {
+        Stopped,
+        Netlink,
+        ProcScan
+    };
+
+    using StartCallback = std::function<void(pid_t pid, const std::string& name)>;
+    using ExitCallback = std::function<void(pid_t pid)>;
+
+private:
+    std::vector<std::string> targets;
+    StartCallback onStart;
+    ExitCallback onExit;
+
+    std::atomic<Mode> mode;
+    std::atomic<bool> running;
+    int netlinkFd;
+    int wakePipe[2];
+    int scanIntervalMs;
+    std::thread worker;
+    EventLoop* eventLoop;
+    EventLoop::TaskId loopTask;
+
+    // PIDs currently matched, and everything already classified by the scan
+    mutable std::mutex stateMutex;
+    std::unordered_map<pid_t, std::string> matched;
+    std::unordered_set<pid_t> classified;
+    std::mutex scanMutex;
+    std::vector<pid_t> presentPids;
+    std::string root;
+
+    bool openNetlink();
+    void closeNetlink();
+    void run();
+    void drainNetlink();
+    void handleCandidate(pid_t pid, bool reclassify);
+    void handleExit(pid_t pid);
+    bool matchProcess(pid_t pid, std::string& name, bool& provisional) const;
+
+public:
+    explicit ProcessWatcher(const std::string& rootPrefix = "");
+    ~ProcessWatcher();
+
+    ProcessWatcher(const ProcessWatcher&) = delete;
+    ProcessWatcher& operator=(const ProcessWatcher&) = delete;
+
+    // Call before start()
+    void addTarget(const std::string& name);
+    void setCallbacks(StartCallback started, ExitCallback exited);
+    void setScanInterval(int intervalMs) { scanIntervalMs = intervalMs; }
+
+    // Performs one full scan for already-running targets, then watches for
+    // changes on a background thread. Returns false if already running.
+    bool start(bool allowNetlink = true);
+    // Same, with the socket (or the scan timer) on `loop` instead of a
+    // thread of its own.
+    bool start(EventLoop& loop, bool allowNetlink = true);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    Mode getMode() const { return mode.load(std::memory_order_acquire); }
+
+    // Incremental /proc scan; safe to call from any thread.
+    void scanOnce();
+    // Netlink socket for external event loops (-1 in ProcScan mode)
+    int eventFd() const { return netlinkFd; }
+
+    std::vector<pid_t> matchedPids() const;
+    bool isMatched(pid_t pid) const;
+};
+
+#endif // __linux__
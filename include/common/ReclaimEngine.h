@@ -0,0 +1,132 @@
+// include/common/ReclaimEngine.h - Proactive reclaim of background processes
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+
+#include "MemoryAccountant.h"
+#include "ProcFs.h"
+
+enum class ReclaimMethod {
+    None,
+    CgroupReclaim,      // cgroup v2 memory.reclaim of a single-process cgroup
+    ProcessMadvise      // process_madvise(MADV_PAGEOUT) over the process' mappings
+};
+
+struct ReclaimCandidate {
+    pid_t pid = 0;
+    std::string name;
+    int32_t oomScoreAdj = 0;
+    uint64_t rss = 0;
+    uint64_t idleMs = 0;
+    double score = 0.0;
+};
+
+struct ReclaimTickResult {
+    int processes = 0;                  // processes reclaimed from this tick
+    uint64_t bytesRequested = 0;
+    uint64_t bytesReclaimed = 0;        // RSS drop of the reclaimed processes
+    uint64_t elapsedUs = 0;
+    double memAvailablePercent = 0.0;   // after the tick
+    bool targetMet = false;
+};
+
+struct ReclaimStats {
+    uint64_t ticks = 0;
+    uint64_t processesReclaimed = 0;
+    uint64_t bytesReclaimed = 0;
+    uint64_t cgroupReclaims = 0;
+    uint64_t madviseCalls = 0;
+    uint64_t failures = 0;
+};
+
+// Pages out memory of background processes before lowmemorykiller has to
+// kill them. Candidates come from a MemoryAccountant and are ranked by
+// oom_score_adj (Android's own LRU: cached apps sit at 900+), idle time
+// and RSS; the game and anything below minOomScoreAdj or minUid is never
+// touched. Each tick reclaims from at most maxProcessesPerTick processes,
+// maxBytesPerTick bytes (of measured RSS drop) and maxTickMs of wall time
+// - MADV_PAGEOUT and memory.reclaim reclaim synchronously in the caller -
+// and stops as soon as MemAvailable reaches the target.
+//
+// A process alone in its cgroup (Android's uid_N/pid_M) is reclaimed via
+// memory.reclaim; everything else through process_madvise, which needs
+// Linux 5.10 and CAP_SYS_NICE over the target. `root` only prefixes the
+// files read; reclaim itself always acts on live pids.
+class ReclaimEngine {
+public:
+    struct Options {
+        int32_t minOomScoreAdj = 700;        // previous app and cached apps
+        uint32_t minUid = 10000;             // first Android app uid
+        uint64_t minRssBytes = 16ull << 20;
+        uint64_t maxBytesPerTick = 64ull << 20;
+        uint32_t maxProcessesPerTick = 2;
+        uint32_t maxTickMs = 20;
+        uint32_t cooldownMs = 60000;         // per process, unless it regrew
+        double regrowPercent = 20.0;
+        double targetAvailablePercent = 20.0;
+        bool allowHelper = false;            // memory.reclaim writes through PrivilegedHelper
+    };
+
+private:
+    struct History {
+        uint64_t startTime = 0;
+        uint64_t reclaimedMs = 0;
+        uint64_t rssAfter = 0;
+    };
+
+    MemoryAccountant& accountant;
+    std::string root;
+    Options options;
+    pid_t protectedPid;
+    std::string protectedCgroup;
+    std::unordered_set<pid_t> excludedPids;
+    ProcFsReader meminfoReader;
+    ProcFile scratchFile;
+    uint64_t pageSize;
+    bool madviseUnavailable;
+    bool cgroupReclaimUnavailable;
+    ReclaimStats stats;
+    std::unordered_map<pid_t, History> history;
+    mutable std::mutex mutex;
+
+    bool readAvailablePercent(double& percent);
+    bool readResident(pid_t pid, uint64_t& bytes);
+    std::string cgroupOf(pid_t pid);
+    bool soleMember(const std::string& cgroup, pid_t pid);
+    bool reclaimCgroup(const std::string& cgroup, uint64_t bytes);
+    bool pageOut(pid_t pid, uint64_t maxBytes, uint64_t deadlineNs);
+    bool reclaimLocked(pid_t pid, uint64_t maxBytes, uint64_t deadlineNs, uint64_t& reclaimed, ReclaimMethod& used);
+
+public:
+    explicit ReclaimEngine(MemoryAccountant& memoryAccountant, const std::string& rootPrefix = "");
+
+    ReclaimEngine(const ReclaimEngine&) = delete;
+    ReclaimEngine& operator=(const ReclaimEngine&) = delete;
+
+    void setOptions(const Options& newOptions);
+    // Never reclaimed, nor is any cgroup containing it (0: none).
+    void setProtectedPid(pid_t pid);
+    // Never reclaimed either, their cgroups aside: other game instances.
+    void setExcludedPids(const std::vector<pid_t>& pids);
+
+    // Eligible processes from the accountant's last pass, best first.
+    std::vector<ReclaimCandidate> rankCandidates(uint64_t nowMs);
+    ReclaimTickResult tick(uint64_t nowMs);
+    // Reclaims one process regardless of ranking and cooldown.
+    bool reclaimProcess(pid_t pid, uint64_t maxBytes, uint64_t& reclaimed, ReclaimMethod* used = nullptr);
+
+    ReclaimStats getStats() const;
+    bool isAvailable() const;
+
+    static double score(const ProcessMemory& memory, uint64_t nowMs);
+    static const char* methodName(ReclaimMethod method);
+};
+
+#endif // __linux__
@@ -0,0 +1,181 @@
+// include/common/RunqueueLatency.h - Run-queue delay histograms for a process's threads
+#pragma once
+#if defined(__linux__)
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "ProcFs.h"
+
+// Log-linear histogram of microsecond values, laid out like
+// SelfProfiler's: each power of two is split into 2^resolutionBits linear
+// buckets, so quantiles are within 2^-resolutionBits of the true value.
+// Not thread-safe; RunqueueProbe publishes copies.
+class LatencyHistogram {
+public:
+    static constexpr uint32_t kMaxResolutionBits = 6;
+    static constexpr uint32_t kMaxExponent = 24;          // 2^24 us ~ 17 s; larger values clamp
+
+private:
+    uint32_t bits;
+    std::vector<uint64_t> buckets;
+    uint64_t total;
+    uint64_t maxUs;
+    double sumUs;
+
+public:
+    explicit LatencyHistogram(uint32_t resolutionBits = 3);
+
+    void record(uint64_t valueUs, uint64_t count = 1);
+    // Both histograms must have the same resolution.
+    bool merge(const LatencyHistogram& other);
+    void clear();
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return maxUs; }
+    double mean() const { return total ? sumUs / total : 0.0; }
+    // Bucket midpoint, never past max().
+    uint64_t quantile(double fraction) const;
+
+    uint32_t resolutionBits() const { return bits; }
+    size_t bucketCount() const { return buckets.size(); }
+    uint64_t bucketValue(size_t index) const { return buckets[index]; }
+    uint32_t bucketIndex(uint64_t valueUs) const;
+    uint64_t bucketLowerBound(size_t index) const;
+};
+
+struct RunqueueStats {
+    int32_t tid = 0;               // 0 for the whole process
+    char comm[16] = {};
+    uint64_t events = 0;           // times scheduled in
+    double runMs = 0.0;
+    double waitMs = 0.0;           // runnable but not running
+    double waitShare = 0.0;        // waitMs / (runMs + waitMs)
+    double meanUs = 0.0;           // delay per scheduling event
+    double p50Us = 0.0;
+    double p90Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+struct RunqueueReport {
+    bool valid = false;            // at least one window closed
+    uint64_t timestampMs = 0;      // end of the last window
+    uint32_t windowMs = 0;
+    RunqueueStats process;         // last window
+    RunqueueStats cumulative;      // since attach() or resetCumulative()
+    std::vector<RunqueueStats> threads;   // last window, highest p99 first
+    bool starved = false;          // alert state after the last window
+};
+
+struct RunqueueAlert {
+    bool starved = false;          // false: the alert cleared
+    int32_t pid = 0;
+    double p99Us = 0.0;
+    double thresholdUs = 0.0;
+    int32_t worstTid = 0;
+    char worstComm[16] = {};
+    uint64_t timestampMs = 0;
+};
+
+// Run-queue delay of every thread of one process, from the cumulative
+// wait time and scheduling count in /proc/<pid>/task/<tid>/schedstat.
+//
+// Each sample() contributes, per thread, its mean delay over the interval
+// weighted by the number of times it was scheduled in, so one long wait
+// among many short ones is averaged over a sample interval: the interval
+// is the time resolution of the tail, and the bucket width
+// (resolutionBits) its value resolution. Windows of windowMs are
+// summarised into per-thread and per-process quantiles and folded into a
+// cumulative process histogram, which callers can reset around a change
+// (affinity, priority, throttling) to compare latency before and after.
+//
+// The starvation alert fires once the process p99 has been above the
+// threshold for alertWindows consecutive windows and clears after as many
+// windows below it; windows with fewer than minEvents samples are ignored.
+//
+// sample() is driven by one thread; report() and latest() may be called
+// from any thread. The alert callback runs on the sampling thread.
+class RunqueueProbe {
+public:
+    struct Options {
+        uint32_t windowMs = 1000;
+        uint32_t resolutionBits = 3;
+        double p99ThresholdUs = 4000.0;    // a quarter of a 60 Hz frame
+        uint32_t alertWindows = 2;
+        uint32_t minEvents = 20;
+        uint32_t maxThreads = 128;
+        uint32_t rescanIntervalMs = 2000;
+    };
+    using AlertCallback = std::function<void(const RunqueueAlert& alert)>;
+
+private:
+    struct ThreadState {
+        int32_t tid = 0;
+        char comm[16] = {};
+        ProcFile file;
+        TaskSchedstat last;
+        LatencyHistogram window;
+        double runMs = 0.0;
+        double waitMs = 0.0;
+
+        explicit ThreadState(uint32_t bits) : window(bits) {}
+    };
+
+    std::string root;
+    Options options;
+    pid_t targetPid;
+    int taskDirFd;
+    uint64_t lastRescanMs;
+    uint64_t windowStartMs;
+    std::vector<std::unique_ptr<ThreadState>> threads;
+    LatencyHistogram processWindow;
+    double processRunMs;
+    double processWaitMs;
+    uint32_t overWindows;
+    uint32_t underWindows;
+    bool starved;
+    AlertCallback onAlert;
+
+    mutable std::mutex mutex;                  // guards everything below
+    LatencyHistogram cumulative;
+    double cumulativeRunMs;
+    double cumulativeWaitMs;
+    RunqueueReport published;
+
+    void rescan(uint64_t nowMs);
+    void closeWindow(uint64_t nowMs);
+    static RunqueueStats summarize(const LatencyHistogram& histogram, double runMs, double waitMs);
+
+public:
+    explicit RunqueueProbe(const std::string& rootPrefix = "");
+    ~RunqueueProbe();
+
+    RunqueueProbe(const RunqueueProbe&) = delete;
+    RunqueueProbe& operator=(const RunqueueProbe&) = delete;
+
+    // Takes effect on the next attach().
+    void setOptions(const Options& newOptions);
+    const Options& getOptions() const { return options; }
+    void setAlertCallback(AlertCallback callback) { onAlert = std::move(callback); }
+
+    bool attach(pid_t pid);
+    void detach();
+    pid_t pid() const { return targetPid; }
+
+    // Call every 50-200 ms with EventLoop::nowMs(). Returns true when a
+    // window closed and the report was refreshed.
+    bool sample(uint64_t nowMs);
+    void resetCumulative();
+
+    RunqueueReport report() const;
+    // Last window's process stats only; false before the first window.
+    bool latest(RunqueueStats& out, bool* starvedOut = nullptr) const;
+};
+
+#endif // __linux__
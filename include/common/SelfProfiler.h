@@ -0,0 +1,129 @@
+// include/common/SelfProfiler.h - Self-overhead timers, histograms and counters
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ProfileCounter {
+    Syscalls,
+    Forks,
+    BytesRead,
+    BytesWritten,
+    kCount
+};
+
+struct ProfileSiteStats {
+    std::string name;
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p90Ns = 0;
+    uint64_t p99Ns = 0;
+
+    double meanNs() const { return count ? static_cast<double>(totalNs) / count : 0.0; }
+};
+
+// The optimizer's own footprint. On Android this is the whole app process
+// the library is loaded into, so it is an upper bound.
+struct SelfUsage {
+    uint64_t cpuTimeUs = 0;              // user + system, all threads
+    uint64_t rssBytes = 0;
+    uint64_t maxRssBytes = 0;
+    uint64_t voluntarySwitches = 0;
+    uint64_t involuntarySwitches = 0;
+    uint64_t uptimeMs = 0;               // since the library was loaded
+    double cpuPercent = 0.0;             // of one core, over uptimeMs
+    double recentCpuPercent = 0.0;       // of one core, since the baseline
+};
+
+// Where recentCpuPercent is measured from. Each reader keeps its own, so
+// one polling often does not shrink another's window; sampleUsage()
+// advances it and the owner serialises its calls.
+struct UsageBaseline {
+    uint64_t sampleNs = 0;               // 0: since the library was loaded
+    uint64_t cpuTimeUs = 0;
+};
+
+struct ProfileReport {
+    std::vector<ProfileSiteStats> sites;  // sites with at least one sample
+    uint64_t counters[static_cast<int>(ProfileCounter::kCount)] = {};
+    SelfUsage usage;
+    double budgetPercent = 0.0;           // 0: no budget set
+    bool overBudget = false;              // recentCpuPercent above the budget
+};
+
+// Per-site log-linear latency histograms: each power of two is split into
+// kSubBuckets linear buckets, so quantiles are within ~6% of the true value
+// from 1 ns to ~18 minutes in a fixed array. Recording is a handful of
+// relaxed atomic adds and takes no lock; sites are registered once per
+// call site, like log formats.
+//
+// Building with OPTIMIZER_PROFILING_DISABLED compiles PROFILE_SCOPE and
+// PROFILE_COUNT out entirely; the query API then reports empty stats.
+class SelfProfiler {
+public:
+    static constexpr uint32_t kMaxSites = 64;
+    static constexpr uint32_t kSubBucketBits = 3;
+    static constexpr uint32_t kSubBuckets = 1u << kSubBucketBits;
+    static constexpr uint32_t kMaxExponent = 40;          // 2^40 ns ~ 18 min
+    static constexpr uint32_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+    static constexpr uint32_t kInvalidSite = UINT32_MAX;
+
+    // Returns the same id for the same name; kInvalidSite once full.
+    static uint32_t registerSite(const char* name);
+    static void record(uint32_t site, uint64_t elapsedNs);
+    static void count(ProfileCounter counter, uint64_t amount = 1);
+
+    static uint32_t bucketIndex(uint64_t valueNs);
+    static uint64_t bucketLowerBound(uint32_t index);
+
+    static bool siteStats(const char* name, ProfileSiteStats& out);
+    static uint64_t counterValue(ProfileCounter counter);
+    // recentCpuPercent covers the time since the previous call with
+    // the same baseline.
+    static bool sampleUsage(SelfUsage& out, UsageBaseline& baseline);
+    static void snapshot(ProfileReport& out, UsageBaseline& baseline);
+    // CPU budget (percent of one core) that snapshot() checks against.
+    static void setCpuBudgetPercent(double percent);
+    static double getCpuBudgetPercent();
+    static std::string formatReport(const ProfileReport& report);
+    static void reset();
+
+    static const char* counterName(ProfileCounter counter);
+
+    static uint64_t nowNanos() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
+
+class ScopedTimer {
+private:
+    uint32_t site;
+    uint64_t startNs;
+
+public:
+    explicit ScopedTimer(uint32_t siteId) : site(siteId), startNs(SelfProfiler::nowNanos()) {}
+    ~ScopedTimer() { SelfProfiler::record(site, SelfProfiler::nowNanos() - startNs); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if defined(OPTIMIZER_PROFILING_DISABLED)
+#define PROFILE_SCOPE(site) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#else
+// Times the rest of the enclosing scope: PROFILE_SCOPE("scheduler.tick");
+#define PROFILE_SCOPE(site)                                                                  \
+    static const uint32_t PROFILE_CONCAT(profileSite_, __LINE__) = SelfProfiler::registerSite(site); \
+    ScopedTimer PROFILE_CONCAT(profileTimer_, __LINE__)(PROFILE_CONCAT(profileSite_, __LINE__))
+#define PROFILE_COUNT(counter, amount) SelfProfiler::count(counter, amount)
+#endif
@@ -2,8 +2,10 @@
 #pragma once
 #ifdef ANDROID_BUILD
 
+#include <cstdint>
 #include <string>
 #include <vector>
+#include "ProcFs.h"
 
 struct AndroidAppInfo {
     std::string packageName;
@@ -17,21 +19,27 @@ class SystemManager {
 public:
     static std::vector<AndroidAppInfo> getRunningApps();
     static AndroidAppInfo getAppInfo(const std::string& packageName);
+    // App (not system service) process, judged by uid and argv[0].
+    static bool isAppProcess(uint32_t uid, const std::string& name);
     
     // System optimization
-    static bool setCpuGovernor(const std::string& governor);
     static std::string getCurrentCpuGovernor();
     static bool setGpuGovernor(const std::string& governor);
     
     // Memory management
     static long getTotalMemory();
     static long getAvailableMemory();
+    static bool readSystemSnapshot(SystemSnapshot& snapshot);
     static bool trimMemory(const std::string& packageName);
     
     // Performance
     static bool disableAnimations();
     static bool enablePerformanceMode();
     static bool optimizeBattery();
+    // Read the settings back through the helper; false without root.
+    static bool animationsDisabled();
+    static bool batteryOptimized();
+    static std::string getSystemInfo();
     
 private:
     static bool hasRootAccess();
@@ -8,7 +8,7 @@
 class Utils {
 public:
     // String utilities
-    static std::string trim(const std::string& str);
+    static std::string trim(const std::string& str);   // spaces, tabs, CR/LF, FF, VT
     static std::vector<std::string> split(const std::string& str, char delimiter);
     static std::string toLowerCase(const std::string& str);
     static std::string toUpperCase(const std::string& str);
@@ -23,6 +23,9 @@ public:
     OptimizationResult optimizeMemory() override;
     OptimizationResult optimizeSystemSettings() override;
     ProcessInfo getProcessInfo() override;
+    void startOptimization() override;
+    void stopOptimization() override;
+    bool isRunning() const override;
     
     // Windows-specific methods
     bool setProcessAffinity(DWORD_PTR affinityMask);
@@ -2,82 +2,1321 @@
 #ifdef ANDROID_BUILD
 #include <android/log.h>
 #include <sys/system_properties.h>
+#include <sys/resource.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
+#include "AndroidOptimizer.h"
+#include "Config.h"
+#include "SelfProfiler.h"
+#include "SystemManager.h"
+#include "Utils.h"
+
 #define LOG_TAG "RobloxOptimizer"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-class AndroidOptimizer {
-private:
-    std::string packageName = "com.roblox.client";
-    
-public:
-    AndroidOptimizer() {
-        LOGI("AndroidOptimizer initialized for API 26+");
+namespace {
+
+// Loaded from Utils::getConfigDirectory() and watched; keys are read where
+// they are used, and applyConfig() re-applies the ones read at start.
+const char kConfigFileName[] = "optimizer.conf";
+
+// CPU sampling rate for the game process (10 Hz)
+constexpr int kCpuSampleIntervalMs = 100;
+// Frame cadence windows close on these ticks; same rate as the CPU
+// sampler so both ride one timer wakeup.
+const ConfigKey<int> kFrameSampleIntervalMs("frame.sample_interval_ms", kCpuSampleIntervalMs);
+// Run-queue delay of the game's threads: window length, buckets per power
+// of two (2^bits) and the p99 above which the game counts as starved.
+const ConfigKey<int> kRunqueueWindowMs("runqueue.window_ms", 1000);
+const ConfigKey<int> kRunqueueResolutionBits("runqueue.resolution_bits", 3);
+const ConfigKey<double> kRunqueueP99ThresholdMs("runqueue.p99_threshold_ms", 4.0);
+// Pool threads for work the event loop must not block on (memory
+// accounting passes, pressure-triggered reclaim).
+constexpr unsigned kEventLoopWorkers = 2;
+
+const ConfigKey<std::string> kCpuFreqGovernor("cpufreq.governor", "performance");
+const ConfigKey<int> kLittleMinFloorPercent("cpufreq.little_min_floor_percent", 0);
+const ConfigKey<int> kBigMinFloorPercent("cpufreq.big_min_floor_percent", 0);
+
+const ConfigKey<int> kSchedulerIntervalMs("scheduler.interval_ms", 500);
+// Policy thresholds and knob spacing are fixed when the scheduler is first
+// configured; a reload does not change them.
+const ConfigKey<int> kKnobMinIntervalMs("scheduler.knob_min_interval_ms", 3000);
+const ConfigKey<double> kThermalLimitCelsius("scheduler.thermal_limit_c", 75.0);
+// Empty: keep the session's history in anonymous memory only.
+const ConfigKey<std::string> kMetricsFile("metrics.file", "");
+// Non-empty: record every input the scheduler reads, one frame per tick,
+// for offline replay with RobloxOptimizerTrace.
+const ConfigKey<std::string> kTraceFile("trace.file", "");
+
+// Columns recorded on every scheduler tick, in this order.
+const char* const kMetricNames[] = {
+    "game.cpu", "game.rss_mb", "system.cpu", "mem.available", "thermal", "mem.pressure",
+    "game.pss_mb", "game.swap_mb", "game.majflt_rate", "game.fps", "game.frame_jitter_ms",
+    "game.runq_p99_ms", "game.instances",
+};
+
+const ConfigKey<int> kPlacementIntervalMs("placement.interval_ms", 2000);
+const ConfigKey<double> kPlacementHeavyPercent("placement.heavy_percent", 30.0);
+const ConfigKey<double> kPlacementLightPercent("placement.light_percent", 5.0);
+const ConfigKey<double> kPlacementMigrationGain("placement.migration_gain_percent", 10.0);
+
+// Our own CPU time, as percent of one core, checked every check_interval_ms.
+const ConfigKey<double> kOverheadBudgetPercent("profiler.budget_percent", 0.5);
+const ConfigKey<int> kOverheadCheckIntervalMs("profiler.check_interval_ms", 10000);
+
+// Per-process accounting pass; the accountant spaces out the expensive
+// smaps_rollup reads on its own.
+const ConfigKey<int> kMemorySampleIntervalMs("memory.sample_interval_ms", 2000);
+const ConfigKey<int> kMemoryDetailReadsPerPass("memory.detail_reads_per_pass", 8);
+const ConfigKey<double> kMemoryRssChangePercent("memory.rss_change_percent", 10.0);
+
+// Background reclaim runs until MemAvailable reaches the target; each
+// memory.trim level above 1 raises the target by 5 points and doubles the
+// per-tick byte budget.
+const ConfigKey<double> kReclaimTargetPercent("reclaim.target_available_percent", 20.0);
+const ConfigKey<int> kReclaimMaxMbPerTick("reclaim.max_mb_per_tick", 64);
+const ConfigKey<int> kReclaimMaxTickMs("reclaim.max_tick_ms", 20);
+const ConfigKey<int> kReclaimMinOomScoreAdj("reclaim.min_oom_score_adj", 700);
+
+// cgroup v2 partitioning: the game in a high-weight, uclamp-floored,
+// memory.low protected group; background apps in a capped one. memory.low
+// follows the game's footprint scaled by game_memory_low_percent.
+const ConfigKey<bool> kCgroupEnabled("cgroup.enabled", true);
+const ConfigKey<int> kCgroupGameCpuWeight("cgroup.game_cpu_weight", 1000);
+const ConfigKey<double> kCgroupGameUclampMin("cgroup.game_uclamp_min_percent", 20.0);
+const ConfigKey<int> kCgroupGameMemoryLowPercent("cgroup.game_memory_low_percent", 125);
+const ConfigKey<int> kCgroupBackgroundCpuWeight("cgroup.background_cpu_weight", 20);
+const ConfigKey<double> kCgroupBackgroundCpuMax("cgroup.background_cpu_max_percent", 200.0);
+const ConfigKey<int> kCgroupBackgroundIoWeight("cgroup.background_io_weight", 10);
+
+// I/O priority classes ("rt:N", "be:N", "idle", "none") for every thread
+// of the game and of background apps; new threads are picked up every
+// refresh_interval_ms. background_packages are treated as background even
+// when the system ranks them higher: store updates, photo backup and
+// media scanning are the usual storage hogs during play.
+const ConfigKey<bool> kIoprioEnabled("ioprio.enabled", true);
+const ConfigKey<std::string> kIoprioGame("ioprio.game", "be:0");
+const ConfigKey<std::string> kIoprioBackground("ioprio.background", "idle");
+const ConfigKey<int> kIoprioRefreshIntervalMs("ioprio.refresh_interval_ms", 1000);
+const ConfigKey<std::string> kIoprioBackgroundPackages("ioprio.background_packages",
+                                                       "com.android.vending,"
+                                                       "com.google.android.apps.photos,"
+                                                       "com.android.providers.media.module");
+
+// Page-cache prewarming: the files the game touched during its first
+// learn_ms are read ahead (up to max_mb, threads at a time) as soon as the
+// next launch is seen; lock_mb of the hottest extents stay mlock()ed while
+// it runs. Every relearn_every-th launch (0: only without a current
+// profile) is learned cold and merged into profile_file.
+const ConfigKey<bool> kPrewarmEnabled("prewarm.enabled", true);
+const ConfigKey<std::string> kPrewarmProfileFile("prewarm.profile_file",
+                                                 "/data/local/tmp/roblox_optimizer_prewarm.profile");
+const ConfigKey<int> kPrewarmLearnMs("prewarm.learn_ms", 30000);
+const ConfigKey<int> kPrewarmSampleIntervalMs("prewarm.sample_interval_ms", 250);
+const ConfigKey<int> kPrewarmRelearnEvery("prewarm.relearn_every", 8);
+const ConfigKey<int> kPrewarmThreads("prewarm.threads", 4);
+const ConfigKey<int> kPrewarmMaxMb("prewarm.max_mb", 256);
+const ConfigKey<int> kPrewarmLockMb("prewarm.lock_mb", 0);
+
+// Concurrent clients: with min_instances or more running (and partition
+// on), each one's threads stay on CPUs of its own, sized by its measured
+// demand times headroom. reserved_cpus of the smallest cores are left to
+// the system while there are more cores than clients.
+const ConfigKey<bool> kInstancesPartition("instances.partition", true);
+const ConfigKey<int> kInstancesMinInstances("instances.min_instances", 2);
+const ConfigKey<int> kInstancesReservedCpus("instances.reserved_cpus", 1);
+const ConfigKey<int> kInstancesUpdateIntervalMs("instances.update_interval_ms", 1000);
+const ConfigKey<double> kInstancesHeadroom("instances.headroom", 1.25);
+
+// clearCache(): comma-separated roots in addition to the package's own
+// /data/data/<package>/cache (listed once even if repeated here), files
+// untouched for min_age_hours, excludes as comma-separated globs.
+// dry_run only reports what would be freed.
+const ConfigKey<std::string> kCacheRoots("cache.roots", "/sdcard/Android/data/com.roblox.client/cache");
+const ConfigKey<int> kCacheMinAgeHours("cache.min_age_hours", 24);
+const ConfigKey<std::string> kCacheExclude("cache.exclude", "");
+const ConfigKey<bool> kCacheDryRun("cache.dry_run", false);
+const ConfigKey<int> kCacheThreads("cache.threads", 0);
+// applyProfile() skips the cache step when it ran this recently.
+const ConfigKey<int> kCacheMinIntervalMin("cache.min_interval_min", 30);
+
+// Steps of applyProfile() running at once.
+const ConfigKey<int> kPlanMaxParallel("plan.max_parallel", 4);
+
+// Big-cluster floor (% of cpuinfo_max_freq) per cpufreq.floor level; the
+// little cluster gets half.
+const int kFloorPercentByLevel[] = {0, 30, 50, 70};
+
+// Survives the optimizer process so a killed instance can be undone on
+// the next start.
+const char kCpuFreqStateFile[] = "/data/local/tmp/roblox_optimizer_cpufreq.state";
+const char kCgroupStateFile[] = "/data/local/tmp/roblox_optimizer_cgroup.state";
+
+} // namespace
+
+AndroidOptimizer::AndroidOptimizer()
+    : jvm(nullptr), activityObject(nullptr), packageName("com.roblox.client"), robloxPid(0), schedulerTask(0),
+      memoryTask(0), memorySampleQueued(false), frameTask(0), runqueueTask(0),
+      cpuFreqController("", kCpuFreqStateFile), frequencyFloorLevel(0), haveCpuStat(false), threadPlacement(topology),
+      placementActive(false), placementSuspended(false), lastPlacementMs(0), lastOverheadCheckMs(0),
+      overBudget(false), reclaimEngine(memoryAccountant), reclaimLevel(0), reclaimBurst(false), reclaimQueued(false),
+      cgroupManager("", "roblox_optimizer", kCgroupStateFile), ioPriorityTask(0), ioPriorityQueued(false),
+      prewarmTask(0), prewarmQueued(false), prewarmReady(false), prewarmLaunches(0), instanceManager(topology),
+      instancesTask(0), instancesQueued(false), instanceReplans(0), lastCacheCleanMs(0), configListener(0) {
+    // First, so every key below already reads the file's value.
+    Config* config = Config::getInstance();
+    std::string configPath = Utils::getConfigDirectory() + "/" + kConfigFileName;
+    if (config->loadFromFile(configPath)) {
+        LOGI("Configuration loaded from %s", configPath.c_str());
+    } else if (access(configPath.c_str(), F_OK) == 0) {
+        LOGE("Ignoring %s: unreadable or malformed", configPath.c_str());
     }
-    
-    bool findRobloxProcess() {
-        LOGI("Searching for Roblox process...");
-        // Stub: In real implementation, would check running apps
-        return false;
+    configListener = config->addReloadListener([this] { applyConfig(); });
+    if (!config->startWatching(eventLoop)) {
+        LOGE("Cannot watch %s for changes", configPath.c_str());
     }
-    
-    bool optimizeCpuGovernor() {
-        LOGI("Setting CPU governor to performance mode...");
-        
-        // Check if we have root access
-        if (geteuid() != 0) {
-            LOGI("Root access not available - limited optimizations");
-            return false;
+    if (cpuFreqController.recoverFromStateFile()) {
+        LOGI("Restored CPU frequency state left by a previous run");
+    }
+    CpuFreqController::installCrashRestore();
+    if (cgroupManager.recoverFromStateFile()) {
+        LOGI("Removed cgroups left by a previous run");
+    }
+    if (metrics.open(kMetricsFile.get()) || metrics.open()) {
+        for (const char* name : kMetricNames) {
+            metricIds.push_back(metrics.registerMetric(name));
+        }
+    }
+    std::string prewarmPath = kPrewarmProfileFile.get();
+    if (kPrewarmEnabled.get() && access(prewarmPath.c_str(), F_OK) == 0) {
+        std::string error;
+        if (prewarmProfile.load(prewarmPath, &error)) {
+            prewarmReady.store(!prewarmProfile.files.empty());
+            LOGI("Prewarm profile: %zu files, %llu KB from %u sessions", prewarmProfile.files.size(),
+                 static_cast<unsigned long long>(prewarmProfile.bytes() >> 10), prewarmProfile.sessions);
+        } else {
+            LOGE("Ignoring prewarm profile: %s", error.c_str());
         }
-        
-        // Stub: Would set CPU governor to performance
-        return true;
     }
-    
-    bool optimizeMemory() {
-        LOGI("Optimizing memory management...");
-        
-        // Trigger memory trim
-        system("sync");
-        
-        // Stub: Would perform memory optimizations
+    runqueueProbe.setAlertCallback([](const RunqueueAlert& alert) {
+        if (alert.starved) {
+            LOGE("Game threads starved: run-queue p99 %.1f ms over %.1f ms (worst: %s/%d)", alert.p99Us / 1000.0,
+                 alert.thresholdUs / 1000.0, alert.worstComm, alert.worstTid);
+        } else {
+            LOGI("Game run-queue delay back under %.1f ms (p99 %.1f ms)", alert.thresholdUs / 1000.0,
+                 alert.p99Us / 1000.0);
+        }
+    });
+    LOGI("AndroidOptimizer initialized for API 26+");
+}
+
+AndroidOptimizer::~AndroidOptimizer() {
+    Config::getInstance()->stopWatching();
+    Config::getInstance()->removeReloadListener(configListener);
+    cacheCleaner.cancel();
+    stopOptimization();
+    processWatcher.stop();
+    cpuSampler.stop();
+    eventLoop.stop();
+    cpuFreqController.restore();
+    cgroupManager.teardown();
+    ioPriority.restore();
+}
+
+bool AndroidOptimizer::startEventLoop() {
+    if (eventLoop.isRunning()) {
         return true;
     }
-    
-    bool disableAnimations() {
-        LOGI("Disabling system animations...");
-        
-        // Stub: Would disable window/transition animations
-        // Requires WRITE_SETTINGS permission
+    // Pool jobs are our own maintenance: they read storage at idle class.
+    if (!eventLoop.start(kEventLoopWorkers, [] { IoPriorityManager::setCurrentThreadIdle(); })) {
+        LOGE("Cannot start event loop: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void AndroidOptimizer::onRobloxStarted(pid_t pid) {
+    if (instanceManager.add(pid, packageName, EventLoop::nowMs())) {
+        onInstancesChanged();
+    }
+    // Make room before the first match rather than after the first kill.
+    reclaimBurst.store(true);
+    pid_t expected = 0;
+    if (!robloxPid.compare_exchange_strong(expected, pid)) {
+        // The primary keeps the per-game probes; this one gets a partition.
+        LOGI("Roblox instance started: pid %d (%zu running)", pid, instanceManager.count());
+        return;
+    }
+    attachGame(pid);
+    if (kPrewarmEnabled.get()) {
+        int every = std::max(0, kPrewarmRelearnEvery.get());
+        if (!prewarmReady.load() || (every > 0 && ++prewarmLaunches % every == 0)) {
+            startPrewarmLearning(pid);
+        } else if (!eventLoop.offload([this] { prewarmGameFiles(); })) {
+            prewarmGameFiles();
+        }
+    }
+    LOGI("Roblox process found: pid %d", pid);
+}
+
+void AndroidOptimizer::attachGame(pid_t pid) {
+    cpuSampler.start(eventLoop, pid, kCpuSampleIntervalMs);
+    // remove() waits out a running sample, so the estimator is only ever
+    // touched by one thread at a time.
+    eventLoop.remove(frameTask);
+    if (frameCadence.attach(pid)) {
+        uint32_t interval = static_cast<uint32_t>(std::max(kFrameSampleIntervalMs.get(), 20));
+        frameTask = eventLoop.addPeriodic("frame.sample", interval, [this](uint64_t now) { frameCadence.sample(now); });
+    }
+    eventLoop.remove(runqueueTask);
+    RunqueueProbe::Options runqueueOptions;
+    runqueueOptions.windowMs = static_cast<uint32_t>(std::max(kRunqueueWindowMs.get(), 100));
+    runqueueOptions.resolutionBits = static_cast<uint32_t>(std::max(kRunqueueResolutionBits.get(), 0));
+    runqueueOptions.p99ThresholdUs = kRunqueueP99ThresholdMs.get() * 1000.0;
+    runqueueProbe.setOptions(runqueueOptions);
+    if (runqueueProbe.attach(pid)) {
+        runqueueTask = eventLoop.addPeriodic("runqueue.sample", static_cast<uint32_t>(kCpuSampleIntervalMs),
+                                             [this](uint64_t now) { runqueueProbe.sample(now); });
+    }
+    memoryAccountant.setFocusPid(pid);
+    reclaimEngine.setProtectedPid(pid);
+    if (cgroupManager.isActive() && !cgroupManager.setGamePid(pid)) {
+        LOGE("Cannot move pid %d into the game cgroup", pid);
+    }
+    if (ioPriorityTask != 0) {
+        ioPriority.setGamePid(pid);
+        queueIoPriorityRefresh();
+    }
+}
+
+void AndroidOptimizer::detachGame() {
+    cpuSampler.stop();
+    eventLoop.remove(frameTask);
+    frameTask = 0;
+    frameCadence.detach();
+    eventLoop.remove(runqueueTask);
+    runqueueTask = 0;
+    runqueueProbe.detach();
+    memoryAccountant.setFocusPid(0);
+    reclaimEngine.setProtectedPid(0);
+    cgroupManager.setGamePid(0);
+    ioPriority.setGamePid(0);
+}
+
+void AndroidOptimizer::onRobloxExited(pid_t pid) {
+    if (instanceManager.remove(pid)) {
+        onInstancesChanged();
+    }
+    pid_t expected = pid;
+    if (!robloxPid.compare_exchange_strong(expected, 0)) {
+        return;
+    }
+    detachGame();
+    // A session cut short still taught us its launch.
+    if (prewarmRecorder.pid() == pid && !eventLoop.offload([this] { finishPrewarmLearning(); })) {
+        finishPrewarmLearning();
+    }
+    LOGI("Roblox process exited: pid %d", pid);
+    pid_t next = instanceManager.oldest();
+    expected = 0;
+    if (next != 0 && robloxPid.compare_exchange_strong(expected, next)) {
+        attachGame(next);
+        LOGI("Roblox pid %d is now the primary instance", next);
+        return;
+    }
+    reclaimBurst.store(false);
+    prewarmer.unlock();
+    if (cpuFreqController.hasChanges() && applyFrequencyFloor(0)) {
+        LOGI("CPU frequency floor dropped");
+    }
+}
+
+bool AndroidOptimizer::findRobloxProcess() {
+    // The watcher does one full scan on start and then tracks launches and
+    // exits through the proc connector (or an incremental /proc scan).
+    if (!processWatcher.isRunning()) {
+        LOGI("Searching for Roblox process...");
+        processWatcher.addTarget(packageName);
+        processWatcher.setCallbacks(
+            [this](pid_t pid, const std::string&) { onRobloxStarted(pid); },
+            [this](pid_t pid) { onRobloxExited(pid); });
+        if (startEventLoop()) {
+            processWatcher.start(eventLoop);
+        } else {
+            processWatcher.start();
+        }
+        LOGI("Process watcher running (%s)",
+             processWatcher.getMode() == ProcessWatcher::Mode::Netlink ? "netlink" : "proc scan");
+    }
+    return robloxPid.load() != 0;
+}
+
+OptimizationResult AndroidOptimizer::optimizeProcessPriority() {
+    PROFILE_SCOPE("optimize.process_priority");
+    if (!findRobloxProcess()) {
+        return OptimizationResult(false, "Roblox process not found");
+    }
+    pid_t pid = robloxPid.load();
+    if (setpriority(PRIO_PROCESS, pid, -10) != 0) {
+        return OptimizationResult(false, "Failed to raise process priority", strerror(errno));
+    }
+    if (!kIoprioEnabled.get()) {
+        return OptimizationResult(true, "Process priority raised");
+    }
+    // I/O too: asset streaming stalls behind background reads otherwise.
+    configureIoPriority();
+    ioPriority.setGamePid(pid);
+    ioPriority.refresh();
+    IoPriorityStatus status = ioPriority.getStatus();
+    return OptimizationResult(true, "Process priority raised",
+                              "I/O " + kIoprioGame.get() + " on " + std::to_string(status.gameThreads) + " threads");
+}
+
+OptimizationResult AndroidOptimizer::optimizeMemory() {
+    PROFILE_SCOPE("optimize.memory");
+    LOGI("Optimizing memory management...");
+
+    // One budgeted pass now; the scheduler keeps going until the target.
+    configureReclaim(std::max(reclaimLevel.load(), 1));
+    ReclaimTickResult result = reclaimEngine.tick(AdaptiveScheduler::nowMs());
+    reclaimBurst.store(!result.targetMet);
+    std::string details = std::to_string(result.bytesReclaimed >> 20) + " MB from " +
+                          std::to_string(result.processes) + " background processes";
+    if (result.targetMet || result.processes > 0) {
+        return OptimizationResult(true, "Memory optimized", details);
+    }
+    return OptimizationResult(reclaimEngine.isAvailable(), "No background memory reclaimed", details);
+}
+
+OptimizationResult AndroidOptimizer::optimizeSystemSettings() {
+    PROFILE_SCOPE("optimize.system_settings");
+    OptimizationResult animations = disableAnimations();
+    OptimizationResult battery = optimizeBatterySettings();
+    bool success = animations.success && battery.success;
+    return OptimizationResult(success, success ? "System settings optimized" : "System settings partially optimized");
+}
+
+ProcessInfo AndroidOptimizer::getProcessInfo() {
+    ProcessInfo info;
+    pid_t pid = robloxPid.load();
+    info.pid = static_cast<uint32_t>(pid);
+    info.name = packageName;
+
+    // Latest values published by the sampler thread; no lock taken here.
+    ProcessCpuSample sample;
+    if (pid != 0 && cpuSampler.pid() == pid && cpuSampler.latestProcessSample(sample)) {
+        info.cpuUsage = sample.usagePercent;
+        info.memoryUsage = sample.rssBytes;
+        info.isRunning = cpuSampler.isRunning();
+    }
+    FrameCadence cadence = frameCadence.current();
+    if (pid != 0 && cadence.valid) {
+        info.frameRate = cadence.fps;
+        info.frameJitterMs = cadence.jitterMs;
+    }
+    RunqueueStats runqueue;
+    if (pid != 0 && runqueueProbe.latest(runqueue)) {
+        info.runqueueP99Ms = runqueue.p99Us / 1000.0;
+    }
+    // PSS once the accountant has measured it; RSS double-counts the
+    // zygote's shared pages every app maps.
+    ProcessMemory memory;
+    if (pid != 0 && memoryAccountant.get(pid, memory)) {
+        info.memoryUsage = memory.footprint();
+    }
+    return info;
+}
+
+std::vector<ProcessInfo> AndroidOptimizer::getInstances() {
+    std::vector<ProcessInfo> result;
+    ProcessInfo primary = getProcessInfo();
+    if (primary.pid != 0) {
+        result.push_back(primary);
+    }
+    // The others have no frame or run-queue probes of their own.
+    for (const InstanceInfo& instance : instanceManager.snapshot()) {
+        if (instance.pid == static_cast<pid_t>(primary.pid)) {
+            continue;
+        }
+        ProcessInfo info;
+        info.pid = static_cast<uint32_t>(instance.pid);
+        info.name = instance.name;
+        info.cpuUsage = instance.cpuPercent;
+        info.memoryUsage = instance.rssBytes;
+        info.isRunning = true;
+        ProcessMemory memory;
+        if (memoryAccountant.get(instance.pid, memory)) {
+            info.memoryUsage = memory.footprint();
+        }
+        result.push_back(info);
+    }
+    return result;
+}
+
+void AndroidOptimizer::configureScheduler() {
+    if (scheduler.isConfigured()) {
+        return;
+    }
+    uint32_t knobInterval = static_cast<uint32_t>(kKnobMinIntervalMs.get());
+    scheduler.setSignalSource([this](OptimizerSignals& out) { return sampleSignals(out); });
+    scheduler.addPolicy(std::unique_ptr<OptimizationPolicy>(new CpuFloorPolicy(kThermalLimitCelsius.get())));
+    scheduler.addPolicy(std::unique_ptr<OptimizationPolicy>(new AffinityPolicy(kRunqueueP99ThresholdMs.get())));
+    scheduler.addPolicy(std::unique_ptr<OptimizationPolicy>(new MemoryTrimPolicy()));
+    scheduler.addKnob("cpufreq.floor", [this](int level) { return applyFrequencyFloor(level); }, knobInterval);
+    scheduler.addKnob("affinity", [this](int level) { return applyGameAffinity(level); }, knobInterval);
+    scheduler.addKnob("memory.trim", [this](int level) {
+        reclaimLevel.store(level);
         return true;
+    }, knobInterval);
+    scheduler.addTickListener([this](const OptimizerSignals&, uint64_t now) { updatePlacement(now); });
+    scheduler.addTickListener([this](const OptimizerSignals& signals, uint64_t now) {
+        recordMetrics(signals, now);
+    });
+    scheduler.addTickListener([this](const OptimizerSignals&, uint64_t now) { checkOverhead(now); });
+    scheduler.addTickListener([this](const OptimizerSignals& signals, uint64_t now) { reclaimTick(signals, now); });
+    scheduler.addTickListener([this](const OptimizerSignals&, uint64_t now) {
+        if (traceRecorder.isOpen()) {
+            traceRecorder.setGamePid(robloxPid.load());
+            traceRecorder.capture(now);
+        }
+    });
+}
+
+bool AndroidOptimizer::sampleSignals(OptimizerSignals& out) {
+    PROFILE_SCOPE("scheduler.sample_signals");
+    pid_t pid = robloxPid.load();
+    ProcessCpuSample sample;
+    if (pid != 0 && cpuSampler.pid() == pid && cpuSampler.latestProcessSample(sample)) {
+        out.gameRunning = true;
+        out.gameCpuPercent = sample.usagePercent;
     }
-    
-    bool optimizeBattery() {
-        LOGI("Optimizing battery settings for gaming...");
-        
-        // Stub: Would optimize power profile for performance
+    FrameCadence cadence = frameCadence.current();
+    if (pid != 0 && cadence.valid) {
+        out.gameFps = cadence.fps;
+        out.frameJitterMs = cadence.jitterMs;
+    }
+    RunqueueStats runqueue;
+    if (pid != 0 && runqueueProbe.latest(runqueue)) {
+        out.runqueueP99Ms = runqueue.p99Us / 1000.0;
+    }
+
+    CpuStat stat;
+    if (signalReader.readCpuStat(stat)) {
+        if (haveCpuStat) {
+            uint64_t total = stat.aggregate.total() - lastCpuStat.aggregate.total();
+            uint64_t busy = stat.aggregate.busy() - lastCpuStat.aggregate.busy();
+            out.systemCpuPercent = total ? 100.0 * busy / total : 0.0;
+        }
+        lastCpuStat = stat;
+        haveCpuStat = true;
+    }
+
+    MemInfo memory;
+    if (signalReader.readMemInfo(memory) && memory.memTotal != 0) {
+        out.memAvailablePercent = 100.0 * memory.memAvailable / memory.memTotal;
+    }
+
+    int32_t milliCelsius = 0;
+    if (signalReader.readMaxThermal(milliCelsius)) {
+        out.thermalCelsius = milliCelsius / 1000.0;
+    }
+    out.memoryPressure = static_cast<int>(pressureMonitor.getLevel(PressureResource::Memory));
+    return true;
+}
+
+void AndroidOptimizer::recordMetrics(const OptimizerSignals& signals, uint64_t) {
+    if (metricIds.size() != sizeof(kMetricNames) / sizeof(kMetricNames[0])) {
+        return;
+    }
+    ProcessCpuSample sample;
+    bool haveSample = signals.gameRunning && cpuSampler.latestProcessSample(sample);
+    ProcessMemory memory;
+    bool haveMemory = signals.gameRunning && memoryAccountant.get(robloxPid.load(), memory) && memory.hasDetail;
+    const float values[] = {
+        signals.gameRunning ? static_cast<float>(signals.gameCpuPercent) : NAN,
+        haveSample ? static_cast<float>(sample.rssBytes / (1024.0 * 1024.0)) : NAN,
+        static_cast<float>(signals.systemCpuPercent),
+        static_cast<float>(signals.memAvailablePercent),
+        signals.thermalCelsius > 0.0 ? static_cast<float>(signals.thermalCelsius) : NAN,
+        static_cast<float>(signals.memoryPressure),
+        haveMemory ? static_cast<float>(memory.pss / (1024.0 * 1024.0)) : NAN,
+        haveMemory ? static_cast<float>(memory.swap / (1024.0 * 1024.0)) : NAN,
+        haveMemory ? static_cast<float>(memory.majorFaultsPerSec) : NAN,
+        signals.gameFps > 0.0 ? static_cast<float>(signals.gameFps) : NAN,
+        signals.gameFps > 0.0 ? static_cast<float>(signals.frameJitterMs) : NAN,
+        signals.gameRunning ? static_cast<float>(signals.runqueueP99Ms) : NAN,
+        static_cast<float>(instanceManager.count()),
+    };
+    float row[sizeof(values) / sizeof(values[0])];
+    std::fill(row, row + sizeof(row) / sizeof(row[0]), NAN);
+    for (size_t i = 0; i < metricIds.size(); i++) {
+        if (metricIds[i] >= 0 && metricIds[i] < static_cast<int>(sizeof(row) / sizeof(row[0]))) {
+            row[metricIds[i]] = values[i];
+        }
+    }
+    // Wall-clock, not the scheduler's monotonic ms: a file-backed history
+    // has to stay ordered across reboots. The store clamps backward steps.
+    uint64_t wallMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    metrics.append(wallMs, row, sizeof(row) / sizeof(row[0]));
+}
+
+void AndroidOptimizer::checkOverhead(uint64_t now) {
+    if (now - lastOverheadCheckMs < static_cast<uint64_t>(kOverheadCheckIntervalMs.get())) {
+        return;
+    }
+    lastOverheadCheckMs = now;
+    SelfProfiler::setCpuBudgetPercent(kOverheadBudgetPercent.get());
+
+    ProfileReport report;
+    SelfProfiler::snapshot(report, overheadBaseline);
+    // Log transitions only; the status string carries the current state.
+    if (report.overBudget != overBudget) {
+        overBudget = report.overBudget;
+        if (overBudget) {
+            LOGE("Optimizer overhead %.2f%% of a core exceeds budget %.2f%%",
+                 report.usage.recentCpuPercent, report.budgetPercent);
+        } else {
+            LOGI("Optimizer overhead back within budget (%.2f%%)", report.usage.recentCpuPercent);
+        }
+    }
+}
+
+void AndroidOptimizer::sampleMemory(uint64_t now) {
+    // A pool thread; the accountant and the cgroup manager lock for
+    // themselves, so this overlaps freely with the scheduler task.
+    memoryAccountant.sample(now);
+    syncBackground();
+}
+
+void AndroidOptimizer::configureMemory() {
+    MemoryAccountant::Options options;
+    options.maxDetailReadsPerPass = static_cast<uint32_t>(std::max(1, kMemoryDetailReadsPerPass.get()));
+    options.rssChangePercent = kMemoryRssChangePercent.get();
+    memoryAccountant.setOptions(options);
+}
+
+CgroupLimits AndroidOptimizer::cgroupLimits() const {
+    CgroupLimits limits;
+    limits.gameCpuWeight = static_cast<uint32_t>(std::max(0, kCgroupGameCpuWeight.get()));
+    limits.gameUclampMinPercent = kCgroupGameUclampMin.get();
+    limits.backgroundCpuWeight = static_cast<uint32_t>(std::max(0, kCgroupBackgroundCpuWeight.get()));
+    limits.backgroundCpuMaxPercent = kCgroupBackgroundCpuMax.get();
+    limits.backgroundIoWeight = static_cast<uint32_t>(std::max(0, kCgroupBackgroundIoWeight.get()));
+    return limits;
+}
+
+void AndroidOptimizer::setupCgroups() {
+    if (!kCgroupEnabled.get()) {
+        return;
+    }
+    std::string error;
+    if (!cgroupManager.setup(cgroupLimits(), &error)) {
+        LOGI("cgroup partitioning unavailable: %s", error.c_str());
+        return;
+    }
+    CgroupStatus status = cgroupManager.getStatus();
+    LOGI("cgroup partitioning at %s (controllers: %s)", status.path.c_str(),
+         status.controllers.empty() ? "none" : status.controllers.c_str());
+    pid_t pid = robloxPid.load();
+    if (pid != 0) {
+        cgroupManager.setGamePid(pid);
+    }
+}
+
+void AndroidOptimizer::syncBackground() {
+    bool cgroups = cgroupManager.isActive();
+    bool io = ioPriorityTask != 0;
+    if (!cgroups && !io) {
+        return;
+    }
+    // Background means an app the system itself ranks below foreground
+    // (oom_score_adj > 0); the game and anything unmeasured stay put. The
+    // I/O set adds the known storage-heavy packages whatever their rank.
+    std::vector<std::string> packages = Utils::split(kIoprioBackgroundPackages.get(), ',');
+    pid_t game = robloxPid.load();
+    std::vector<pid_t> background;
+    std::vector<pid_t> ioBackground;
+    for (const ProcessMemory& memory : memoryAccountant.snapshot()) {
+        if (memory.pid == game) {
+            if (cgroups && memory.hasDetail && kCgroupGameMemoryLowPercent.get() > 0) {
+                cgroupManager.setGameMemoryLow(memory.footprint() / 100 * kCgroupGameMemoryLowPercent.get());
+            }
+            continue;
+        }
+        if (memory.pid == getpid() || instanceManager.contains(memory.pid)) {
+            continue;   // ourselves, or another client, whatever the system ranks them
+        }
+        if (memory.hasDetail && memory.oomScoreAdj > 0 && SystemManager::isAppProcess(memory.uid, memory.name)) {
+            background.push_back(memory.pid);
+            ioBackground.push_back(memory.pid);
+            continue;
+        }
+        std::string package = memory.name.substr(0, memory.name.find(':'));
+        if (std::find(packages.begin(), packages.end(), package) != packages.end()) {
+            ioBackground.push_back(memory.pid);
+        }
+    }
+    if (cgroups) {
+        cgroupManager.syncBackground(background);
+    }
+    if (io) {
+        ioPriority.syncBackground(ioBackground);
+    }
+}
+
+void AndroidOptimizer::configureIoPriority() {
+    IoPriorityOptions options;
+    if (!IoPriority::parse(kIoprioGame.get(), options.game)) {
+        LOGE("Invalid ioprio.game '%s', using %s", kIoprioGame.get().c_str(), options.game.toString().c_str());
+    }
+    if (!IoPriority::parse(kIoprioBackground.get(), options.background)) {
+        LOGE("Invalid ioprio.background '%s', using %s", kIoprioBackground.get().c_str(),
+             options.background.toString().c_str());
+    }
+    options.allowHelper = true;
+    ioPriority.setOptions(options);
+}
+
+void AndroidOptimizer::setupIoPriority() {
+    if (!kIoprioEnabled.get()) {
+        return;
+    }
+    configureIoPriority();
+    ioPriority.setGamePid(robloxPid.load());
+    // Walking task lists (and any helper round trip) happens on the pool.
+    ioPriorityTask.store(eventLoop.addPeriodic("ioprio.refresh",
+                                               static_cast<uint32_t>(std::max(100, kIoprioRefreshIntervalMs.get())),
+                                               [this](uint64_t) { queueIoPriorityRefresh(); }));
+    queueIoPriorityRefresh();
+}
+
+void AndroidOptimizer::queueIoPriorityRefresh() {
+    if (ioPriorityQueued.exchange(true)) {
+        return;
+    }
+    if (!eventLoop.offload([this] {
+            ioPriority.refresh();
+            ioPriorityQueued.store(false);
+        })) {
+        ioPriorityQueued.store(false);
+    }
+}
+
+void AndroidOptimizer::configureInstances() {
+    InstanceManager::Options options;
+    // 0 turns partitioning off; the instances are still tracked.
+    options.minInstances =
+        kInstancesPartition.get() ? static_cast<uint32_t>(std::max(2, kInstancesMinInstances.get())) : 0;
+    options.planner.reservedCpus = static_cast<uint32_t>(std::max(0, kInstancesReservedCpus.get()));
+    options.planner.headroom = std::max(1.0, kInstancesHeadroom.get());
+    instanceManager.setOptions(options);
+}
+
+void AndroidOptimizer::onInstancesChanged() {
+    // Only the primary is the reclaim engine's protected pid.
+    std::vector<pid_t> pids;
+    for (const InstanceInfo& info : instanceManager.snapshot()) {
+        pids.push_back(info.pid);
+    }
+    reclaimEngine.setExcludedPids(pids);
+    queueInstancesUpdate();
+}
+
+void AndroidOptimizer::queueInstancesUpdate() {
+    if (instancesTask.load() == 0 || instancesQueued.exchange(true)) {
+        return;
+    }
+    if (!eventLoop.offload([this] {
+            if (instancesTask.load() != 0) {
+                size_t pinned = instanceManager.update(EventLoop::nowMs());
+                InstanceStats stats = instanceManager.getStats();
+                if (stats.replans != instanceReplans) {
+                    instanceReplans = stats.replans;
+                    LOGI("Instance partitions: %zu instances on %zu partitions, %zu threads pinned", stats.instances,
+                         stats.partitions, pinned);
+                }
+            }
+            instancesQueued.store(false);
+        })) {
+        instancesQueued.store(false);
+    }
+}
+
+void AndroidOptimizer::startPrewarmLearning(pid_t pid) {
+    eventLoop.remove(prewarmTask.exchange(0));
+    PrewarmRecorder::Options options;
+    options.learnMs = static_cast<uint32_t>(std::max(1000, kPrewarmLearnMs.get()));
+    prewarmRecorder.setOptions(options);
+    {
+        // Pages of the known files already cached are not this launch's.
+        std::lock_guard<std::mutex> lock(prewarmMutex);
+        if (!prewarmRecorder.attach(pid, EventLoop::nowMs(), &prewarmProfile)) {
+            return;
+        }
+    }
+    LOGI("Learning game file access for %u ms", options.learnMs);
+    // mincore() over every mapped file is a pool job; a sample still
+    // queued when the next falls due is skipped.
+    prewarmTask.store(eventLoop.addPeriodic(
+        "prewarm.learn", static_cast<uint32_t>(std::max(50, kPrewarmSampleIntervalMs.get())), [this](uint64_t now) {
+            if (prewarmQueued.exchange(true)) {
+                return;
+            }
+            if (!eventLoop.offload([this, now] {
+                    if (!prewarmRecorder.sample(now)) {
+                        finishPrewarmLearning();
+                    }
+                    prewarmQueued.store(false);
+                })) {
+                prewarmQueued.store(false);
+            }
+        }));
+}
+
+void AndroidOptimizer::finishPrewarmLearning() {
+    uint32_t unreadable = prewarmRecorder.unreadableFiles();
+    PrewarmProfile learned = prewarmRecorder.finish();
+    if (learned.sessions == 0) {
+        return;   // finished already
+    }
+    eventLoop.remove(prewarmTask.exchange(0));
+    if (unreadable > 0) {
+        LOGI("Prewarm: %u game files not readable by mincore() without root", unreadable);
+    }
+    if (learned.files.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(prewarmMutex);
+    learned.merge(prewarmProfile);
+    std::string error;
+    if (!learned.save(kPrewarmProfileFile.get(), &error)) {
+        LOGE("Cannot save prewarm profile: %s", error.c_str());
+    }
+    LOGI("Prewarm profile learned: %zu files, %zu extents, %llu KB", learned.files.size(), learned.extentCount(),
+         static_cast<unsigned long long>(learned.bytes() >> 10));
+    prewarmProfile = std::move(learned);
+    prewarmReady.store(true);
+}
+
+OptimizationResult AndroidOptimizer::prewarmGameFiles() {
+    PROFILE_SCOPE("optimize.prewarm");
+    std::lock_guard<std::mutex> lock(prewarmMutex);
+    if (prewarmProfile.files.empty()) {
+        return OptimizationResult(false, "No prewarm profile learned yet");
+    }
+    PrewarmOptions options;
+    options.threads = static_cast<unsigned>(std::max(1, kPrewarmThreads.get()));
+    options.maxBytes = static_cast<uint64_t>(std::max(1, kPrewarmMaxMb.get())) << 20;
+    options.lockBytes = static_cast<uint64_t>(std::max(0, kPrewarmLockMb.get())) << 20;
+    // The reads are the game's own, a little early: same class.
+    IoPriority::parse(kIoprioGame.get(), options.priority);
+    PrewarmResult result = prewarmer.warm(prewarmProfile, options);
+    if (result.staleFiles > 0) {
+        // The game was updated: learn the new files on the next launch.
+        prewarmReady.store(false);
+    }
+    std::string details = std::to_string(result.bytesRequested >> 20) + " MB from " + std::to_string(result.files) +
+                          " files in " + std::to_string(result.elapsedMs) + " ms";
+    if (result.bytesLocked > 0) {
+        details += ", " + std::to_string(result.bytesLocked >> 20) + " MB locked";
+    }
+    if (result.staleFiles > 0) {
+        details += ", " + std::to_string(result.staleFiles) + " changed";
+    }
+    LOGI("Prewarm: %s", details.c_str());
+    if (!result.success) {
+        return OptimizationResult(false, "Prewarm failed", result.error);
+    }
+    return OptimizationResult(true, "Game files prewarmed", details);
+}
+
+PrewarmResidency AndroidOptimizer::getPrewarmResidency() {
+    std::lock_guard<std::mutex> lock(prewarmMutex);
+    return PageCachePrewarmer::residency(prewarmProfile);
+}
+
+void AndroidOptimizer::configureReclaim(int level) {
+    int boost = std::max(level, 1) - 1;
+    ReclaimEngine::Options options;
+    options.targetAvailablePercent = kReclaimTargetPercent.get() + 5.0 * boost;
+    options.maxBytesPerTick = static_cast<uint64_t>(std::max(1, kReclaimMaxMbPerTick.get())) << (20 + boost);
+    options.maxTickMs = static_cast<uint32_t>(std::max(1, kReclaimMaxTickMs.get()));
+    options.minOomScoreAdj = kReclaimMinOomScoreAdj.get();
+    options.allowHelper = true;
+    reclaimEngine.setOptions(options);
+}
+
+void AndroidOptimizer::reclaimTick(const OptimizerSignals& signals, uint64_t now) {
+    int level = reclaimLevel.load();
+    if (level <= 0 && !reclaimBurst.load()) {
+        return;
+    }
+    // The tick's own signals settle the common case without touching the
+    // engine: nothing to do while MemAvailable is above the target.
+    double target = kReclaimTargetPercent.get() + 5.0 * (std::max(level, 1) - 1);
+    if (signals.memAvailablePercent >= target) {
+        reclaimBurst.store(false);
+        return;
+    }
+    // A pass can wait on a helper round trip and a synchronous
+    // memory.reclaim; keep it off the loop. One pass at a time.
+    if (reclaimQueued.exchange(true)) {
+        return;
+    }
+    if (!eventLoop.offload([this, level, now] {
+            configureReclaim(level);
+            ReclaimTickResult result = reclaimEngine.tick(now);
+            if (result.processes > 0) {
+                LOGI("Reclaimed %llu KB from %d background processes in %llu us (available %.1f%%)",
+                     static_cast<unsigned long long>(result.bytesReclaimed >> 10), result.processes,
+                     static_cast<unsigned long long>(result.elapsedUs), result.memAvailablePercent);
+            }
+            if (result.targetMet) {
+                reclaimBurst.store(false);
+            }
+            reclaimQueued.store(false);
+        })) {
+        reclaimQueued.store(false);
+    }
+}
+
+void AndroidOptimizer::onPressureEvent(const PressureEvent& event) {
+    // Runs on the event loop as soon as the trigger fires; the scheduler
+    // sees the same level on its next tick through getLevel().
+    if (event.resource != PressureResource::Memory || event.level < PressureLevel::Medium) {
+        return;
+    }
+    LOGI("Memory pressure %s (some avg10 %.2f%%, full avg10 %.2f%%)",
+         PressureMonitor::levelName(event.level), event.stats.someAvg10, event.stats.fullAvg10);
+    // A reclaim pass can take a helper round trip; keep it off the loop.
+    // Triggers repeat every window while pressure lasts, and reclaimTick()
+    // may already have a pass on the pool: one pass at a time.
+    if (robloxPid.load() == 0 || reclaimQueued.exchange(true)) {
+        return;
+    }
+    if (!eventLoop.offload([this] {
+            optimizeMemory();
+            reclaimQueued.store(false);
+        })) {
+        reclaimQueued.store(false);
+    }
+}
+
+bool AndroidOptimizer::applyFrequencyFloor(int level) {
+    std::lock_guard<std::mutex> lock(cpuFreqMutex);
+    if (level > 0 && cpuFreqController.discover() == 0) {
+        return false;
+    }
+    frequencyFloorLevel = level;
+    std::string error;
+    if (!applyFrequencyLocked(&error)) {
+        LOGE("Frequency floor level %d failed: %s", level, error.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AndroidOptimizer::applyFrequencyLocked(std::string* error) {
+    std::vector<CpuFreqTarget> targets = cpuFreqProfile;
+    if (frequencyFloorLevel <= 0) {
+        // restore() when optimizeCpuGovernor() never ran.
+        return cpuFreqController.revert(targets);
+    }
+    if (targets.size() < 2) {
+        targets.resize(2, targets.empty() ? CpuFreqTarget() : targets.front());
+    }
+    int index = std::min(frequencyFloorLevel,
+                         static_cast<int>(sizeof(kFloorPercentByLevel) / sizeof(kFloorPercentByLevel[0])) - 1);
+    for (size_t i = 0; i < targets.size(); i++) {
+        int floor = i == 0 ? kFloorPercentByLevel[index] / 2 : kFloorPercentByLevel[index];
+        targets[i].minFreqPercent = std::max(targets[i].minFreqPercent, floor);
+    }
+    return cpuFreqController.apply(targets, error);
+}
+
+bool AndroidOptimizer::applyGameAffinity(int level) {
+    if (level <= 0) {
+        placementActive = false;
+        if (!placementSuspended) {
+            threadPlacement.restore();
+        }
         return true;
     }
-    
-    std::string getSystemInfo() {
-        char sdk_version[PROP_VALUE_MAX];
-        char device_model[PROP_VALUE_MAX];
-        
-        __system_property_get("ro.build.version.sdk", sdk_version);
-        __system_property_get("ro.product.model", device_model);
-        
-        std::string info = "Android SDK: ";
-        info += sdk_version;
-        info += "\nDevice: ";
-        info += device_model;
-        info += "\nTarget: API 26+ (Android 8.0+)";
-        
-        return info;
+    if (!topology.isLoaded() && !topology.load()) {
+        return false;
     }
-};
+    ThreadPlacement::Thresholds thresholds;
+    thresholds.heavyPercent = kPlacementHeavyPercent.get();
+    thresholds.lightPercent = kPlacementLightPercent.get();
+    thresholds.migrationGainPercent = kPlacementMigrationGain.get();
+    threadPlacement.setThresholds(thresholds);
+    placementActive = true;
+    lastPlacementMs = 0;
+    return true;
+}
+
+void AndroidOptimizer::updatePlacement(uint64_t now) {
+    // Scheduler thread only, like the affinity knob itself.
+    if (!placementActive || now - lastPlacementMs < static_cast<uint64_t>(kPlacementIntervalMs.get())) {
+        return;
+    }
+    lastPlacementMs = now;
+    // The instance partitions own every client's affinity meanwhile; once
+    // they are gone placement starts over from the full mask.
+    bool partitioned = instanceManager.isPartitioned();
+    if (partitioned != placementSuspended) {
+        placementSuspended = partitioned;
+        if (!partitioned) {
+            threadPlacement.restore();
+        }
+        LOGI("Thread placement %s", partitioned ? "suspended for instance partitions" : "resumed");
+    }
+    if (partitioned) {
+        return;
+    }
+    pid_t pid = robloxPid.load();
+    if (pid == 0 || cpuSampler.pid() != pid) {
+        return;
+    }
+    int moved = threadPlacement.rebalance(cpuSampler);
+    if (moved > 0) {
+        LOGI("Thread placement: %d threads moved", moved);
+    }
+}
+
+void AndroidOptimizer::startOptimization() {
+    if (isRunning() || !startEventLoop()) {
+        return;
+    }
+    findRobloxProcess();
+    configureScheduler();
+    haveCpuStat = false;
+    lastOverheadCheckMs = AdaptiveScheduler::nowMs();
+    SelfUsage usage;
+    SelfProfiler::sampleUsage(usage, overheadBaseline);
+    configureMemory();
+    SelfProfiler::setCpuBudgetPercent(kOverheadBudgetPercent.get());
+    std::string tracePath = kTraceFile.get();
+    if (!tracePath.empty()) {
+        if (traceRecorder.open(tracePath)) {
+            LOGI("Recording procfs trace to %s", tracePath.c_str());
+        } else {
+            LOGE("Cannot open trace file %s: %s", tracePath.c_str(), strerror(errno));
+        }
+    }
+    setupCgroups();
+    setupIoPriority();
+    configureInstances();
+    if (topology.isLoaded() || topology.load()) {
+        uint32_t interval = static_cast<uint32_t>(std::max(100, kInstancesUpdateIntervalMs.get()));
+        instancesTask.store(
+            eventLoop.addPeriodic("instances.update", interval, [this](uint64_t) { queueInstancesUpdate(); }));
+        queueInstancesUpdate();
+    }
+    pressureMonitor.setCallback([this](const PressureEvent& event) { onPressureEvent(event); });
+    pressureMonitor.start(eventLoop);
+    LOGI("Pressure monitor running (%s)",
+         pressureMonitor.getMode() == PressureMonitor::Mode::Psi ? "psi" : "meminfo fallback");
+    // The accounting pass walks every process, so it runs on the pool; a
+    // pass still queued or running when the next one falls due is skipped.
+    memoryTask.store(eventLoop.addPeriodic(
+        "memory.sample", static_cast<uint32_t>(std::max(100, kMemorySampleIntervalMs.get())), [this](uint64_t now) {
+            if (memorySampleQueued.exchange(true)) {
+                return;
+            }
+            if (!eventLoop.offload([this, now] {
+                    sampleMemory(now);
+                    memorySampleQueued.store(false);
+                })) {
+                memorySampleQueued.store(false);
+            }
+        }));
+    scheduler.start(static_cast<uint32_t>(kSchedulerIntervalMs.get()), false);
+    schedulerTask.store(eventLoop.addPeriodic("scheduler", scheduler.getInterval(),
+                                              [this](uint64_t now) { scheduler.tick(now); }));
+    LOGI("Adaptive optimization started");
+}
+
+void AndroidOptimizer::applyConfig() {
+    LOGI("Configuration reloaded");
+    // Reclaim, placement and most thresholds read their keys per tick;
+    // these were read once by startOptimization(), which reads them afresh
+    // next time. The enabled switches also wait for the next start.
+    EventLoop::TaskId task = schedulerTask.load();
+    if (task == 0) {
+        return;
+    }
+    scheduler.setInterval(static_cast<uint32_t>(std::max(1, kSchedulerIntervalMs.get())));
+    eventLoop.setInterval(task, scheduler.getInterval());
+    configureMemory();
+    eventLoop.setInterval(memoryTask.load(), static_cast<uint32_t>(std::max(100, kMemorySampleIntervalMs.get())));
+    if (cgroupManager.isActive() && !cgroupManager.applyLimits(cgroupLimits())) {
+        LOGE("Cannot apply reloaded cgroup limits");
+    }
+    if (ioPriorityTask.load() != 0) {
+        configureIoPriority();
+        eventLoop.setInterval(ioPriorityTask.load(),
+                              static_cast<uint32_t>(std::max(100, kIoprioRefreshIntervalMs.get())));
+        queueIoPriorityRefresh();
+    }
+    configureInstances();
+    if (instancesTask.load() != 0) {
+        eventLoop.setInterval(instancesTask.load(),
+                              static_cast<uint32_t>(std::max(100, kInstancesUpdateIntervalMs.get())));
+        queueInstancesUpdate();
+    }
+}
+
+void AndroidOptimizer::stopOptimization() {
+    // Every knob is driven back to level 0 before this returns.
+    EventLoop::TaskId task = schedulerTask.exchange(0);
+    if (task == 0) {
+        return;
+    }
+    eventLoop.remove(task);
+    eventLoop.remove(memoryTask.exchange(0));
+    eventLoop.remove(ioPriorityTask.exchange(0));
+    eventLoop.remove(instancesTask.exchange(0));
+    instanceManager.restore();
+    pressureMonitor.stop();
+    scheduler.stop();
+    reclaimBurst.store(false);
+    cgroupManager.teardown();
+    ioPriority.restore();
+    if (traceRecorder.isOpen()) {
+        LOGI("Trace closed: %llu frames, %llu bytes",
+             static_cast<unsigned long long>(traceRecorder.frameCount()),
+             static_cast<unsigned long long>(traceRecorder.bytesRecorded()));
+        traceRecorder.close();
+    }
+    LOGI("Adaptive optimization stopped");
+}
+
+bool AndroidOptimizer::setJavaVM(JavaVM* vm) {
+    jvm = vm;
+    return jvm != nullptr;
+}
+
+bool AndroidOptimizer::setActivityObject(jobject activity) {
+    activityObject = activity;
+    return activityObject != nullptr;
+}
+
+OptimizationResult AndroidOptimizer::optimizeCpuGovernor() {
+    PROFILE_SCOPE("optimize.cpu_governor");
+    LOGI("Applying CPU frequency policy...");
+
+    std::lock_guard<std::mutex> lock(cpuFreqMutex);
+    int clusters = cpuFreqController.discover();
+    if (clusters == 0) {
+        return OptimizationResult(false, "No cpufreq policies available");
+    }
+
+    // policy0 is the little cluster; every later policy gets the big floor.
+    CpuFreqTarget little;
+    little.governor = kCpuFreqGovernor.get();
+    little.minFreqPercent = kLittleMinFloorPercent.get();
+    CpuFreqTarget big = little;
+    big.minFreqPercent = kBigMinFloorPercent.get();
+
+    // An active floor stays on top.
+    std::vector<CpuFreqTarget> previous = cpuFreqProfile;
+    cpuFreqProfile = {little, big};
+    std::string error;
+    if (!applyFrequencyLocked(&error)) {
+        cpuFreqProfile = previous;
+        LOGE("CPU frequency policy rolled back: %s", error.c_str());
+        return OptimizationResult(false, "Failed to apply CPU frequency policy", error);
+    }
+    return OptimizationResult(true, "CPU governor optimized",
+                              std::to_string(clusters) + " cpufreq policies updated");
+}
+
+OptimizationResult AndroidOptimizer::clearCache() {
+    PROFILE_SCOPE("optimize.clear_cache");
+    LOGI("Clearing stale cache files...");
+
+    CleanOptions options;
+    std::vector<std::string> roots = Utils::split(kCacheRoots.get(), ',');
+    if (!packageName.empty()) {
+        roots.push_back("/data/data/" + packageName + "/cache");
+    }
+    // A root listed twice would be walked twice and its files counted twice.
+    for (const std::string& root : roots) {
+        std::string path = Utils::trim(root);
+        while (path.size() > 1 && path.back() == '/') {
+            path.pop_back();
+        }
+        if (!path.empty() && std::find(options.roots.begin(), options.roots.end(), path) == options.roots.end()) {
+            options.roots.push_back(path);
+        }
+    }
+    for (const std::string& pattern : Utils::split(kCacheExclude.get(), ',')) {
+        std::string glob = Utils::trim(pattern);
+        if (!glob.empty()) {
+            options.excludes.push_back(glob);
+        }
+    }
+    CleanRule stale;
+    stale.minAgeSec = static_cast<uint64_t>(std::max(kCacheMinAgeHours.get(), 0)) * 3600;
+    options.rules.push_back(stale);
+    options.dryRun = kCacheDryRun.get();
+    options.threads = static_cast<unsigned>(std::max(kCacheThreads.get(), 0));
+
+    CleanStats stats = cacheCleaner.run(options);
+    if (!options.dryRun && !stats.cancelled && stats.dirsScanned != 0) {
+        lastCacheCleanMs.store(AdaptiveScheduler::nowMs());
+    }
+    uint64_t bytes = options.dryRun ? stats.bytesMatched : stats.bytesDeleted;
+    uint64_t files = options.dryRun ? stats.filesMatched : stats.filesDeleted;
+    std::string details = std::to_string(files) + " files, " + std::to_string(bytes >> 10) + " KB" +
+                          (options.dryRun ? " reclaimable" : " freed") + " in " +
+                          std::to_string(stats.dirsScanned) + " directories (" +
+                          std::to_string(stats.elapsedMs) + " ms)";
+    LOGI("Cache cleanup: %s, %llu errors", details.c_str(), static_cast<unsigned long long>(stats.errors));
+    if (stats.dirsScanned == 0) {
+        return OptimizationResult(false, "No cache directories readable", details);
+    }
+    return OptimizationResult(true, options.dryRun ? "Cache scanned" : "Cache cleared", details);
+}
+
+OptimizationPlan AndroidOptimizer::buildPlan() {
+    OptimizationPlan plan;
+
+    // Deleting stale cache first drops its page cache, so reclaim only
+    // goes after what is left.
+    PlanStep cache;
+    cache.name = "cache";
+    cache.isSatisfied = [this](StateCache&) {
+        uint64_t last = lastCacheCleanMs.load();
+        return last != 0 &&
+               AdaptiveScheduler::nowMs() - last < static_cast<uint64_t>(kCacheMinIntervalMin.get()) * 60000;
+    };
+    cache.apply = [this] { return clearCache(); };
+    plan.addStep(cache);
+
+    PlanStep memory;
+    memory.name = "memory";
+    memory.dependsOn = {"cache"};
+    memory.isSatisfied = [this](StateCache& state) {
+        std::string text;
+        MemInfo info;
+        if (!state.read("/proc/meminfo", text) || !ProcParser::parseMemInfo(text, info) || info.memTotal == 0) {
+            return false;
+        }
+        double target = kReclaimTargetPercent.get() + 5.0 * (std::max(reclaimLevel.load(), 1) - 1);
+        return 100.0 * info.memAvailable / info.memTotal >= target;
+    };
+    memory.apply = [this] { return optimizeMemory(); };
+    memory.invalidates = {"/proc/meminfo"};
+    plan.addStep(memory);
+
+    // After reclaim and cache cleaning, which would undo it. Satisfied
+    // while most of the profile is still resident.
+    if (prewarmReady.load()) {
+        PlanStep prewarm;
+        prewarm.name = "prewarm";
+        prewarm.dependsOn = {"cache", "memory"};
+        prewarm.isSatisfied = [this](StateCache&) { return getPrewarmResidency().residentPercent() >= 90.0; };
+        prewarm.apply = [this] { return prewarmGameFiles(); };
+        plan.addStep(prewarm);
+    }
+
+    // Settings are read back through the helper, one round trip per step.
+    PlanStep animations;
+    animations.name = "animations";
+    animations.isSatisfied = [](StateCache&) { return SystemManager::animationsDisabled(); };
+    animations.apply = [this] { return disableAnimations(); };
+    plan.addStep(animations);
+
+    PlanStep battery;
+    battery.name = "battery";
+    battery.isSatisfied = [](StateCache&) { return SystemManager::batteryOptimized(); };
+    battery.apply = [this] { return optimizeBatterySettings(); };
+    plan.addStep(battery);
+
+    // After the power profile, which may reset governors on its own.
+    // Floors are resolved against each policy's operating points, so only
+    // a governor-only profile can be checked from sysfs; the controller
+    // skips unchanged attributes either way.
+    PlanStep governor;
+    governor.name = "cpu_governor";
+    governor.dependsOn = {"battery"};
+    if (cpuFreqController.getPolicies().empty()) {
+        cpuFreqController.discover();
+    }
+    if (kLittleMinFloorPercent.get() == 0 && kBigMinFloorPercent.get() == 0) {
+        for (const CpuFreqPolicy& policy : cpuFreqController.getPolicies()) {
+            governor.targets.push_back({policy.path + "/scaling_governor", kCpuFreqGovernor.get()});
+        }
+    }
+    governor.apply = [this] { return optimizeCpuGovernor(); };
+    plan.addStep(governor);
+    return plan;
+}
+
+PlanResult AndroidOptimizer::applyProfile() {
+    PROFILE_SCOPE("optimize.apply_profile");
+    std::lock_guard<std::mutex> lock(planMutex);
+    OptimizationPlan plan = buildPlan();
+    PlanResult result = plan.execute(planState, static_cast<unsigned>(std::max(1, kPlanMaxParallel.get())));
+    for (const StepResult& step : result.steps) {
+        LOGI("  %-12s %-8s %6llu us  %s%s%s", step.name.c_str(),
+             step.skipped ? "skipped" : step.blocked ? "blocked" : step.result.success ? "applied" : "failed",
+             static_cast<unsigned long long>(step.durationUs), step.result.message.c_str(),
+             step.result.details.empty() ? "" : ": ", step.result.details.c_str());
+    }
+    LOGI("Profile applied in %llu us: %zu applied, %zu already in place", static_cast<unsigned long long>(result.elapsedUs),
+         result.applied, result.skipped);
+    return result;
+}
+
+OptimizationResult AndroidOptimizer::disableAnimations() {
+    PROFILE_SCOPE("optimize.animations");
+    LOGI("Disabling system animations...");
+
+    // WRITE_SETTINGS is not granted to apps; the helper writes them as root.
+    if (!SystemManager::disableAnimations()) {
+        return OptimizationResult(false, "Animations unchanged", "settings need root");
+    }
+    return OptimizationResult(true, "Animations disabled");
+}
+
+OptimizationResult AndroidOptimizer::optimizeBatterySettings() {
+    PROFILE_SCOPE("optimize.battery");
+    LOGI("Optimizing battery settings for gaming...");
+
+    if (!SystemManager::optimizeBattery()) {
+        return OptimizationResult(false, "Battery settings unchanged", "settings need root");
+    }
+    return OptimizationResult(true, "Battery settings optimized");
+}
+
+std::string AndroidOptimizer::getSystemInfo() {
+    char sdk_version[PROP_VALUE_MAX];
+    char device_model[PROP_VALUE_MAX];
+
+    __system_property_get("ro.build.version.sdk", sdk_version);
+    __system_property_get("ro.product.model", device_model);
+
+    std::string info = "Android SDK: ";
+    info += sdk_version;
+    info += "\nDevice: ";
+    info += device_model;
+    info += "\nTarget: API 26+ (Android 8.0+)";
+
+    return info;
+}
 
 // Global instance
 static AndroidOptimizer* g_optimizer = nullptr;
@@ -92,7 +1331,7 @@ Java_com_robloxoptimizer_MainActivity_initOptimizer(JNIEnv* env, jobject instanc
     }
 }
 
-JNIEXPORT jstring JNICALL  
+JNIEXPORT jstring JNICALL
 Java_com_robloxoptimizer_MainActivity_getSystemInfo(JNIEnv* env, jobject instance) {
     if (g_optimizer) {
         std::string info = g_optimizer->getSystemInfo();
@@ -107,18 +1346,27 @@ Java_com_robloxoptimizer_MainActivity_performOptimizations(JNIEnv* env, jobject
         LOGE("Optimizer not initialized");
         return JNI_FALSE;
     }
-    
-    bool success = true;
-    
-    success &= g_optimizer->optimizeMemory();
-    success &= g_optimizer->disableAnimations();
-    success &= g_optimizer->optimizeBattery();
-    success &= g_optimizer->optimizeCpuGovernor();
-    
+
+    bool success = g_optimizer->applyProfile().success;
+
     LOGI("Optimization complete: %s", success ? "SUCCESS" : "PARTIAL");
     return success ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT void JNICALL
+Java_com_robloxoptimizer_MainActivity_startOptimization(JNIEnv* env, jobject instance) {
+    if (g_optimizer) {
+        g_optimizer->startOptimization();
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_robloxoptimizer_MainActivity_stopOptimization(JNIEnv* env, jobject instance) {
+    if (g_optimizer) {
+        g_optimizer->stopOptimization();
+    }
+}
+
 } // extern "C"
 
 #endif // ANDROID_BUILD
@@ -2,137 +2,266 @@
 #ifdef ANDROID_BUILD
 #include <android/log.h>
 #include <sys/system_properties.h>
-#include <fstream>
+#include <chrono>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
+#include "SystemManager.h"
+#include "MemoryAccountant.h"
+#include "PrivilegedHelper.h"
+#include "ReclaimEngine.h"
+#include "ProcFs.h"
+#include "Utils.h"
+
 #define LOG_TAG "SystemManager"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+// One reader per calling thread: the fds and buffers are reused across
+// samples and no lock is needed between the UI thread and the sampler.
+ProcFsReader& procReader() {
+    thread_local ProcFsReader reader;
+    return reader;
+}
+
+// Shared by every caller; it locks internally and each query only pays
+// for the processes that changed since the previous one.
+MemoryAccountant& appAccountant() {
+    static MemoryAccountant accountant;
+    return accountant;
+}
+
+ReclaimEngine& appReclaimer() {
+    static ReclaimEngine engine(appAccountant());
+    return engine;
+}
+
+// Android app uids start at AID_APP_START; below are system services.
+constexpr uint32_t kFirstAppUid = 10000;
+
+struct Setting {
+    const char* nameSpace;
+    const char* key;
+    const char* value;
+};
+
+const std::vector<Setting> kAnimationSettings = {
+    {"global", "window_animation_scale", "0"},
+    {"global", "transition_animation_scale", "0"},
+    {"global", "animator_duration_scale", "0"},
+};
 
-class SystemManager {
-public:
-    static bool hasRootAccess() {
-        return (geteuid() == 0) || system("su -c 'echo test' 2>/dev/null") == 0;
+const std::vector<Setting> kBatterySettings = {
+    {"global", "low_power", "0"},
+    {"system", "screen_brightness_mode", "0"},
+};
+
+// Applies every setting in one helper round trip.
+bool putSettings(const std::vector<Setting>& settings) {
+    std::vector<HelperCommand> commands;
+    for (const Setting& setting : settings) {
+        commands.push_back(HelperCommand::putSetting(setting.nameSpace, setting.key, setting.value));
     }
-    
-    static std::string getCurrentCpuGovernor() {
-        std::ifstream file("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
-        if (file.is_open()) {
-            std::string governor;
-            std::getline(file, governor);
-            return governor;
-        }
-        return "unknown";
+    bool success = true;
+    for (const auto& result : PrivilegedHelper::getInstance()->execute(commands)) {
+        success &= result.success;
     }
-    
-    static bool setCpuGovernor(const std::string& governor) {
-        if (!hasRootAccess()) {
-            LOGI("Root access required for CPU governor change");
+    return success;
+}
+
+// Reads every setting back in one round trip. Scales come back as "0.0"
+// or "null" when never set, so numbers are compared by value.
+bool settingsMatch(const std::vector<Setting>& settings) {
+    std::vector<HelperCommand> commands;
+    for (const Setting& setting : settings) {
+        std::string args = std::string(setting.nameSpace) + " " + setting.key;
+        commands.push_back(HelperCommand::shell("cmd settings get " + args + " || settings get " + args));
+    }
+    std::vector<HelperResult> results = PrivilegedHelper::getInstance()->execute(commands);
+    for (size_t i = 0; i < settings.size(); i++) {
+        if (i >= results.size() || !results[i].success) {
             return false;
         }
-        
-        std::string command = "echo " + governor + " > /sys/devices/system/cpu/cpu0/cpufreq/scaling_governor";
-        return system(command.c_str()) == 0;
-    }
-    
-    static long getTotalMemory() {
-        std::ifstream meminfo("/proc/meminfo");
-        if (meminfo.is_open()) {
-            std::string line;
-            while (std::getline(meminfo, line)) {
-                if (line.find("MemTotal:") == 0) {
-                    // Extract memory value
-                    size_t start = line.find_first_of("0123456789");
-                    size_t end = line.find(" kB");
-                    if (start != std::string::npos && end != std::string::npos) {
-                        long kb = std::stol(line.substr(start, end - start));
-                        return kb * 1024; // Convert to bytes
-                    }
-                }
-            }
+        std::string current = Utils::trim(results[i].output);
+        char* end = nullptr;
+        double number = std::strtod(current.c_str(), &end);
+        bool numeric = !current.empty() && *end == '\0';
+        if (current != settings[i].value && !(numeric && number == std::strtod(settings[i].value, nullptr))) {
+            return false;
         }
-        return 0;
     }
-    
-    static long getAvailableMemory() {
-        std::ifstream meminfo("/proc/meminfo");
-        if (meminfo.is_open()) {
-            std::string line;
-            while (std::getline(meminfo, line)) {
-                if (line.find("MemAvailable:") == 0) {
-                    size_t start = line.find_first_of("0123456789");
-                    size_t end = line.find(" kB");
-                    if (start != std::string::npos && end != std::string::npos) {
-                        long kb = std::stol(line.substr(start, end - start));
-                        return kb * 1024; // Convert to bytes
-                    }
-                }
-            }
-        }
-        return 0;
+    return true;
+}
+
+uint64_t monotonicMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+bool SystemManager::hasRootAccess() {
+    // Probed once when the helper starts, then cached
+    return PrivilegedHelper::getInstance()->hasRoot();
+}
+
+bool SystemManager::executeCommand(const std::string& command) {
+    return PrivilegedHelper::getInstance()->execute(HelperCommand::shell(command)).success;
+}
+
+std::string SystemManager::getCurrentCpuGovernor() {
+    CpuFreqInfo freq;
+    if (procReader().readCpuFreq(0, freq) && freq.governor[0] != '\0') {
+        return freq.governor;
     }
-    
-    static bool disableAnimations() {
-        if (!hasRootAccess()) {
-            LOGI("Limited animation optimization without root");
-            return false;
-        }
-        
-        // Disable system animations
-        std::vector<std::string> commands = {
-            "settings put global window_animation_scale 0",
-            "settings put global transition_animation_scale 0",
-            "settings put global animator_duration_scale 0"
-        };
-        
-        bool success = true;
-        for (const auto& cmd : commands) {
-            if (system(cmd.c_str()) != 0) {
-                success = false;
-            }
-        }
-        
-        return success;
+    return "unknown";
+}
+
+long SystemManager::getTotalMemory() {
+    MemInfo info;
+    if (procReader().readMemInfo(info)) {
+        return static_cast<long>(info.memTotal);
     }
-    
-    static bool optimizeBattery() {
-        // Optimize battery settings for performance
-        std::vector<std::string> commands = {
-            "settings put global low_power 0",
-            "settings put system screen_brightness_mode 0"
-        };
-        
-        for (const auto& cmd : commands) {
-            system(cmd.c_str()); // Don't fail if some commands don't work
+    return 0;
+}
+
+long SystemManager::getAvailableMemory() {
+    MemInfo info;
+    if (procReader().readMemInfo(info)) {
+        return static_cast<long>(info.memAvailable);
+    }
+    return 0;
+}
+
+bool SystemManager::isAppProcess(uint32_t uid, const std::string& name) {
+    // App processes carry their package name (plus ":service" suffixes for
+    // secondary processes) as argv[0]; native daemons a path.
+    return uid >= kFirstAppUid && !name.empty() && name[0] != '/' && name.find('.') != std::string::npos;
+}
+
+std::vector<AndroidAppInfo> SystemManager::getRunningApps() {
+    MemoryAccountant& accountant = appAccountant();
+    accountant.sample(monotonicMs());
+    std::vector<AndroidAppInfo> apps;
+    // Largest footprint first.
+    for (const ProcessMemory& memory : accountant.snapshot()) {
+        if (!isAppProcess(memory.uid, memory.name)) {
+            continue;
         }
-        
-        return true;
+        AndroidAppInfo info;
+        info.packageName = memory.name;
+        info.appName = memory.name;
+        info.uid = static_cast<int>(memory.uid);
+        info.memoryUsage = static_cast<long>(memory.footprint());
+        info.isRunning = true;
+        apps.push_back(info);
     }
-    
-    static std::string getSystemInfo() {
-        char brand[PROP_VALUE_MAX];
-        char model[PROP_VALUE_MAX];
-        char version[PROP_VALUE_MAX];
-        char sdk[PROP_VALUE_MAX];
-        
-        __system_property_get("ro.product.brand", brand);
-        __system_property_get("ro.product.model", model);
-        __system_property_get("ro.build.version.release", version);
-        __system_property_get("ro.build.version.sdk", sdk);
-        
-        std::string info = "Brand: ";
-        info += brand;
-        info += "\nModel: ";
-        info += model;  
-        info += "\nAndroid: ";
-        info += version;
-        info += "\nSDK: ";
-        info += sdk;
-        info += "\nRoot: ";
-        info += hasRootAccess() ? "Yes" : "No";
-        
+    return apps;
+}
+
+AndroidAppInfo SystemManager::getAppInfo(const std::string& packageName) {
+    AndroidAppInfo info;
+    info.packageName = packageName;
+    info.appName = packageName;
+    info.uid = -1;
+    info.memoryUsage = 0;
+    info.isRunning = false;
+
+    MemoryAccountant& accountant = appAccountant();
+    uint64_t now = monotonicMs();
+    accountant.sample(now);
+    ProcessMemory memory;
+    if (!accountant.findByName(packageName, memory)) {
         return info;
     }
-};
+    // Fresh PSS for the one app asked about, outside the pass budget.
+    accountant.refreshDetail(memory.pid, now);
+    accountant.get(memory.pid, memory);
+    info.uid = static_cast<int>(memory.uid);
+    info.memoryUsage = static_cast<long>(memory.footprint());
+    info.isRunning = true;
+    return info;
+}
+
+bool SystemManager::trimMemory(const std::string& packageName) {
+    MemoryAccountant& accountant = appAccountant();
+    accountant.sample(monotonicMs());
+    ProcessMemory memory;
+    if (!accountant.findByName(packageName, memory)) {
+        LOGI("trimMemory: %s is not running", packageName.c_str());
+        return false;
+    }
+    ReclaimEngine& engine = appReclaimer();
+    ReclaimEngine::Options options;
+    options.allowHelper = true;
+    engine.setOptions(options);
+    uint64_t reclaimed = 0;
+    ReclaimMethod method = ReclaimMethod::None;
+    if (!engine.reclaimProcess(memory.pid, memory.rss, reclaimed, &method)) {
+        LOGE("trimMemory: cannot reclaim from %s (pid %d)", packageName.c_str(), memory.pid);
+        return false;
+    }
+    LOGI("trimMemory: %llu KB reclaimed from %s via %s", static_cast<unsigned long long>(reclaimed >> 10),
+         packageName.c_str(), ReclaimEngine::methodName(method));
+    return true;
+}
+
+bool SystemManager::readSystemSnapshot(SystemSnapshot& snapshot) {
+    return procReader().readSnapshot(snapshot);
+}
+
+bool SystemManager::disableAnimations() {
+    if (!hasRootAccess()) {
+        LOGI("Limited animation optimization without root");
+        return false;
+    }
+    
+    return putSettings(kAnimationSettings);
+}
+
+bool SystemManager::animationsDisabled() {
+    return hasRootAccess() && settingsMatch(kAnimationSettings);
+}
+
+bool SystemManager::optimizeBattery() {
+    // Battery saver off and fixed brightness, for performance
+    if (!hasRootAccess()) {
+        LOGI("Battery settings need root");
+        return false;
+    }
+    return putSettings(kBatterySettings);
+}
+
+bool SystemManager::batteryOptimized() {
+    return hasRootAccess() && settingsMatch(kBatterySettings);
+}
+
+std::string SystemManager::getSystemInfo() {
+    char brand[PROP_VALUE_MAX];
+    char model[PROP_VALUE_MAX];
+    char version[PROP_VALUE_MAX];
+    char sdk[PROP_VALUE_MAX];
+    
+    __system_property_get("ro.product.brand", brand);
+    __system_property_get("ro.product.model", model);
+    __system_property_get("ro.build.version.release", version);
+    __system_property_get("ro.build.version.sdk", sdk);
+    
+    std::string info = "Brand: ";
+    info += brand;
+    info += "\nModel: ";
+    info += model;  
+    info += "\nAndroid: ";
+    info += version;
+    info += "\nSDK: ";
+    info += sdk;
+    info += "\nRoot: ";
+    info += hasRootAccess() ? "Yes" : "No";
+    
+    return info;
+}
 
 #endif // ANDROID_BUILD
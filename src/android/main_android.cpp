@@ -2,11 +2,23 @@
 #ifdef ANDROID_BUILD
 #include <jni.h>
 #include <android/log.h>
+#include <mutex>
 #include <string>
 
+#include "SelfProfiler.h"
+
 #define LOG_TAG "RobloxOptimizer"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 
+namespace {
+
+// The status screen's own window for recent CPU, apart from the
+// optimizer's budget check.
+std::mutex g_statusMutex;
+UsageBaseline g_statusBaseline;
+
+} // namespace
+
 extern "C" {
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
@@ -26,7 +38,16 @@ Java_com_robloxoptimizer_MainActivity_getOptimizationStatus(JNIEnv* env, jobject
                         "🎯 Target: Roblox mobile optimization\n"
                         "🛡️ Safe: System-level optimization only\n"
                         "⚡ Status: Basic build test successful";
-    
+
+    // Cost of the optimizer itself: per-site latencies, counters, CPU and RSS.
+    ProfileReport report;
+    {
+        std::lock_guard<std::mutex> lock(g_statusMutex);
+        SelfProfiler::snapshot(report, g_statusBaseline);
+    }
+    status += "\n\n📊 Optimizer overhead\n";
+    status += SelfProfiler::formatReport(report);
+
     return env->NewStringUTF(status.c_str());
 }
 
@@ -0,0 +1,282 @@
+// src/common/AdaptiveScheduler.cpp - Closed-loop optimization scheduler
+#include "AdaptiveScheduler.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+// ---------------------------------------------------------------------------
+// HysteresisLevel
+
+HysteresisLevel::HysteresisLevel(std::vector<double> levelThresholds, double hysteresisMargin, int dwell)
+    : thresholds(std::move(levelThresholds)), margin(hysteresisMargin), dwellTicks(std::max(dwell, 1)),
+      level(0), pendingLevel(0), pendingCount(0) {}
+
+int HysteresisLevel::update(double value) {
+    int target = level;
+    while (target < static_cast<int>(thresholds.size()) && value >= thresholds[target]) {
+        target++;
+    }
+    while (target > 0 && value < thresholds[target - 1] - margin) {
+        target--;
+    }
+
+    if (target == level) {
+        pendingCount = 0;
+        return level;
+    }
+    if (target != pendingLevel) {
+        pendingLevel = target;
+        pendingCount = 0;
+    }
+    if (++pendingCount >= dwellTicks) {
+        level = target;
+        pendingCount = 0;
+    }
+    return level;
+}
+
+void HysteresisLevel::reset() {
+    level = 0;
+    pendingLevel = 0;
+    pendingCount = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Built-in policies
+
+CpuFloorPolicy::CpuFloorPolicy(double thermalLimitCelsius)
+    // Load is per core: three floors as the game saturates 0.6, 1.2, 2 cores.
+    : load({60.0, 120.0, 200.0}, 15.0, 3),
+      thermal({thermalLimitCelsius}, 5.0, 2) {}
+
+int CpuFloorPolicy::evaluate(const OptimizerSignals& signals) {
+    if (!signals.gameRunning) {
+        load.reset();
+        return 0;
+    }
+    int level = load.update(signals.gameCpuPercent);
+    if (signals.thermalCelsius > 0.0 && thermal.update(signals.thermalCelsius) > 0) {
+        return 0;
+    }
+    return level;
+}
+
+void CpuFloorPolicy::reset() {
+    load.reset();
+    thermal.reset();
+}
+
+AffinityPolicy::AffinityPolicy(double starvationP99Ms)
+    : load({150.0}, 50.0, 5),
+      starvation({starvationP99Ms}, starvationP99Ms / 2, 3) {}
+
+int AffinityPolicy::evaluate(const OptimizerSignals& signals) {
+    if (!signals.gameRunning) {
+        reset();
+        return 0;
+    }
+    return std::max(load.update(signals.gameCpuPercent), starvation.update(signals.runqueueP99Ms));
+}
+
+void AffinityPolicy::reset() {
+    load.reset();
+    starvation.reset();
+}
+
+// Pressure = 100 - MemAvailable%: light trim under 15% free, heavy under 8%.
+MemoryTrimPolicy::MemoryTrimPolicy() : pressure({85.0, 92.0}, 5.0, 2) {}
+
+int MemoryTrimPolicy::evaluate(const OptimizerSignals& signals) {
+    if (!signals.gameRunning) {
+        pressure.reset();
+        return 0;
+    }
+    int level = pressure.update(100.0 - signals.memAvailablePercent);
+    return std::max(level, std::min(signals.memoryPressure - 1, 2));
+}
+
+// ---------------------------------------------------------------------------
+// AdaptiveScheduler
+
+AdaptiveScheduler::AdaptiveScheduler()
+    : ticks(0), running(false), intervalMs(500), stopRequested(false) {}
+
+AdaptiveScheduler::~AdaptiveScheduler() {
+    stop();
+}
+
+uint64_t AdaptiveScheduler::nowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void AdaptiveScheduler::setSignalSource(SignalSource signalSource) {
+    std::lock_guard<std::mutex> lock(mutex);
+    source = std::move(signalSource);
+}
+
+void AdaptiveScheduler::addPolicy(std::unique_ptr<OptimizationPolicy> policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policies.push_back(std::move(policy));
+}
+
+void AdaptiveScheduler::addKnob(const std::string& name, Actuator actuator, uint32_t minIntervalMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Knob* existing = findKnob(name);
+    Knob& knob = existing ? *existing : (knobs.emplace_back(), knobs.back());
+    knob.name = name;
+    knob.actuator = std::move(actuator);
+    knob.minIntervalMs = minIntervalMs;
+}
+
+void AdaptiveScheduler::addTickListener(TickListener listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    listeners.push_back(std::move(listener));
+}
+
+bool AdaptiveScheduler::isConfigured() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return source && !policies.empty();
+}
+
+AdaptiveScheduler::Knob* AdaptiveScheduler::findKnob(const std::string& name) {
+    for (auto& knob : knobs) {
+        if (knob.name == name) {
+            return &knob;
+        }
+    }
+    return nullptr;
+}
+
+void AdaptiveScheduler::applyLocked(Knob& knob, int level, uint64_t now, bool force) {
+    knob.desired = level;
+    if (level == knob.applied) {
+        return;
+    }
+    // Rate limit covers failed attempts too, so a broken actuator is not
+    // hammered every tick.
+    if (!force && knob.lastAttemptMs != 0 && now - knob.lastAttemptMs < knob.minIntervalMs) {
+        return;
+    }
+    knob.lastAttemptMs = now;
+    if (knob.actuator && !knob.actuator(level)) {
+        knob.failures++;
+        return;
+    }
+    knob.applied = level;
+    knob.lastChangeMs = now;
+    knob.changes++;
+}
+
+void AdaptiveScheduler::tick(uint64_t now) {
+    PROFILE_SCOPE("scheduler.tick");
+    OptimizerSignals signals;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!source || !source(signals)) {
+            return;
+        }
+    }
+    signals.timestampMs = now;
+    tick(now, signals);
+}
+
+void AdaptiveScheduler::tick(uint64_t now, const OptimizerSignals& signals) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastSignals = signals;
+    ticks++;
+
+    // Every knob starts at 0 each tick and takes the highest level asked.
+    std::vector<int> wanted(knobs.size(), 0);
+    for (auto& policy : policies) {
+        int level = policy->evaluate(signals);
+        for (size_t i = 0; i < knobs.size(); i++) {
+            if (knobs[i].name == policy->knob()) {
+                wanted[i] = std::max(wanted[i], level);
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < knobs.size(); i++) {
+        applyLocked(knobs[i], wanted[i], now, false);
+    }
+    for (auto& listener : listeners) {
+        listener(signals, now);
+    }
+}
+
+void AdaptiveScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopRequested) {
+        lock.unlock();
+        tick(nowMs());
+        lock.lock();
+        wake.wait_for(lock, std::chrono::milliseconds(intervalMs.load()), [this] { return stopRequested; });
+    }
+}
+
+bool AdaptiveScheduler::start(uint32_t tickIntervalMs, bool spawnThread) {
+    if (running.exchange(true)) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = false;
+        for (auto& policy : policies) {
+            policy->reset();
+        }
+    }
+    intervalMs.store(std::max<uint32_t>(tickIntervalMs, 10));
+    if (spawnThread) {
+        thread = std::thread(&AdaptiveScheduler::run, this);
+    }
+    return true;
+}
+
+void AdaptiveScheduler::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t now = nowMs();
+    for (auto& knob : knobs) {
+        applyLocked(knob, 0, now, true);
+    }
+}
+
+std::vector<AdaptiveScheduler::KnobStatus> AdaptiveScheduler::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<KnobStatus> status;
+    status.reserve(knobs.size());
+    for (const auto& knob : knobs) {
+        KnobStatus entry;
+        entry.name = knob.name;
+        entry.level = knob.applied;
+        entry.desired = knob.desired;
+        entry.lastChangeMs = knob.lastChangeMs;
+        entry.changes = knob.changes;
+        entry.failures = knob.failures;
+        status.push_back(entry);
+    }
+    return status;
+}
+
+OptimizerSignals AdaptiveScheduler::getLastSignals() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastSignals;
+}
+
+uint64_t AdaptiveScheduler::getTickCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ticks;
+}
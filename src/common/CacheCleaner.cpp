@@ -0,0 +1,344 @@
+// src/common/CacheCleaner.cpp - Parallel cache/temp directory cleaner
+#if defined(__linux__)
+#include "CacheCleaner.h"
+#include "IoPriority.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef STATX_SIZE
+#include <linux/stat.h>
+#endif
+
+namespace {
+
+constexpr unsigned kMaxThreads = 4;
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+struct Counters {
+    std::atomic<uint64_t> dirsScanned{0};
+    std::atomic<uint64_t> filesScanned{0};
+    std::atomic<uint64_t> filesMatched{0};
+    std::atomic<uint64_t> bytesMatched{0};
+    std::atomic<uint64_t> filesDeleted{0};
+    std::atomic<uint64_t> bytesDeleted{0};
+    std::atomic<uint64_t> dirsRemoved{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+struct Walk;
+
+// An open directory. Subdirectory tasks hold a reference to their parent,
+// so the parent's fd outlives every openat() relative to it, and the
+// handle is released exactly when its whole subtree is done - which is
+// when an emptied directory can be removed.
+struct DirHandle {
+    int fd = -1;
+    std::shared_ptr<DirHandle> parent;
+    std::string name;
+    std::atomic<bool> deletedEntry{false};
+    Walk* walk = nullptr;
+
+    ~DirHandle();
+};
+
+struct Task {
+    std::shared_ptr<DirHandle> parent;     // null for a root
+    std::string name;                      // relative to parent, or an absolute root
+    int depth = 0;
+};
+
+struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+};
+
+struct Walk {
+    const CleanOptions& options;
+    std::atomic<bool>& cancelled;
+    Counters counters;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<int64_t> pending{0};
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    time_t now;
+
+    Walk(const CleanOptions& walkOptions, std::atomic<bool>& cancelFlag)
+        : options(walkOptions), cancelled(cancelFlag), now(time(nullptr)) {}
+
+    void push(size_t worker, Task task) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(workers[worker]->mutex);
+            workers[worker]->tasks.push_back(std::move(task));
+        }
+        idle.notify_one();
+    }
+
+    bool take(size_t self, Task& out) {
+        {
+            Worker& own = *workers[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                out = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < workers.size(); i++) {
+            Worker& victim = *workers[(self + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                out = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void finish() {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            idle.notify_all();
+        }
+    }
+
+    bool excluded(const char* name) const {
+        for (const std::string& pattern : options.excludes) {
+            if (fnmatch(pattern.c_str(), name, 0) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool matches(const char* name, uint64_t size, time_t lastUse) const {
+        if (options.rules.empty()) {
+            return true;
+        }
+        for (const CleanRule& rule : options.rules) {
+            if ((rule.glob.empty() || fnmatch(rule.glob.c_str(), name, 0) == 0) && size >= rule.minSizeBytes &&
+                (rule.minAgeSec == 0 || (now > lastUse && static_cast<uint64_t>(now - lastUse) >= rule.minAgeSec))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void process(size_t self, Task& task);
+    void cleanFile(DirHandle& dir, const char* name);
+    void run(size_t self);
+};
+
+DirHandle::~DirHandle() {
+    if (fd >= 0) {
+        close(fd);
+    }
+    // Only directories this run emptied; ENOTEMPTY leaves the rest alone.
+    if (parent && parent->fd >= 0 && deletedEntry.load(std::memory_order_relaxed) &&
+        walk->options.removeEmptyDirs && !walk->options.dryRun &&
+        unlinkat(parent->fd, name.c_str(), AT_REMOVEDIR) == 0) {
+        walk->counters.dirsRemoved.fetch_add(1, std::memory_order_relaxed);
+        parent->deletedEntry.store(true, std::memory_order_relaxed);
+    }
+}
+
+void Walk::cleanFile(DirHandle& dir, const char* name) {
+    counters.filesScanned.fetch_add(1, std::memory_order_relaxed);
+    uint64_t size = 0;
+    uint64_t allocated = 0;
+    time_t lastUse = 0;
+    struct statx info;
+    // AT_STATX_DONT_SYNC: network/FUSE mounts may answer from cache.
+    if (syscall(SYS_statx, dir.fd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+                STATX_SIZE | STATX_BLOCKS | STATX_ATIME | STATX_MTIME, &info) == 0) {
+        size = info.stx_size;
+        allocated = info.stx_blocks * 512;
+        lastUse = static_cast<time_t>(std::max(info.stx_atime.tv_sec, info.stx_mtime.tv_sec));
+    } else {
+        struct stat fallback;   // kernels before 4.11
+        if (errno != ENOSYS || fstatat(dir.fd, name, &fallback, AT_SYMLINK_NOFOLLOW) != 0) {
+            counters.errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        size = static_cast<uint64_t>(fallback.st_size);
+        allocated = static_cast<uint64_t>(fallback.st_blocks) * 512;
+        lastUse = std::max(fallback.st_atime, fallback.st_mtime);
+    }
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+
+    if (!matches(name, size, lastUse)) {
+        return;
+    }
+    counters.filesMatched.fetch_add(1, std::memory_order_relaxed);
+    counters.bytesMatched.fetch_add(allocated, std::memory_order_relaxed);
+    if (options.dryRun) {
+        return;
+    }
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    if (unlinkat(dir.fd, name, 0) != 0) {
+        if (errno != ENOENT) {
+            counters.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    dir.deletedEntry.store(true, std::memory_order_relaxed);
+    counters.filesDeleted.fetch_add(1, std::memory_order_relaxed);
+    uint64_t total = counters.bytesDeleted.fetch_add(allocated, std::memory_order_relaxed) + allocated;
+    if (options.maxBytes && total >= options.maxBytes) {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+}
+
+void Walk::process(size_t self, Task& task) {
+    int parentFd = task.parent ? task.parent->fd : AT_FDCWD;
+    int fd = openat(parentFd, task.name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            counters.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    auto handle = std::make_shared<DirHandle>();
+    handle->fd = fd;
+    handle->parent = task.parent;
+    handle->name = task.name;
+    handle->walk = this;
+    counters.dirsScanned.fetch_add(1, std::memory_order_relaxed);
+
+    alignas(8) char buffer[32768];
+    while (!cancelled.load(std::memory_order_relaxed)) {
+        long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n <= 0) {
+            if (n < 0) {
+                counters.errors.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            const char* name = entry->d_name;
+            if ((name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) || excluded(name)) {
+                continue;
+            }
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                // Some filesystems (older XFS, FUSE) don't fill d_type.
+                struct stat info;
+                if (fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+                    continue;
+                }
+                type = S_ISDIR(info.st_mode) ? DT_DIR : DT_REG;
+            }
+            if (type == DT_DIR) {
+                if (task.depth < options.maxDepth) {
+                    push(self, Task{handle, name, task.depth + 1});
+                }
+            } else {
+                cleanFile(*handle, name);
+            }
+        }
+    }
+}
+
+void Walk::run(size_t self) {
+    if (options.idleIoPriority) {
+        // Both apply to the calling thread only: ioprio "process" 0 and
+        // setpriority(PRIO_PROCESS, tid) are per-task on Linux.
+        IoPriorityManager::setCurrentThreadIdle();
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+    }
+    for (;;) {
+        Task task;
+        if (take(self, task)) {
+            if (!cancelled.load(std::memory_order_relaxed)) {
+                process(self, task);
+            }
+            task = Task();   // drop the parent reference before finishing
+            finish();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idleMutex);
+        if (pending.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+        // Woken by a push or the last finish; the timeout covers a push
+        // racing between take() and wait().
+        idle.wait_for(lock, std::chrono::milliseconds(5));
+    }
+}
+
+} // namespace
+
+CacheCleaner::CacheCleaner() : cancelRequested(false), running(false) {}
+
+CleanStats CacheCleaner::run(const CleanOptions& options) {
+    PROFILE_SCOPE("cleaner.run");
+    auto start = std::chrono::steady_clock::now();
+    cancelRequested.store(false, std::memory_order_relaxed);
+    running.store(true, std::memory_order_release);
+
+    Walk walk(options, cancelRequested);
+    unsigned threads = options.threads ? options.threads
+                                       : std::min(kMaxThreads, std::max(1u, std::thread::hardware_concurrency()));
+    for (unsigned i = 0; i < threads; i++) {
+        walk.workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    // Roots are spread over the workers up front; stealing balances the rest.
+    for (size_t i = 0; i < options.roots.size(); i++) {
+        if (!options.roots[i].empty() && options.roots[i][0] == '/') {
+            walk.push(i % threads, Task{nullptr, options.roots[i], 0});
+        }
+    }
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; i++) {
+        pool.emplace_back([&walk, i] { walk.run(i); });
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    CleanStats stats;
+    stats.dirsScanned = walk.counters.dirsScanned.load();
+    stats.filesScanned = walk.counters.filesScanned.load();
+    stats.filesMatched = walk.counters.filesMatched.load();
+    stats.bytesMatched = walk.counters.bytesMatched.load();
+    stats.filesDeleted = walk.counters.filesDeleted.load();
+    stats.bytesDeleted = walk.counters.bytesDeleted.load();
+    stats.dirsRemoved = walk.counters.dirsRemoved.load();
+    stats.errors = walk.counters.errors.load();
+    stats.cancelled = cancelRequested.load();
+    stats.elapsedMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    running.store(false, std::memory_order_release);
+    return stats;
+}
+
+#endif // __linux__
@@ -0,0 +1,478 @@
+// src/common/CgroupManager.cpp - cgroup v2 game/background partitioning
+#if defined(__linux__)
+#include "CgroupManager.h"
+#include "PrivilegedHelper.h"
+#include "ProcFs.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kStateHeader[] = "roblox_optimizer_cgroup_v1";
+
+// Controllers delegated to the two groups, in subtree_control order.
+const char* const kControllers[] = {"cpu", "memory", "io"};
+
+const char* groupLeaf(CgroupManager::Group group) {
+    return group == CgroupManager::Group::Game ? "game" : "background";
+}
+
+bool hasToken(const std::string& list, const std::string& token) {
+    std::istringstream fields(list);
+    std::string field;
+    while (fields >> field) {
+        if (field == token) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+CgroupManager::CgroupManager(const std::string& rootPrefix, const std::string& name, const std::string& stateFilePath)
+    : root(rootPrefix), mount(rootPrefix + "/sys/fs/cgroup"), groupName(name), stateFile(stateFilePath),
+      active(false), gamePid(0), gameMemoryLow(0), failedMoves(0) {}
+
+CgroupManager::~CgroupManager() {
+    teardown();
+}
+
+std::string CgroupManager::groupDir(Group group) const {
+    return mount + relativePath(group);
+}
+
+std::string CgroupManager::relativePath(Group group) const {
+    return "/" + groupName + "/" + groupLeaf(group);
+}
+
+bool CgroupManager::writeValue(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t n = write(fd, value.data(), value.size());
+        close(fd);
+        PROFILE_COUNT(ProfileCounter::Syscalls, 3);
+        PROFILE_COUNT(ProfileCounter::BytesWritten, n > 0 ? static_cast<uint64_t>(n) : 0);
+        return n == static_cast<ssize_t>(value.size());
+    }
+    if (errno != EACCES && errno != EPERM) {
+        return false;
+    }
+    return PrivilegedHelper::getInstance()->execute(HelperCommand::writeFile(path, value)).success;
+}
+
+bool CgroupManager::makeDir(const std::string& path) {
+    if (mkdir(path.c_str(), 0755) == 0 || errno == EEXIST) {
+        return true;
+    }
+    if (errno != EACCES && errno != EPERM) {
+        return false;
+    }
+    return PrivilegedHelper::getInstance()->execute(
+        HelperCommand::shell("mkdir -p " + PrivilegedHelper::shellQuote(path))).success;
+}
+
+bool CgroupManager::removeDir(const std::string& path) {
+    if (rmdir(path.c_str()) == 0 || errno == ENOENT) {
+        return true;
+    }
+    if (errno != EACCES && errno != EPERM) {
+        return false;   // EBUSY: still populated
+    }
+    return PrivilegedHelper::getInstance()->execute(
+        HelperCommand::shell("rmdir " + PrivilegedHelper::shellQuote(path))).success;
+}
+
+std::string CgroupManager::readValue(const std::string& path) const {
+    ProcFile file(path, 512);
+    return std::string(ProcParser::trimLine(file.read()));
+}
+
+std::vector<pid_t> CgroupManager::readMembers(const std::string& dir) const {
+    std::vector<pid_t> pids;
+    ProcFile file(dir + "/cgroup.procs", 4096);
+    std::string_view text = file.read();
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        uint64_t pid = 0;
+        if (ProcParser::parseUnsigned(text.substr(0, end), pid) && pid > 0) {
+            pids.push_back(static_cast<pid_t>(pid));
+        }
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    }
+    return pids;
+}
+
+std::string CgroupManager::cgroupOf(pid_t pid) const {
+    ProcFile file(root + "/proc/" + std::to_string(pid) + "/cgroup", 1024);
+    std::string_view text = file.read();
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        if (line.compare(0, 3, "0::") == 0) {
+            return std::string(line.substr(3));
+        }
+    }
+    return std::string();
+}
+
+bool CgroupManager::frozen(const std::string& cgroup) const {
+    if (cgroup.empty() || cgroup == "/") {
+        return false;
+    }
+    // cgroup.freeze is what the system asked for, cgroup.events' "frozen"
+    // what took effect; either way it wants the process stopped.
+    if (readValue(mount + cgroup + "/cgroup.freeze") == "1") {
+        return true;
+    }
+    ProcFile events(mount + cgroup + "/cgroup.events", 256);
+    return events.read().find("frozen 1") != std::string_view::npos;
+}
+
+void CgroupManager::resetParentLocked() {
+    // Only matters if the group outlives teardown (a member we could not
+    // move back keeps it populated).
+    std::string parent = mount + "/" + groupName;
+    if (access((parent + "/cpu.uclamp.min").c_str(), F_OK) == 0) {
+        writeValue(parent + "/cpu.uclamp.min", "0");
+    }
+    if (access((parent + "/memory.low").c_str(), F_OK) == 0) {
+        writeValue(parent + "/memory.low", "0");
+    }
+}
+
+bool CgroupManager::movePid(pid_t pid, const std::string& cgroup) {
+    std::string dir = cgroup == "/" || cgroup.empty() ? mount : mount + cgroup;
+    if (writeValue(dir + "/cgroup.procs", std::to_string(pid))) {
+        return true;
+    }
+    failedMoves++;
+    return false;
+}
+
+bool CgroupManager::enter(pid_t pid, Group group) {
+    if (origins.find(pid) == origins.end()) {
+        std::string origin = cgroupOf(pid);
+        if (origin.empty()) {
+            return false;   // exited, or no v2 membership to return to
+        }
+        // Already inside our tree (a previous instance died): nothing
+        // better to return to than the root.
+        std::string ours = "/" + groupName;
+        if (origin.compare(0, ours.size(), ours) == 0 && (origin.size() == ours.size() || origin[ours.size()] == '/')) {
+            origin = "/";
+        }
+        origins[pid] = origin;
+    }
+    return movePid(pid, relativePath(group));
+}
+
+void CgroupManager::leave(pid_t pid) {
+    auto it = origins.find(pid);
+    if (it == origins.end()) {
+        return;
+    }
+    // ESRCH once the process is gone; nothing to undo then.
+    movePid(pid, it->second);
+    origins.erase(it);
+}
+
+bool CgroupManager::isAvailable() const {
+    return access((mount + "/cgroup.controllers").c_str(), R_OK) == 0;
+}
+
+bool CgroupManager::setup(const CgroupLimits& limits, std::string* error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active) {
+        return applyLimitsLocked(limits);
+    }
+    if (!isAvailable()) {
+        if (error) *error = "no cgroup v2 hierarchy at " + mount;
+        return false;
+    }
+
+    // A controller reaches our groups only if every ancestor enables it.
+    std::string available = readValue(mount + "/cgroup.controllers");
+    std::string rootEnabled = readValue(mount + "/cgroup.subtree_control");
+    std::string groupDirPath = mount + "/" + groupName;
+    if (!makeDir(groupDirPath) || !makeDir(groupDir(Group::Game)) || !makeDir(groupDir(Group::Background))) {
+        if (error) *error = std::string("cannot create ") + groupDirPath + ": " + std::strerror(errno);
+        return false;
+    }
+    controllers.clear();
+    for (const char* controller : kControllers) {
+        if (!hasToken(available, controller)) {
+            continue;
+        }
+        if (!hasToken(rootEnabled, controller) &&
+            !writeValue(mount + "/cgroup.subtree_control", std::string("+") + controller)) {
+            continue;
+        }
+        if (writeValue(groupDirPath + "/cgroup.subtree_control", std::string("+") + controller)) {
+            controllers.push_back(controller);
+        }
+    }
+    active = true;
+    applyLimitsLocked(limits);
+    saveStateLocked();
+    return true;
+}
+
+bool CgroupManager::applyLimitsLocked(const CgroupLimits& limits) {
+    if (!active) {
+        return false;
+    }
+    bool ok = true;
+    char value[64];
+    std::string game = groupDir(Group::Game);
+    std::string background = groupDir(Group::Background);
+    bool cpu = std::find(controllers.begin(), controllers.end(), "cpu") != controllers.end();
+    bool memory = std::find(controllers.begin(), controllers.end(), "memory") != controllers.end();
+    bool io = std::find(controllers.begin(), controllers.end(), "io") != controllers.end();
+    // uclamp.min and memory.low are both capped by every ancestor's value,
+    // and our parent group starts at 0: it gets the game's value too (the
+    // background child keeps its own 0, so it gains nothing from it).
+    std::string parent = mount + "/" + groupName;
+
+    if (cpu && limits.gameCpuWeight) {
+        ok &= writeValue(game + "/cpu.weight", std::to_string(limits.gameCpuWeight));
+    }
+    // cpu.uclamp.* needs CONFIG_UCLAMP_TASK_GROUP; absent is not an error.
+    if (cpu && limits.gameUclampMinPercent > 0.0 && access((game + "/cpu.uclamp.min").c_str(), F_OK) == 0) {
+        std::snprintf(value, sizeof(value), "%.2f", std::min(limits.gameUclampMinPercent, 100.0));
+        ok &= writeValue(parent + "/cpu.uclamp.min", value);
+        ok &= writeValue(game + "/cpu.uclamp.min", value);
+    }
+    if (memory && limits.gameMemoryLowBytes) {
+        ok &= writeValue(parent + "/memory.low", std::to_string(limits.gameMemoryLowBytes));
+        ok &= writeValue(game + "/memory.low", std::to_string(limits.gameMemoryLowBytes));
+        gameMemoryLow = limits.gameMemoryLowBytes;
+    }
+    if (cpu && limits.backgroundCpuWeight) {
+        ok &= writeValue(background + "/cpu.weight", std::to_string(limits.backgroundCpuWeight));
+    }
+    if (cpu && limits.backgroundCpuMaxPercent > 0.0 && limits.cpuPeriodUs) {
+        uint64_t quota = static_cast<uint64_t>(limits.backgroundCpuMaxPercent / 100.0 * limits.cpuPeriodUs);
+        // The kernel's floor for a quota is 1 ms.
+        std::snprintf(value, sizeof(value), "%llu %u", static_cast<unsigned long long>(std::max<uint64_t>(quota, 1000)),
+                      limits.cpuPeriodUs);
+        ok &= writeValue(background + "/cpu.max", value);
+    }
+    if (io && limits.backgroundIoWeight && access((background + "/io.weight").c_str(), F_OK) == 0) {
+        ok &= writeValue(background + "/io.weight", "default " + std::to_string(limits.backgroundIoWeight));
+    }
+    return ok;
+}
+
+bool CgroupManager::applyLimits(const CgroupLimits& limits) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return applyLimitsLocked(limits);
+}
+
+bool CgroupManager::setGameMemoryLow(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active || std::find(controllers.begin(), controllers.end(), "memory") == controllers.end()) {
+        return false;
+    }
+    uint64_t delta = bytes > gameMemoryLow ? bytes - gameMemoryLow : gameMemoryLow - bytes;
+    if (gameMemoryLow != 0 && delta * 20 <= gameMemoryLow) {
+        return true;
+    }
+    if (!writeValue(mount + "/" + groupName + "/memory.low", std::to_string(bytes)) ||
+        !writeValue(groupDir(Group::Game) + "/memory.low", std::to_string(bytes))) {
+        return false;
+    }
+    gameMemoryLow = bytes;
+    return true;
+}
+
+bool CgroupManager::setGamePid(pid_t pid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pid == gamePid) {
+        return true;
+    }
+    if (gamePid > 0) {
+        leave(gamePid);
+    }
+    gamePid = 0;
+    if (pid <= 0 || !active) {
+        saveStateLocked();
+        return pid <= 0;
+    }
+    // The game may have been sorted into the background before it was
+    // recognised; it keeps its original origin either way.
+    background.erase(pid);
+    bool moved = enter(pid, Group::Game);
+    if (moved) {
+        gamePid = pid;
+    }
+    saveStateLocked();
+    return moved;
+}
+
+int CgroupManager::syncBackground(const std::vector<pid_t>& pids) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active) {
+        return 0;
+    }
+    std::unordered_set<pid_t> wanted(pids.begin(), pids.end());
+    wanted.erase(gamePid);
+    wanted.erase(getpid());
+    std::vector<pid_t> members = readMembers(groupDir(Group::Background));
+    std::unordered_set<pid_t> present(members.begin(), members.end());
+
+    // Taking a cached app out of its per-app group (uid_N/pid_M on Android)
+    // hides it from the system's freezer, which freezes that group, not the
+    // process. So frozen processes are never taken, and a member whose
+    // original group the system has since frozen goes back to be frozen.
+    // Members also lose the sole-member memory.reclaim of ReclaimEngine,
+    // which falls back to process_madvise() for them.
+    int moved = 0;
+    for (auto it = background.begin(); it != background.end();) {
+        auto origin = origins.find(*it);
+        if (wanted.count(*it) && present.count(*it) && origin != origins.end() && frozen(origin->second)) {
+            wanted.erase(*it);
+        }
+        if (wanted.count(*it) == 0) {
+            if (present.count(*it)) {
+                leave(*it);
+                moved++;
+            } else {
+                origins.erase(*it);   // exited, or moved elsewhere by the system
+            }
+            it = background.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (pid_t pid : wanted) {
+        if (present.count(pid)) {
+            background.insert(pid);
+            continue;
+        }
+        if (frozen(cgroupOf(pid))) {
+            continue;
+        }
+        if (enter(pid, Group::Background)) {
+            background.insert(pid);
+            moved++;
+        }
+    }
+    if (moved) {
+        saveStateLocked();
+    }
+    return moved;
+}
+
+void CgroupManager::drainLocked(const std::unordered_map<pid_t, std::string>& knownOrigins) {
+    // Members include children forked after the move; with no recorded
+    // origin they go to the root.
+    for (Group group : {Group::Game, Group::Background}) {
+        for (pid_t pid : readMembers(groupDir(group))) {
+            auto it = knownOrigins.find(pid);
+            movePid(pid, it != knownOrigins.end() ? it->second : "/");
+        }
+    }
+}
+
+void CgroupManager::teardown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active) {
+        return;
+    }
+    resetParentLocked();
+    drainLocked(origins);
+    removeDir(groupDir(Group::Game));
+    removeDir(groupDir(Group::Background));
+    removeDir(mount + "/" + groupName);
+    origins.clear();
+    background.clear();
+    gamePid = 0;
+    gameMemoryLow = 0;
+    controllers.clear();
+    active = false;
+    if (!stateFile.empty()) {
+        unlink(stateFile.c_str());
+    }
+}
+
+bool CgroupManager::isActive() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return active;
+}
+
+void CgroupManager::saveStateLocked() const {
+    if (stateFile.empty()) {
+        return;
+    }
+    std::string temp = stateFile + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        if (!out) {
+            return;
+        }
+        out << kStateHeader << "\n";
+        for (const auto& entry : origins) {
+            out << entry.first << " " << entry.second << "\n";
+        }
+        if (!out.flush()) {
+            return;
+        }
+    }
+    std::rename(temp.c_str(), stateFile.c_str());
+}
+
+bool CgroupManager::recoverFromStateFile() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active || access((mount + "/" + groupName).c_str(), F_OK) != 0) {
+        return false;
+    }
+    std::unordered_map<pid_t, std::string> saved;
+    std::ifstream in(stateFile);
+    std::string line;
+    if (!stateFile.empty() && in && std::getline(in, line) && line == kStateHeader) {
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            pid_t pid = 0;
+            std::string origin;
+            if (fields >> pid >> origin) {
+                saved[pid] = origin;
+            }
+        }
+    }
+    resetParentLocked();
+    drainLocked(saved);
+    removeDir(groupDir(Group::Game));
+    removeDir(groupDir(Group::Background));
+    bool removed = removeDir(mount + "/" + groupName);
+    if (!stateFile.empty()) {
+        unlink(stateFile.c_str());
+    }
+    return removed;
+}
+
+CgroupStatus CgroupManager::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    CgroupStatus status;
+    status.active = active;
+    status.path = mount + "/" + groupName;
+    for (const std::string& controller : controllers) {
+        status.controllers += (status.controllers.empty() ? "" : " ") + controller;
+    }
+    status.gamePid = gamePid;
+    status.backgroundMembers = background.size();
+    status.failedMoves = failedMoves;
+    return status;
+}
+
+#endif // __linux__
@@ -1,34 +1,565 @@
-// src/common/Config.cpp - Basic implementation
-#include <map>
-#include <string>
+// src/common/Config.cpp - Snapshot configuration with hot reload
+#include "Config.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <sstream>
+#include <string_view>
+
+#if defined(__linux__)
+#include "EventLoop.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
 
-class Config {
-private:
-    static Config* instance;
-    std::map<std::string, std::string> settings;
-    
-public:
-    static Config* getInstance() {
-        if (!instance) {
-            instance = new Config();
+// Registered key names; written at static-init/startup, read on publish.
+// Function-local so ConfigKey globals in other files can register safely
+// during static initialization.
+struct KeyRegistry {
+    std::mutex mutex;
+    std::vector<std::string> names;
+};
+
+KeyRegistry& keyRegistry() {
+    static KeyRegistry registry;
+    return registry;
+}
+
+// Each reading thread caches the snapshot it last saw. The hot path is one
+// atomic load and a compare; the shared_ptr is re-copied (under the write
+// mutex) only once per thread after each reload.
+struct ReaderCache {
+    uint64_t generation = std::numeric_limits<uint64_t>::max();
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+};
+thread_local ReaderCache t_readerCache;
+
+std::string_view trimView(std::string_view text) {
+    const char* whitespace = " \t\r\n";
+    size_t first = text.find_first_not_of(whitespace);
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    size_t last = text.find_last_not_of(whitespace);
+    return text.substr(first, last - first + 1);
+}
+
+bool equalsIgnoreCase(std::string_view a, const char* b) {
+    size_t n = std::strlen(b);
+    if (a.size() != n) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        if (c != b[i]) {
+            return false;
         }
-        return instance;
     }
-    
-    std::string getString(const std::string& key, const std::string& defaultValue = "") {
-        auto it = settings.find(key);
-        return (it != settings.end()) ? it->second : defaultValue;
+    return true;
+}
+
+bool needsQuotes(const std::string& value) {
+    return value.empty() || value.front() == ' ' || value.back() == ' ' ||
+           value.find_first_of("#;\"") != std::string::npos;
+}
+
+} // namespace
+
+Config* Config::getInstance() {
+    static Config instance;
+    return &instance;
+}
+
+Config::Config()
+    : generation(0), watching(false), inotifyFd(-1), watchWakePipe{-1, -1}, watchEventLoop(nullptr), watchTask(0),
+      reloadTask(0), nextListenerId(1) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    publish({});
+}
+
+Config::~Config() {
+    stopWatching();
+}
+
+uint32_t Config::registerKey(const std::string& key) {
+    KeyRegistry& registry = keyRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t i = 0; i < registry.names.size(); i++) {
+        if (registry.names[i] == key) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    registry.names.push_back(key);
+    return static_cast<uint32_t>(registry.names.size() - 1);
+}
+
+ConfigValue Config::makeValue(const std::string& text) {
+    ConfigValue value;
+    value.text = text;
+    std::string_view view = trimView(text);
+    if (view.empty()) {
+        return value;
     }
-    
-    void setString(const std::string& key, const std::string& value) {
-        settings[key] = value;
+
+    int64_t parsed = 0;
+    const char* begin = view.data();
+    const char* end = view.data() + view.size();
+    bool negative = *begin == '-';
+    std::from_chars_result result;
+    if (!negative && view.size() > 2 && view[0] == '0' && (view[1] == 'x' || view[1] == 'X')) {
+        result = std::from_chars(begin + 2, end, parsed, 16);
+    } else {
+        result = std::from_chars(begin, end, parsed);
     }
-    
-    bool loadFromFile(const std::string& filename) {
-        std::ifstream file(filename);
-        return file.good();
+    if (result.ec == std::errc() && result.ptr == end) {
+        value.hasInt = true;
+        value.intValue = parsed;
+        value.hasDouble = true;
+        value.doubleValue = static_cast<double>(parsed);
+    } else {
+        // strtod rather than from_chars: the NDK's libc++ lacks the
+        // floating-point overloads.
+        std::string copy(view);
+        char* parsedEnd = nullptr;
+        errno = 0;
+        double d = std::strtod(copy.c_str(), &parsedEnd);
+        if (errno == 0 && parsedEnd == copy.c_str() + copy.size()) {
+            value.hasDouble = true;
+            value.doubleValue = d;
+        }
     }
-};
 
-Config* Config::instance = nullptr;
+    if (equalsIgnoreCase(view, "true") || equalsIgnoreCase(view, "yes") || equalsIgnoreCase(view, "on")) {
+        value.hasBool = true;
+        value.boolValue = true;
+    } else if (equalsIgnoreCase(view, "false") || equalsIgnoreCase(view, "no") || equalsIgnoreCase(view, "off")) {
+        value.hasBool = true;
+        value.boolValue = false;
+    } else if (value.hasInt) {
+        value.hasBool = true;
+        value.boolValue = value.intValue != 0;
+    }
+    return value;
+}
+
+bool Config::parse(const std::string& text, std::unordered_map<std::string, ConfigValue>& out) {
+    std::string_view rest(text);
+    std::string section;
+    bool ok = true;
+
+    while (!rest.empty()) {
+        size_t newline = rest.find('\n');
+        std::string_view line = rest.substr(0, newline);
+        rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+
+        line = trimView(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                ok = false;
+                continue;
+            }
+            section = std::string(trimView(line.substr(1, line.size() - 2)));
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            ok = false;  // malformed line: skip it, keep the rest
+            continue;
+        }
+        std::string_view key = trimView(line.substr(0, equals));
+        std::string_view value = trimView(line.substr(equals + 1));
+        if (key.empty()) {
+            ok = false;
+            continue;
+        }
+
+        if (value.size() >= 2 && value.front() == '"') {
+            size_t closing = value.find('"', 1);
+            value = closing == std::string_view::npos ? value.substr(1) : value.substr(1, closing - 1);
+        } else {
+            // Trailing comment after an unquoted value
+            size_t comment = value.find_first_of("#;");
+            if (comment != std::string_view::npos) {
+                value = trimView(value.substr(0, comment));
+            }
+        }
+
+        std::string fullKey = section.empty() ? std::string(key) : section + "." + std::string(key);
+        out[fullKey] = makeValue(std::string(value));
+    }
+    return ok;
+}
+
+void Config::publish(std::unordered_map<std::string, ConfigValue>&& values) {
+    // Caller holds writeMutex.
+    auto next = std::make_shared<ConfigSnapshot>();
+    next->generation = generation.load(std::memory_order_relaxed) + 1;
+    next->values = std::move(values);
+    {
+        KeyRegistry& registry = keyRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        next->byKeyId.resize(registry.names.size(), nullptr);
+        for (size_t i = 0; i < registry.names.size(); i++) {
+            auto it = next->values.find(registry.names[i]);
+            if (it != next->values.end()) {
+                next->byKeyId[i] = &it->second;
+            }
+        }
+    }
+    snapshot = std::move(next);
+    generation.store(snapshot->generation, std::memory_order_release);
+}
+
+const ConfigSnapshot* Config::acquire() const {
+    ReaderCache& cache = t_readerCache;
+    if (cache.generation != generation.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        cache.snapshot = snapshot;
+        cache.generation = snapshot->generation;
+    }
+    return cache.snapshot.get();
+}
+
+const ConfigValue* Config::find(const std::string& key) const {
+    const ConfigSnapshot* current = acquire();
+    auto it = current->values.find(key);
+    return it != current->values.end() ? &it->second : nullptr;
+}
+
+const ConfigValue* Config::findById(uint32_t keyId, const std::string& key) const {
+    const ConfigSnapshot* current = acquire();
+    if (keyId < current->byKeyId.size()) {
+        return current->byKeyId[keyId];
+    }
+    // Key registered after this snapshot was published
+    auto it = current->values.find(key);
+    return it != current->values.end() ? &it->second : nullptr;
+}
+
+bool Config::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        configFile = filename;
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+
+    // A half-edited file must not go live: listeners only hear of
+    // accepted loads, so a partial snapshot would never be applied.
+    std::unordered_map<std::string, ConfigValue> values;
+    if (!parse(contents.str(), values)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(writeMutex);
+    configFile = filename;
+    publish(std::move(values));
+    return true;
+}
+
+bool Config::reload() {
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        filename = configFile;
+    }
+    return !filename.empty() && loadFromFile(filename);
+}
+
+bool Config::saveToFile(const std::string& filename) {
+    std::shared_ptr<const ConfigSnapshot> current;
+    std::string target = filename;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        current = snapshot;
+        if (target.empty()) {
+            target = configFile;
+        }
+    }
+    if (target.empty()) {
+        return false;
+    }
+
+    std::vector<const std::pair<const std::string, ConfigValue>*> entries;
+    for (const auto& entry : current->values) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    // Write beside the target and rename, so watchers never see a partial file.
+    std::string temp = target + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        for (const auto* entry : entries) {
+            const std::string& value = entry->second.text;
+            file << entry->first << " = ";
+            if (needsQuotes(value)) {
+                file << '"' << value << '"';
+            } else {
+                file << value;
+            }
+            file << '\n';
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+    return std::rename(temp.c_str(), target.c_str()) == 0;
+}
+
+std::string Config::getString(const std::string& key, const std::string& defaultValue) {
+    const ConfigValue* value = find(key);
+    return value ? value->text : defaultValue;
+}
+
+int Config::getInt(const std::string& key, int defaultValue) {
+    const ConfigValue* value = find(key);
+    return value && value->hasInt ? static_cast<int>(value->intValue) : defaultValue;
+}
+
+bool Config::getBool(const std::string& key, bool defaultValue) {
+    const ConfigValue* value = find(key);
+    return value && value->hasBool ? value->boolValue : defaultValue;
+}
+
+double Config::getDouble(const std::string& key, double defaultValue) {
+    const ConfigValue* value = find(key);
+    return value && value->hasDouble ? value->doubleValue : defaultValue;
+}
+
+void Config::setString(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    auto values = snapshot->values;
+    values[key] = makeValue(value);
+    publish(std::move(values));
+}
+
+void Config::setInt(const std::string& key, int value) {
+    setString(key, std::to_string(value));
+}
+
+void Config::setBool(const std::string& key, bool value) {
+    setString(key, value ? "true" : "false");
+}
+
+void Config::setDouble(const std::string& key, double value) {
+    std::ostringstream text;
+    text.precision(17);
+    text << value;
+    setString(key, text.str());
+}
+
+bool Config::hasKey(const std::string& key) const {
+    return find(key) != nullptr;
+}
+
+void Config::removeKey(const std::string& key) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (snapshot->values.count(key) == 0) {
+        return;
+    }
+    auto values = snapshot->values;
+    values.erase(key);
+    publish(std::move(values));
+}
+
+void Config::clear() {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    publish({});
+}
+
+uint64_t Config::addReloadListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    reloadListeners.emplace_back(nextListenerId, std::move(listener));
+    return nextListenerId++;
+}
+
+void Config::removeReloadListener(uint64_t id) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    reloadListeners.erase(std::remove_if(reloadListeners.begin(), reloadListeners.end(),
+                                         [id](const auto& entry) { return entry.first == id; }),
+                          reloadListeners.end());
+}
+
+#if defined(__linux__)
+
+bool Config::openWatch() {
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        filename = configFile;
+    }
+    if (filename.empty()) {
+        return false;
+    }
+
+    // Watch the directory, not the file: editors and saveToFile() replace
+    // the file by rename, which would orphan a watch on the old inode.
+    size_t slash = filename.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : filename.substr(0, slash == 0 ? 1 : slash);
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        return false;
+    }
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool Config::drainWatch() {
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        size_t slash = configFile.rfind('/');
+        name = slash == std::string::npos ? configFile : configFile.substr(slash + 1);
+    }
+    bool changed = false;
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < length;) {
+            auto* event = reinterpret_cast<inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len && name == event->name) {
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+void Config::notifyReload() {
+    if (!watching.load() || !reload()) {
+        return;
+    }
+    std::vector<std::pair<uint64_t, std::function<void()>>> listeners;
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        listeners = reloadListeners;
+    }
+    for (const auto& listener : listeners) {
+        listener.second();
+    }
+}
+
+bool Config::startWatching() {
+    if (watching.load() || !openWatch()) {
+        return false;
+    }
+    if (pipe2(watchWakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    watching.store(true);
+    watchThread = std::thread(&Config::watchLoop, this);
+    return true;
+}
+
+bool Config::startWatching(EventLoop& loop) {
+    if (watching.load() || !openWatch()) {
+        return false;
+    }
+    watching.store(true);
+    watchEventLoop = &loop;
+    watchTask = loop.addFd("config.watch", inotifyFd, EPOLLIN, [this](uint32_t) {
+        // Coalesce the burst of events a single save produces; the file
+        // read and the listeners (which may write sysfs) go to the pool.
+        if (!drainWatch() || reloadTask.load() != 0) {
+            return;
+        }
+        reloadTask.store(watchEventLoop->addTimeout("config.reload", 50, [this](uint64_t) {
+            reloadTask.store(0);
+            if (!watchEventLoop->offload([this] { notifyReload(); })) {
+                notifyReload();
+            }
+        }));
+    });
+    return true;
+}
+
+void Config::stopWatching() {
+    if (watchEventLoop) {
+        watching.store(false);
+        watchEventLoop->remove(watchTask);
+        watchEventLoop->remove(reloadTask.exchange(0));
+        watchEventLoop = nullptr;
+        watchTask = 0;
+    } else if (watching.exchange(false)) {
+        char byte = 0;
+        (void)write(watchWakePipe[1], &byte, 1);
+    }
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+    for (int* fd : {&inotifyFd, &watchWakePipe[0], &watchWakePipe[1]}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void Config::watchLoop() {
+    while (watching.load()) {
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {watchWakePipe[0], POLLIN, 0}};
+        int timeout = -1;
+        bool pending = false;
+        for (;;) {
+            int ready = poll(fds, 2, timeout);
+            if (ready <= 0 || (fds[1].revents & POLLIN)) {
+                break;  // timeout ends the debounce window; wake pipe means stop
+            }
+            // Coalesce the burst of events a single save produces.
+            pending = drainWatch() || pending;
+            timeout = pending ? 50 : -1;
+        }
+        if (pending) {
+            notifyReload();
+        }
+    }
+}
+
+#else
+
+bool Config::startWatching() {
+    return false;
+}
+
+bool Config::startWatching(EventLoop&) {
+    return false;
+}
+
+void Config::stopWatching() {}
+
+void Config::watchLoop() {}
+
+#endif
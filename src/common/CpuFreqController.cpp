@@ -0,0 +1,520 @@
+// src/common/CpuFreqController.cpp - Transactional cpufreq policy control
+#if defined(__linux__)
+#include "CpuFreqController.h"
+#include "PrivilegedHelper.h"
+#include "ProcFs.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+const char kPolicyRoot[] = "/sys/devices/system/cpu/cpufreq";
+const char kCpuRoot[] = "/sys/devices/system/cpu";
+const char kStateHeader[] = "cpufreq-baseline 1";
+
+constexpr size_t kMaxSignalPolicies = 16;
+
+bool readAttribute(int dirFd, const char* name, std::string& out) {
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[1024];
+    ssize_t n;
+    do {
+        n = read(fd, buffer, sizeof(buffer));
+    } while (n < 0 && errno == EINTR);
+    close(fd);
+    if (n < 0) {
+        return false;
+    }
+    out.assign(ProcParser::trimLine(std::string_view(buffer, static_cast<size_t>(n))));
+    return true;
+}
+
+uint32_t readFrequency(int dirFd, const char* name) {
+    std::string text;
+    uint64_t value = 0;
+    if (readAttribute(dirFd, name, text) && ProcParser::parseSysfsUnsigned(text, value)) {
+        return static_cast<uint32_t>(value);
+    }
+    return 0;
+}
+
+// related_cpus is a space separated list ("4 5 6 7").
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::istringstream stream(text);
+    int cpu;
+    while (stream >> cpu) {
+        cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Pre-rendered restore data for the signal handler: only openat/write/
+// close are used there, all async-signal-safe.
+struct SignalPolicy {
+    int dirFd;
+    char governor[32];
+    char minFreq[16];
+    char maxFreq[16];
+};
+
+SignalPolicy g_signalPolicies[kMaxSignalPolicies];
+std::atomic<int> g_signalPolicyCount(0);
+std::atomic<const CpuFreqController*> g_signalOwner(nullptr);
+
+const int kCrashSignals[] = {SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGTERM};
+struct sigaction g_previousActions[sizeof(kCrashSignals) / sizeof(kCrashSignals[0])];
+std::atomic<bool> g_handlersInstalled(false);
+
+void signalWrite(int dirFd, const char* name, const char* value) {
+    if (value[0] == '\0') {
+        return;
+    }
+    int fd = openat(dirFd, name, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t ignored = write(fd, value, std::strlen(value));
+        (void)ignored;
+        close(fd);
+    }
+}
+
+void crashRestoreHandler(int sig) {
+    int count = g_signalPolicyCount.exchange(0);
+    for (int i = 0; i < count; i++) {
+        const SignalPolicy& policy = g_signalPolicies[i];
+        signalWrite(policy.dirFd, "scaling_governor", policy.governor);
+        // Current limits are unknown here: max, min, max succeeds whichever
+        // way the old range overlaps the new one.
+        signalWrite(policy.dirFd, "scaling_max_freq", policy.maxFreq);
+        signalWrite(policy.dirFd, "scaling_min_freq", policy.minFreq);
+        signalWrite(policy.dirFd, "scaling_max_freq", policy.maxFreq);
+    }
+
+    for (size_t i = 0; i < sizeof(kCrashSignals) / sizeof(kCrashSignals[0]); i++) {
+        if (kCrashSignals[i] == sig) {
+            sigaction(sig, &g_previousActions[i], nullptr);
+            break;
+        }
+    }
+    raise(sig);
+}
+
+} // namespace
+
+CpuFreqController::CpuFreqController(const std::string& rootPrefix, const std::string& stateFilePath)
+    : root(rootPrefix), stateFile(stateFilePath), haveBaseline(false) {}
+
+CpuFreqController::~CpuFreqController() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const CpuFreqController* self = this;
+    if (g_signalOwner.compare_exchange_strong(self, nullptr)) {
+        g_signalPolicyCount.store(0);
+    }
+    closePolicies();
+}
+
+void CpuFreqController::closePolicies() {
+    for (auto& policy : policies) {
+        if (policy.dirFd >= 0) {
+            close(policy.dirFd);
+        }
+    }
+    policies.clear();
+}
+
+int CpuFreqController::discover() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (haveBaseline) {
+        // The baseline is indexed by policy; keep the set stable until restored.
+        return static_cast<int>(policies.size());
+    }
+    closePolicies();
+
+    auto addPolicy = [this](const std::string& path, int id) {
+        int fd = open(path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        CpuFreqPolicy policy;
+        policy.id = id;
+        policy.dirFd = fd;
+        policy.path = path;
+
+        std::string text;
+        if (readAttribute(fd, "related_cpus", text) || readAttribute(fd, "affected_cpus", text)) {
+            policy.cpus = parseCpuList(text);
+        }
+        if (policy.cpus.empty()) {
+            policy.cpus.push_back(id);
+        }
+        policy.cpuinfoMinFreq = readFrequency(fd, "cpuinfo_min_freq");
+        policy.cpuinfoMaxFreq = readFrequency(fd, "cpuinfo_max_freq");
+        if (readAttribute(fd, "scaling_available_frequencies", text)) {
+            std::istringstream stream(text);
+            uint32_t freq;
+            while (stream >> freq) {
+                policy.availableFrequencies.push_back(freq);
+            }
+            std::sort(policy.availableFrequencies.begin(), policy.availableFrequencies.end());
+        }
+        if (readAttribute(fd, "scaling_available_governors", text)) {
+            std::istringstream stream(text);
+            std::string governor;
+            while (stream >> governor) {
+                policy.availableGovernors.push_back(governor);
+            }
+        }
+        policies.push_back(std::move(policy));
+    };
+
+    std::string policyRoot = root + kPolicyRoot;
+    if (DIR* dir = opendir(policyRoot.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (std::strncmp(entry->d_name, "policy", 6) != 0) {
+                continue;
+            }
+            uint64_t id = 0;
+            if (ProcParser::parseUnsigned(entry->d_name + 6, id)) {
+                addPolicy(policyRoot + "/" + entry->d_name, static_cast<int>(id));
+            }
+        }
+        closedir(dir);
+    }
+
+    if (policies.empty()) {
+        // Pre-4.x kernels only expose cpuN/cpufreq; one entry per cluster.
+        std::vector<bool> covered(kMaxTrackedCpus, false);
+        for (int cpu = 0; cpu < static_cast<int>(kMaxTrackedCpus); cpu++) {
+            if (covered[cpu]) {
+                continue;
+            }
+            std::string path = root + kCpuRoot + "/cpu" + std::to_string(cpu) + "/cpufreq";
+            if (access(path.c_str(), F_OK) != 0) {
+                continue;
+            }
+            addPolicy(path, cpu);
+            if (!policies.empty() && policies.back().id == cpu) {
+                for (int related : policies.back().cpus) {
+                    if (related >= 0 && related < static_cast<int>(kMaxTrackedCpus)) {
+                        covered[related] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(policies.begin(), policies.end(),
+              [](const CpuFreqPolicy& a, const CpuFreqPolicy& b) { return a.id < b.id; });
+    return static_cast<int>(policies.size());
+}
+
+bool CpuFreqController::readState(const CpuFreqPolicy& policy, CpuFreqPolicyState& out) const {
+    if (!readAttribute(policy.dirFd, "scaling_governor", out.governor)) {
+        return false;
+    }
+    out.minFreq = readFrequency(policy.dirFd, "scaling_min_freq");
+    out.maxFreq = readFrequency(policy.dirFd, "scaling_max_freq");
+    return out.minFreq != 0 && out.maxFreq != 0;
+}
+
+bool CpuFreqController::readPolicyState(int index, CpuFreqPolicyState& out) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (index < 0 || index >= static_cast<int>(policies.size())) {
+        return false;
+    }
+    return readState(policies[index], out);
+}
+
+bool CpuFreqController::writeAttribute(const CpuFreqPolicy& policy, const char* name, const std::string& value) {
+    int fd = openat(policy.dirFd, name, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t n = write(fd, value.data(), value.size());
+        close(fd);
+        PROFILE_COUNT(ProfileCounter::Syscalls, 3);
+        PROFILE_COUNT(ProfileCounter::BytesWritten, n > 0 ? static_cast<uint64_t>(n) : 0);
+        return n == static_cast<ssize_t>(value.size());
+    }
+    if (errno != EACCES && errno != EPERM) {
+        return false;
+    }
+    // Not writable by this uid: one round trip through the root helper.
+    return PrivilegedHelper::getInstance()->execute(
+        HelperCommand::writeFile(policy.path + "/" + name, value)).success;
+}
+
+bool CpuFreqController::applyState(const CpuFreqPolicy& policy, const CpuFreqPolicyState& current,
+                                   const CpuFreqPolicyState& wanted) {
+    if (!wanted.governor.empty() && wanted.governor != current.governor &&
+        !writeAttribute(policy, "scaling_governor", wanted.governor)) {
+        return false;
+    }
+
+    bool minChanged = wanted.minFreq != 0 && wanted.minFreq != current.minFreq;
+    bool maxChanged = wanted.maxFreq != 0 && wanted.maxFreq != current.maxFreq;
+    // The kernel rejects min > max, so order the writes to keep the range
+    // valid at every step: raise max before min, lower min before max.
+    if (minChanged && wanted.minFreq > current.maxFreq) {
+        if (maxChanged && !writeAttribute(policy, "scaling_max_freq", std::to_string(wanted.maxFreq))) {
+            return false;
+        }
+        return writeAttribute(policy, "scaling_min_freq", std::to_string(wanted.minFreq));
+    }
+    if (minChanged && !writeAttribute(policy, "scaling_min_freq", std::to_string(wanted.minFreq))) {
+        return false;
+    }
+    if (maxChanged && !writeAttribute(policy, "scaling_max_freq", std::to_string(wanted.maxFreq))) {
+        return false;
+    }
+    return true;
+}
+
+bool CpuFreqController::resolve(const CpuFreqPolicy& policy, const CpuFreqPolicyState& current,
+                                const CpuFreqTarget& target, CpuFreqPolicyState& out, std::string& error) const {
+    out = current;
+    if (!target.governor.empty()) {
+        if (!policy.availableGovernors.empty() &&
+            std::find(policy.availableGovernors.begin(), policy.availableGovernors.end(), target.governor) ==
+                policy.availableGovernors.end()) {
+            error = "governor '" + target.governor + "' not available on policy" + std::to_string(policy.id);
+            return false;
+        }
+        out.governor = target.governor;
+    }
+
+    uint32_t lower = policy.cpuinfoMinFreq;
+    uint32_t upper = policy.cpuinfoMaxFreq ? policy.cpuinfoMaxFreq : UINT32_MAX;
+    auto clamp = [&](uint32_t freq) { return std::min(std::max(freq, lower), upper); };
+
+    if (target.maxFreq != 0) {
+        out.maxFreq = clamp(target.maxFreq);
+    }
+    uint32_t minFreq = target.minFreq;
+    if (minFreq == 0 && target.minFreqPercent > 0 && policy.cpuinfoMaxFreq != 0) {
+        minFreq = static_cast<uint32_t>(static_cast<uint64_t>(policy.cpuinfoMaxFreq) *
+                                        std::min(target.minFreqPercent, 100) / 100);
+    }
+    if (minFreq != 0) {
+        minFreq = clamp(minFreq);
+        // Snap up to an operating point so the floor is actually reached.
+        auto step = std::lower_bound(policy.availableFrequencies.begin(), policy.availableFrequencies.end(), minFreq);
+        if (step != policy.availableFrequencies.end()) {
+            minFreq = *step;
+        }
+        out.minFreq = std::min(minFreq, out.maxFreq);
+    }
+    return true;
+}
+
+bool CpuFreqController::apply(const std::vector<CpuFreqTarget>& targets, std::string* error) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::string message;
+    auto fail = [&](const std::string& text) {
+        if (error) {
+            *error = text;
+        }
+        return false;
+    };
+
+    if (targets.empty()) {
+        return fail("no targets");
+    }
+    if (policies.empty() && discover() == 0) {
+        return fail("no cpufreq policies");
+    }
+
+    std::vector<CpuFreqPolicyState> current(policies.size());
+    std::vector<CpuFreqPolicyState> wanted(policies.size());
+    for (size_t i = 0; i < policies.size(); i++) {
+        if (!readState(policies[i], current[i])) {
+            return fail("cannot read " + policies[i].path);
+        }
+        const CpuFreqTarget& target = targets[std::min(i, targets.size() - 1)];
+        if (!resolve(policies[i], current[i], target, wanted[i], message)) {
+            return fail(message);
+        }
+    }
+
+    bool capturedBaseline = false;
+    if (!haveBaseline) {
+        baseline = current;
+        haveBaseline = true;
+        capturedBaseline = true;
+        saveBaselineFile();
+        prepareSignalRestore();
+    }
+
+    for (size_t i = 0; i < policies.size(); i++) {
+        if (applyState(policies[i], current[i], wanted[i])) {
+            continue;
+        }
+        message = "write failed on " + policies[i].path;
+        // Roll back every policy touched so far, including this one.
+        for (size_t j = 0; j <= i; j++) {
+            CpuFreqPolicyState now;
+            if (readState(policies[j], now)) {
+                applyState(policies[j], now, current[j]);
+            }
+        }
+        if (capturedBaseline) {
+            haveBaseline = false;
+            baseline.clear();
+            g_signalPolicyCount.store(0);
+            if (!stateFile.empty()) {
+                unlink(stateFile.c_str());
+            }
+        }
+        return fail(message);
+    }
+    return true;
+}
+
+bool CpuFreqController::applyAll(const CpuFreqTarget& target, std::string* error) {
+    return apply(std::vector<CpuFreqTarget>{target}, error);
+}
+
+bool CpuFreqController::restore() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!haveBaseline) {
+        return true;
+    }
+    const CpuFreqController* self = this;
+    if (g_signalOwner.compare_exchange_strong(self, nullptr)) {
+        g_signalPolicyCount.store(0);
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < policies.size() && i < baseline.size(); i++) {
+        CpuFreqPolicyState now;
+        if (!readState(policies[i], now) || !applyState(policies[i], now, baseline[i])) {
+            success = false;
+        }
+    }
+    haveBaseline = false;
+    baseline.clear();
+    if (!stateFile.empty()) {
+        unlink(stateFile.c_str());
+    }
+    return success;
+}
+
+bool CpuFreqController::revert(const std::vector<CpuFreqTarget>& keep) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!haveBaseline) {
+        return keep.empty() || apply(keep);
+    }
+    if (keep.empty()) {
+        return restore();
+    }
+    bool success = true;
+    std::string message;
+    for (size_t i = 0; i < policies.size() && i < baseline.size(); i++) {
+        CpuFreqPolicyState now;
+        CpuFreqPolicyState wanted;
+        if (!readState(policies[i], now) ||
+            !resolve(policies[i], baseline[i], keep[std::min(i, keep.size() - 1)], wanted, message) ||
+            !applyState(policies[i], now, wanted)) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool CpuFreqController::saveBaselineFile() const {
+    if (stateFile.empty()) {
+        return true;
+    }
+    std::string temp = stateFile + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out << kStateHeader << "\n";
+        for (size_t i = 0; i < policies.size() && i < baseline.size(); i++) {
+            out << policies[i].id << " " << baseline[i].governor << " "
+                << baseline[i].minFreq << " " << baseline[i].maxFreq << "\n";
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    return std::rename(temp.c_str(), stateFile.c_str()) == 0;
+}
+
+bool CpuFreqController::recoverFromStateFile() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (stateFile.empty() || haveBaseline) {
+        return false;
+    }
+    std::ifstream in(stateFile);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != kStateHeader) {
+        return false;
+    }
+    if (policies.empty()) {
+        discover();
+    }
+
+    bool restored = false;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        int id;
+        CpuFreqPolicyState saved;
+        if (!(fields >> id >> saved.governor >> saved.minFreq >> saved.maxFreq)) {
+            continue;
+        }
+        for (const auto& policy : policies) {
+            CpuFreqPolicyState now;
+            if (policy.id == id && readState(policy, now) && applyState(policy, now, saved)) {
+                restored = true;
+            }
+        }
+    }
+    unlink(stateFile.c_str());
+    return restored;
+}
+
+void CpuFreqController::prepareSignalRestore() {
+    size_t count = std::min(policies.size(), std::min(baseline.size(), kMaxSignalPolicies));
+    // Unpublish while the table is rewritten.
+    g_signalPolicyCount.store(0);
+    for (size_t i = 0; i < count; i++) {
+        SignalPolicy& entry = g_signalPolicies[i];
+        entry.dirFd = policies[i].dirFd;
+        std::snprintf(entry.governor, sizeof(entry.governor), "%s", baseline[i].governor.c_str());
+        std::snprintf(entry.minFreq, sizeof(entry.minFreq), "%u", baseline[i].minFreq);
+        std::snprintf(entry.maxFreq, sizeof(entry.maxFreq), "%u", baseline[i].maxFreq);
+    }
+    g_signalOwner.store(this);
+    g_signalPolicyCount.store(static_cast<int>(count));
+}
+
+void CpuFreqController::installCrashRestore() {
+    if (g_handlersInstalled.exchange(true)) {
+        return;
+    }
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = crashRestoreHandler;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(kCrashSignals) / sizeof(kCrashSignals[0]); i++) {
+        sigaction(kCrashSignals[i], &action, &g_previousActions[i]);
+    }
+}
+
+#endif // __linux__
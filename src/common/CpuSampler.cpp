@@ -0,0 +1,417 @@
+// src/common/CpuSampler.cpp - Background per-thread CPU usage sampler
+#if defined(__linux__)
+#include "CpuSampler.h"
+#include "SelfProfiler.h"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t monotonicNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool parseTid(const char* name, int32_t& tid) {
+    int32_t value = 0;
+    if (*name == '\0') {
+        return false;
+    }
+    for (const char* p = name; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    tid = value;
+    return true;
+}
+
+uint32_t clampDelta(uint64_t now, uint64_t before) {
+    if (now < before) {
+        return 0;
+    }
+    uint64_t delta = now - before;
+    return delta > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(delta);
+}
+
+} // namespace
+
+CpuSampler::CpuSampler(const std::string& rootPrefix)
+    : slots(new ThreadSlot[kMaxThreads]),
+      processRing(new ProcessEntry[kProcessHistory]),
+      processHead(0),
+      targetPid(0),
+      intervalMs(100),
+      running(false),
+      root(rootPrefix),
+      lastProcessUtime(0),
+      lastProcessStime(0),
+      lastProcessTimestampNs(0),
+      lastThreadCount(0),
+      ticksSinceRescan(0),
+      clockTicksPerSecond(sysconf(_SC_CLK_TCK)),
+      pageSize(sysconf(_SC_PAGESIZE)),
+      onlineCpus(static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN))),
+      taskDirFd(-1),
+      eventLoop(nullptr),
+      loopTask(0) {
+    if (clockTicksPerSecond <= 0) clockTicksPerSecond = 100;
+    if (pageSize <= 0) pageSize = 4096;
+    if (onlineCpus <= 0) onlineCpus = 1;
+}
+
+CpuSampler::~CpuSampler() {
+    stop();
+    if (taskDirFd >= 0) {
+        close(taskDirFd);
+    }
+}
+
+void CpuSampler::resetState() {
+    for (int i = 0; i < kMaxThreads; i++) {
+        ThreadSlot& slot = slots[i];
+        slot.tid.store(0, std::memory_order_release);
+        slot.head.store(0, std::memory_order_release);
+        slot.statFile.close();
+        slot.seen = false;
+    }
+    processHead.store(0, std::memory_order_release);
+    lastProcessUtime = 0;
+    lastProcessStime = 0;
+    lastProcessTimestampNs = 0;
+    lastThreadCount = 0;
+    ticksSinceRescan = 0;
+    if (taskDirFd >= 0) {
+        close(taskDirFd);
+        taskDirFd = -1;
+    }
+}
+
+bool CpuSampler::attach(pid_t pid) {
+    if (isRunning()) {
+        return false;
+    }
+    resetState();
+    if (!processReader.attach(pid, root)) {
+        targetPid.store(0, std::memory_order_release);
+        return false;
+    }
+    std::string taskDir = root + "/proc/" + std::to_string(pid) + "/task";
+    taskDirFd = open(taskDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    targetPid.store(pid, std::memory_order_release);
+    rescanThreads();
+    return true;
+}
+
+bool CpuSampler::start(pid_t pid, int samplingIntervalMs) {
+    stop();
+    setInterval(samplingIntervalMs);
+    if (!attach(pid)) {
+        return false;
+    }
+    running.store(true, std::memory_order_release);
+    worker = std::thread(&CpuSampler::run, this);
+    return true;
+}
+
+bool CpuSampler::start(EventLoop& loop, pid_t pid, int samplingIntervalMs) {
+    stop();
+    setInterval(samplingIntervalMs);
+    if (!attach(pid)) {
+        return false;
+    }
+    running.store(true, std::memory_order_release);
+    eventLoop = &loop;
+    loopTask.store(loop.addPeriodic("sampler", static_cast<uint32_t>(intervalMs.load()), [this](uint64_t) {
+        if (isRunning() && !sampleOnce()) {
+            // Target exited; readers keep the last published values.
+            running.store(false, std::memory_order_release);
+            EventLoop::TaskId task = loopTask.exchange(0);
+            if (task) {
+                eventLoop->remove(task);
+            }
+        }
+    }));
+    return true;
+}
+
+void CpuSampler::stop() {
+    EventLoop::TaskId task = loopTask.exchange(0);
+    if (task) {
+        eventLoop->remove(task);   // waits out a sample in progress
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running.store(false, std::memory_order_release);
+    }
+    wakeCondition.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void CpuSampler::setInterval(int samplingIntervalMs) {
+    intervalMs.store(samplingIntervalMs < 10 ? 10 : samplingIntervalMs, std::memory_order_relaxed);
+    EventLoop::TaskId task = loopTask.load();
+    if (task) {
+        eventLoop->setInterval(task, static_cast<uint32_t>(intervalMs.load()));
+    }
+}
+
+void CpuSampler::run() {
+    auto next = std::chrono::steady_clock::now();
+    while (isRunning()) {
+        if (!sampleOnce()) {
+            // Target exited; readers keep the last published values.
+            running.store(false, std::memory_order_release);
+            break;
+        }
+        next += std::chrono::milliseconds(intervalMs.load(std::memory_order_relaxed));
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now;  // fell behind; don't try to catch up with a burst
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait_until(lock, next, [this] { return !isRunning(); });
+    }
+}
+
+CpuSampler::ThreadSlot* CpuSampler::findSlot(int32_t tid) {
+    for (int i = 0; i < kMaxThreads; i++) {
+        if (slots[i].tid.load(std::memory_order_relaxed) == tid) {
+            return &slots[i];
+        }
+    }
+    return nullptr;
+}
+
+CpuSampler::ThreadSlot* CpuSampler::claimSlot(int32_t tid) {
+    for (int i = 0; i < kMaxThreads; i++) {
+        ThreadSlot& slot = slots[i];
+        if (slot.tid.load(std::memory_order_relaxed) != 0) {
+            continue;
+        }
+        std::string path = root + "/proc/" + std::to_string(targetPid.load(std::memory_order_relaxed)) +
+                           "/task/" + std::to_string(tid) + "/stat";
+        if (!slot.statFile.open(path, 1024)) {
+            return nullptr;
+        }
+        slot.seen = false;
+        slot.head.store(0, std::memory_order_relaxed);
+        slot.tid.store(tid, std::memory_order_release);
+        return &slot;
+    }
+    return nullptr;  // more than kMaxThreads live threads; extras are not tracked
+}
+
+void CpuSampler::rescanThreads() {
+    ticksSinceRescan = 0;
+    if (taskDirFd < 0) {
+        return;
+    }
+    // getdents64 into a stack buffer on a held directory fd: no opendir()
+    // allocation and no path lookup per scan.
+    alignas(8) char buffer[4096];
+    lseek(taskDirFd, 0, SEEK_SET);
+    for (;;) {
+        long n = syscall(SYS_getdents64, taskDirFd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            int32_t tid = 0;
+            if (parseTid(entry->d_name, tid) && !findSlot(tid)) {
+                claimSlot(tid);
+            }
+        }
+    }
+}
+
+void CpuSampler::sampleThread(ThreadSlot& slot, uint64_t nowNs, double elapsedSec) {
+    TaskStat stat;
+    std::string_view text = slot.statFile.read();
+    if (text.empty() || !ProcParser::parseTaskStat(text, stat)) {
+        // Thread exited: release the slot for reuse.
+        slot.tid.store(0, std::memory_order_release);
+        slot.statFile.close();
+        return;
+    }
+
+    uint64_t previousUtime = slot.utime.load(std::memory_order_relaxed);
+    uint64_t previousStime = slot.stime.load(std::memory_order_relaxed);
+    uint64_t commWords[2] = {0, 0};
+    std::memcpy(commWords, stat.comm, sizeof(stat.comm));
+    slot.commWords[0].store(commWords[0], std::memory_order_relaxed);
+    slot.commWords[1].store(commWords[1], std::memory_order_relaxed);
+    slot.utime.store(stat.utime, std::memory_order_relaxed);
+    slot.stime.store(stat.stime, std::memory_order_relaxed);
+    slot.lastCpu.store(stat.processor, std::memory_order_relaxed);
+
+    if (!slot.seen || elapsedSec <= 0.0) {
+        slot.seen = true;
+        return;
+    }
+
+    uint32_t du = clampDelta(stat.utime, previousUtime);
+    uint32_t ds = clampDelta(stat.stime, previousStime);
+    uint32_t head = slot.head.load(std::memory_order_relaxed);
+    RingEntry& entry = slot.ring[head % kThreadHistory];
+    entry.timestampNs.store(nowNs, std::memory_order_relaxed);
+    entry.utimeDelta.store(du, std::memory_order_relaxed);
+    entry.stimeDelta.store(ds, std::memory_order_relaxed);
+    entry.usagePercent.store(static_cast<float>((du + ds) * 100.0 / clockTicksPerSecond / elapsedSec),
+                             std::memory_order_relaxed);
+    slot.head.store(head + 1, std::memory_order_release);
+}
+
+bool CpuSampler::sampleOnce() {
+    PROFILE_SCOPE("sampler.sample");
+    if (targetPid.load(std::memory_order_relaxed) <= 0) {
+        return false;
+    }
+    uint64_t nowNs = monotonicNanos();
+    TaskStat stat;
+    if (!processReader.readStat(stat)) {
+        return false;
+    }
+
+    double elapsedSec = lastProcessTimestampNs ? (nowNs - lastProcessTimestampNs) / 1e9 : 0.0;
+
+    // Rescan the task list only when the thread count moved, plus a slow
+    // periodic rescan to catch threads replaced one-for-one.
+    if (stat.numThreads != lastThreadCount || ++ticksSinceRescan >= 20) {
+        rescanThreads();
+        lastThreadCount = stat.numThreads;
+    }
+    for (int i = 0; i < kMaxThreads; i++) {
+        if (slots[i].tid.load(std::memory_order_relaxed) != 0) {
+            sampleThread(slots[i], nowNs, elapsedSec);
+        }
+    }
+
+    if (elapsedSec > 0.0) {
+        uint32_t du = clampDelta(stat.utime, lastProcessUtime);
+        uint32_t ds = clampDelta(stat.stime, lastProcessStime);
+        double usage = (du + ds) * 100.0 / clockTicksPerSecond / elapsedSec;
+
+        uint32_t head = processHead.load(std::memory_order_relaxed);
+        ProcessEntry& entry = processRing[head % kProcessHistory];
+        entry.timestampNs.store(nowNs, std::memory_order_relaxed);
+        entry.utime.store(stat.utime, std::memory_order_relaxed);
+        entry.stime.store(stat.stime, std::memory_order_relaxed);
+        entry.utimeDelta.store(du, std::memory_order_relaxed);
+        entry.stimeDelta.store(ds, std::memory_order_relaxed);
+        entry.usagePercent.store(static_cast<float>(usage), std::memory_order_relaxed);
+        entry.systemSharePercent.store(static_cast<float>(usage / onlineCpus), std::memory_order_relaxed);
+        entry.rssBytes.store(stat.rssPages * static_cast<uint64_t>(pageSize), std::memory_order_relaxed);
+        entry.threadCount.store(stat.numThreads, std::memory_order_relaxed);
+        processHead.store(head + 1, std::memory_order_release);
+    }
+
+    lastProcessUtime = stat.utime;
+    lastProcessStime = stat.stime;
+    lastProcessTimestampNs = nowNs;
+    return true;
+}
+
+double CpuSampler::processCpuUsage() const {
+    ProcessCpuSample sample;
+    return latestProcessSample(sample) ? sample.usagePercent : 0.0;
+}
+
+bool CpuSampler::latestProcessSample(ProcessCpuSample& out) const {
+    return processHistory(&out, 1) == 1;
+}
+
+int CpuSampler::processHistory(ProcessCpuSample* out, int maxSamples) const {
+    uint32_t head = processHead.load(std::memory_order_acquire);
+    int available = head < static_cast<uint32_t>(kProcessHistory) ? static_cast<int>(head) : kProcessHistory;
+    int count = maxSamples < available ? maxSamples : available;
+    // Newest first
+    for (int i = 0; i < count; i++) {
+        const ProcessEntry& entry = processRing[(head - 1 - i) % kProcessHistory];
+        ProcessCpuSample& sample = out[i];
+        sample.timestampNs = entry.timestampNs.load(std::memory_order_relaxed);
+        sample.utime = entry.utime.load(std::memory_order_relaxed);
+        sample.stime = entry.stime.load(std::memory_order_relaxed);
+        sample.utimeDelta = entry.utimeDelta.load(std::memory_order_relaxed);
+        sample.stimeDelta = entry.stimeDelta.load(std::memory_order_relaxed);
+        sample.usagePercent = entry.usagePercent.load(std::memory_order_relaxed);
+        sample.systemSharePercent = entry.systemSharePercent.load(std::memory_order_relaxed);
+        sample.rssBytes = entry.rssBytes.load(std::memory_order_relaxed);
+        sample.threadCount = entry.threadCount.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+int CpuSampler::threadUsage(ThreadCpuUsage* out, int maxThreads) const {
+    int count = 0;
+    for (int i = 0; i < kMaxThreads && count < maxThreads; i++) {
+        const ThreadSlot& slot = slots[i];
+        int32_t tid = slot.tid.load(std::memory_order_acquire);
+        uint32_t head = slot.head.load(std::memory_order_acquire);
+        if (tid == 0 || head == 0) {
+            continue;
+        }
+        ThreadCpuUsage& usage = out[count];
+        usage.tid = tid;
+        uint64_t commWords[2] = {slot.commWords[0].load(std::memory_order_relaxed),
+                                 slot.commWords[1].load(std::memory_order_relaxed)};
+        std::memcpy(usage.comm, commWords, sizeof(usage.comm));
+        usage.comm[sizeof(usage.comm) - 1] = '\0';
+        usage.utime = slot.utime.load(std::memory_order_relaxed);
+        usage.stime = slot.stime.load(std::memory_order_relaxed);
+        usage.lastCpu = slot.lastCpu.load(std::memory_order_relaxed);
+        const RingEntry& entry = slot.ring[(head - 1) % kThreadHistory];
+        usage.latest.timestampNs = entry.timestampNs.load(std::memory_order_relaxed);
+        usage.latest.utimeDelta = entry.utimeDelta.load(std::memory_order_relaxed);
+        usage.latest.stimeDelta = entry.stimeDelta.load(std::memory_order_relaxed);
+        usage.latest.usagePercent = entry.usagePercent.load(std::memory_order_relaxed);
+        // Drop the entry if the slot was recycled for another thread meanwhile.
+        if (slot.tid.load(std::memory_order_acquire) == tid) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int CpuSampler::threadHistory(int32_t tid, CpuSample* out, int maxSamples) const {
+    for (int i = 0; i < kMaxThreads; i++) {
+        const ThreadSlot& slot = slots[i];
+        if (slot.tid.load(std::memory_order_acquire) != tid) {
+            continue;
+        }
+        uint32_t head = slot.head.load(std::memory_order_acquire);
+        int available = head < static_cast<uint32_t>(kThreadHistory) ? static_cast<int>(head) : kThreadHistory;
+        int count = maxSamples < available ? maxSamples : available;
+        for (int j = 0; j < count; j++) {
+            const RingEntry& entry = slot.ring[(head - 1 - j) % kThreadHistory];
+            out[j].timestampNs = entry.timestampNs.load(std::memory_order_relaxed);
+            out[j].utimeDelta = entry.utimeDelta.load(std::memory_order_relaxed);
+            out[j].stimeDelta = entry.stimeDelta.load(std::memory_order_relaxed);
+            out[j].usagePercent = entry.usagePercent.load(std::memory_order_relaxed);
+        }
+        return slot.tid.load(std::memory_order_acquire) == tid ? count : 0;
+    }
+    return 0;
+}
+
+#endif // __linux__
@@ -0,0 +1,364 @@
+// src/common/CpuTopology.cpp - CPU topology model and thread placement
+#if defined(__linux__)
+#include "CpuTopology.h"
+#include "CpuSampler.h"
+#include "ProcFs.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <utility>
+#include <unistd.h>
+
+namespace {
+
+bool readLine(const std::string& path, std::string& out) {
+    std::ifstream file(path);
+    if (!file || !std::getline(file, out)) {
+        return false;
+    }
+    out.assign(ProcParser::trimLine(out));
+    return true;
+}
+
+bool readSigned(const std::string& path, int64_t& value) {
+    std::string text;
+    return readLine(path, text) && ProcParser::parseSigned(text, value);
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// CpuTopology
+
+CpuTopology::CpuTopology(const std::string& rootPrefix) : root(rootPrefix) {}
+
+std::vector<int> CpuTopology::parseCpuMask(const std::string& hexMask) {
+    // "ff,000000ff": 32-bit words, most significant first.
+    std::vector<int> cpus;
+    int bit = 0;
+    for (auto it = hexMask.rbegin(); it != hexMask.rend(); ++it) {
+        int digit = hexDigit(*it);
+        if (digit < 0) {
+            continue;
+        }
+        for (int i = 0; i < 4; i++) {
+            if (digit & (1 << i)) {
+                cpus.push_back(bit + i);
+            }
+        }
+        bit += 4;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+std::vector<int> CpuTopology::parseCpuList(const std::string& list) {
+    // "0-3,6"
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        std::string range = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = range.find('-');
+        uint64_t first = 0;
+        uint64_t last = 0;
+        if (dash == std::string::npos) {
+            if (ProcParser::parseUnsigned(ProcParser::trimLine(range), first)) {
+                cpus.push_back(static_cast<int>(first));
+            }
+        } else if (ProcParser::parseUnsigned(ProcParser::trimLine(std::string_view(range).substr(0, dash)), first) &&
+                   ProcParser::parseUnsigned(ProcParser::trimLine(std::string_view(range).substr(dash + 1)), last)) {
+            for (uint64_t cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+                cpus.push_back(static_cast<int>(cpu));
+            }
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+bool CpuTopology::load() {
+    cores.clear();
+    clusters.clear();
+
+    uint32_t highestFreq = 0;
+    bool missingCapacity = false;
+    for (int cpu = 0; cpu < kMaxTrackedCpus; cpu++) {
+        std::string dir = root + "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        if (access(dir.c_str(), F_OK) != 0) {
+            break;
+        }
+        CoreInfo info;
+        info.cpu = cpu;
+
+        // cpu0 is usually not hotpluggable and has no "online" file.
+        int64_t value = 1;
+        readSigned(dir + "/online", value);
+        info.online = value != 0;
+
+        if (readSigned(dir + "/cpu_capacity", value) && value > 0) {
+            info.capacity = static_cast<uint32_t>(value);
+        } else {
+            missingCapacity = true;
+        }
+        if (readSigned(dir + "/topology/cluster_id", value)) {
+            info.clusterId = static_cast<int>(value);
+        }
+        if (readSigned(dir + "/topology/physical_package_id", value)) {
+            info.packageId = static_cast<int>(value);
+        }
+        std::string text;
+        if (readLine(dir + "/topology/core_siblings", text)) {
+            info.coreSiblings = parseCpuMask(text);
+        } else if (readLine(dir + "/topology/core_siblings_list", text)) {
+            info.coreSiblings = parseCpuList(text);
+        }
+        if (readLine(dir + "/topology/thread_siblings_list", text)) {
+            info.threadSiblings = parseCpuList(text);
+        }
+        if (info.threadSiblings.empty()) {
+            info.threadSiblings.push_back(cpu);
+        }
+        if (readSigned(dir + "/cpufreq/cpuinfo_min_freq", value)) {
+            info.minFreq = static_cast<uint32_t>(value);
+        }
+        if (readSigned(dir + "/cpufreq/cpuinfo_max_freq", value)) {
+            info.maxFreq = static_cast<uint32_t>(value);
+        }
+        highestFreq = std::max(highestFreq, info.maxFreq);
+        cores.push_back(std::move(info));
+    }
+    if (cores.empty()) {
+        return false;
+    }
+
+    if (missingCapacity) {
+        // No EAS capacity table: scale by max frequency, or treat as equal.
+        for (auto& info : cores) {
+            if (info.capacity == 0) {
+                info.capacity = highestFreq && info.maxFreq
+                    ? static_cast<uint32_t>(static_cast<uint64_t>(info.maxFreq) * kMaxCpuCapacity / highestFreq)
+                    : kMaxCpuCapacity;
+            }
+        }
+    }
+
+    // Capacity always splits a group (DynamIQ puts mixed cores in one
+    // cluster); within a capacity, cluster_id or the package separates.
+    std::map<std::pair<uint32_t, int>, size_t> groups;
+    for (const auto& info : cores) {
+        int id = info.clusterId >= 0 ? info.clusterId : info.packageId;
+        auto key = std::make_pair(info.capacity, id);
+        auto found = groups.find(key);
+        if (found == groups.end()) {
+            found = groups.emplace(key, clusters.size()).first;
+            ClusterInfo cluster;
+            cluster.id = id;
+            clusters.push_back(cluster);
+        }
+        ClusterInfo& cluster = clusters[found->second];
+        cluster.cpus.push_back(info.cpu);
+        cluster.capacity = std::max(cluster.capacity, info.capacity);
+        cluster.maxFreq = std::max(cluster.maxFreq, info.maxFreq);
+    }
+    std::sort(clusters.begin(), clusters.end(), [](const ClusterInfo& a, const ClusterInfo& b) {
+        return a.capacity != b.capacity ? a.capacity < b.capacity : a.cpus.front() < b.cpus.front();
+    });
+    for (size_t i = 0; i < clusters.size(); i++) {
+        if (clusters[i].id < 0) {
+            clusters[i].id = static_cast<int>(i);
+        }
+    }
+    return true;
+}
+
+const CoreInfo* CpuTopology::core(int cpu) const {
+    if (cpu < 0 || cpu >= static_cast<int>(cores.size())) {
+        return nullptr;
+    }
+    return &cores[cpu];
+}
+
+cpu_set_t CpuTopology::clusterMask(size_t firstCluster, size_t lastCluster) const {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (size_t i = firstCluster; i <= lastCluster && i < clusters.size(); i++) {
+        for (int cpu : clusters[i].cpus) {
+            if (cores[cpu].online) {
+                CPU_SET(cpu, &mask);
+            }
+        }
+    }
+    return mask;
+}
+
+cpu_set_t CpuTopology::onlineMask() const {
+    return clusterMask(0, clusters.empty() ? 0 : clusters.size() - 1);
+}
+
+// ---------------------------------------------------------------------------
+// ThreadPlacement
+
+ThreadPlacement::ThreadPlacement(const CpuTopology& cpuTopology)
+    : topology(cpuTopology), totalMigrations(0) {
+    setter = [](pid_t tid, const cpu_set_t& mask) {
+        return sched_setaffinity(tid, sizeof(mask), &mask) == 0;
+    };
+}
+
+const char* ThreadPlacement::tierName(PlacementTier tier) {
+    switch (tier) {
+    case PlacementTier::Prime: return "prime";
+    case PlacementTier::Performance: return "performance";
+    case PlacementTier::Little: return "little";
+    case PlacementTier::Any:
+    default: return "any";
+    }
+}
+
+cpu_set_t ThreadPlacement::maskFor(PlacementTier tier) const {
+    size_t last = topology.getClusters().size() - 1;
+    switch (tier) {
+    case PlacementTier::Prime: return topology.clusterMask(last, last);
+    case PlacementTier::Performance: return topology.clusterMask(1, last);
+    case PlacementTier::Little: return topology.clusterMask(0, 0);
+    case PlacementTier::Any:
+    default: return topology.onlineMask();
+    }
+}
+
+int ThreadPlacement::rebalance(const std::vector<ThreadDemand>& demands) {
+    PROFILE_SCOPE("placement.rebalance");
+    if (!topology.isHeterogeneous()) {
+        return 0;
+    }
+    const auto& clusters = topology.getClusters();
+    size_t primeSlots = clusters.back().cpus.size();
+    size_t performanceSlots = 0;
+    for (size_t i = 1; i < clusters.size(); i++) {
+        performanceSlots += clusters[i].cpus.size();
+    }
+
+    struct Candidate {
+        pid_t tid;
+        double demand;
+        double rank;
+        PlacementTier current;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(demands.size());
+    for (const auto& demand : demands) {
+        auto found = assignments.find(demand.tid);
+        PlacementTier current = found != assignments.end() ? found->second.tier : PlacementTier::Any;
+        bool incumbent = current == PlacementTier::Prime || current == PlacementTier::Performance;
+        double rank = demand.usagePercent + (incumbent ? thresholds.migrationGainPercent : 0.0);
+        candidates.push_back({demand.tid, demand.usagePercent, rank, current});
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.rank > b.rank; });
+
+    std::unordered_map<pid_t, ThreadAssignment> next;
+    next.reserve(candidates.size());
+    size_t heavyRank = 0;
+    int moved = 0;
+    for (const auto& candidate : candidates) {
+        bool incumbentHeavy = candidate.current == PlacementTier::Prime ||
+                              candidate.current == PlacementTier::Performance;
+        double heavyBar = thresholds.heavyPercent - (incumbentHeavy ? thresholds.migrationGainPercent : 0.0);
+        double lightBar = thresholds.lightPercent * (candidate.current == PlacementTier::Little ? 2.0 : 1.0);
+
+        PlacementTier desired;
+        if (candidate.demand >= heavyBar && heavyRank < performanceSlots) {
+            desired = heavyRank < primeSlots ? PlacementTier::Prime : PlacementTier::Performance;
+            heavyRank++;
+        } else if (candidate.demand < lightBar) {
+            desired = PlacementTier::Little;
+        } else {
+            desired = PlacementTier::Any;
+        }
+
+        ThreadAssignment assignment;
+        auto previous = assignments.find(candidate.tid);
+        if (previous != assignments.end()) {
+            assignment = previous->second;
+        }
+        assignment.tid = candidate.tid;
+        assignment.demand = candidate.demand;
+
+        if (desired != candidate.current) {
+            cpu_set_t wanted = maskFor(desired);
+            cpu_set_t current = maskFor(candidate.current);
+            // With two clusters prime and performance are the same cores.
+            if (CPU_EQUAL(&wanted, &current)) {
+                assignment.tier = desired;
+            } else if (setter(candidate.tid, wanted)) {
+                assignment.tier = desired;
+                assignment.migrations++;
+                totalMigrations++;
+                moved++;
+            }
+        }
+        next[candidate.tid] = assignment;
+    }
+    // Threads missing from `demands` have exited.
+    assignments.swap(next);
+    return moved;
+}
+
+int ThreadPlacement::rebalance(const CpuSampler& sampler, int windowSamples) {
+    std::vector<ThreadCpuUsage> threads(CpuSampler::kMaxThreads);
+    int count = sampler.threadUsage(threads.data(), static_cast<int>(threads.size()));
+
+    std::vector<CpuSample> history(std::max(windowSamples, 1));
+    std::vector<ThreadDemand> demands;
+    demands.reserve(count);
+    for (int i = 0; i < count; i++) {
+        int samples = sampler.threadHistory(threads[i].tid, history.data(), static_cast<int>(history.size()));
+        double total = 0.0;
+        for (int j = 0; j < samples; j++) {
+            total += history[j].usagePercent;
+        }
+        ThreadDemand demand;
+        demand.tid = threads[i].tid;
+        demand.usagePercent = samples > 0 ? total / samples : threads[i].latest.usagePercent;
+        demands.push_back(demand);
+    }
+    return rebalance(demands);
+}
+
+void ThreadPlacement::restore() {
+    if (topology.isLoaded()) {
+        cpu_set_t all = topology.onlineMask();
+        for (const auto& entry : assignments) {
+            if (entry.second.tier != PlacementTier::Any) {
+                setter(entry.first, all);
+            }
+        }
+    }
+    assignments.clear();
+}
+
+std::vector<ThreadAssignment> ThreadPlacement::getAssignments() const {
+    std::vector<ThreadAssignment> result;
+    result.reserve(assignments.size());
+    for (const auto& entry : assignments) {
+        result.push_back(entry.second);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const ThreadAssignment& a, const ThreadAssignment& b) { return a.demand > b.demand; });
+    return result;
+}
+
+#endif // __linux__
@@ -0,0 +1,500 @@
+// src/common/EventLoop.cpp - Single-threaded epoll/timerfd reactor
+#if defined(__linux__)
+#include "EventLoop.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+// epoll tags of the loop's own fds; task ids count up from 1.
+constexpr uint64_t kWakeTag = UINT64_MAX;
+constexpr uint64_t kTimerTag = UINT64_MAX - 1;
+constexpr uint64_t kSignalTag = UINT64_MAX - 2;
+
+constexpr uint64_t kNever = UINT64_MAX;
+
+uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint32_t resolveSlack(uint32_t intervalMs, uint32_t slackMs) {
+    if (slackMs != EventLoop::kAutoSlack) {
+        return slackMs;
+    }
+    return std::min(intervalMs / 10, EventLoop::kMaxAutoSlackMs);
+}
+
+} // namespace
+
+uint64_t EventLoop::nowMs() {
+    return monotonicNs() / 1000000;
+}
+
+EventLoop::EventLoop()
+    : epollFd(epoll_create1(EPOLL_CLOEXEC)), timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+      wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), signalFd(-1), armedMs(0), running(false), nextId(1),
+      currentTask(0), poolStopping(false) {
+    sigemptyset(&signalMask);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    if (epollFd >= 0 && timerFd >= 0) {
+        event.data.u64 = kTimerTag;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event);
+    }
+    if (epollFd >= 0 && wakeFd >= 0) {
+        event.data.u64 = kWakeTag;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    }
+}
+
+EventLoop::~EventLoop() {
+    stop();
+    if (loopThread.joinable()) {
+        loopThread.join();
+    }
+    for (int fd : {epollFd, timerFd, wakeFd, signalFd}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool EventLoop::start(unsigned workers, Job workerInit) {
+    if (epollFd < 0 || timerFd < 0 || wakeFd < 0) {
+        return false;
+    }
+    if (running.exchange(true, std::memory_order_acq_rel)) {
+        return true;
+    }
+    if (loopThread.joinable()) {
+        loopThread.join();   // stopped from its own callback earlier
+    }
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        poolStopping = false;
+        poolInit = std::move(workerInit);
+    }
+    for (unsigned i = 0; i < workers; i++) {
+        pool.emplace_back(&EventLoop::poolWorker, this);
+    }
+    loopThread = std::thread(&EventLoop::run, this);
+    return true;
+}
+
+void EventLoop::stop() {
+    if (!running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        poolStopping = true;
+        jobs.clear();
+    }
+    poolWake.notify_all();
+    for (std::thread& worker : pool) {
+        if (worker.get_id() != std::this_thread::get_id()) {
+            worker.join();
+        } else {
+            worker.detach();
+        }
+    }
+    pool.clear();
+    if (inLoopThread()) {
+        return;   // run() returns after this callback; joined by start() or the destructor
+    }
+    wake();
+    if (loopThread.joinable()) {
+        loopThread.join();
+    }
+}
+
+bool EventLoop::inLoopThread() const {
+    return loopThreadId.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+EventLoop::TaskId EventLoop::addTask(std::shared_ptr<Task> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    task->id = nextId++;
+    if (task->kind == Kind::Fd) {
+        epoll_event event = {};
+        event.events = task->events;
+        event.data.u64 = task->id;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, task->fd, &event) != 0) {
+            return 0;
+        }
+    } else if (task->kind == Kind::Signal) {
+        sigaddset(&signalMask, task->signo);
+        int fd = signalfd(signalFd, &signalMask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd < 0) {
+            sigdelset(&signalMask, task->signo);
+            return 0;
+        }
+        if (signalFd < 0) {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u64 = kSignalTag;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            signalFd = fd;
+        }
+    }
+    tasks[task->id] = task;
+    return task->id;
+}
+
+EventLoop::TaskId EventLoop::addPeriodic(const std::string& name, uint32_t intervalMs, TimerCallback callback,
+                                         uint32_t slackMs) {
+    auto task = std::make_shared<Task>();
+    task->name = name;
+    task->kind = Kind::Timer;
+    task->intervalMs = std::max<uint32_t>(intervalMs, 1);
+    task->slackMs = resolveSlack(task->intervalMs, slackMs);
+    task->requestedSlackMs = slackMs;
+    task->dueMs = nowMs() + task->intervalMs;
+    task->onTimer = std::move(callback);
+    TaskId id = addTask(task);
+    if (!inLoopThread()) {
+        wake();
+    }
+    return id;
+}
+
+EventLoop::TaskId EventLoop::addTimeout(const std::string& name, uint32_t delayMs, TimerCallback callback,
+                                        uint32_t slackMs) {
+    auto task = std::make_shared<Task>();
+    task->name = name;
+    task->kind = Kind::Timer;
+    task->intervalMs = 0;
+    task->slackMs = resolveSlack(delayMs, slackMs);
+    task->dueMs = nowMs() + delayMs;
+    task->onTimer = std::move(callback);
+    TaskId id = addTask(task);
+    if (!inLoopThread()) {
+        wake();
+    }
+    return id;
+}
+
+EventLoop::TaskId EventLoop::addFd(const std::string& name, int fd, uint32_t events, FdCallback callback) {
+    if (fd < 0) {
+        return 0;
+    }
+    auto task = std::make_shared<Task>();
+    task->name = name;
+    task->kind = Kind::Fd;
+    task->fd = fd;
+    task->events = events;
+    task->onFd = std::move(callback);
+    return addTask(task);
+}
+
+EventLoop::TaskId EventLoop::addSignal(const std::string& name, int signo, SignalCallback callback) {
+    sigset_t block;
+    sigemptyset(&block);
+    sigaddset(&block, signo);
+    pthread_sigmask(SIG_BLOCK, &block, nullptr);
+    auto task = std::make_shared<Task>();
+    task->name = name;
+    task->kind = Kind::Signal;
+    task->signo = signo;
+    task->onSignal = std::move(callback);
+    return addTask(task);
+}
+
+bool EventLoop::setInterval(TaskId id, uint32_t intervalMs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = tasks.find(id);
+        if (it == tasks.end() || it->second->kind != Kind::Timer || it->second->intervalMs == 0) {
+            return false;
+        }
+        Task& task = *it->second;
+        intervalMs = std::max<uint32_t>(intervalMs, 1);
+        if (task.intervalMs == intervalMs) {
+            return true;
+        }
+        // Due one new interval after the previous run.
+        task.dueMs = task.dueMs - task.intervalMs + intervalMs;
+        task.intervalMs = intervalMs;
+        task.slackMs = resolveSlack(intervalMs, task.requestedSlackMs);
+    }
+    if (!inLoopThread()) {
+        wake();
+    }
+    return true;
+}
+
+bool EventLoop::remove(TaskId id) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = tasks.find(id);
+    if (it == tasks.end()) {
+        return false;
+    }
+    std::shared_ptr<Task> task = it->second;
+    tasks.erase(it);
+    if (task->kind == Kind::Fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, task->fd, nullptr);
+    } else if (task->kind == Kind::Signal) {
+        bool shared = false;
+        for (const auto& entry : tasks) {
+            shared |= entry.second->kind == Kind::Signal && entry.second->signo == task->signo;
+        }
+        if (!shared) {
+            sigdelset(&signalMask, task->signo);
+            signalfd(signalFd, &signalMask, SFD_NONBLOCK | SFD_CLOEXEC);
+        }
+    }
+    if (!inLoopThread()) {
+        taskDone.wait(lock, [this, id] { return currentTask != id; });
+    }
+    return true;
+}
+
+void EventLoop::post(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        posted.push_back(std::move(job));
+        stats.posted++;
+    }
+    wake();
+}
+
+bool EventLoop::offload(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (pool.empty() || poolStopping) {
+            return false;
+        }
+        jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.offloaded++;
+    }
+    poolWake.notify_one();
+    return true;
+}
+
+void EventLoop::poolWorker() {
+    if (poolInit) {
+        poolInit();
+    }
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            poolWake.wait(lock, [this] { return poolStopping || !jobs.empty(); });
+            if (poolStopping) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void EventLoop::invoke(const std::shared_ptr<Task>& task, const std::function<void()>& call) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.find(task->id) == tasks.end()) {
+            return;   // removed since it was picked
+        }
+        currentTask = task->id;
+    }
+    uint64_t startNs = monotonicNs();
+    call();
+    uint64_t elapsedNs = monotonicNs() - startNs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = 0;
+        task->runs++;
+        task->totalNs += elapsedNs;
+    }
+    taskDone.notify_all();
+}
+
+void EventLoop::rearmTimer() {
+    uint64_t target = kNever;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : tasks) {
+            const Task& task = *entry.second;
+            if (task.kind == Kind::Timer) {
+                target = std::min(target, task.dueMs + task.slackMs);
+            }
+        }
+    }
+    if (target == armedMs || (target == kNever && armedMs == 0)) {
+        return;
+    }
+    itimerspec spec = {};
+    if (target != kNever) {
+        uint64_t ms = std::max<uint64_t>(target, 1);
+        spec.it_value.tv_sec = static_cast<time_t>(ms / 1000);
+        spec.it_value.tv_nsec = static_cast<long>(ms % 1000) * 1000000;
+    }
+    timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    armedMs = target == kNever ? 0 : target;
+}
+
+void EventLoop::runTimers() {
+    uint64_t now = nowMs();
+    std::vector<std::shared_ptr<Task>> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : tasks) {
+            Task& task = *entry.second;
+            if (task.kind != Kind::Timer || task.dueMs > now) {
+                continue;
+            }
+            due.push_back(entry.second);
+            if (task.intervalMs) {
+                task.dueMs += task.intervalMs;
+                if (task.dueMs <= now) {
+                    task.dueMs = now + task.intervalMs;   // fell behind; skip, don't burst
+                }
+            } else {
+                task.dueMs = kNever - task.slackMs;
+            }
+        }
+        if (due.empty()) {
+            return;
+        }
+        stats.timerRuns += due.size();
+        stats.coalescedRuns += due.size() - 1;
+    }
+    for (const auto& task : due) {
+        invoke(task, [&task, now] { task->onTimer(now); });
+        if (task->intervalMs == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.erase(task->id);
+        }
+    }
+}
+
+void EventLoop::runFd(TaskId id, uint32_t events) {
+    std::shared_ptr<Task> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = tasks.find(id);
+        if (it == tasks.end()) {
+            return;
+        }
+        task = it->second;
+        stats.fdEvents++;
+    }
+    invoke(task, [&task, events] { task->onFd(events); });
+}
+
+void EventLoop::runSignals() {
+    signalfd_siginfo info;
+    while (read(signalFd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+        std::vector<std::shared_ptr<Task>> handlers;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.signals++;
+            for (const auto& entry : tasks) {
+                if (entry.second->kind == Kind::Signal && entry.second->signo == static_cast<int>(info.ssi_signo)) {
+                    handlers.push_back(entry.second);
+                }
+            }
+        }
+        for (const auto& task : handlers) {
+            invoke(task, [&task, &info] { task->onSignal(info); });
+        }
+    }
+}
+
+void EventLoop::runPosted() {
+    std::vector<Job> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(posted);
+    }
+    for (Job& job : batch) {
+        job();
+    }
+}
+
+void EventLoop::run() {
+    loopThreadId.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    epoll_event events[16];
+    while (running.load(std::memory_order_acquire)) {
+        rearmTimer();
+        int ready = epoll_wait(epollFd, events, 16, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        PROFILE_SCOPE("loop.dispatch");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.wakeups++;
+        }
+        for (int i = 0; i < ready; i++) {
+            uint64_t tag = events[i].data.u64;
+            uint64_t drained;
+            if (tag == kWakeTag) {
+                ssize_t ignored = read(wakeFd, &drained, sizeof(drained));
+                (void)ignored;
+            } else if (tag == kTimerTag) {
+                ssize_t ignored = read(timerFd, &drained, sizeof(drained));
+                (void)ignored;
+                armedMs = 0;   // one-shot expiry consumed
+            } else if (tag == kSignalTag) {
+                runSignals();
+            } else {
+                runFd(tag, events[i].events);
+            }
+        }
+        runTimers();
+        runPosted();
+    }
+    loopThreadId.store(std::thread::id(), std::memory_order_relaxed);
+}
+
+EventLoopStats EventLoop::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::vector<EventLoopTaskInfo> EventLoop::getTasks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<EventLoopTaskInfo> list;
+    list.reserve(tasks.size());
+    for (const auto& entry : tasks) {
+        const Task& task = *entry.second;
+        EventLoopTaskInfo info;
+        info.id = task.id;
+        info.name = task.name;
+        info.timer = task.kind == Kind::Timer;
+        info.intervalMs = task.intervalMs;
+        info.slackMs = task.slackMs;
+        info.runs = task.runs;
+        info.totalNs = task.totalNs;
+        list.push_back(info);
+    }
+    std::sort(list.begin(), list.end(),
+              [](const EventLoopTaskInfo& a, const EventLoopTaskInfo& b) { return a.id < b.id; });
+    return list;
+}
+
+#endif // __linux__
@@ -0,0 +1,371 @@
+// src/common/FrameCadence.cpp - Render-thread frame cadence from scheduler statistics
+#if defined(__linux__)
+#include "FrameCadence.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Fewer windows than this and a rate is not worth reporting.
+constexpr size_t kMinWindows = 4;
+// Render-looking names get this much extra weight when ranking threads.
+constexpr double kNameHintWeight = 4.0;
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool parseTid(const char* name, int32_t& tid) {
+    int32_t value = 0;
+    if (*name == '\0') {
+        return false;
+    }
+    for (const char* p = name; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    tid = value;
+    return true;
+}
+
+// One-off read of a small file below the held task directory.
+std::string_view readAt(int dirFd, const char* path, char* buffer, size_t size) {
+    int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return {};
+    }
+    ssize_t n = read(fd, buffer, size);
+    close(fd);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 3);
+    return n > 0 ? std::string_view(buffer, static_cast<size_t>(n)) : std::string_view();
+}
+
+} // namespace
+
+FrameCadenceEstimator::FrameCadenceEstimator(const std::string& rootPrefix)
+    : root(rootPrefix),
+      targetPid(0),
+      taskDirFd(-1),
+      lastRescanMs(0) {}
+
+FrameCadenceEstimator::~FrameCadenceEstimator() {
+    detach();
+}
+
+void FrameCadenceEstimator::setOptions(const Options& newOptions) {
+    options = newOptions;
+    options.windowMs = std::max<uint32_t>(options.windowMs, 50);
+    options.historyWindows = std::max<uint32_t>(options.historyWindows, kMinWindows);
+    options.maxCandidates = std::max<uint32_t>(options.maxCandidates, 1);
+}
+
+bool FrameCadenceEstimator::isRenderThreadName(const char* comm) {
+    static const char* const kHints[] = {"render", "glthread", "gfx", "gpu", "vulkan"};
+    char lower[16] = {};
+    for (size_t i = 0; i + 1 < sizeof(lower) && comm[i]; i++) {
+        lower[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(comm[i])));
+    }
+    for (const char* hint : kHints) {
+        if (std::strstr(lower, hint)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FrameCadenceEstimator::attach(pid_t pid) {
+    detach();
+    if (pid <= 0) {
+        return false;
+    }
+    std::string taskDir = root + "/proc/" + std::to_string(pid) + "/task";
+    taskDirFd = open(taskDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskDirFd < 0) {
+        return false;
+    }
+    targetPid = pid;
+    return true;
+}
+
+void FrameCadenceEstimator::detach() {
+    if (taskDirFd >= 0) {
+        close(taskDirFd);
+        taskDirFd = -1;
+    }
+    targetPid = 0;
+    lastRescanMs = 0;
+    tracked.clear();
+    seen.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    published = FrameCadence();
+    publishedCandidates.clear();
+}
+
+bool FrameCadenceEstimator::readCounters(Candidate& candidate, TaskSchedstat& sched, uint64_t& voluntary) {
+    TaskStatus status;
+    if (!ProcParser::parseSchedstat(candidate.schedstatFile.read(), sched) ||
+        !ProcParser::parseTaskStatus(candidate.statusFile.read(), status)) {
+        return false;   // thread exited
+    }
+    voluntary = status.voluntaryCtxtSwitches;
+    return true;
+}
+
+bool FrameCadenceEstimator::openCandidate(Candidate& candidate, uint64_t nowMs) {
+    std::string taskPath = root + "/proc/" + std::to_string(targetPid) + "/task/" + std::to_string(candidate.tid);
+    if (!candidate.schedstatFile.open(taskPath + "/schedstat", 128) ||
+        !candidate.statusFile.open(taskPath + "/status", 2048)) {
+        return false;
+    }
+    candidate.history.assign(options.historyWindows, Window());
+    candidate.historyHead = 0;
+    candidate.windowStartMs = nowMs;
+    candidate.estimate.tid = candidate.tid;
+    std::memcpy(candidate.estimate.comm, candidate.comm, sizeof(candidate.comm));
+    return readCounters(candidate, candidate.windowSched, candidate.windowVoluntary);
+}
+
+void FrameCadenceEstimator::rescan(uint64_t nowMs) {
+    PROFILE_SCOPE("frame.rescan");
+    lastRescanMs = nowMs;
+    struct Ranked {
+        int32_t tid;
+        double weight;
+    };
+    std::vector<Ranked> ranked;
+    std::unordered_map<int32_t, ThreadSeen> next;
+    next.reserve(seen.size() + 8);
+
+    alignas(8) char buffer[4096];
+    char text[256];
+    char path[32];
+    lseek(taskDirFd, 0, SEEK_SET);
+    for (;;) {
+        long n = syscall(SYS_getdents64, taskDirFd, buffer, sizeof(buffer));
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            int32_t tid = 0;
+            TaskSchedstat sched;
+            if (!parseTid(entry->d_name, tid)) {
+                continue;
+            }
+            std::snprintf(path, sizeof(path), "%d/schedstat", tid);
+            if (!ProcParser::parseSchedstat(readAt(taskDirFd, path, text, sizeof(text)), sched)) {
+                continue;
+            }
+
+            ThreadSeen thread;
+            thread.runNs = sched.runNs;
+            // CPU time since the previous rescan; a thread seen for the
+            // first time is ranked by its whole lifetime.
+            uint64_t runDelta = sched.runNs;
+            auto previous = seen.find(tid);
+            if (previous != seen.end()) {
+                std::memcpy(thread.comm, previous->second.comm, sizeof(thread.comm));
+                thread.nameHint = previous->second.nameHint;
+                runDelta = sched.runNs >= previous->second.runNs ? sched.runNs - previous->second.runNs : 0;
+            } else {
+                std::snprintf(path, sizeof(path), "%d/comm", tid);
+                std::string_view comm = ProcParser::trimLine(readAt(taskDirFd, path, text, sizeof(text)));
+                std::memcpy(thread.comm, comm.data(), std::min(comm.size(), sizeof(thread.comm) - 1));
+                thread.nameHint = isRenderThreadName(thread.comm);
+            }
+            next[tid] = thread;
+            if (runDelta > 0) {
+                ranked.push_back({tid, static_cast<double>(runDelta) * (thread.nameHint ? kNameHintWeight : 1.0)});
+            }
+        }
+    }
+    seen.swap(next);
+
+    std::sort(ranked.begin(), ranked.end(), [](const Ranked& a, const Ranked& b) { return a.weight > b.weight; });
+    if (ranked.size() > options.maxCandidates) {
+        ranked.resize(options.maxCandidates);
+    }
+    // The current best keeps its history even through a quiet spell, so
+    // the estimate does not flap between threads.
+    const Candidate* best = nullptr;
+    for (const auto& candidate : tracked) {
+        if (candidate->estimate.valid && (!best || candidate->score > best->score)) {
+            best = candidate.get();
+        }
+    }
+    if (best && seen.count(best->tid) &&
+        std::none_of(ranked.begin(), ranked.end(), [&](const Ranked& r) { return r.tid == best->tid; })) {
+        ranked.push_back({best->tid, 0.0});
+    }
+
+    std::vector<std::unique_ptr<Candidate>> kept;
+    for (const Ranked& r : ranked) {
+        auto existing = std::find_if(tracked.begin(), tracked.end(),
+                                     [&](const std::unique_ptr<Candidate>& c) { return c && c->tid == r.tid; });
+        if (existing != tracked.end()) {
+            kept.push_back(std::move(*existing));
+            continue;
+        }
+        auto candidate = std::make_unique<Candidate>();
+        candidate->tid = r.tid;
+        const ThreadSeen& thread = seen[r.tid];
+        std::memcpy(candidate->comm, thread.comm, sizeof(candidate->comm));
+        candidate->nameHint = thread.nameHint;
+        if (openCandidate(*candidate, nowMs)) {
+            kept.push_back(std::move(candidate));
+        }
+    }
+    tracked.swap(kept);
+}
+
+void FrameCadenceEstimator::closeWindow(Candidate& candidate, const TaskSchedstat& sched, uint64_t voluntary,
+                                        uint64_t nowMs) {
+    Window window;
+    window.durationMs = static_cast<double>(nowMs - candidate.windowStartMs);
+    window.frames = voluntary >= candidate.windowVoluntary ? voluntary - candidate.windowVoluntary : 0;
+    window.runMs = sched.runNs >= candidate.windowSched.runNs ? (sched.runNs - candidate.windowSched.runNs) / 1e6 : 0.0;
+    window.waitMs = sched.waitNs >= candidate.windowSched.waitNs ? (sched.waitNs - candidate.windowSched.waitNs) / 1e6 : 0.0;
+    candidate.history[candidate.historyHead % candidate.history.size()] = window;
+    candidate.historyHead++;
+    candidate.windowSched = sched;
+    candidate.windowVoluntary = voluntary;
+    candidate.windowStartMs = nowMs;
+}
+
+void FrameCadenceEstimator::evaluate(Candidate& candidate) const {
+    FrameCadence& estimate = candidate.estimate;
+    estimate.valid = false;
+    estimate.timestampMs = candidate.windowStartMs;
+    candidate.score = 0.0;
+    size_t count = std::min(candidate.historyHead, candidate.history.size());
+    if (count < kMinWindows) {
+        return;
+    }
+
+    double durationMs = 0.0;
+    double runMs = 0.0;
+    double waitMs = 0.0;
+    uint64_t frames = 0;
+    double rateSum = 0.0;
+    double rateSquares = 0.0;
+    double frameTimeSum = 0.0;
+    double frameTimeSquares = 0.0;
+    size_t framedWindows = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Window& window = candidate.history[i];
+        if (window.durationMs <= 0.0) {
+            continue;
+        }
+        durationMs += window.durationMs;
+        runMs += window.runMs;
+        waitMs += window.waitMs;
+        frames += window.frames;
+        double rate = window.frames * 1000.0 / window.durationMs;
+        rateSum += rate;
+        rateSquares += rate * rate;
+        if (window.frames > 0) {
+            double frameTime = window.durationMs / window.frames;
+            frameTimeSum += frameTime;
+            frameTimeSquares += frameTime * frameTime;
+            framedWindows++;
+        }
+    }
+    if (frames == 0 || durationMs <= 0.0) {
+        return;
+    }
+
+    double rateMean = rateSum / count;
+    double rateStd = std::sqrt(std::max(0.0, rateSquares / count - rateMean * rateMean));
+    double frameTimeMean = frameTimeSum / framedWindows;
+    double regularity = std::clamp(1.0 - rateStd / rateMean, 0.0, 1.0);
+
+    estimate.fps = frames * 1000.0 / durationMs;
+    estimate.frameTimeMs = durationMs / frames;
+    estimate.jitterMs = std::sqrt(std::max(0.0, frameTimeSquares / framedWindows - frameTimeMean * frameTimeMean));
+    estimate.cpuPerFrameMs = runMs / frames;
+    estimate.waitPerFrameMs = waitMs / frames;
+    estimate.cpuShare = runMs / durationMs;
+    estimate.confidence = regularity * count / candidate.history.size();
+    estimate.valid = estimate.fps >= options.minFps && estimate.fps <= options.maxFps;
+    if (estimate.valid) {
+        // A steady rate counts only when real work rides on it: a 100 Hz
+        // poll thread is as regular as a render loop but burns ~0% CPU.
+        candidate.score = regularity * std::min(1.0, estimate.cpuShare * 10.0) *
+                          (candidate.nameHint ? 1.5 : 1.0);
+    }
+}
+
+bool FrameCadenceEstimator::sample(uint64_t nowMs) {
+    PROFILE_SCOPE("frame.sample");
+    if (taskDirFd < 0) {
+        return false;
+    }
+    if (tracked.empty() || nowMs - lastRescanMs >= options.rescanIntervalMs) {
+        rescan(nowMs);
+    }
+
+    bool refreshed = false;
+    for (auto it = tracked.begin(); it != tracked.end();) {
+        Candidate& candidate = **it;
+        if (nowMs - candidate.windowStartMs < options.windowMs) {
+            ++it;
+            continue;
+        }
+        TaskSchedstat sched;
+        uint64_t voluntary = 0;
+        if (!readCounters(candidate, sched, voluntary)) {
+            it = tracked.erase(it);
+            refreshed = true;
+            continue;
+        }
+        closeWindow(candidate, sched, voluntary, nowMs);
+        evaluate(candidate);
+        refreshed = true;
+        ++it;
+    }
+    if (!refreshed) {
+        return false;
+    }
+
+    std::vector<const Candidate*> order;
+    for (const auto& candidate : tracked) {
+        order.push_back(candidate.get());
+    }
+    std::sort(order.begin(), order.end(), [](const Candidate* a, const Candidate* b) { return a->score > b->score; });
+    std::vector<FrameCadence> estimates;
+    for (const Candidate* candidate : order) {
+        estimates.push_back(candidate->estimate);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    published = !order.empty() && order.front()->score > 0.0 ? order.front()->estimate : FrameCadence();
+    publishedCandidates.swap(estimates);
+    return true;
+}
+
+FrameCadence FrameCadenceEstimator::current() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return published;
+}
+
+std::vector<FrameCadence> FrameCadenceEstimator::candidates() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return publishedCandidates;
+}
+
+#endif // __linux__
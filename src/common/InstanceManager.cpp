@@ -0,0 +1,578 @@
+// src/common/InstanceManager.cpp - Concurrent game clients with per-instance CPU partitions
+#if defined(__linux__)
+#include "InstanceManager.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <limits>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool parseTid(const char* name, int32_t& tid) {
+    int32_t value = 0;
+    if (*name == '\0') {
+        return false;
+    }
+    for (const char* p = name; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    tid = value;
+    return true;
+}
+
+// CPUs never split between partitions: the SMT threads of one core.
+struct Unit {
+    std::vector<int> cpus;
+    uint32_t capacity = 0;
+    uint32_t coreCapacity = 0;   // of one thread, for ordering
+    int packageId = -1;
+};
+
+std::vector<Unit> buildUnits(const CpuTopology& topology) {
+    const std::vector<CoreInfo>& cores = topology.getCores();
+    std::vector<bool> taken(CPU_SETSIZE, false);
+    std::vector<Unit> units;
+    for (const CoreInfo& core : cores) {
+        if (!core.online || taken[core.cpu]) {
+            continue;
+        }
+        Unit unit;
+        unit.packageId = core.packageId;
+        for (int sibling : core.threadSiblings) {
+            const CoreInfo* info = topology.core(sibling);
+            if (info && info->online && !taken[sibling]) {
+                taken[sibling] = true;
+                unit.cpus.push_back(sibling);
+                unit.capacity += info->capacity;
+                unit.coreCapacity = std::max(unit.coreCapacity, info->capacity);
+            }
+        }
+        if (!taken[core.cpu]) {   // sibling list without the core itself
+            taken[core.cpu] = true;
+            unit.cpus.push_back(core.cpu);
+            unit.capacity += core.capacity;
+            unit.coreCapacity = std::max(unit.coreCapacity, core.capacity);
+        }
+        std::sort(unit.cpus.begin(), unit.cpus.end());
+        units.push_back(std::move(unit));
+    }
+    // Biggest cores first, then package and CPU number, so consecutive
+    // units share a cluster and a last-level cache.
+    std::stable_sort(units.begin(), units.end(), [](const Unit& a, const Unit& b) {
+        if (a.coreCapacity != b.coreCapacity) {
+            return a.coreCapacity > b.coreCapacity;
+        }
+        if (a.packageId != b.packageId) {
+            return a.packageId < b.packageId;
+        }
+        return a.cpus.front() < b.cpus.front();
+    });
+    return units;
+}
+
+void addUnit(CpuPartition& partition, const Unit& unit) {
+    partition.cpus.insert(partition.cpus.end(), unit.cpus.begin(), unit.cpus.end());
+    partition.capacity += unit.capacity;
+}
+
+cpu_set_t maskOf(const std::vector<int>& cpus) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &mask);
+        }
+    }
+    return mask;
+}
+
+} // namespace
+
+int PartitionPlan::partitionOf(pid_t pid) const {
+    for (size_t i = 0; i < partitions.size(); i++) {
+        const std::vector<pid_t>& members = partitions[i].members;
+        if (std::find(members.begin(), members.end(), pid) != members.end()) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// PartitionPlanner
+
+PartitionPlan PartitionPlanner::plan(const CpuTopology& topology, const std::map<pid_t, double>& demandCores,
+                                     const PartitionPlan& previous, const Options& options) {
+    PartitionPlan result;
+    std::vector<Unit> units = buildUnits(topology);
+    // Reserve only spare units: sharing a core between two instances costs
+    // more than the system threads they would have shared it with.
+    size_t reservedCount = 0;
+    while (reservedCount < options.reservedCpus && units.size() > std::max<size_t>(2, demandCores.size())) {
+        const Unit& unit = units.back();
+        result.reserved.insert(result.reserved.end(), unit.cpus.begin(), unit.cpus.end());
+        reservedCount += unit.cpus.size();
+        units.pop_back();
+    }
+    std::sort(result.reserved.begin(), result.reserved.end());
+    if (units.empty() || demandCores.empty()) {
+        return result;
+    }
+
+    struct Entry {
+        pid_t pid;
+        double demand;
+        int previousOrder;     // first CPU's position in the unit order, or max
+    };
+    std::vector<int> unitOf(CPU_SETSIZE, -1);
+    for (size_t i = 0; i < units.size(); i++) {
+        for (int cpu : units[i].cpus) {
+            unitOf[cpu] = static_cast<int>(i);
+        }
+    }
+    std::vector<Entry> entries;
+    for (const auto& demand : demandCores) {
+        Entry entry{demand.first, std::max(demand.second, options.minDemandCores), std::numeric_limits<int>::max()};
+        int index = previous.partitionOf(demand.first);
+        if (index >= 0 && !previous.partitions[index].cpus.empty()) {
+            int first = unitOf[previous.partitions[index].cpus.front()];
+            entry.previousOrder = first >= 0 ? first : entry.previousOrder;
+        }
+        entries.push_back(entry);
+    }
+    // Incumbents keep their order and newcomers, heaviest first, take the
+    // places of instances that left, so a start or exit only moves the
+    // boundaries next to it; the rest of the newcomers go last.
+    std::vector<int> vacated;
+    for (const CpuPartition& partition : previous.partitions) {
+        bool left = std::none_of(partition.members.begin(), partition.members.end(),
+                                 [&](pid_t pid) { return demandCores.count(pid) != 0; });
+        if (left && !partition.cpus.empty() && unitOf[partition.cpus.front()] >= 0) {
+            vacated.push_back(unitOf[partition.cpus.front()]);
+        }
+    }
+    std::sort(vacated.begin(), vacated.end());
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.demand > b.demand; });
+    size_t nextVacated = 0;
+    for (Entry& entry : entries) {
+        if (entry.previousOrder == std::numeric_limits<int>::max() && nextVacated < vacated.size()) {
+            entry.previousOrder = vacated[nextVacated++];
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.previousOrder != b.previousOrder) {
+            return a.previousOrder < b.previousOrder;
+        }
+        return a.demand > b.demand;
+    });
+
+    if (entries.size() <= units.size()) {
+        double remainingDemand = 0.0;
+        uint64_t remainingCapacity = 0;
+        for (const Entry& entry : entries) {
+            remainingDemand += entry.demand * options.headroom;
+        }
+        for (const Unit& unit : units) {
+            remainingCapacity += unit.capacity;
+        }
+        size_t next = 0;
+        for (size_t k = 0; k < entries.size(); k++) {
+            CpuPartition partition;
+            size_t after = entries.size() - k - 1;   // instances still to place
+            double want = entries[k].demand * options.headroom;
+            if (after == 0) {
+                while (next < units.size()) {
+                    addUnit(partition, units[next++]);
+                }
+            } else {
+                double target = remainingCapacity * want / remainingDemand;
+                do {
+                    addUnit(partition, units[next++]);
+                } while (next < units.size() - after && partition.capacity + units[next].capacity / 2.0 <= target);
+            }
+            remainingDemand -= want;
+            remainingCapacity -= partition.capacity;
+            std::sort(partition.cpus.begin(), partition.cpus.end());
+            partition.members.push_back(entries[k].pid);
+            partition.demandCores = entries[k].demand;
+            result.partitions.push_back(std::move(partition));
+        }
+        return result;
+    }
+
+    // More instances than units: every unit is a partition, instances go
+    // heaviest first onto the one that ends up least loaded.
+    for (const Unit& unit : units) {
+        CpuPartition partition;
+        addUnit(partition, unit);
+        result.partitions.push_back(std::move(partition));
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.demand > b.demand; });
+    for (const Entry& entry : entries) {
+        auto loadWith = [&](const CpuPartition& partition) {
+            return (partition.demandCores + entry.demand) / partition.capacityCores();
+        };
+        size_t best = 0;
+        for (size_t i = 1; i < result.partitions.size(); i++) {
+            if (loadWith(result.partitions[i]) < loadWith(result.partitions[best])) {
+                best = i;
+            }
+        }
+        int index = previous.partitionOf(entry.pid);
+        if (index >= 0) {
+            for (size_t i = 0; i < result.partitions.size(); i++) {
+                if (result.partitions[i].cpus == previous.partitions[index].cpus) {
+                    if (loadWith(result.partitions[i]) <= loadWith(result.partitions[best]) * (1.0 + options.stickiness)) {
+                        best = i;
+                    }
+                    break;
+                }
+            }
+        }
+        result.partitions[best].members.push_back(entry.pid);
+        result.partitions[best].demandCores += entry.demand;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// InstanceManager
+
+InstanceManager::InstanceManager(const CpuTopology& cpuTopology, const std::string& rootPrefix)
+    : root(rootPrefix), topology(cpuTopology), membershipChanged(false), lastReplanMs(0),
+      clockTicksPerSecond(sysconf(_SC_CLK_TCK)) {
+    if (clockTicksPerSecond <= 0) {
+        clockTicksPerSecond = 100;
+    }
+    setter = [](pid_t tid, const cpu_set_t& mask) {
+        return sched_setaffinity(tid, sizeof(mask), &mask) == 0;
+    };
+}
+
+InstanceManager::~InstanceManager() {
+    restore();
+}
+
+void InstanceManager::setOptions(const Options& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+}
+
+void InstanceManager::setAffinitySetter(AffinitySetter affinitySetter) {
+    std::lock_guard<std::mutex> lock(mutex);
+    setter = std::move(affinitySetter);
+}
+
+bool InstanceManager::add(pid_t pid, const std::string& name, uint64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pid <= 0 || instances.count(pid)) {
+        return false;
+    }
+    std::unique_ptr<Instance> instance(new Instance());
+    if (!instance->reader.attach(pid, root)) {
+        return false;
+    }
+    instance->schedstat.open(root + "/proc/" + std::to_string(pid) + "/schedstat", 256);
+    instance->info.pid = pid;
+    instance->info.name = name;
+    instance->info.startedMs = nowMs;
+    instances[pid] = std::move(instance);
+    membershipChanged = true;
+    return true;
+}
+
+bool InstanceManager::remove(pid_t pid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (instances.erase(pid) == 0) {
+        return false;
+    }
+    membershipChanged = true;
+    return true;
+}
+
+bool InstanceManager::contains(pid_t pid) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return instances.count(pid) != 0;
+}
+
+size_t InstanceManager::count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return instances.size();
+}
+
+pid_t InstanceManager::oldest() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    pid_t found = 0;
+    uint64_t startedMs = std::numeric_limits<uint64_t>::max();
+    for (const auto& entry : instances) {
+        if (entry.second->info.startedMs < startedMs) {
+            startedMs = entry.second->info.startedMs;
+            found = entry.first;
+        }
+    }
+    return found;
+}
+
+std::vector<pid_t> InstanceManager::listThreads(pid_t pid) const {
+    std::vector<pid_t> tids;
+    std::string dir = root + "/proc/" + std::to_string(pid) + "/task";
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return tids;
+    }
+    alignas(8) char buffer[4096];
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            int32_t tid = 0;
+            if (parseTid(entry->d_name, tid)) {
+                tids.push_back(tid);
+            }
+        }
+    }
+    close(fd);
+    return tids;
+}
+
+void InstanceManager::sampleLocked(Instance& instance, uint64_t nowMs) {
+    TaskStat stat;
+    if (!instance.reader.readStat(stat)) {
+        return;
+    }
+    TaskStatus status;
+    bool haveStatus = instance.reader.readStatus(status);
+    TaskSchedstat sched;
+    bool haveSched = instance.schedstat.isOpen() && ProcParser::parseSchedstat(instance.schedstat.read(), sched);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 3);
+
+    InstanceInfo& info = instance.info;
+    uint64_t ticks = stat.utime + stat.stime;
+    info.rssBytes = stat.rssPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    info.threads = stat.numThreads;
+    uint64_t elapsedMs = nowMs - instance.lastTimestampMs;
+    if (instance.sampled && elapsedMs > 0) {
+        double seconds = elapsedMs / 1000.0;
+        info.cpuPercent = (ticks - instance.lastTicks) * 100.0 / clockTicksPerSecond / seconds;
+        double cores = info.cpuPercent / 100.0;
+        info.demandCores = info.demandCores == 0.0
+            ? cores
+            : options.demandSmoothing * cores + (1.0 - options.demandSmoothing) * info.demandCores;
+        if (haveSched) {
+            double run = static_cast<double>(sched.runNs - instance.lastSched.runNs);
+            double wait = static_cast<double>(sched.waitNs - instance.lastSched.waitNs);
+            info.waitShare = run + wait > 0.0 ? wait / (run + wait) : 0.0;
+        }
+        if (haveStatus) {
+            info.preemptionsPerSec = (status.nonvoluntaryCtxtSwitches - instance.lastPreemptions) / seconds;
+        }
+        instance.measured = true;
+    }
+    instance.lastTicks = ticks;
+    instance.lastTimestampMs = nowMs;
+    if (haveSched) {
+        instance.lastSched = sched;
+    }
+    if (haveStatus) {
+        instance.lastPreemptions = status.nonvoluntaryCtxtSwitches;
+    }
+    instance.sampled = true;
+}
+
+bool InstanceManager::outgrownLocked() const {
+    // Loads from the current demand, not the one the plan was made with.
+    std::vector<double> loads;
+    for (const CpuPartition& partition : plan.partitions) {
+        double demand = 0.0;
+        for (pid_t pid : partition.members) {
+            auto found = instances.find(pid);
+            if (found != instances.end()) {
+                demand += std::max(found->second->info.demandCores, options.planner.minDemandCores);
+            }
+        }
+        loads.push_back(partition.capacity ? demand / partition.capacityCores() : 0.0);
+    }
+    for (size_t i = 0; i < loads.size(); i++) {
+        if (loads[i] <= options.overloadRatio) {
+            continue;
+        }
+        for (size_t j = 0; j < loads.size(); j++) {
+            if (j != i && loads[j] < options.underloadRatio && plan.partitions[j].cpus.size() > 1) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool InstanceManager::awaitingDemandLocked(uint64_t nowMs) const {
+    for (const auto& entry : instances) {
+        const Instance& instance = *entry.second;
+        if (!instance.measured && nowMs - instance.info.startedMs < options.replanIntervalMs) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void InstanceManager::replanLocked(uint64_t nowMs) {
+    PROFILE_SCOPE("instances.replan");
+    std::map<pid_t, double> demands;
+    for (const auto& entry : instances) {
+        demands[entry.first] = entry.second->info.demandCores;
+    }
+    plan = PartitionPlanner::plan(topology, demands, plan, options.planner);
+    for (auto& entry : instances) {
+        InstanceInfo& info = entry.second->info;
+        int index = plan.partitionOf(entry.first);
+        std::vector<int> cpus = index >= 0 ? plan.partitions[index].cpus : std::vector<int>();
+        if (cpus != info.cpus) {
+            entry.second->pinned.clear();   // every thread moves
+        }
+        info.partition = index;
+        info.cpus = std::move(cpus);
+    }
+    membershipChanged = false;
+    lastReplanMs = nowMs;
+    stats.replans++;
+}
+
+size_t InstanceManager::pinLocked(Instance& instance, bool all) {
+    if (instance.info.cpus.empty()) {
+        return 0;
+    }
+    if (all) {
+        instance.pinned.clear();
+    }
+    std::vector<pid_t> tids = listThreads(instance.info.pid);
+    std::unordered_set<pid_t> live(tids.begin(), tids.end());
+    for (auto it = instance.pinned.begin(); it != instance.pinned.end();) {
+        it = live.count(*it) ? std::next(it) : instance.pinned.erase(it);
+    }
+    cpu_set_t mask = maskOf(instance.info.cpus);
+    size_t pinned = 0;
+    for (pid_t tid : tids) {
+        if (instance.pinned.count(tid)) {
+            continue;
+        }
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (setter(tid, mask)) {
+            pinned++;
+            stats.threadsPinned++;
+        } else if (errno != ESRCH) {
+            stats.pinFailures++;   // not retried: EPERM stays EPERM
+        }
+        instance.pinned.insert(tid);
+    }
+    return pinned;
+}
+
+void InstanceManager::unpinLocked(Instance& instance) {
+    cpu_set_t all = topology.onlineMask();
+    for (pid_t tid : instance.pinned) {
+        setter(tid, all);
+    }
+    PROFILE_COUNT(ProfileCounter::Syscalls, instance.pinned.size());
+    instance.pinned.clear();
+    instance.info.partition = -1;
+    instance.info.cpus.clear();
+}
+
+size_t InstanceManager::update(uint64_t nowMs) {
+    PROFILE_SCOPE("instances.update");
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : instances) {
+        sampleLocked(*entry.second, nowMs);
+    }
+    bool partitioning = options.minInstances > 0 && instances.size() >= options.minInstances && topology.isLoaded();
+    if (!partitioning) {
+        if (!plan.partitions.empty()) {
+            for (auto& entry : instances) {
+                unpinLocked(*entry.second);
+            }
+            plan = PartitionPlan();
+        }
+        return 0;
+    }
+    if (membershipChanged || plan.partitions.empty()) {
+        // Until then a newcomer stays unpinned and the others keep their partitions.
+        if (!awaitingDemandLocked(nowMs)) {
+            replanLocked(nowMs);
+        }
+    } else if (nowMs - lastReplanMs >= options.replanIntervalMs && outgrownLocked()) {
+        replanLocked(nowMs);
+    }
+    size_t pinned = 0;
+    for (auto& entry : instances) {
+        pinned += pinLocked(*entry.second, false);
+    }
+    return pinned;
+}
+
+void InstanceManager::restore() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : instances) {
+        unpinLocked(*entry.second);
+    }
+    plan = PartitionPlan();
+    membershipChanged = true;
+}
+
+bool InstanceManager::isPartitioned() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !plan.partitions.empty();
+}
+
+std::vector<InstanceInfo> InstanceManager::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<InstanceInfo> result;
+    for (const auto& entry : instances) {
+        result.push_back(entry.second->info);
+    }
+    return result;
+}
+
+bool InstanceManager::get(pid_t pid, InstanceInfo& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = instances.find(pid);
+    if (found == instances.end()) {
+        return false;
+    }
+    out = found->second->info;
+    return true;
+}
+
+PartitionPlan InstanceManager::getPlan() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return plan;
+}
+
+InstanceStats InstanceManager::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    InstanceStats result = stats;
+    result.instances = instances.size();
+    result.partitions = plan.partitions.size();
+    return result;
+}
+
+#endif // __linux__
@@ -0,0 +1,437 @@
+// src/common/IoPriority.cpp - I/O priority classes for the game, background apps and our own work
+#if defined(__linux__)
+#include "IoPriority.h"
+#include "PrivilegedHelper.h"
+#include "RunqueueLatency.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// ioprio_get/ioprio_set(2); no libc wrapper.
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassShift = 13;
+constexpr int kIoprioLevelMask = (1 << kIoprioClassShift) - 1;
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool parseTid(const char* name, int32_t& tid) {
+    int32_t value = 0;
+    if (*name == '\0') {
+        return false;
+    }
+    for (const char* p = name; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    tid = value;
+    return true;
+}
+
+uint64_t monotonicNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Fills `path` up to `bytes` with incompressible data so the probe reads
+// real blocks even on compressing filesystems (f2fs, btrfs).
+bool prepareFile(const std::string& path, uint64_t bytes, std::string& error) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && static_cast<uint64_t>(st.st_size) >= bytes) {
+        return true;
+    }
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::vector<uint64_t> chunk((1u << 20) / sizeof(uint64_t));
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    bool ok = true;
+    for (uint64_t written = 0; ok && written < bytes;) {
+        for (uint64_t& word : chunk) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            word = state;
+        }
+        size_t length = static_cast<size_t>(std::min<uint64_t>(chunk.size() * sizeof(uint64_t), bytes - written));
+        ssize_t n = pwrite(fd, chunk.data(), length, static_cast<off_t>(written));
+        ok = n == static_cast<ssize_t>(length);
+        written += length;
+    }
+    ok = ok && fsync(fd) == 0;
+    if (!ok) {
+        error = path + ": " + std::strerror(errno);
+    }
+    close(fd);
+    return ok;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// IoPriority
+
+int IoPriority::toRaw() const {
+    if (ioClass == IoClass::None) {
+        return 0;
+    }
+    int lvl = ioClass == IoClass::Idle ? 0 : std::clamp(level, 0, 7);
+    return (static_cast<int>(ioClass) << kIoprioClassShift) | lvl;
+}
+
+IoPriority IoPriority::fromRaw(int raw) {
+    return IoPriority(static_cast<IoClass>((raw >> kIoprioClassShift) & 3), raw & kIoprioLevelMask);
+}
+
+bool IoPriority::parse(const std::string& text, IoPriority& out) {
+    std::string name = text.substr(0, text.find(':'));
+    IoPriority parsed;
+    if (name == "rt") parsed.ioClass = IoClass::RealTime;
+    else if (name == "be") parsed.ioClass = IoClass::BestEffort;
+    else if (name == "idle") parsed.ioClass = IoClass::Idle;
+    else if (name == "none") parsed.ioClass = IoClass::None;
+    else return false;
+    size_t colon = text.find(':');
+    if (colon != std::string::npos) {
+        char* end = nullptr;
+        long value = std::strtol(text.c_str() + colon + 1, &end, 10);
+        if (end == text.c_str() + colon + 1 || *end != '\0' || value < 0 || value > 7) {
+            return false;
+        }
+        parsed.level = static_cast<int>(value);
+    }
+    out = parsed;
+    return true;
+}
+
+std::string IoPriority::toString() const {
+    switch (ioClass) {
+    case IoClass::RealTime:
+        return "rt:" + std::to_string(level);
+    case IoClass::BestEffort:
+        return "be:" + std::to_string(level);
+    case IoClass::Idle:
+        return "idle";
+    case IoClass::None:
+    default:
+        return "none";
+    }
+}
+
+bool IoPriority::get(pid_t tid, IoPriority& out) {
+    long raw = syscall(SYS_ioprio_get, kIoprioWhoProcess, tid);
+    if (raw < 0) {
+        return false;
+    }
+    out = fromRaw(static_cast<int>(raw));
+    return true;
+}
+
+bool IoPriority::set(pid_t tid, const IoPriority& priority) {
+    return syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, priority.toRaw()) == 0;
+}
+
+// ---------------------------------------------------------------------------
+// IoPriorityManager
+
+IoPriorityManager::IoPriorityManager(const std::string& rootPrefix)
+    : root(rootPrefix), gamePid(0), applied(0), restored(0), failed(0) {}
+
+IoPriorityManager::~IoPriorityManager() {
+    restore();
+}
+
+void IoPriorityManager::setOptions(const IoPriorityOptions& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+}
+
+std::vector<pid_t> IoPriorityManager::listThreads(pid_t pid) const {
+    std::vector<pid_t> tids;
+    std::string taskDir = root + "/proc/" + std::to_string(pid) + "/task";
+    int fd = open(taskDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return tids;
+    }
+    alignas(8) char buffer[4096];
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            int32_t tid = 0;
+            if (parseTid(entry->d_name, tid)) {
+                tids.push_back(tid);
+            }
+        }
+    }
+    close(fd);
+    return tids;
+}
+
+size_t IoPriorityManager::setAllLocked(const std::vector<std::pair<pid_t, int>>& changes) {
+    size_t done = 0;
+    std::vector<HelperCommand> privileged;
+    for (const auto& change : changes) {
+        if (syscall(SYS_ioprio_set, kIoprioWhoProcess, change.first, change.second) == 0) {
+            done++;
+        } else if ((errno == EPERM || errno == EACCES) && options.allowHelper) {
+            privileged.push_back(HelperCommand::setIoPriority(change.first, change.second));
+        } else if (errno != ESRCH) {
+            failed++;   // ESRCH: the thread exited, nothing left to change
+        }
+    }
+    PROFILE_COUNT(ProfileCounter::Syscalls, changes.size());
+    if (!privileged.empty()) {
+        for (const HelperResult& result : PrivilegedHelper::getInstance()->execute(privileged)) {
+            if (result.success) {
+                done++;
+            } else {
+                failed++;
+            }
+        }
+    }
+    return done;
+}
+
+size_t IoPriorityManager::applyLocked(pid_t pid, const IoPriority& priority) {
+    std::vector<pid_t> tids = listThreads(pid);
+    if (tids.empty()) {
+        origins.erase(pid);
+        return 0;
+    }
+    auto& known = origins[pid];
+    // Forget threads that exited; tids are not reused while the process
+    // holds them, but they are afterwards.
+    std::unordered_set<pid_t> live(tids.begin(), tids.end());
+    for (auto it = known.begin(); it != known.end();) {
+        it = live.count(it->first) ? std::next(it) : known.erase(it);
+    }
+    std::vector<pid_t> fresh;
+    for (pid_t tid : tids) {
+        if (!known.count(tid)) {
+            fresh.push_back(tid);
+        }
+    }
+    // A thread created after we changed its creator inherited our class;
+    // its real origin is the one the process had, taken from the main
+    // thread.
+    auto main = known.find(pid);
+    const bool inherited = main != known.end();
+    const int processOrigin = inherited ? main->second : 0;
+    std::vector<std::pair<pid_t, int>> changes;
+    const int target = priority.toRaw();
+    for (pid_t tid : fresh) {
+        IoPriority current;
+        if (!IoPriority::get(tid, current)) {
+            continue;
+        }
+        int raw = current.toRaw();
+        known[tid] = inherited && raw == target ? processOrigin : raw;
+        if (raw != target) {
+            changes.emplace_back(tid, target);
+        }
+    }
+    size_t done = setAllLocked(changes);
+    applied += done;
+    return done;
+}
+
+void IoPriorityManager::restoreLocked(pid_t pid) {
+    auto it = origins.find(pid);
+    if (it == origins.end()) {
+        return;
+    }
+    std::vector<std::pair<pid_t, int>> changes(it->second.begin(), it->second.end());
+    origins.erase(it);
+    restored += setAllLocked(changes);
+}
+
+void IoPriorityManager::setGamePid(pid_t pid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pid == gamePid) {
+        return;
+    }
+    if (gamePid != 0) {
+        restoreLocked(gamePid);
+    }
+    // A process that was background until now keeps no stale origins.
+    if (pid != 0 && background.erase(pid)) {
+        restoreLocked(pid);
+    }
+    gamePid = pid;
+}
+
+void IoPriorityManager::syncBackground(const std::vector<pid_t>& pids) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_set<pid_t> next;
+    for (pid_t pid : pids) {
+        if (pid > 0 && pid != gamePid) {
+            next.insert(pid);
+        }
+    }
+    for (pid_t pid : background) {
+        if (!next.count(pid)) {
+            restoreLocked(pid);
+        }
+    }
+    background.swap(next);
+}
+
+size_t IoPriorityManager::refresh() {
+    PROFILE_SCOPE("ioprio.refresh");
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t changed = 0;
+    if (gamePid != 0) {
+        changed += applyLocked(gamePid, options.game);
+    }
+    for (auto it = background.begin(); it != background.end();) {
+        changed += applyLocked(*it, options.background);
+        // Exited: applyLocked dropped its origins.
+        it = origins.count(*it) ? std::next(it) : background.erase(it);
+    }
+    return changed;
+}
+
+void IoPriorityManager::restore() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!origins.empty()) {
+        restoreLocked(origins.begin()->first);
+    }
+    gamePid = 0;
+    background.clear();
+}
+
+IoPriorityStatus IoPriorityManager::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    IoPriorityStatus status;
+    status.gamePid = gamePid;
+    for (const auto& process : origins) {
+        if (process.first == gamePid) {
+            status.gameThreads = process.second.size();
+        } else {
+            status.backgroundThreads += process.second.size();
+        }
+    }
+    status.backgroundProcesses = background.size();
+    status.applied = applied;
+    status.restored = restored;
+    status.failed = failed;
+    return status;
+}
+
+bool IoPriorityManager::setCurrentThreadIdle() {
+    return IoPriority::set(0, IoPriority(IoClass::Idle, 0));
+}
+
+// ---------------------------------------------------------------------------
+// IoLatencyProbe
+
+IoLatencyResult IoLatencyProbe::run(const IoLatencyOptions& options) {
+    IoLatencyResult result;
+    const uint32_t block = std::max<uint32_t>(512, options.blockBytes & ~511u);
+    if (options.path.empty() || options.fileBytes < block) {
+        result.error = "no file, or file smaller than one block";
+        return result;
+    }
+    if (!prepareFile(options.path, options.fileBytes, result.error)) {
+        return result;
+    }
+
+    int fd = -1;
+    if (options.direct) {
+        fd = open(options.path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+        result.direct = fd >= 0;
+    }
+    if (fd < 0) {
+        fd = open(options.path.c_str(), O_RDONLY | O_CLOEXEC);   // tmpfs and friends refuse O_DIRECT
+    }
+    void* buffer = nullptr;
+    if (fd < 0 || posix_memalign(&buffer, 4096, block) != 0) {
+        result.error = options.path + ": " + std::strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return result;
+    }
+
+    IoPriority original;
+    bool changed = false;
+    if (options.priority.ioClass != IoClass::None) {
+        if (!IoPriority::get(0, original) || !IoPriority::set(0, options.priority)) {
+            result.error = "cannot read at " + options.priority.toString() + ": " + std::strerror(errno);
+            free(buffer);
+            close(fd);
+            return result;
+        }
+        changed = true;
+    }
+
+    const uint64_t blocks = options.fileBytes / block;
+    uint64_t state = monotonicNanos() | 1;
+    LatencyHistogram histogram(3);
+    const uint64_t startNs = monotonicNanos();
+    const uint64_t endNs = startNs + static_cast<uint64_t>(options.durationMs) * 1000000ull;
+    uint64_t nowNs = startNs;
+    while ((options.maxReads == 0 || result.reads < options.maxReads) &&
+           (nowNs < endNs || (options.durationMs == 0 && options.maxReads != 0))) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        off_t offset = static_cast<off_t>((state % blocks) * block);
+        if (!result.direct) {
+            posix_fadvise(fd, offset, block, POSIX_FADV_DONTNEED);
+        }
+        uint64_t beforeNs = monotonicNanos();
+        ssize_t n = pread(fd, buffer, block, offset);
+        nowNs = monotonicNanos();
+        if (n != static_cast<ssize_t>(block)) {
+            result.error = std::string("read: ") + (n < 0 ? std::strerror(errno) : "short read");
+            break;
+        }
+        histogram.record((nowNs - beforeNs) / 1000);
+        result.reads++;
+    }
+    uint64_t elapsedNs = nowNs - startNs;
+
+    if (changed) {
+        IoPriority::set(0, original);
+    }
+    free(buffer);
+    close(fd);
+
+    result.success = result.reads > 0 && result.error.empty();
+    result.iops = elapsedNs ? result.reads * 1e9 / elapsedNs : 0.0;
+    result.meanUs = histogram.mean();
+    result.p50Us = static_cast<double>(histogram.quantile(0.50));
+    result.p90Us = static_cast<double>(histogram.quantile(0.90));
+    result.p99Us = static_cast<double>(histogram.quantile(0.99));
+    result.maxUs = static_cast<double>(histogram.max());
+    return result;
+}
+
+#endif // __linux__
@@ -1,21 +1,507 @@
-// src/common/Logger.cpp - Basic implementation
-#include <iostream>
-#include <fstream>
+// src/common/Logger.cpp - Asynchronous ring-buffer logger
+#include "Logger.h"
+
 #include <chrono>
-#include <iomanip>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const char* kLevelNames[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+// Binary log layout (host byte order; the header records it):
+//   header : "RBXLOG1\0" u32 byteOrderMark
+//   'F'    : u32 formatId, u16 length, bytes      (first use of a format)
+//   'R'    : u64 timestampNs, u8 level, u32 threadId, u32 formatId, u8 argc,
+//            argc x { u8 type, (u16 length + bytes) | 8-byte value }
+const char kBinaryMagic[8] = {'R', 'B', 'X', 'L', 'O', 'G', '1', '\0'};
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+// Format strings are registered once per call site and never freed.
+std::atomic<uint32_t> g_formatCount{1};
+std::atomic<const char*> g_formats[Logger::kMaxFormats];
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+const char* argString(const LogRecord& record, const LogArg& arg) {
+    return record.payload + arg.value.stringOffset;
+}
+
+// Formats one printf conversion with a typed argument, coercing when the
+// call site and the conversion disagree.
+void appendConversion(std::string& out, std::string spec, char conversion,
+                      const LogRecord& record, const LogArg* arg) {
+    char buffer[128];
+    if (!arg) {
+        out += "<?>";
+        return;
+    }
+    switch (conversion) {
+    case 'd': case 'i': {
+        int64_t v = arg->type == LogArg::Type::Double ? static_cast<int64_t>(arg->value.d) : arg->value.i;
+        spec += PRId64;
+        std::snprintf(buffer, sizeof(buffer), spec.c_str(), v);
+        break;
+    }
+    case 'u': case 'x': case 'X': case 'o': case 'p': {
+        uint64_t v = arg->type == LogArg::Type::Double ? static_cast<uint64_t>(arg->value.d) : arg->value.u;
+        if (conversion == 'p') {
+            spec += "#";
+        }
+        spec += conversion == 'u' ? PRIu64 : conversion == 'o' ? PRIo64 : conversion == 'X' ? PRIX64 : PRIx64;
+        std::snprintf(buffer, sizeof(buffer), spec.c_str(), v);
+        break;
+    }
+    case 'c':
+        spec += 'c';
+        std::snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<int>(arg->value.i));
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+        double v = arg->type == LogArg::Type::Double ? arg->value.d
+                 : arg->type == LogArg::Type::Int ? static_cast<double>(arg->value.i)
+                 : static_cast<double>(arg->value.u);
+        spec += conversion;
+        std::snprintf(buffer, sizeof(buffer), spec.c_str(), v);
+        break;
+    }
+    case 's':
+        if (arg->type == LogArg::Type::String) {
+            spec += 's';
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(), argString(record, *arg));
+        } else if (arg->type == LogArg::Type::Double) {
+            std::snprintf(buffer, sizeof(buffer), "%g", arg->value.d);
+        } else if (arg->type == LogArg::Type::Int) {
+            std::snprintf(buffer, sizeof(buffer), "%" PRId64, arg->value.i);
+        } else {
+            std::snprintf(buffer, sizeof(buffer), "%" PRIu64, arg->value.u);
+        }
+        break;
+    default:
+        out += "<?>";
+        return;
+    }
+    out += buffer;
+}
+
+void appendTimestamp(std::string& out, uint64_t timestampNs) {
+    time_t seconds = static_cast<time_t>(timestampNs / 1000000000ull);
+    unsigned millis = static_cast<unsigned>((timestampNs / 1000000ull) % 1000);
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char buffer[32];
+    size_t n = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    std::snprintf(buffer + n, sizeof(buffer) - n, ".%03u", millis);
+    out += buffer;
+}
+
+std::string renderLine(const LogRecord& record, const char* format) {
+    std::string line;
+    line.reserve(96);
+    appendTimestamp(line, record.timestampNs);
+    line += " [";
+    line += kLevelNames[static_cast<int>(record.level) & 3];
+    line += "] ";
+    line += Logger::formatRecord(record, format);
+    return line;
+}
 
-class Logger {
-public:
-    static Logger& getInstance() {
-        static Logger instance;
-        return instance;
+} // namespace
+
+// ---------------------------------------------------------------------------
+
+Logger* Logger::getInstance(const std::string& filename) {
+    static Logger instance(filename);
+    return &instance;
+}
+
+Logger::Logger(const std::string& filename)
+    : ring(new Cell[kRingSize]),
+      enqueuePos(0),
+      dequeuePos(0),
+      droppedCount(0),
+      flushedSequence(0),
+      reportedDrops(0),
+      currentLevel(LogLevel::INFO),
+      consoleOutput(true),
+      running(true),
+      binaryFormatsWritten{} {
+    for (size_t i = 0; i < kRingSize; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    if (!filename.empty()) {
+        logFile.open(filename, std::ios::app);
+    }
+    flusher = std::thread(&Logger::flushLoop, this);
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running.store(false, std::memory_order_release);
+    }
+    wakeCondition.notify_all();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+}
+
+void Logger::setLevel(LogLevel level) {
+    currentLevel.store(level, std::memory_order_relaxed);
+}
+
+uint32_t Logger::registerFormat(const char* format) {
+    uint32_t id = g_formatCount.fetch_add(1, std::memory_order_relaxed);
+    if (id >= kMaxFormats) {
+        return 0;  // table full: fall back to raw text of the format itself
+    }
+    g_formats[id].store(format, std::memory_order_release);
+    return id;
+}
+
+const char* Logger::formatString(uint32_t formatId) {
+    if (formatId == 0 || formatId >= kMaxFormats) {
+        return nullptr;
     }
-    
-    void info(const std::string& message) {
-        std::cout << "[INFO] " << message << std::endl;
+    return g_formats[formatId].load(std::memory_order_acquire);
+}
+
+uint32_t Logger::currentThreadId() {
+    thread_local uint32_t id = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return id;
+}
+
+uint64_t Logger::nowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+LogRecord* Logger::beginRecord(LogLevel level, uint32_t formatId, uint64_t& position) {
+    // Bounded MPMC queue (Vyukov); only the producer side is contended.
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = ring[pos & (kRingSize - 1)];
+        uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    position = pos;
+    LogRecord& record = ring[pos & (kRingSize - 1)].record;
+    record.timestampNs = nowNanos();
+    record.formatId = formatId;
+    record.threadId = currentThreadId();
+    record.level = level;
+    record.argCount = 0;
+    record.payloadUsed = 0;
+    return &record;
+}
+
+void Logger::commitRecord(uint64_t position, LogLevel level) {
+    ring[position & (kRingSize - 1)].sequence.store(position + 1, std::memory_order_release);
+    if (level == LogLevel::ERROR) {
+        wakeCondition.notify_one();  // errors are written promptly
     }
-    
-    void error(const std::string& message) {
-        std::cout << "[ERROR] " << message << std::endl;
+}
+
+void Logger::encodeArg(LogRecord& r, LogArg& a, const char* v) {
+    a.type = LogArg::Type::String;
+    a.value.stringOffset = r.payloadUsed;
+    size_t room = LogRecord::kPayloadSize - r.payloadUsed;
+    if (room == 0) {
+        a.value.stringOffset = LogRecord::kPayloadSize - 1;  // points at the final NUL
+        return;
+    }
+    size_t length = v ? std::strlen(v) : 0;
+    if (length >= room) {
+        length = room - 1;
+    }
+    if (length) {
+        std::memcpy(r.payload + r.payloadUsed, v, length);
+    }
+    r.payload[r.payloadUsed + length] = '\0';
+    r.payloadUsed = static_cast<uint16_t>(r.payloadUsed + length + 1);
+}
+
+void Logger::log(LogLevel level, const std::string& message) {
+    if (!isEnabled(level)) {
+        return;
+    }
+    uint64_t position = 0;
+    LogRecord* record = beginRecord(level, 0, position);
+    if (!record) {
+        return;
+    }
+    encodeArg(*record, record->args[0], message.c_str());
+    record->argCount = 1;
+    if (message.size() >= LogRecord::kPayloadSize) {
+        std::memcpy(record->payload + LogRecord::kPayloadSize - 4, "...", 4);
+    }
+    commitRecord(position, level);
+}
+
+void Logger::debug(const std::string& message) { log(LogLevel::DEBUG, message); }
+void Logger::info(const std::string& message) { log(LogLevel::INFO, message); }
+void Logger::warning(const std::string& message) { log(LogLevel::WARNING, message); }
+void Logger::error(const std::string& message) { log(LogLevel::ERROR, message); }
+
+bool Logger::enableBinaryOutput(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.write(kBinaryMagic, sizeof(kBinaryMagic));
+    writeValue(file, kByteOrderMark);
+    // The flusher only touches binaryFile while holding wakeMutex between batches.
+    binaryFile = std::move(file);
+    std::fill(std::begin(binaryFormatsWritten), std::end(binaryFormatsWritten), false);
+    return true;
+}
+
+std::string Logger::formatRecord(const LogRecord& record, const char* format) {
+    if (!format) {
+        // Raw text record (or unregistered format): concatenate string args.
+        std::string text;
+        for (int i = 0; i < record.argCount; i++) {
+            if (record.args[i].type == LogArg::Type::String) {
+                text += argString(record, record.args[i]);
+            }
+        }
+        return text;
+    }
+
+    std::string out;
+    int argIndex = 0;
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') {
+            out += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            p++;
+            continue;
+        }
+        std::string spec = "%";
+        const char* q = p + 1;
+        while (*q && std::strchr("-+ #0123456789.", *q)) {
+            spec += *q++;
+        }
+        while (*q && std::strchr("hlLqjzt", *q)) {
+            q++;  // length modifiers are replaced by the argument's real width
+        }
+        if (!*q) {
+            break;
+        }
+        const LogArg* arg = argIndex < record.argCount ? &record.args[argIndex] : nullptr;
+        appendConversion(out, spec, *q, record, arg);
+        argIndex++;
+        p = q;
+    }
+    return out;
+}
+
+void Logger::writeText(const LogRecord& record) {
+    std::string line = renderLine(record, formatString(record.formatId));
+    if (consoleOutput.load(std::memory_order_relaxed)) {
+        std::cout << line << '\n';
+    }
+    if (logFile.is_open()) {
+        logFile << line << '\n';
+    }
+}
+
+void Logger::writeBinary(const LogRecord& record) {
+    const char* format = formatString(record.formatId);
+    uint32_t formatId = format ? record.formatId : 0;
+    if (formatId && !binaryFormatsWritten[formatId]) {
+        binaryFormatsWritten[formatId] = true;
+        uint16_t length = static_cast<uint16_t>(std::strlen(format));
+        binaryFile.put('F');
+        writeValue(binaryFile, formatId);
+        writeValue(binaryFile, length);
+        binaryFile.write(format, length);
+    }
+
+    binaryFile.put('R');
+    writeValue(binaryFile, record.timestampNs);
+    writeValue(binaryFile, static_cast<uint8_t>(record.level));
+    writeValue(binaryFile, record.threadId);
+    writeValue(binaryFile, formatId);
+    writeValue(binaryFile, record.argCount);
+    for (int i = 0; i < record.argCount; i++) {
+        const LogArg& arg = record.args[i];
+        writeValue(binaryFile, static_cast<uint8_t>(arg.type));
+        if (arg.type == LogArg::Type::String) {
+            const char* text = argString(record, arg);
+            uint16_t length = static_cast<uint16_t>(std::strlen(text));
+            writeValue(binaryFile, length);
+            binaryFile.write(text, length);
+        } else {
+            writeValue(binaryFile, arg.value.u);
+        }
+    }
+}
+
+size_t Logger::drainBatch() {
+    size_t written = 0;
+    for (;;) {
+        Cell& cell = ring[dequeuePos & (kRingSize - 1)];
+        uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != dequeuePos + 1) {
+            break;  // empty, or the next producer has not committed yet
+        }
+        if (binaryFile.is_open()) {
+            writeBinary(cell.record);
+        } else {
+            writeText(cell.record);
+        }
+        cell.sequence.store(dequeuePos + kRingSize, std::memory_order_release);
+        dequeuePos++;
+        written++;
+    }
+
+    uint64_t dropped = droppedCount.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops) {
+        LogRecord notice = {};
+        notice.timestampNs = nowNanos();
+        notice.level = LogLevel::WARNING;
+        std::string text = "Logger dropped " + std::to_string(dropped - reportedDrops) +
+                           " records (ring full)";
+        encodeArg(notice, notice.args[0], text.c_str());
+        notice.argCount = 1;
+        reportedDrops = dropped;
+        if (binaryFile.is_open()) {
+            writeBinary(notice);
+        } else {
+            writeText(notice);
+        }
+        written++;
+    }
+
+    if (written) {
+        if (consoleOutput.load(std::memory_order_relaxed)) {
+            std::cout.flush();
+        }
+        if (logFile.is_open()) {
+            logFile.flush();
+        }
+        if (binaryFile.is_open()) {
+            binaryFile.flush();
+        }
+    }
+    return written;
+}
+
+void Logger::flushLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    for (;;) {
+        drainBatch();
+        flushedSequence.store(dequeuePos, std::memory_order_release);
+        flushedCondition.notify_all();
+        if (!running.load(std::memory_order_acquire)) {
+            break;
+        }
+        // Batch window: producers never signal except for errors and flush().
+        wakeCondition.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    drainBatch();
+}
+
+void Logger::flush() {
+    uint64_t target = enqueuePos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (flushedSequence.load(std::memory_order_acquire) < target && running.load()) {
+        wakeCondition.notify_one();
+        flushedCondition.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+bool Logger::decodeBinaryLog(const std::string& filename, std::ostream& out) {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(kBinaryMagic)];
+    uint32_t byteOrder = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kBinaryMagic, sizeof(magic)) != 0 ||
+        !readValue(in, byteOrder) || byteOrder != kByteOrderMark) {
+        return false;
+    }
+
+    std::vector<std::string> formats;
+    char tag = 0;
+    while (in.get(tag)) {
+        if (tag == 'F') {
+            uint32_t id = 0;
+            uint16_t length = 0;
+            if (!readValue(in, id) || !readValue(in, length) || id >= kMaxFormats) {
+                return false;
+            }
+            if (formats.size() <= id) {
+                formats.resize(id + 1);
+            }
+            formats[id].resize(length);
+            if (!in.read(&formats[id][0], length)) {
+                return false;
+            }
+        } else if (tag == 'R') {
+            LogRecord record = {};
+            uint8_t level = 0;
+            if (!readValue(in, record.timestampNs) || !readValue(in, level) ||
+                !readValue(in, record.threadId) || !readValue(in, record.formatId) ||
+                !readValue(in, record.argCount) || record.argCount > LogRecord::kMaxArgs) {
+                return false;
+            }
+            record.level = static_cast<LogLevel>(level & 3);
+            for (int i = 0; i < record.argCount; i++) {
+                uint8_t type = 0;
+                if (!readValue(in, type)) {
+                    return false;
+                }
+                LogArg& arg = record.args[i];
+                arg.type = static_cast<LogArg::Type>(type);
+                if (arg.type == LogArg::Type::String) {
+                    uint16_t length = 0;
+                    if (!readValue(in, length) || record.payloadUsed + length + 1 > LogRecord::kPayloadSize) {
+                        return false;
+                    }
+                    arg.value.stringOffset = record.payloadUsed;
+                    in.read(record.payload + record.payloadUsed, length);
+                    record.payload[record.payloadUsed + length] = '\0';
+                    record.payloadUsed = static_cast<uint16_t>(record.payloadUsed + length + 1);
+                } else if (!readValue(in, arg.value.u)) {
+                    return false;
+                }
+            }
+            const char* format = record.formatId && record.formatId < formats.size()
+                ? formats[record.formatId].c_str() : nullptr;
+            out << renderLine(record, format) << '\n';
+        } else {
+            return false;
+        }
     }
-};
+    return true;
+}
@@ -0,0 +1,417 @@
+// src/common/MemoryAccountant.cpp - Per-process memory accounting
+#if defined(__linux__)
+#include "MemoryAccountant.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Upper bound on zram devices probed; phones have one.
+constexpr int kMaxZramDevices = 8;
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool parsePid(const char* name, pid_t& pid) {
+    if (*name < '1' || *name > '9') {
+        return false;
+    }
+    long value = 0;
+    for (const char* p = name; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    pid = static_cast<pid_t>(value);
+    return true;
+}
+
+} // namespace
+
+MemoryAccountant::MemoryAccountant(const std::string& rootPrefix)
+    : root(rootPrefix), procFd(-1), pageSize(static_cast<uint64_t>(sysconf(_SC_PAGESIZE))), focusPid(0),
+      buffer(4096) {}
+
+MemoryAccountant::~MemoryAccountant() {
+    if (procFd >= 0) {
+        close(procFd);
+    }
+}
+
+void MemoryAccountant::setOptions(const Options& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+}
+
+void MemoryAccountant::setFocusPid(pid_t pid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    focusPid = pid;
+    for (auto& item : entries) {
+        item.second.memory.focus = item.first == pid;
+    }
+}
+
+bool MemoryAccountant::openProcDir() {
+    if (procFd >= 0) {
+        return true;
+    }
+    procFd = open((root + "/proc").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return procFd >= 0;
+}
+
+std::string_view MemoryAccountant::readAt(int dirFd, const char* path) {
+    int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    if (fd < 0) {
+        return {};
+    }
+    size_t used = 0;
+    for (;;) {
+        ssize_t n = ::read(fd, buffer.data() + used, buffer.size() - used);
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            used = 0;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        used += static_cast<size_t>(n);
+        if (used == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+    close(fd);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    PROFILE_COUNT(ProfileCounter::BytesRead, used);
+    return std::string_view(buffer.data(), used);
+}
+
+void MemoryAccountant::discover() {
+    for (auto& item : entries) {
+        item.second.seen = false;
+    }
+    alignas(8) char dirents[16384];
+    lseek(procFd, 0, SEEK_SET);
+    for (;;) {
+        long n = syscall(SYS_getdents64, procFd, dirents, sizeof(dirents));
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(dirents + offset);
+            offset += entry->d_reclen;
+            pid_t pid = 0;
+            if (parsePid(entry->d_name, pid)) {
+                Entry& tracked = entries[pid];
+                tracked.seen = true;
+                if (tracked.memory.pid == 0) {
+                    tracked.memory.pid = pid;
+                    tracked.memory.focus = pid == focusPid;
+                }
+            }
+        }
+    }
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!it->second.seen) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool MemoryAccountant::sampleCheap(Entry& entry, uint64_t nowMs) {
+    ProcessMemory& memory = entry.memory;
+    char path[48];
+    std::snprintf(path, sizeof(path), "%d/stat", memory.pid);
+    TaskStat stat;
+    if (!ProcParser::parseTaskStat(readAt(procFd, path), stat)) {
+        return false;
+    }
+    stats.cheapReads++;
+
+    if (memory.cheapSampleMs != 0 && stat.startTime != memory.startTime) {
+        // Same pid, new process: nothing from the old one carries over.
+        pid_t pid = memory.pid;
+        entry = Entry();
+        entry.memory.pid = pid;
+        entry.memory.focus = pid == focusPid;
+        stats.generations++;
+    }
+    if (memory.cheapSampleMs == 0) {
+        memory.startTime = stat.startTime;
+        std::memcpy(memory.comm, stat.comm, sizeof(memory.comm));
+        // Kernel threads have no mm: vsize is 0 and there is nothing to
+        // account, so they are never read again for this generation.
+        if (stat.vsize == 0) {
+            entry.kernelThread = true;
+            memory.cheapSampleMs = nowMs;
+            return true;
+        }
+        struct stat dirStat;
+        std::snprintf(path, sizeof(path), "%d", memory.pid);
+        if (fstatat(procFd, path, &dirStat, 0) == 0) {
+            memory.uid = dirStat.st_uid;
+        }
+        readName(memory);
+    }
+
+    uint64_t previousRss = memory.rss;
+    std::snprintf(path, sizeof(path), "%d/statm", memory.pid);
+    TaskStatm statm;
+    if (ProcParser::parseTaskStatm(readAt(procFd, path), statm)) {
+        memory.rss = statm.residentPages * pageSize;
+        memory.shared = statm.sharedPages * pageSize;
+    } else {
+        memory.rss = stat.rssPages * pageSize;
+    }
+    // A process that touches memory faults or grows; one that does
+    // neither between samples is idle as far as reclaim is concerned.
+    if (memory.cheapSampleMs == 0 || stat.minorFaults != memory.minorFaults ||
+        stat.majorFaults != memory.majorFaults || memory.rss > previousRss) {
+        memory.lastActiveMs = nowMs;
+    }
+    if (memory.cheapSampleMs != 0 && nowMs > memory.cheapSampleMs && stat.majorFaults >= memory.majorFaults) {
+        memory.majorFaultsPerSec = (stat.majorFaults - memory.majorFaults) * 1000.0 / (nowMs - memory.cheapSampleMs);
+    }
+    memory.minorFaults = stat.minorFaults;
+    memory.majorFaults = stat.majorFaults;
+    memory.cheapSampleMs = nowMs;
+    return true;
+}
+
+void MemoryAccountant::readName(ProcessMemory& memory) {
+    char path[48];
+    std::snprintf(path, sizeof(path), "%d/cmdline", memory.pid);
+    std::string_view cmdline = readAt(procFd, path);
+    cmdline = cmdline.substr(0, cmdline.find('\0'));
+    memory.name.assign(cmdline.empty() ? std::string_view(memory.comm) : cmdline);
+}
+
+bool MemoryAccountant::sampleDetail(Entry& entry, uint64_t nowMs) {
+    ProcessMemory& memory = entry.memory;
+    char path[48];
+    std::snprintf(path, sizeof(path), "%d/status", memory.pid);
+    TaskStatus status;
+    if (!ProcParser::parseTaskStatus(readAt(procFd, path), status)) {
+        return false;
+    }
+    stats.detailReads++;
+    memory.uid = status.uid;
+    memory.rssAnon = status.rssAnon;
+    memory.rssFile = status.rssFile;
+    memory.rssShmem = status.rssShmem;
+    memory.swap = status.vmSwap;
+
+    std::snprintf(path, sizeof(path), "%d/smaps_rollup", memory.pid);
+    SmapsRollup rollup;
+    memory.hasPss = ProcParser::parseSmapsRollup(readAt(procFd, path), rollup);
+    if (memory.hasPss) {
+        memory.pss = rollup.pss;
+        memory.pssAnon = rollup.pssAnon;
+        memory.pssFile = rollup.pssFile;
+        memory.pssShmem = rollup.pssShmem;
+        memory.swap = rollup.swap;
+        memory.swapPss = rollup.swapPss;
+    } else {
+        memory.pss = status.vmRss;
+        memory.pssAnon = status.rssAnon;
+        memory.pssFile = status.rssFile;
+        memory.pssShmem = status.rssShmem;
+        memory.swapPss = status.vmSwap;
+    }
+    memory.zramEstimate = zram.origDataSize
+        ? static_cast<uint64_t>(static_cast<double>(memory.swapPss) * zram.comprDataSize / zram.origDataSize)
+        : 0;
+
+    std::snprintf(path, sizeof(path), "%d/oom_score_adj", memory.pid);
+    int64_t adj = 0;
+    if (ProcParser::parseSigned(ProcParser::trimLine(readAt(procFd, path)), adj)) {
+        memory.oomScoreAdj = static_cast<int32_t>(adj);
+    }
+
+    // Apps are forked from the zygote and renamed after specialization,
+    // so argv[0] is re-read with every detail pass rather than cached.
+    readName(memory);
+
+    memory.hasDetail = true;
+    memory.detailSampleMs = nowMs;
+    memory.rssAtDetail = memory.rss;
+    return true;
+}
+
+double MemoryAccountant::detailUrgency(const Entry& entry, uint64_t nowMs) const {
+    const ProcessMemory& memory = entry.memory;
+    if (!memory.hasDetail) {
+        // Unmeasured processes go first, largest first.
+        return 1e12 + static_cast<double>(memory.rss);
+    }
+    uint64_t age = nowMs - memory.detailSampleMs;
+    uint32_t interval = memory.focus ? options.focusDetailIntervalMs : options.backgroundDetailIntervalMs;
+    double urgency = interval ? static_cast<double>(age) / interval : 1.0;
+    if (age >= options.minDetailIntervalMs && options.rssChangePercent > 0.0) {
+        uint64_t base = std::max<uint64_t>(memory.rssAtDetail, pageSize);
+        uint64_t delta = memory.rss > memory.rssAtDetail ? memory.rss - memory.rssAtDetail
+                                                         : memory.rssAtDetail - memory.rss;
+        urgency = std::max(urgency, 100.0 * delta / base / options.rssChangePercent);
+    }
+    return urgency;
+}
+
+void MemoryAccountant::readZram() {
+    ZramStats next;
+    for (int device = 0; device < kMaxZramDevices; device++) {
+        std::string path = root + "/sys/block/zram" + std::to_string(device) + "/mm_stat";
+        std::string_view text = readAt(AT_FDCWD, path.c_str());
+        if (text.empty()) {
+            break;
+        }
+        // orig_data_size compr_data_size mem_used_total mem_limit ...
+        uint64_t values[3] = {};
+        bool ok = true;
+        for (uint64_t& value : values) {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+                text.remove_prefix(1);
+            }
+            size_t end = text.find_first_of(" \t\n");
+            ok &= ProcParser::parseUnsigned(text.substr(0, end), value);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end);
+        }
+        if (!ok) {
+            continue;
+        }
+        next.devices++;
+        next.origDataSize += values[0];
+        next.comprDataSize += values[1];
+        next.memUsedTotal += values[2];
+    }
+    zram = next;
+}
+
+bool MemoryAccountant::sample(uint64_t nowMs) {
+    PROFILE_SCOPE("memory.sample");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!openProcDir()) {
+        return false;
+    }
+    uint64_t startNs = SelfProfiler::nowNanos();
+    discover();
+    readZram();
+
+    detailQueue.clear();
+    stats.processes = 0;
+    stats.kernelThreads = 0;
+    for (auto it = entries.begin(); it != entries.end();) {
+        Entry& entry = it->second;
+        ProcessMemory& memory = entry.memory;
+        bool due = memory.cheapSampleMs == 0 || memory.focus ||
+                   nowMs - memory.cheapSampleMs >= options.backgroundCheapIntervalMs;
+        if (!entry.kernelThread && due && !sampleCheap(entry, nowMs)) {
+            it = entries.erase(it);   // exited since discovery
+            continue;
+        }
+        if (entry.kernelThread) {
+            stats.kernelThreads++;
+        } else {
+            stats.processes++;
+            double urgency = detailUrgency(entry, nowMs);
+            if (urgency >= 1.0) {
+                detailQueue.emplace_back(memory.focus ? 1e18 : urgency, &entry);
+            }
+        }
+        ++it;
+    }
+
+    size_t budget = std::min<size_t>(options.maxDetailReadsPerPass, detailQueue.size());
+    std::partial_sort(detailQueue.begin(), detailQueue.begin() + budget, detailQueue.end(),
+                      [](const std::pair<double, Entry*>& a, const std::pair<double, Entry*>& b) {
+                          return a.first > b.first;
+                      });
+    for (size_t i = 0; i < budget; i++) {
+        sampleDetail(*detailQueue[i].second, nowMs);
+    }
+    detailQueue.clear();
+
+    stats.passes++;
+    stats.lastPassNs = SelfProfiler::nowNanos() - startNs;
+    return true;
+}
+
+bool MemoryAccountant::refreshDetail(pid_t pid, uint64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(pid);
+    if (it == entries.end() || it->second.kernelThread || !openProcDir()) {
+        return false;
+    }
+    return sampleCheap(it->second, nowMs) && sampleDetail(it->second, nowMs);
+}
+
+bool MemoryAccountant::get(pid_t pid, ProcessMemory& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(pid);
+    if (it == entries.end() || it->second.kernelThread || it->second.memory.cheapSampleMs == 0) {
+        return false;
+    }
+    out = it->second.memory;
+    return true;
+}
+
+bool MemoryAccountant::findByName(const std::string& name, ProcessMemory& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& item : entries) {
+        const ProcessMemory& memory = item.second.memory;
+        if (!item.second.kernelThread && memory.cheapSampleMs != 0 &&
+            (memory.name == name || name == memory.comm)) {
+            out = memory;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<ProcessMemory> MemoryAccountant::snapshot() const {
+    std::vector<ProcessMemory> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.reserve(entries.size());
+        for (const auto& item : entries) {
+            if (!item.second.kernelThread && item.second.memory.cheapSampleMs != 0) {
+                result.push_back(item.second.memory);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const ProcessMemory& a, const ProcessMemory& b) {
+        return a.footprint() > b.footprint();
+    });
+    return result;
+}
+
+ZramStats MemoryAccountant::getZramStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return zram;
+}
+
+MemoryAccountantStats MemoryAccountant::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+#endif // __linux__
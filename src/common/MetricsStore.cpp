@@ -0,0 +1,458 @@
+// src/common/MetricsStore.cpp - Columnar metrics time-series store
+#if defined(__linux__)
+#include "MetricsStore.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'R', 'B', 'X', 'M', 'T', 'S', '1', '\0'};
+constexpr uint32_t kLayoutVersion = 1;
+const uint64_t kBucketWidthMs[MetricsStore::kTierCount] = {1000, 10000, 60000};
+
+size_t align8(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+const float kMissing = std::numeric_limits<float>::quiet_NaN();
+
+} // namespace
+
+struct MetricsStore::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t maxMetrics;
+    uint32_t rawCapacity;
+    uint32_t tierCapacity[kTierCount];
+    uint32_t metricCount;
+    uint32_t reserved;
+    uint64_t rawHead;                 // rows ever appended
+    uint64_t tierHead[kTierCount];    // buckets ever closed
+    // followed by maxMetrics names of kMaxNameLength bytes
+};
+
+MetricsStore::MetricsStore(const MetricsStoreOptions& storeOptions)
+    : options(storeOptions), region(nullptr), regionSize(0), fileBacked(false), header(nullptr),
+      rawTimestamps(nullptr), rawValues(nullptr), randomState(0x9E3779B97F4A7C15ull) {
+    options.maxMetrics = std::max<uint32_t>(options.maxMetrics, 1);
+    options.rawCapacity = std::max<uint32_t>(options.rawCapacity, 1);
+    for (int tier = 0; tier < kTierCount; tier++) {
+        options.tierCapacity[tier] = std::max<uint32_t>(options.tierCapacity[tier], 1);
+        tierTimestamps[tier] = nullptr;
+        tierCounts[tier] = nullptr;
+        tierValues[tier] = nullptr;
+    }
+}
+
+MetricsStore::~MetricsStore() {
+    close();
+}
+
+uint64_t MetricsStore::bucketWidthMs(Tier tier) {
+    return kBucketWidthMs[tier];
+}
+
+size_t MetricsStore::layoutSize() const {
+    size_t size = align8(sizeof(Header)) + align8(options.maxMetrics * kMaxNameLength);
+    size += align8(options.rawCapacity * sizeof(uint64_t));
+    size += align8(static_cast<size_t>(options.maxMetrics) * options.rawCapacity * sizeof(float));
+    for (int tier = 0; tier < kTierCount; tier++) {
+        uint32_t capacity = options.tierCapacity[tier];
+        size += align8(capacity * sizeof(uint64_t));
+        size += align8(capacity * sizeof(uint32_t));
+        size += align8(static_cast<size_t>(options.maxMetrics) * capacity * sizeof(RollupValue));
+    }
+    return size;
+}
+
+void MetricsStore::mapSections() {
+    uint8_t* cursor = region;
+    header = reinterpret_cast<Header*>(cursor);
+    cursor += align8(sizeof(Header)) + align8(options.maxMetrics * kMaxNameLength);
+    rawTimestamps = reinterpret_cast<uint64_t*>(cursor);
+    cursor += align8(options.rawCapacity * sizeof(uint64_t));
+    rawValues = reinterpret_cast<float*>(cursor);
+    cursor += align8(static_cast<size_t>(options.maxMetrics) * options.rawCapacity * sizeof(float));
+    for (int tier = 0; tier < kTierCount; tier++) {
+        uint32_t capacity = options.tierCapacity[tier];
+        tierTimestamps[tier] = reinterpret_cast<uint64_t*>(cursor);
+        cursor += align8(capacity * sizeof(uint64_t));
+        tierCounts[tier] = reinterpret_cast<uint32_t*>(cursor);
+        cursor += align8(capacity * sizeof(uint32_t));
+        tierValues[tier] = reinterpret_cast<RollupValue*>(cursor);
+        cursor += align8(static_cast<size_t>(options.maxMetrics) * capacity * sizeof(RollupValue));
+    }
+}
+
+char* MetricsStore::nameSlot(int metric) const {
+    return reinterpret_cast<char*>(region) + align8(sizeof(Header)) + static_cast<size_t>(metric) * kMaxNameLength;
+}
+
+bool MetricsStore::headerMatches() const {
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kLayoutVersion ||
+        header->maxMetrics != options.maxMetrics || header->rawCapacity != options.rawCapacity ||
+        header->metricCount > options.maxMetrics) {
+        return false;
+    }
+    for (int tier = 0; tier < kTierCount; tier++) {
+        if (header->tierCapacity[tier] != options.tierCapacity[tier]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MetricsStore::initializeHeader() {
+    std::memset(region, 0, regionSize);
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kLayoutVersion;
+    header->maxMetrics = options.maxMetrics;
+    header->rawCapacity = options.rawCapacity;
+    for (int tier = 0; tier < kTierCount; tier++) {
+        header->tierCapacity[tier] = options.tierCapacity[tier];
+    }
+}
+
+bool MetricsStore::open(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (region) {
+        return true;
+    }
+    regionSize = layoutSize();
+    bool reuse = false;
+
+    if (filePath.empty()) {
+        void* memory = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return false;
+        }
+        region = static_cast<uint8_t*>(memory);
+        fileBacked = false;
+    } else {
+        int fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        reuse = fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == regionSize;
+        if (!reuse && ftruncate(fd, static_cast<off_t>(regionSize)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void* memory = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED) {
+            return false;
+        }
+        region = static_cast<uint8_t*>(memory);
+        fileBacked = true;
+        path = filePath;
+    }
+
+    mapSections();
+    if (!reuse || !headerMatches()) {
+        initializeHeader();
+    }
+    for (auto& bucket : buckets) {
+        bucket.active = false;
+        bucket.metrics.assign(options.maxMetrics, Accumulator());
+        for (auto& accumulator : bucket.metrics) {
+            accumulator.reservoir.reserve(kReservoirSize);
+        }
+    }
+    scratch.reserve(kReservoirSize);
+    return true;
+}
+
+void MetricsStore::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!region) {
+        return;
+    }
+    // Partial buckets are kept so a restarted session sees them.
+    for (int tier = 0; tier < kTierCount; tier++) {
+        if (buckets[tier].active) {
+            closeBucket(tier);
+        }
+    }
+    if (fileBacked) {
+        msync(region, regionSize, MS_SYNC);
+    }
+    munmap(region, regionSize);
+    region = nullptr;
+    header = nullptr;
+    regionSize = 0;
+    path.clear();
+}
+
+void MetricsStore::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (region && fileBacked) {
+        msync(region, regionSize, MS_ASYNC);
+    }
+}
+
+int MetricsStore::findMetric(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return findLocked(name);
+}
+
+int MetricsStore::findLocked(const std::string& name) const {
+    if (!region) {
+        return -1;
+    }
+    for (uint32_t metric = 0; metric < header->metricCount; metric++) {
+        if (std::strncmp(nameSlot(metric), name.c_str(), kMaxNameLength) == 0) {
+            return static_cast<int>(metric);
+        }
+    }
+    return -1;
+}
+
+int MetricsStore::registerMetric(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int existing = findLocked(name);
+    if (existing >= 0) {
+        return existing;
+    }
+    if (!region || header->metricCount >= options.maxMetrics) {
+        return -1;
+    }
+    int metric = static_cast<int>(header->metricCount);
+    std::strncpy(nameSlot(metric), name.c_str(), kMaxNameLength - 1);
+    // Rows appended before registration hold no value for this column.
+    for (uint32_t slot = 0; slot < options.rawCapacity; slot++) {
+        rawValues[static_cast<size_t>(metric) * options.rawCapacity + slot] = kMissing;
+    }
+    for (int tier = 0; tier < kTierCount; tier++) {
+        RollupValue* column = tierValues[tier] + static_cast<size_t>(metric) * options.tierCapacity[tier];
+        for (uint32_t slot = 0; slot < options.tierCapacity[tier]; slot++) {
+            column[slot] = {kMissing, kMissing, kMissing, kMissing};
+        }
+    }
+    header->metricCount++;
+    return metric;
+}
+
+size_t MetricsStore::metricCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return region ? header->metricCount : 0;
+}
+
+std::string MetricsStore::metricName(int metric) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!region || metric < 0 || metric >= static_cast<int>(header->metricCount)) {
+        return "";
+    }
+    return std::string(nameSlot(metric), strnlen(nameSlot(metric), kMaxNameLength));
+}
+
+uint64_t MetricsStore::nextRandom() {
+    // xorshift64*: reservoir slots only need to be unbiased, not secure.
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 0x2545F4914F6CDD1Dull;
+}
+
+void MetricsStore::closeBucket(int tier) {
+    OpenBucket& bucket = buckets[tier];
+    uint32_t capacity = options.tierCapacity[tier];
+    uint64_t slot = header->tierHead[tier] % capacity;
+    tierTimestamps[tier][slot] = bucket.startMs;
+    tierCounts[tier][slot] = bucket.rows;
+
+    for (uint32_t metric = 0; metric < options.maxMetrics; metric++) {
+        Accumulator& accumulator = bucket.metrics[metric];
+        RollupValue& value = tierValues[tier][static_cast<size_t>(metric) * capacity + slot];
+        if (accumulator.count == 0) {
+            value = {kMissing, kMissing, kMissing, kMissing};
+            continue;
+        }
+        scratch.assign(accumulator.reservoir.begin(), accumulator.reservoir.end());
+        size_t rank = static_cast<size_t>(std::ceil(0.95 * scratch.size())) - 1;
+        std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.end());
+        value.min = accumulator.min;
+        value.max = accumulator.max;
+        value.avg = static_cast<float>(accumulator.sum / accumulator.count);
+        value.p95 = scratch[rank];
+        accumulator.count = 0;
+        accumulator.sum = 0.0;
+        accumulator.reservoir.clear();
+    }
+    header->tierHead[tier]++;
+    bucket.active = false;
+    bucket.rows = 0;
+}
+
+bool MetricsStore::append(uint64_t timestampMs, const float* values, size_t count) {
+    PROFILE_SCOPE("metrics.append");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!region) {
+        return false;
+    }
+    uint32_t rawCapacity = options.rawCapacity;
+    // Wall clocks step back (NTP, the user setting the time); such rows
+    // are filed at the newest row's time so the rings stay ordered.
+    if (header->rawHead > 0) {
+        timestampMs = std::max(timestampMs, rawTimestamps[(header->rawHead - 1) % rawCapacity]);
+    }
+
+    uint64_t slot = header->rawHead % rawCapacity;
+    rawTimestamps[slot] = timestampMs;
+    uint32_t metrics = header->metricCount;
+    for (uint32_t metric = 0; metric < metrics; metric++) {
+        rawValues[static_cast<size_t>(metric) * rawCapacity + slot] = metric < count ? values[metric] : kMissing;
+    }
+    header->rawHead++;
+
+    for (int tier = 0; tier < kTierCount; tier++) {
+        OpenBucket& bucket = buckets[tier];
+        uint64_t start = timestampMs - timestampMs % kBucketWidthMs[tier];
+        if (bucket.active && bucket.startMs != start) {
+            closeBucket(tier);
+        }
+        if (!bucket.active) {
+            bucket.active = true;
+            bucket.startMs = start;
+        }
+        bucket.rows++;
+        for (uint32_t metric = 0; metric < metrics && metric < count; metric++) {
+            float value = values[metric];
+            if (std::isnan(value)) {
+                continue;
+            }
+            Accumulator& accumulator = bucket.metrics[metric];
+            if (accumulator.count == 0) {
+                accumulator.min = value;
+                accumulator.max = value;
+            } else {
+                accumulator.min = std::min(accumulator.min, value);
+                accumulator.max = std::max(accumulator.max, value);
+            }
+            accumulator.count++;
+            accumulator.sum += value;
+            if (accumulator.reservoir.size() < kReservoirSize) {
+                accumulator.reservoir.push_back(value);
+            } else {
+                uint64_t pick = nextRandom() % accumulator.count;
+                if (pick < kReservoirSize) {
+                    accumulator.reservoir[pick] = value;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// First logical index in [first, head) whose timestamp is >= fromMs.
+uint64_t lowerBound(const uint64_t* timestamps, uint32_t capacity, uint64_t first, uint64_t head, uint64_t fromMs) {
+    uint64_t low = first;
+    uint64_t high = head;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (timestamps[middle % capacity] < fromMs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+} // namespace
+
+size_t MetricsStore::queryRaw(int metric, uint64_t fromMs, uint64_t toMs, MetricPoint* out, size_t maxPoints) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!region || metric < 0 || metric >= static_cast<int>(header->metricCount)) {
+        return 0;
+    }
+    uint32_t capacity = options.rawCapacity;
+    uint64_t head = header->rawHead;
+    uint64_t first = head - std::min<uint64_t>(head, capacity);
+    const float* column = rawValues + static_cast<size_t>(metric) * capacity;
+
+    size_t written = 0;
+    for (uint64_t i = lowerBound(rawTimestamps, capacity, first, head, fromMs); i < head && written < maxPoints; i++) {
+        uint64_t slot = i % capacity;
+        if (rawTimestamps[slot] > toMs) {
+            break;
+        }
+        if (!std::isnan(column[slot])) {
+            out[written].timestampMs = rawTimestamps[slot];
+            out[written].value = column[slot];
+            written++;
+        }
+    }
+    return written;
+}
+
+size_t MetricsStore::queryRollup(Tier tier, int metric, uint64_t fromMs, uint64_t toMs,
+                                 RollupPoint* out, size_t maxPoints) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!region || tier < 0 || tier >= kTierCount || metric < 0 || metric >= static_cast<int>(header->metricCount)) {
+        return 0;
+    }
+    uint32_t capacity = options.tierCapacity[tier];
+    uint64_t head = header->tierHead[tier];
+    uint64_t first = head - std::min<uint64_t>(head, capacity);
+    const RollupValue* column = tierValues[tier] + static_cast<size_t>(metric) * capacity;
+
+    size_t written = 0;
+    for (uint64_t i = lowerBound(tierTimestamps[tier], capacity, first, head, fromMs);
+         i < head && written < maxPoints; i++) {
+        uint64_t slot = i % capacity;
+        if (tierTimestamps[tier][slot] > toMs) {
+            break;
+        }
+        const RollupValue& value = column[slot];
+        if (std::isnan(value.avg)) {
+            continue;
+        }
+        RollupPoint& point = out[written++];
+        point.timestampMs = tierTimestamps[tier][slot];
+        point.count = tierCounts[tier][slot];
+        point.min = value.min;
+        point.max = value.max;
+        point.avg = value.avg;
+        point.p95 = value.p95;
+    }
+    return written;
+}
+
+bool MetricsStore::latest(int metric, MetricPoint& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!region || metric < 0 || metric >= static_cast<int>(header->metricCount)) {
+        return false;
+    }
+    uint32_t capacity = options.rawCapacity;
+    uint64_t head = header->rawHead;
+    uint64_t first = head - std::min<uint64_t>(head, capacity);
+    const float* column = rawValues + static_cast<size_t>(metric) * capacity;
+    for (uint64_t i = head; i > first; i--) {
+        uint64_t slot = (i - 1) % capacity;
+        if (!std::isnan(column[slot])) {
+            out.timestampMs = rawTimestamps[slot];
+            out.value = column[slot];
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t MetricsStore::sampleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return region ? header->rawHead : 0;
+}
+
+#endif // __linux__
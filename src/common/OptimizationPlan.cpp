@@ -0,0 +1,274 @@
+// src/common/OptimizationPlan.cpp - Dependency-ordered, idempotent optimization steps
+#include "OptimizationPlan.h"
+#include "SelfProfiler.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+uint64_t steadyUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// StateCache
+
+StateCache::StateCache(uint32_t maxAge) : maxAgeMs(maxAge), hits(0), misses(0) {}
+
+bool StateCache::read(const std::string& path, std::string& out) {
+    uint64_t now = steadyUs() / 1000;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if (it != entries.end() && now - it->second.readMs <= maxAgeMs) {
+            hits++;
+            out = it->second.value;
+            return it->second.readable;
+        }
+        misses++;
+    }
+    // Read outside the lock; two steps racing for the same path just
+    // both read it.
+    Entry entry;
+    entry.readMs = now;
+    std::ifstream file(path);
+    if (file.is_open()) {
+        std::ostringstream text;
+        text << file.rdbuf();
+        entry.value = text.str();
+        entry.readable = !file.bad();
+    }
+    out = entry.value;
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[path] = entry;
+    return entry.readable;
+}
+
+void StateCache::invalidate(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void StateCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+uint64_t StateCache::hitCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+uint64_t StateCache::missCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+// ---------------------------------------------------------------------------
+// OptimizationPlan
+
+bool OptimizationPlan::addStep(PlanStep step) {
+    if (step.name.empty() || !step.apply) {
+        return false;
+    }
+    for (const PlanStep& existing : steps) {
+        if (existing.name == step.name) {
+            return false;
+        }
+    }
+    steps.push_back(std::move(step));
+    return true;
+}
+
+bool OptimizationPlan::validate(std::string* error) const {
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < steps.size(); i++) {
+        index[steps[i].name] = i;
+    }
+    // Kahn's algorithm: whatever never reaches zero pending dependencies
+    // sits on a cycle.
+    std::vector<size_t> pending(steps.size(), 0);
+    std::vector<std::vector<size_t>> dependents(steps.size());
+    for (size_t i = 0; i < steps.size(); i++) {
+        for (const std::string& dependency : steps[i].dependsOn) {
+            auto it = index.find(dependency);
+            if (it == index.end()) {
+                if (error) {
+                    *error = "step '" + steps[i].name + "' depends on unknown step '" + dependency + "'";
+                }
+                return false;
+            }
+            dependents[it->second].push_back(i);
+            pending[i]++;
+        }
+    }
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < steps.size(); i++) {
+        if (pending[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    size_t visited = 0;
+    while (!ready.empty()) {
+        size_t current = ready.back();
+        ready.pop_back();
+        visited++;
+        for (size_t dependent : dependents[current]) {
+            if (--pending[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    }
+    if (visited != steps.size()) {
+        if (error) {
+            for (size_t i = 0; i < steps.size(); i++) {
+                if (pending[i] != 0) {
+                    *error = "dependency cycle through step '" + steps[i].name + "'";
+                    break;
+                }
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+bool OptimizationPlan::satisfied(const PlanStep& step, StateCache& cache) const {
+    if (step.targets.empty() && !step.isSatisfied) {
+        return false;   // nothing to compare against: always apply
+    }
+    for (const PlanTarget& target : step.targets) {
+        std::string current;
+        if (!cache.read(target.path, current) || Utils::trim(current) != Utils::trim(target.value)) {
+            return false;
+        }
+    }
+    return !step.isSatisfied || step.isSatisfied(cache);
+}
+
+PlanResult OptimizationPlan::execute(StateCache& cache, unsigned maxParallel) const {
+    PROFILE_SCOPE("plan.execute");
+    PlanResult plan;
+    uint64_t startUs = steadyUs();
+    std::string error;
+    if (!validate(&error)) {
+        StepResult invalid;
+        invalid.name = "plan";
+        invalid.result = OptimizationResult(false, "Invalid optimization plan", error);
+        plan.steps.push_back(invalid);
+        return plan;
+    }
+
+    const size_t count = steps.size();
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < count; i++) {
+        index[steps[i].name] = i;
+    }
+    std::vector<size_t> pending(count, 0);
+    std::vector<std::vector<size_t>> dependents(count);
+    std::deque<size_t> ready;
+    for (size_t i = 0; i < count; i++) {
+        for (const std::string& dependency : steps[i].dependsOn) {
+            dependents[index[dependency]].push_back(i);
+            pending[i]++;
+        }
+        if (pending[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    plan.steps.resize(count);
+    size_t finished = 0;
+    std::mutex mutex;
+    std::condition_variable progress;
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            progress.wait(lock, [&] { return !ready.empty() || finished == count; });
+            if (finished == count) {
+                return;
+            }
+            size_t current = ready.front();
+            ready.pop_front();
+            const PlanStep& step = steps[current];
+            std::string failedDependency;
+            for (const std::string& dependency : step.dependsOn) {
+                if (!plan.steps[index[dependency]].result.success) {
+                    failedDependency = dependency;
+                    break;
+                }
+            }
+            lock.unlock();
+
+            StepResult result;
+            result.name = step.name;
+            uint64_t stepStartUs = steadyUs();
+            if (!failedDependency.empty()) {
+                result.blocked = true;
+                result.result = OptimizationResult(false, "Not applied", "dependency '" + failedDependency + "' failed");
+            } else if (satisfied(step, cache)) {
+                result.skipped = true;
+                result.result = OptimizationResult(true, "Already applied");
+            } else {
+                result.result = step.apply();
+                for (const PlanTarget& target : step.targets) {
+                    cache.invalidate(target.path);
+                }
+                for (const std::string& prefix : step.invalidates) {
+                    cache.invalidate(prefix);
+                }
+            }
+            result.durationUs = steadyUs() - stepStartUs;
+
+            lock.lock();
+            plan.steps[current] = result;
+            finished++;
+            for (size_t dependent : dependents[current]) {
+                if (--pending[dependent] == 0) {
+                    ready.push_back(dependent);
+                }
+            }
+            progress.notify_all();
+        }
+    };
+
+    // The calling thread is one of the workers.
+    unsigned threads = static_cast<unsigned>(std::min<size_t>(std::max(maxParallel, 1u), std::max<size_t>(count, 1)));
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    plan.success = true;
+    for (const StepResult& step : plan.steps) {
+        plan.success &= step.result.success;
+        if (step.skipped) {
+            plan.skipped++;
+        } else if (!step.blocked) {
+            plan.applied++;
+        }
+    }
+    plan.elapsedUs = steadyUs() - startUs;
+    return plan;
+}
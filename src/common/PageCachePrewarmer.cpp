@@ -0,0 +1,903 @@
+// src/common/PageCachePrewarmer.cpp - Learned page-cache prewarming for game launches and teleports
+#if defined(__linux__)
+#include "PageCachePrewarmer.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+const char kProfileMagic[8] = {'R', 'B', 'X', 'P', 'W', 'M', '1', '\0'};
+constexpr uint32_t kNever = UINT32_MAX;
+// Extents are split into pieces of this size so the threads share long
+// extents and a big late extent cannot hold back early ones.
+constexpr uint64_t kChunkBytes = 4ull << 20;
+constexpr unsigned kMaxThreads = 16;
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+uint64_t pageSize() {
+    static const uint64_t size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+uint32_t pageShift() {
+    uint32_t shift = 0;
+    while ((1ull << shift) < pageSize()) {
+        shift++;
+    }
+    return shift;
+}
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(const std::string& in, size_t& pos, size_t end, uint64_t& value) {
+    value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        if (pos >= end) {
+            return false;
+        }
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t fnv1a(const char* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Zigzag so a pre-1970 mtime still encodes compactly.
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Opens `path` only if it is still the file the profile was learned on.
+int openMatching(const PrewarmFile& file, bool& stale) {
+    stale = false;
+    int fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != file.size ||
+        static_cast<int64_t>(st.st_mtime) != file.mtimeSec) {
+        stale = true;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Per-page heat and first use of a file, the form profiles are merged in.
+struct PageMap {
+    std::vector<uint8_t> heat;
+    std::vector<uint32_t> firstSeenMs;
+
+    void expand(const PrewarmFile& file, double scale) {
+        for (const PrewarmExtent& extent : file.extents) {
+            uint64_t first = extent.offset / pageSize();
+            uint64_t end = first + extent.length / pageSize();
+            if (end > heat.size()) {
+                heat.resize(end, 0);
+                firstSeenMs.resize(end, kNever);
+            }
+            uint8_t scaled = static_cast<uint8_t>(std::lround(extent.heat * scale));
+            for (uint64_t page = first; page < end; page++) {
+                if (scaled > heat[page]) {
+                    heat[page] = scaled;
+                }
+                firstSeenMs[page] = std::min(firstSeenMs[page], extent.firstSeenMs);
+            }
+        }
+    }
+};
+
+// Runs of pages with heat, holes of up to gapPages bridged. An extent's
+// heat is the mean over its hot pages, its first use the earliest.
+void buildExtents(const std::vector<uint8_t>& heat, const std::vector<uint32_t>& firstSeenMs, uint32_t gapPages,
+                  std::vector<PrewarmExtent>& out) {
+    out.clear();
+    size_t count = heat.size();
+    size_t page = 0;
+    while (page < count) {
+        if (heat[page] == 0) {
+            page++;
+            continue;
+        }
+        size_t start = page;
+        size_t last = page;
+        uint64_t heatSum = 0;
+        uint64_t hotPages = 0;
+        uint32_t firstSeen = kNever;
+        for (; page < count && page <= last + gapPages; page++) {
+            if (heat[page] != 0) {
+                last = page;
+                heatSum += heat[page];
+                hotPages++;
+                firstSeen = std::min(firstSeen, firstSeenMs[page]);
+            }
+        }
+        PrewarmExtent extent;
+        extent.offset = start * pageSize();
+        extent.length = (last + 1 - start) * pageSize();
+        extent.firstSeenMs = firstSeen == kNever ? 0 : firstSeen;
+        extent.heat = static_cast<uint8_t>(std::max<uint64_t>(1, (heatSum + hotPages / 2) / hotPages));
+        out.push_back(extent);
+        page = last + 1;
+    }
+}
+
+void sortByFirstUse(std::vector<PrewarmFile>& files) {
+    std::stable_sort(files.begin(), files.end(), [](const PrewarmFile& a, const PrewarmFile& b) {
+        return a.firstSeenMs() < b.firstSeenMs();
+    });
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// PrewarmFile / PrewarmProfile
+
+uint64_t PrewarmFile::bytes() const {
+    uint64_t total = 0;
+    for (const PrewarmExtent& extent : extents) {
+        total += extent.length;
+    }
+    return total;
+}
+
+uint32_t PrewarmFile::firstSeenMs() const {
+    uint32_t first = kNever;
+    for (const PrewarmExtent& extent : extents) {
+        first = std::min(first, extent.firstSeenMs);
+    }
+    return first;
+}
+
+uint64_t PrewarmProfile::bytes() const {
+    uint64_t total = 0;
+    for (const PrewarmFile& file : files) {
+        total += file.bytes();
+    }
+    return total;
+}
+
+size_t PrewarmProfile::extentCount() const {
+    size_t total = 0;
+    for (const PrewarmFile& file : files) {
+        total += file.extents.size();
+    }
+    return total;
+}
+
+bool PrewarmProfile::save(const std::string& path, std::string* error) const {
+    PROFILE_SCOPE("prewarm.save");
+    uint32_t shift = pageShift();
+    std::string out(kProfileMagic, sizeof(kProfileMagic));
+    putVarint(out, shift);
+    putVarint(out, sessions);
+    putVarint(out, files.size());
+    for (const PrewarmFile& file : files) {
+        putVarint(out, file.path.size());
+        out += file.path;
+        putVarint(out, file.size);
+        putVarint(out, zigzag(file.mtimeSec));
+        putVarint(out, file.extents.size());
+        uint64_t previousEnd = 0;
+        for (const PrewarmExtent& extent : file.extents) {
+            uint64_t first = extent.offset >> shift;
+            putVarint(out, first - previousEnd);
+            putVarint(out, extent.length >> shift);
+            putVarint(out, extent.firstSeenMs);
+            out.push_back(static_cast<char>(extent.heat));
+            previousEnd = first + (extent.length >> shift);
+        }
+    }
+    uint32_t checksum = fnv1a(out.data(), out.size());
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((checksum >> (8 * i)) & 0xff));
+    }
+
+    // Written aside and renamed so a crash never leaves half a profile.
+    std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        if (error) *error = temporary + ": " + std::strerror(errno);
+        return false;
+    }
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        if (error) *error = path + ": " + std::strerror(errno);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    PROFILE_COUNT(ProfileCounter::BytesWritten, out.size());
+    return true;
+}
+
+bool PrewarmProfile::load(const std::string& path, std::string* error) {
+    PROFILE_SCOPE("prewarm.load");
+    auto fail = [&](const std::string& why) {
+        if (error) *error = path + ": " + why;
+        return false;
+    };
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return fail(std::strerror(errno));
+    }
+    std::string in;
+    char buffer[16384];
+    for (size_t n; (n = std::fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+        in.append(buffer, n);
+    }
+    std::fclose(file);
+    PROFILE_COUNT(ProfileCounter::BytesRead, in.size());
+
+    if (in.size() < sizeof(kProfileMagic) + 4 || std::memcmp(in.data(), kProfileMagic, sizeof(kProfileMagic)) != 0) {
+        return fail("not a prewarm profile");
+    }
+    size_t end = in.size() - 4;
+    uint32_t stored = 0;
+    for (int i = 0; i < 4; i++) {
+        stored |= static_cast<uint32_t>(static_cast<uint8_t>(in[end + i])) << (8 * i);
+    }
+    if (stored != fnv1a(in.data(), end)) {
+        return fail("checksum mismatch");
+    }
+
+    size_t pos = sizeof(kProfileMagic);
+    uint64_t shift = 0;
+    uint64_t sessionCount = 0;
+    uint64_t fileCount = 0;
+    if (!getVarint(in, pos, end, shift) || shift < 9 || shift > 24 || !getVarint(in, pos, end, sessionCount) ||
+        !getVarint(in, pos, end, fileCount) || fileCount > end - pos) {
+        return fail("corrupt header");
+    }
+    std::vector<PrewarmFile> loaded(fileCount);
+    for (PrewarmFile& entry : loaded) {
+        uint64_t length = 0;
+        uint64_t mtime = 0;
+        uint64_t extentCount = 0;
+        if (!getVarint(in, pos, end, length) || length > end - pos) {
+            return fail("corrupt file entry");
+        }
+        entry.path.assign(in, pos, length);
+        pos += length;
+        if (!getVarint(in, pos, end, entry.size) || !getVarint(in, pos, end, mtime) ||
+            !getVarint(in, pos, end, extentCount) || extentCount > end - pos) {
+            return fail("corrupt file entry");
+        }
+        entry.mtimeSec = unzigzag(mtime);
+        entry.extents.resize(extentCount);
+        uint64_t previousEnd = 0;
+        for (PrewarmExtent& extent : entry.extents) {
+            uint64_t gap = 0;
+            uint64_t pages = 0;
+            uint64_t firstSeen = 0;
+            if (!getVarint(in, pos, end, gap) || !getVarint(in, pos, end, pages) ||
+                !getVarint(in, pos, end, firstSeen) || pos >= end) {
+                return fail("corrupt extent");
+            }
+            extent.offset = (previousEnd + gap) << shift;
+            extent.length = pages << shift;
+            extent.firstSeenMs = static_cast<uint32_t>(std::min<uint64_t>(firstSeen, kNever - 1));
+            extent.heat = static_cast<uint8_t>(in[pos++]);
+            previousEnd += gap + pages;
+        }
+    }
+    sessions = static_cast<uint32_t>(sessionCount);
+    files = std::move(loaded);
+    return true;
+}
+
+void PrewarmProfile::merge(const PrewarmProfile& older, double decay, uint8_t minHeat, uint32_t gapPages) {
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < files.size(); i++) {
+        index[files[i].path] = i;
+    }
+    for (const PrewarmFile& old : older.files) {
+        auto found = index.find(old.path);
+        if (found == index.end()) {
+            // Not touched this session: keep it, faded, while it still
+            // exists unchanged.
+            struct stat st;
+            if (stat(old.path.c_str(), &st) != 0 || static_cast<uint64_t>(st.st_size) != old.size ||
+                static_cast<int64_t>(st.st_mtime) != old.mtimeSec) {
+                continue;
+            }
+            PrewarmFile faded = old;
+            faded.extents.clear();
+            for (PrewarmExtent extent : old.extents) {
+                extent.heat = static_cast<uint8_t>(std::lround(extent.heat * decay));
+                if (extent.heat >= minHeat && extent.heat > 0) {
+                    faded.extents.push_back(extent);
+                }
+            }
+            if (!faded.extents.empty()) {
+                files.push_back(std::move(faded));
+            }
+            continue;
+        }
+        PrewarmFile& current = files[found->second];
+        if (current.size != old.size || current.mtimeSec != old.mtimeSec) {
+            continue;   // replaced since: the old offsets mean nothing
+        }
+        PageMap fresh;
+        fresh.expand(current, 1.0);
+        PageMap faded;
+        faded.expand(old, decay);
+        size_t count = std::max(fresh.heat.size(), faded.heat.size());
+        fresh.heat.resize(count, 0);
+        fresh.firstSeenMs.resize(count, kNever);
+        for (size_t page = 0; page < faded.heat.size(); page++) {
+            uint8_t oldHeat = faded.heat[page];
+            if (oldHeat == 0 || (fresh.heat[page] == 0 && oldHeat < minHeat)) {
+                continue;
+            }
+            fresh.heat[page] = std::max(fresh.heat[page], oldHeat);
+            fresh.firstSeenMs[page] = std::min(fresh.firstSeenMs[page], faded.firstSeenMs[page]);
+        }
+        buildExtents(fresh.heat, fresh.firstSeenMs, gapPages, current.extents);
+    }
+    sessions += older.sessions;
+    sortByFirstUse(files);
+}
+
+// ---------------------------------------------------------------------------
+// PrewarmRecorder
+
+PrewarmRecorder::TrackedFile::~TrackedFile() {
+    if (map) {
+        munmap(map, static_cast<size_t>(mapped));
+    }
+}
+
+PrewarmRecorder::PrewarmRecorder(const std::string& rootPrefix)
+    : root(rootPrefix), targetPid(0), startMs(0), samples(0), unreadable(0) {}
+
+PrewarmRecorder::~PrewarmRecorder() {
+    detach();
+}
+
+void PrewarmRecorder::setOptions(const Options& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+}
+
+bool PrewarmRecorder::attach(pid_t pid, uint64_t nowMs, const PrewarmProfile* known) {
+    PROFILE_SCOPE("prewarm.attach");
+    std::lock_guard<std::mutex> lock(mutex);
+    clearLocked();
+    if (!mapsFile.open(root + "/proc/" + std::to_string(pid) + "/maps", 65536)) {
+        return false;
+    }
+    targetPid = pid;
+    startMs = nowMs;
+
+    // What is resident now was cached before this launch, not read by it.
+    std::vector<std::string> paths;
+    collectMapped(paths);
+    if (options.openFiles) {
+        collectOpen(paths);
+    }
+    if (known) {
+        for (const PrewarmFile& file : known->files) {
+            paths.push_back(file.path);
+        }
+    }
+    for (const std::string& path : paths) {
+        if (files.find(path) == files.end() && rejected.find(path) == rejected.end()) {
+            track(path);
+        }
+    }
+    for (auto& entry : files) {
+        TrackedFile& file = *entry.second;
+        residency.resize(file.hits.size());
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (mincore(file.map, static_cast<size_t>(file.mapped), residency.data()) != 0) {
+            continue;
+        }
+        file.warm.resize(residency.size());
+        for (size_t page = 0; page < residency.size(); page++) {
+            file.warm[page] = (residency[page] & 1) != 0;
+        }
+    }
+    return true;
+}
+
+void PrewarmRecorder::detach() {
+    std::lock_guard<std::mutex> lock(mutex);
+    clearLocked();
+}
+
+void PrewarmRecorder::clearLocked() {
+    mapsFile.close();
+    files.clear();
+    rejected.clear();
+    targetPid = 0;
+    startMs = 0;
+    samples = 0;
+    unreadable = 0;
+}
+
+pid_t PrewarmRecorder::pid() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return targetPid;
+}
+
+bool PrewarmRecorder::excluded(const std::string& path) const {
+    if (path.size() > 10 && path.compare(path.size() - 10, 10, " (deleted)") == 0) {
+        return true;
+    }
+    for (const std::string& prefix : options.excludePrefixes) {
+        if (path.compare(0, prefix.size(), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PrewarmRecorder::track(const std::string& path) {
+    if (excluded(path) || files.size() >= options.maxFiles) {
+        rejected.insert(path);
+        return;
+    }
+    std::string fullPath = root + path;
+    int fd = open(fullPath.c_str(), O_RDONLY | O_CLOEXEC);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 2);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        rejected.insert(path);
+        return;
+    }
+    // mincore() reports other files as non-resident whatever their state.
+    if (geteuid() != 0 && st.st_uid != geteuid() && access(fullPath.c_str(), W_OK) != 0) {
+        close(fd);
+        unreadable++;
+        rejected.insert(path);
+        return;
+    }
+    std::unique_ptr<TrackedFile> file(new TrackedFile());
+    file->path = path;
+    file->size = static_cast<uint64_t>(st.st_size);
+    file->mtimeSec = static_cast<int64_t>(st.st_mtime);
+    file->mapped = std::min(file->size, options.maxFileBytes);
+    // Never touched, so the mapping costs address space only.
+    void* map = mmap(nullptr, static_cast<size_t>(file->mapped), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        rejected.insert(path);
+        return;
+    }
+    file->map = map;
+    size_t pages = static_cast<size_t>((file->mapped + pageSize() - 1) / pageSize());
+    file->hits.assign(pages, 0);
+    file->firstSeenMs.assign(pages, kNever);
+    files[path] = std::move(file);
+}
+
+void PrewarmRecorder::collectMapped(std::vector<std::string>& paths) {
+    // "start-end perms offset dev inode   path"; anonymous and special
+    // mappings have inode 0 or no absolute path.
+    std::string_view text = mapsFile.read();
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    std::string_view previous;
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text = newline == std::string_view::npos ? std::string_view() : text.substr(newline + 1);
+        size_t pos = 0;
+        std::string_view inode;
+        for (int field = 0; field < 5; field++) {
+            while (pos < line.size() && line[pos] == ' ') pos++;
+            size_t start = pos;
+            while (pos < line.size() && line[pos] != ' ') pos++;
+            inode = line.substr(start, pos - start);
+        }
+        while (pos < line.size() && line[pos] == ' ') pos++;
+        std::string_view path = line.substr(pos);
+        if (inode == "0" || path.empty() || path[0] != '/' || path == previous) {
+            continue;
+        }
+        previous = path;
+        paths.emplace_back(path);
+    }
+}
+
+void PrewarmRecorder::collectOpen(std::vector<std::string>& paths) {
+    std::string dir = root + "/proc/" + std::to_string(targetPid) + "/fd";
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return;   // another user's process without root
+    }
+    alignas(8) char buffer[8192];
+    char target[4096];
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            ssize_t length = readlinkat(fd, entry->d_name, target, sizeof(target));
+            PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+            if (length > 0 && length < static_cast<ssize_t>(sizeof(target)) && target[0] == '/') {
+                paths.emplace_back(target, static_cast<size_t>(length));
+            }
+        }
+    }
+    close(fd);
+}
+
+bool PrewarmRecorder::sample(uint64_t nowMs) {
+    PROFILE_SCOPE("prewarm.sample");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (targetPid == 0 || (samples > 0 && nowMs - startMs >= options.learnMs)) {
+        return false;
+    }
+    std::vector<std::string> paths;
+    collectMapped(paths);
+    if (options.openFiles) {
+        collectOpen(paths);
+    }
+    for (const std::string& path : paths) {
+        if (files.find(path) == files.end() && rejected.find(path) == rejected.end()) {
+            track(path);
+        }
+    }
+
+    uint32_t elapsed = static_cast<uint32_t>(std::min<uint64_t>(nowMs - startMs, kNever - 1));
+    for (auto& entry : files) {
+        TrackedFile& file = *entry.second;
+        residency.resize(file.hits.size());
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (mincore(file.map, static_cast<size_t>(file.mapped), residency.data()) != 0) {
+            continue;
+        }
+        bool baseline = !file.warm.empty();
+        for (size_t page = 0; page < residency.size(); page++) {
+            if (baseline && file.warm[page]) {
+                file.warm[page] = (residency[page] & 1) != 0;
+                continue;
+            }
+            if (residency[page] & 1) {
+                if (file.hits[page] < UINT16_MAX) {
+                    file.hits[page]++;
+                }
+                if (file.firstSeenMs[page] == kNever) {
+                    file.firstSeenMs[page] = elapsed;
+                }
+            }
+        }
+    }
+    samples++;
+    return true;
+}
+
+PrewarmProfile PrewarmRecorder::finish() {
+    PROFILE_SCOPE("prewarm.finish");
+    std::lock_guard<std::mutex> lock(mutex);
+    PrewarmProfile profile;
+    if (samples > 0) {
+        profile.sessions = 1;
+        std::vector<uint8_t> heat;
+        for (const auto& entry : files) {
+            const TrackedFile& tracked = *entry.second;
+            heat.assign(tracked.hits.size(), 0);
+            bool any = false;
+            for (size_t page = 0; page < heat.size(); page++) {
+                if (tracked.hits[page] != 0) {
+                    heat[page] = static_cast<uint8_t>(std::max<uint32_t>(1, (tracked.hits[page] * 255u + samples / 2) / samples));
+                    any = true;
+                }
+            }
+            if (!any) {
+                continue;
+            }
+            PrewarmFile file;
+            file.path = tracked.path;
+            file.size = tracked.size;
+            file.mtimeSec = tracked.mtimeSec;
+            buildExtents(heat, tracked.firstSeenMs, options.gapPages, file.extents);
+            profile.files.push_back(std::move(file));
+        }
+        sortByFirstUse(profile.files);
+    }
+    clearLocked();
+    return profile;
+}
+
+size_t PrewarmRecorder::trackedFiles() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return files.size();
+}
+
+uint32_t PrewarmRecorder::unreadableFiles() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return unreadable;
+}
+
+// ---------------------------------------------------------------------------
+// PageCachePrewarmer
+
+PageCachePrewarmer::PageCachePrewarmer() : lockedBytes(0) {}
+
+PageCachePrewarmer::~PageCachePrewarmer() {
+    unlock();
+}
+
+PrewarmResult PageCachePrewarmer::warm(const PrewarmProfile& profile, const PrewarmOptions& options) {
+    PROFILE_SCOPE("prewarm.warm");
+    auto start = std::chrono::steady_clock::now();
+    PrewarmResult result;
+    if (profile.files.empty()) {
+        result.error = "empty profile";
+        return result;
+    }
+
+    struct Read {
+        int fd;
+        uint64_t offset;
+        uint64_t length;
+        uint32_t firstSeenMs;
+    };
+    std::vector<int> fds(profile.files.size(), -1);
+    std::vector<Read> reads;
+    for (size_t i = 0; i < profile.files.size(); i++) {
+        const PrewarmFile& file = profile.files[i];
+        bool stale = false;
+        fds[i] = openMatching(file, stale);
+        PROFILE_COUNT(ProfileCounter::Syscalls, 2);
+        if (fds[i] < 0) {
+            (stale ? result.staleFiles : result.missingFiles)++;
+            continue;
+        }
+        result.files++;
+        for (const PrewarmExtent& extent : file.extents) {
+            if (extent.heat < options.minHeat) {
+                continue;
+            }
+            result.extents++;
+            for (uint64_t offset = 0; offset < extent.length; offset += kChunkBytes) {
+                reads.push_back(Read{fds[i], extent.offset + offset, std::min(kChunkBytes, extent.length - offset),
+                                     extent.firstSeenMs});
+            }
+        }
+    }
+    std::stable_sort(reads.begin(), reads.end(),
+                     [](const Read& a, const Read& b) { return a.firstSeenMs < b.firstSeenMs; });
+    uint64_t budget = options.maxBytes;
+    for (size_t i = 0; i < reads.size(); i++) {
+        if (reads[i].length >= budget) {
+            reads[i].length = budget;
+            reads.resize(budget ? i + 1 : i);
+            break;
+        }
+        budget -= reads[i].length;
+    }
+    for (const Read& read : reads) {
+        result.bytesRequested += read.length;
+    }
+
+    // readahead(2) blocks while it queues the read, so a few threads keep
+    // several requests in flight; each takes the earliest read left.
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> failures(0);
+    auto worker = [&] {
+        if (options.priority.ioClass != IoClass::None) {
+            IoPriority::set(0, options.priority);
+        }
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < reads.size();) {
+            const Read& read = reads[i];
+            bool ok = !options.fadvise && readahead(read.fd, static_cast<off64_t>(read.offset),
+                                                    static_cast<size_t>(read.length)) == 0;
+            // Filesystems without readahead support (FUSE, some overlays)
+            // still take the hint.
+            if (!ok) {
+                ok = posix_fadvise(read.fd, static_cast<off_t>(read.offset), static_cast<off_t>(read.length),
+                                   POSIX_FADV_WILLNEED) == 0;
+            }
+            if (!ok) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+    // Workers of their own, so the priority never sticks to the caller.
+    unsigned threads = std::max(1u, std::min({options.threads, kMaxThreads, static_cast<unsigned>(reads.size())}));
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    PROFILE_COUNT(ProfileCounter::Syscalls, reads.size());
+    result.failures = failures.load();
+
+    if (options.lockBytes > 0) {
+        lockHottest(profile, fds, options, result);
+    }
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    result.success = result.files > 0;
+    if (!result.success) {
+        result.error = "no profiled file is present and unchanged";
+    }
+    result.elapsedMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    return result;
+}
+
+void PageCachePrewarmer::lockHottest(const PrewarmProfile& profile, const std::vector<int>& fds,
+                                     const PrewarmOptions& options, PrewarmResult& result) {
+    struct Candidate {
+        int fd;
+        const PrewarmExtent* extent;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < profile.files.size(); i++) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        for (const PrewarmExtent& extent : profile.files[i].extents) {
+            candidates.push_back(Candidate{fds[i], &extent});
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.extent->heat != b.extent->heat) {
+            return a.extent->heat > b.extent->heat;
+        }
+        return a.extent->firstSeenMs < b.extent->firstSeenMs;
+    });
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Candidate& candidate : candidates) {
+        if (lockedBytes >= options.lockBytes) {
+            break;
+        }
+        uint64_t room = (options.lockBytes - lockedBytes) / pageSize() * pageSize();
+        size_t length = static_cast<size_t>(std::min(candidate.extent->length, room));
+        if (length == 0) {
+            break;
+        }
+        void* address = mmap(nullptr, length, PROT_READ, MAP_SHARED, candidate.fd,
+                             static_cast<off_t>(candidate.extent->offset));
+        PROFILE_COUNT(ProfileCounter::Syscalls, 2);
+        // mlock() faults the range in, so this also waits for those reads.
+        if (address == MAP_FAILED || mlock(address, length) != 0) {
+            int saved = errno;
+            if (address != MAP_FAILED) {
+                munmap(address, length);
+            }
+            result.failures++;
+            if (saved == EPERM || saved == ENOMEM || saved == EAGAIN) {
+                break;   // over RLIMIT_MEMLOCK or not allowed: the rest fails too
+            }
+            continue;
+        }
+        locked.push_back(LockedRange{address, length});
+        lockedBytes += length;
+        result.bytesLocked += length;
+    }
+}
+
+void PageCachePrewarmer::unlock() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const LockedRange& range : locked) {
+        munmap(range.address, range.length);
+    }
+    locked.clear();
+    lockedBytes = 0;
+}
+
+uint64_t PageCachePrewarmer::getLockedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lockedBytes;
+}
+
+PrewarmResidency PageCachePrewarmer::residency(const PrewarmProfile& profile) {
+    PROFILE_SCOPE("prewarm.residency");
+    PrewarmResidency report;
+    std::vector<unsigned char> pages;
+    for (const PrewarmFile& file : profile.files) {
+        PrewarmResidency::File entry;
+        entry.path = file.path;
+        entry.profileBytes = file.bytes();
+        report.profileBytes += entry.profileBytes;
+        bool stale = false;
+        int fd = openMatching(file, stale);
+        if (fd >= 0 && !file.extents.empty()) {
+            const PrewarmExtent& last = file.extents.back();
+            uint64_t span = std::min(file.size, last.offset + last.length);
+            void* map = span ? mmap(nullptr, static_cast<size_t>(span), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+            if (map != MAP_FAILED) {
+                pages.resize(static_cast<size_t>((span + pageSize() - 1) / pageSize()));
+                if (mincore(map, static_cast<size_t>(span), pages.data()) == 0) {
+                    entry.present = true;
+                    for (const PrewarmExtent& extent : file.extents) {
+                        uint64_t first = extent.offset / pageSize();
+                        uint64_t end = std::min<uint64_t>(pages.size(), first + extent.length / pageSize());
+                        for (uint64_t page = first; page < end; page++) {
+                            if (pages[page] & 1) {
+                                entry.residentBytes += pageSize();
+                            }
+                        }
+                    }
+                }
+                munmap(map, static_cast<size_t>(span));
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        report.residentBytes += entry.residentBytes;
+        report.files.push_back(std::move(entry));
+    }
+    return report;
+}
+
+size_t PageCachePrewarmer::evict(const PrewarmProfile& profile) {
+    size_t evicted = 0;
+    for (const PrewarmFile& file : profile.files) {
+        int fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0) {
+            evicted++;
+        }
+        close(fd);
+    }
+    return evicted;
+}
+
+#endif // __linux__
@@ -0,0 +1,435 @@
+// src/common/PressureMonitor.cpp - PSI-triggered pressure monitor
+#if defined(__linux__)
+#include "PressureMonitor.h"
+#include "ProcFs.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kPressureFiles[] = {"memory", "cpu", "io"};
+
+constexpr uint32_t kUnprivilegedWindowUs = 2000000;
+
+// The kernel parses a NUL-terminated string; each fd holds one trigger.
+bool writeTrigger(int fd, const PressureTrigger& trigger) {
+    std::string spec = std::string(trigger.full ? "full " : "some ") + std::to_string(trigger.stallUs) +
+                       " " + std::to_string(trigger.windowUs);
+    return write(fd, spec.c_str(), spec.size() + 1) >= 0;
+}
+
+uint64_t monotonicMs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + static_cast<uint64_t>(ts.tv_nsec) / 1000000;
+}
+
+int resourceIndex(PressureResource resource) {
+    return static_cast<int>(resource);
+}
+
+// "some avg10=0.12 avg60=0.05 avg300=0.01 total=12345"
+void parseLine(std::string_view line, double& avg10, double& avg60, double& avg300, uint64_t& total) {
+    size_t pos = 0;
+    while (pos < line.size()) {
+        size_t space = line.find(' ', pos);
+        std::string_view field = line.substr(pos, space == std::string_view::npos ? std::string_view::npos : space - pos);
+        size_t equals = field.find('=');
+        if (equals != std::string_view::npos) {
+            std::string_view key = field.substr(0, equals);
+            std::string value(field.substr(equals + 1));
+            if (key == "avg10") avg10 = std::strtod(value.c_str(), nullptr);
+            else if (key == "avg60") avg60 = std::strtod(value.c_str(), nullptr);
+            else if (key == "avg300") avg300 = std::strtod(value.c_str(), nullptr);
+            else if (key == "total") ProcParser::parseUnsigned(value, total);
+        }
+        if (space == std::string_view::npos) {
+            break;
+        }
+        pos = space + 1;
+    }
+}
+
+} // namespace
+
+PressureMonitor::PressureMonitor(const std::string& rootPrefix)
+    : root(rootPrefix), triggers(defaultTriggers()), mode(Mode::Stopped), eventCount(0),
+      epollFd(-1), wakeFd(-1), fallbackReader(rootPrefix), eventLoop(nullptr), loopTask(0) {
+    for (auto& resource : levelExpiryMs) {
+        for (auto& expiry : resource) {
+            expiry.store(0);
+        }
+    }
+}
+
+PressureMonitor::~PressureMonitor() {
+    stop();
+}
+
+std::vector<PressureTrigger> PressureMonitor::defaultTriggers() {
+    // Same shape as lmkd's: "some" stalls grade low/medium, a "full"
+    // stall (nothing runnable made progress) is critical.
+    std::vector<PressureTrigger> defaults(5);
+    defaults[0].resource = PressureResource::Memory;
+    defaults[0].stallUs = 70000;
+    defaults[0].level = PressureLevel::Low;
+    defaults[1].resource = PressureResource::Memory;
+    defaults[1].stallUs = 150000;
+    defaults[1].level = PressureLevel::Medium;
+    defaults[2].resource = PressureResource::Memory;
+    defaults[2].full = true;
+    defaults[2].stallUs = 100000;
+    defaults[2].level = PressureLevel::Critical;
+    defaults[3].resource = PressureResource::Cpu;
+    defaults[3].stallUs = 200000;
+    defaults[3].level = PressureLevel::Medium;
+    defaults[4].resource = PressureResource::Io;
+    defaults[4].full = true;
+    defaults[4].stallUs = 100000;
+    defaults[4].level = PressureLevel::Medium;
+    return defaults;
+}
+
+const char* PressureMonitor::resourceName(PressureResource resource) {
+    return kPressureFiles[resourceIndex(resource)];
+}
+
+const char* PressureMonitor::levelName(PressureLevel level) {
+    switch (level) {
+    case PressureLevel::Low: return "low";
+    case PressureLevel::Medium: return "medium";
+    case PressureLevel::Critical: return "critical";
+    case PressureLevel::None:
+    default: return "none";
+    }
+}
+
+PressureLevel PressureMonitor::estimateLevel(PressureResource resource, const PressureStats& stats,
+                                            const std::vector<PressureTrigger>& triggers) {
+    PressureLevel level = PressureLevel::None;
+    for (const PressureTrigger& trigger : triggers) {
+        if (trigger.resource != resource || trigger.windowUs == 0) {
+            continue;
+        }
+        double thresholdPercent = 100.0 * trigger.stallUs / trigger.windowUs;
+        double average = trigger.full ? stats.fullAvg10 : stats.someAvg10;
+        if (average >= thresholdPercent && trigger.level > level) {
+            level = trigger.level;
+        }
+    }
+    return level;
+}
+
+void PressureMonitor::setTriggers(const std::vector<PressureTrigger>& values) {
+    std::lock_guard<std::mutex> lock(mutex);
+    triggers = values;
+}
+
+void PressureMonitor::setCallback(Callback eventCallback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    callback = std::move(eventCallback);
+}
+
+bool PressureMonitor::parseStats(const std::string& text, PressureStats& out) {
+    out = PressureStats();
+    bool found = false;
+    size_t pos = 0;
+    std::string_view view(text);
+    while (pos < view.size()) {
+        size_t newline = view.find('\n', pos);
+        std::string_view line = view.substr(pos, newline == std::string_view::npos ? std::string_view::npos : newline - pos);
+        if (line.compare(0, 5, "some ") == 0) {
+            parseLine(line.substr(5), out.someAvg10, out.someAvg60, out.someAvg300, out.someTotal);
+            found = true;
+        } else if (line.compare(0, 5, "full ") == 0) {
+            parseLine(line.substr(5), out.fullAvg10, out.fullAvg60, out.fullAvg300, out.fullTotal);
+        }
+        if (newline == std::string_view::npos) {
+            break;
+        }
+        pos = newline + 1;
+    }
+    return found;
+}
+
+bool PressureMonitor::readStats(PressureResource resource, PressureStats& out) const {
+    std::string path = root + "/proc/pressure/" + resourceName(resource);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[256];
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) {
+        return false;
+    }
+    return parseStats(std::string(buffer, static_cast<size_t>(n)), out);
+}
+
+PressureLevel PressureMonitor::getLevel(PressureResource resource) const {
+    uint64_t now = monotonicMs();
+    const auto& expiries = levelExpiryMs[resourceIndex(resource)];
+    for (int level = static_cast<int>(PressureLevel::Critical); level > 0; level--) {
+        if (expiries[level].load(std::memory_order_acquire) > now) {
+            return static_cast<PressureLevel>(level);
+        }
+    }
+    return PressureLevel::None;
+}
+
+void PressureMonitor::emit(PressureEvent& event) {
+    eventCount.fetch_add(1);
+    Callback handler;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        handler = callback;
+    }
+    if (handler) {
+        handler(event);
+    }
+}
+
+bool PressureMonitor::armTriggers() {
+    std::vector<PressureTrigger> wanted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wanted = triggers;
+    }
+
+    bool memoryArmed = false;
+    for (const auto& trigger : wanted) {
+        std::string path = root + "/proc/pressure/" + resourceName(trigger.resource);
+        int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        PressureTrigger effective = trigger;
+        bool written = writeTrigger(fd, effective);
+        if (!written && errno == EINVAL && effective.windowUs % kUnprivilegedWindowUs != 0) {
+            // Without CAP_SYS_RESOURCE (6.5+) the window must be a multiple
+            // of 2s; keep the same stall ratio over the longer window.
+            uint32_t window = (effective.windowUs / kUnprivilegedWindowUs + 1) * kUnprivilegedWindowUs;
+            effective.stallUs = static_cast<uint32_t>(static_cast<uint64_t>(effective.stallUs) * window /
+                                                      effective.windowUs);
+            effective.windowUs = window;
+            written = writeTrigger(fd, effective);
+        }
+        if (!written) {
+            close(fd);
+            continue;
+        }
+        epoll_event event = {};
+        event.events = EPOLLPRI;
+        event.data.u32 = static_cast<uint32_t>(armed.size());
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        armed.push_back({effective, fd});
+        memoryArmed |= trigger.resource == PressureResource::Memory;
+    }
+    // The meminfo fallback only covers memory; without a memory trigger it
+    // is the better of the two.
+    if (!memoryArmed) {
+        disarmTriggers();
+        return false;
+    }
+    return true;
+}
+
+void PressureMonitor::disarmTriggers() {
+    for (auto& entry : armed) {
+        if (entry.fd >= 0) {
+            close(entry.fd);
+        }
+    }
+    armed.clear();
+}
+
+void PressureMonitor::handleTrigger(uint32_t index, uint32_t events) {
+    if (index >= armed.size()) {
+        return;
+    }
+    if (events & EPOLLERR) {
+        // Trigger destroyed (cgroup/psi went away); stop watching it.
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, armed[index].fd, nullptr);
+        return;
+    }
+    const PressureTrigger& trigger = armed[index].trigger;
+    uint64_t now = monotonicMs();
+    levelExpiryMs[resourceIndex(trigger.resource)][static_cast<int>(trigger.level)].store(
+        now + trigger.windowUs / 1000, std::memory_order_release);
+
+    PressureEvent event;
+    event.timestampMs = now;
+    event.resource = trigger.resource;
+    event.level = trigger.level;
+    event.fromPsi = true;
+    readStats(trigger.resource, event.stats);
+    emit(event);
+}
+
+uint32_t PressureMonitor::sampleFallback() {
+    FallbackState& state = fallbackState;
+    MemInfo memory;
+    if (!fallbackReader.readMemInfo(memory) || memory.memTotal == 0) {
+        return state.intervalMs;
+    }
+    double percent = 100.0 * memory.memAvailable / memory.memTotal;
+    PressureLevel level = PressureLevel::None;
+    if (percent <= fallback.criticalPercent) level = PressureLevel::Critical;
+    else if (percent <= fallback.mediumPercent) level = PressureLevel::Medium;
+    else if (percent <= fallback.lowPercent) level = PressureLevel::Low;
+
+    // Sample fast while under pressure or falling, back off when idle.
+    bool falling = state.previousPercent >= 0.0 && state.previousPercent - percent >= 1.0;
+    if (level >= PressureLevel::Medium || falling) {
+        state.intervalMs = fallback.minIntervalMs;
+    } else if (level == PressureLevel::Low) {
+        state.intervalMs = std::max(fallback.minIntervalMs, std::min(state.intervalMs * 2, fallback.maxIntervalMs / 4));
+    } else {
+        state.intervalMs = std::min(state.intervalMs + state.intervalMs / 2, fallback.maxIntervalMs);
+    }
+
+    uint64_t now = monotonicMs();
+    if (level != PressureLevel::None) {
+        levelExpiryMs[resourceIndex(PressureResource::Memory)][static_cast<int>(level)].store(
+            now + 2 * state.intervalMs, std::memory_order_release);
+    }
+    if (level != state.previousLevel) {
+        PressureEvent event;
+        event.timestampMs = now;
+        event.resource = PressureResource::Memory;
+        event.level = level;
+        event.memAvailablePercent = percent;
+        emit(event);
+    }
+    state.previousPercent = percent;
+    state.previousLevel = level;
+    return state.intervalMs;
+}
+
+void PressureMonitor::runPsi() {
+    epoll_event events[8];
+    for (;;) {
+        int ready = epoll_wait(epollFd, events, 8, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.u32 == UINT32_MAX) {
+                return;  // stop()
+            }
+            handleTrigger(events[i].data.u32, events[i].events);
+        }
+    }
+}
+
+void PressureMonitor::runFallback() {
+    fallbackState = FallbackState();
+    for (;;) {
+        uint32_t intervalMs = sampleFallback();
+        epoll_event event;
+        int ready = epoll_wait(epollFd, &event, 1, static_cast<int>(intervalMs));
+        if (ready > 0) {
+            return;  // stop()
+        }
+    }
+}
+
+bool PressureMonitor::start(bool allowPsi) {
+    if (mode.load() != Mode::Stopped) {
+        return true;
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0) {
+        stop();
+        return false;
+    }
+    epoll_event wake = {};
+    wake.events = EPOLLIN;
+    wake.data.u32 = UINT32_MAX;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wake);
+
+    if (allowPsi && armTriggers()) {
+        mode.store(Mode::Psi);
+        worker = std::thread(&PressureMonitor::runPsi, this);
+    } else {
+        mode.store(Mode::MeminfoFallback);
+        worker = std::thread(&PressureMonitor::runFallback, this);
+    }
+    return true;
+}
+
+bool PressureMonitor::start(EventLoop& loop, bool allowPsi) {
+    if (mode.load() != Mode::Stopped) {
+        return true;
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        return false;
+    }
+    eventLoop = &loop;
+    // The trigger fds stay on our own epoll set, which the loop watches as
+    // a single fd; it turns readable whenever a trigger fires.
+    if (allowPsi && armTriggers()) {
+        loopTask = loop.addFd("pressure.psi", epollFd, EPOLLIN, [this](uint32_t) {
+            epoll_event events[8];
+            int ready = epoll_wait(epollFd, events, 8, 0);
+            for (int i = 0; i < ready; i++) {
+                handleTrigger(events[i].data.u32, events[i].events);
+            }
+        });
+    }
+    if (loopTask) {
+        mode.store(Mode::Psi);
+    } else {
+        disarmTriggers();
+        fallbackState = FallbackState();
+        mode.store(Mode::MeminfoFallback);
+        loopTask = loop.addPeriodic("pressure.meminfo", fallbackState.intervalMs, [this](uint64_t) {
+            eventLoop->setInterval(loopTask, sampleFallback());
+        });
+    }
+    return true;
+}
+
+void PressureMonitor::stop() {
+    if (loopTask) {
+        eventLoop->remove(loopTask);
+        loopTask = 0;
+    }
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    disarmTriggers();
+    if (epollFd >= 0) {
+        close(epollFd);
+        epollFd = -1;
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+    mode.store(Mode::Stopped);
+}
+
+#endif // __linux__
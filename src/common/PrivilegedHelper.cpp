@@ -0,0 +1,437 @@
+// src/common/PrivilegedHelper.cpp - Persistent privileged command helper
+#if defined(__linux__)
+#include "PrivilegedHelper.h"
+#include "SelfProfiler.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const kSuCandidates[] = {
+    "/system/bin/su",
+    "/system/xbin/su",
+    "/sbin/su",
+    "/su/bin/su",
+    "/debug_ramdisk/su",
+};
+
+const char kReadyMarker[] = "__RBX_READY__ ";
+const char kResultMarker[] = "__RBX_RC__ ";
+const char kEndMarker[] = "__RBX_END__ ";
+
+// The first su invocation may show a grant prompt to the user.
+constexpr int kStartTimeoutMs = 15000;
+constexpr int kCommandTimeoutMs = 10000;
+
+const char* defaultShell() {
+    return access("/system/bin/sh", X_OK) == 0 ? "/system/bin/sh" : "/bin/sh";
+}
+
+bool startsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+} // namespace
+
+HelperCommand HelperCommand::writeFile(const std::string& path, const std::string& contents) {
+    HelperCommand command;
+    command.type = Type::WriteFile;
+    command.target = path;
+    command.value = contents;
+    return command;
+}
+
+HelperCommand HelperCommand::putSetting(const std::string& nameSpace, const std::string& key, const std::string& value) {
+    HelperCommand command;
+    command.type = Type::PutSetting;
+    command.target = nameSpace + "/" + key;
+    command.value = value;
+    return command;
+}
+
+HelperCommand HelperCommand::setPriority(pid_t pid, int nice) {
+    HelperCommand command;
+    command.type = Type::SetPriority;
+    command.pid = pid;
+    command.priority = nice;
+    return command;
+}
+
+HelperCommand HelperCommand::setIoPriority(pid_t tid, int ioprio) {
+    HelperCommand command;
+    command.type = Type::SetIoPriority;
+    command.pid = tid;
+    command.priority = ioprio;
+    return command;
+}
+
+HelperCommand HelperCommand::sync() {
+    HelperCommand command;
+    command.type = Type::Sync;
+    return command;
+}
+
+HelperCommand HelperCommand::shell(const std::string& text) {
+    HelperCommand command;
+    command.type = Type::Shell;
+    command.value = text;
+    return command;
+}
+
+// ---------------------------------------------------------------------------
+
+PrivilegedHelper* PrivilegedHelper::getInstance() {
+    static PrivilegedHelper instance;
+    return &instance;
+}
+
+PrivilegedHelper::PrivilegedHelper()
+    : childPid(0), channel(-1), rootState(RootState::Unknown), batchCounter(0) {}
+
+PrivilegedHelper::~PrivilegedHelper() {
+    stop();
+}
+
+std::string PrivilegedHelper::shellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += "'";
+    return quoted;
+}
+
+bool PrivilegedHelper::writeAll(const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        // MSG_NOSIGNAL: a dead helper must not SIGPIPE the optimizer
+        ssize_t n = send(channel, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool PrivilegedHelper::readLine(std::string& line, int timeoutMs) {
+    for (;;) {
+        size_t newline = readBuffer.find('\n');
+        if (newline != std::string::npos) {
+            line.assign(readBuffer, 0, newline);
+            readBuffer.erase(0, newline + 1);
+            return true;
+        }
+        pollfd pfd = {channel, POLLIN, 0};
+        int ready = poll(&pfd, 1, timeoutMs);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+        char chunk[4096];
+        ssize_t n = recv(channel, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;  // helper exited
+        }
+        readBuffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+bool PrivilegedHelper::spawn(const char* shell, bool viaSu) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+        return false;
+    }
+
+    pid_t pid = fork();
+    PROFILE_COUNT(ProfileCounter::Forks, 1);
+    if (pid < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // dup2 clears FD_CLOEXEC on the duplicates
+        dup2(sockets[1], STDIN_FILENO);
+        dup2(sockets[1], STDOUT_FILENO);
+        int devNull = open("/dev/null", O_WRONLY);
+        if (devNull >= 0) {
+            dup2(devNull, STDERR_FILENO);
+        }
+        execl(shell, shell, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(sockets[1]);
+    childPid = pid;
+    channel = sockets[0];
+    readBuffer.clear();
+
+    std::string line;
+    if (writeAll(std::string("echo ") + kReadyMarker + "$(id -u)\n")) {
+        while (readLine(line, kStartTimeoutMs)) {
+            if (startsWith(line, kReadyMarker)) {
+                bool root = std::atoi(line.c_str() + std::strlen(kReadyMarker)) == 0;
+                if (viaSu && !root) {
+                    break;  // su refused or is a stub; try the next candidate
+                }
+                rootState.store(root ? RootState::Root : RootState::NoRoot, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    stopLocked();
+    return false;
+}
+
+bool PrivilegedHelper::startLocked() {
+    if (childPid > 0) {
+        return true;
+    }
+    if (geteuid() == 0) {
+        return spawn(defaultShell(), false);
+    }
+    for (const char* su : kSuCandidates) {
+        if (access(su, X_OK) == 0 && spawn(su, true)) {
+            return true;
+        }
+    }
+    // No root: keep an unprivileged shell so settings commands still batch.
+    return spawn(defaultShell(), false);
+}
+
+void PrivilegedHelper::stopLocked() {
+    if (channel >= 0) {
+        writeAll("exit\n");
+        close(channel);
+        channel = -1;
+    }
+    if (childPid > 0) {
+        int status = 0;
+        for (int i = 0; i < 20 && waitpid(childPid, &status, WNOHANG) == 0; i++) {
+            usleep(5000);
+        }
+        if (waitpid(childPid, &status, WNOHANG) == 0) {
+            kill(childPid, SIGKILL);
+            waitpid(childPid, &status, 0);
+        }
+        childPid = 0;
+    }
+    readBuffer.clear();
+}
+
+bool PrivilegedHelper::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return startLocked();
+}
+
+void PrivilegedHelper::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopLocked();
+}
+
+bool PrivilegedHelper::isRunning() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return childPid > 0;
+}
+
+bool PrivilegedHelper::hasRoot() {
+    RootState state = rootState.load(std::memory_order_acquire);
+    if (state == RootState::Unknown) {
+        if (geteuid() == 0) {
+            rootState.store(RootState::Root, std::memory_order_release);
+            return true;
+        }
+        start();
+        state = rootState.load(std::memory_order_acquire);
+    }
+    return state == RootState::Root;
+}
+
+bool PrivilegedHelper::tryInProcess(const HelperCommand& command, HelperResult& result) {
+    result.inProcess = true;
+    switch (command.type) {
+    case HelperCommand::Type::WriteFile: {
+        int fd = open(command.target.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EACCES || errno == EPERM) {
+                result.inProcess = false;
+                return false;  // needs the privileged shell
+            }
+            result.output = std::strerror(errno);
+            return true;
+        }
+        ssize_t n = write(fd, command.value.data(), command.value.size());
+        int error = errno;
+        close(fd);
+        result.success = n == static_cast<ssize_t>(command.value.size());
+        result.exitCode = result.success ? 0 : 1;
+        if (!result.success) {
+            result.output = std::strerror(error);
+        }
+        return true;
+    }
+    case HelperCommand::Type::SetPriority:
+        if (setpriority(PRIO_PROCESS, command.pid, command.priority) == 0) {
+            result.success = true;
+            result.exitCode = 0;
+            return true;
+        }
+        if (errno == EACCES || errno == EPERM) {
+            result.inProcess = false;
+            return false;
+        }
+        result.output = std::strerror(errno);
+        return true;
+    case HelperCommand::Type::SetIoPriority:
+        // ioprio_set(IOPRIO_WHO_PROCESS, tid): per thread, no libc wrapper.
+        if (syscall(SYS_ioprio_set, 1, command.pid, command.priority) == 0) {
+            result.success = true;
+            result.exitCode = 0;
+            return true;
+        }
+        if (errno == EACCES || errno == EPERM) {
+            result.inProcess = false;
+            return false;
+        }
+        result.output = std::strerror(errno);
+        return true;
+    case HelperCommand::Type::Sync:
+        ::sync();
+        result.success = true;
+        result.exitCode = 0;
+        return true;
+    default:
+        result.inProcess = false;
+        return false;
+    }
+}
+
+std::string PrivilegedHelper::toShell(const HelperCommand& command) const {
+    switch (command.type) {
+    case HelperCommand::Type::WriteFile:
+        return "printf '%s' " + shellQuote(command.value) + " > " + shellQuote(command.target);
+    case HelperCommand::Type::PutSetting: {
+        size_t slash = command.target.find('/');
+        std::string args = command.target.substr(0, slash) + " " +
+                           shellQuote(command.target.substr(slash + 1)) + " " + shellQuote(command.value);
+        // `cmd settings` talks to the settings provider directly; the
+        // `settings` wrapper script is only a fallback for old images.
+        return "cmd settings put " + args + " || settings put " + args;
+    }
+    case HelperCommand::Type::SetPriority:
+        // `-n N` is an increment to the current nice value; the bare
+        // form sets it outright, like setpriority() in process.
+        return "renice " + std::to_string(command.priority) + " -p " + std::to_string(command.pid);
+    case HelperCommand::Type::SetIoPriority: {
+        // Classes 0 (none) and 3 (idle) take no level.
+        int ioClass = command.priority >> 13;
+        std::string level = ioClass == 1 || ioClass == 2 ? " -n " + std::to_string(command.priority & 7) : "";
+        return "ionice -c " + std::to_string(ioClass) + level + " -p " + std::to_string(command.pid);
+    }
+    case HelperCommand::Type::Sync:
+        return "sync";
+    case HelperCommand::Type::Shell:
+    default:
+        return command.value;
+    }
+}
+
+std::vector<HelperResult> PrivilegedHelper::execute(const std::vector<HelperCommand>& commands) {
+    std::vector<HelperResult> results(commands.size());
+    std::string script;
+    size_t pending = 0;
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (tryInProcess(commands[i], results[i])) {
+            continue;
+        }
+        // stdin is the helper's socket: a command that reads it would
+        // swallow the rest of the batch.
+        script += "{ " + toShell(commands[i]) + "\n} </dev/null 2>&1; echo \"" + kResultMarker + std::to_string(i) + " $?\"\n";
+        pending++;
+    }
+    if (pending == 0) {
+        return results;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!startLocked()) {
+        for (auto& result : results) {
+            if (!result.inProcess) {
+                result.output = "privileged helper unavailable";
+            }
+        }
+        return results;
+    }
+
+    uint64_t batch = ++batchCounter;
+    script += std::string("echo ") + kEndMarker + std::to_string(batch) + "\n";
+    if (!writeAll(script)) {
+        stopLocked();
+        return results;
+    }
+
+    std::string output;
+    std::string line;
+    std::string endLine = kEndMarker + std::to_string(batch);
+    for (;;) {
+        if (!readLine(line, kCommandTimeoutMs)) {
+            // Helper wedged or died; restart it on the next batch.
+            stopLocked();
+            break;
+        }
+        if (line == endLine) {
+            break;
+        }
+        // Output without a trailing newline shares its last line with the marker.
+        size_t marker = line.find(kResultMarker);
+        if (marker != std::string::npos) {
+            if (marker > 0) {
+                if (!output.empty()) {
+                    output += '\n';
+                }
+                output.append(line, 0, marker);
+            }
+            char* end = nullptr;
+            unsigned long index = std::strtoul(line.c_str() + marker + std::strlen(kResultMarker), &end, 10);
+            if (index < results.size()) {
+                HelperResult& result = results[index];
+                result.exitCode = std::atoi(end);
+                result.success = result.exitCode == 0;
+                result.output = output;
+            }
+            output.clear();
+            continue;
+        }
+        if (!output.empty()) {
+            output += '\n';
+        }
+        output += line;
+    }
+    return results;
+}
+
+HelperResult PrivilegedHelper::execute(const HelperCommand& command) {
+    return execute(std::vector<HelperCommand>{command}).front();
+}
+
+#endif // __linux__
@@ -0,0 +1,620 @@
+// src/common/ProcFs.cpp - Zero-allocation procfs/sysfs readers and parsers
+#if defined(__linux__)
+#include "ProcFs.h"
+#include "SelfProfiler.h"
+
+#include <charconv>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Splits off the next line (without the '\n') and advances `text`.
+std::string_view nextLine(std::string_view& text) {
+    size_t end = text.find('\n');
+    std::string_view line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    return line;
+}
+
+// Splits off the next whitespace separated token and advances `text`.
+std::string_view nextToken(std::string_view& text) {
+    size_t start = 0;
+    while (start < text.size() && (text[start] == ' ' || text[start] == '\t')) {
+        start++;
+    }
+    size_t end = start;
+    while (end < text.size() && text[end] != ' ' && text[end] != '\t' && text[end] != '\n') {
+        end++;
+    }
+    std::string_view token = text.substr(start, end - start);
+    text.remove_prefix(end);
+    return token;
+}
+
+// "   123456 kB" -> bytes; bare numbers are returned unscaled.
+bool parseKbValue(std::string_view value, uint64_t& out) {
+    std::string_view number = nextToken(value);
+    if (!ProcParser::parseUnsigned(number, out)) {
+        return false;
+    }
+    if (nextToken(value) == "kB") {
+        out *= 1024;
+    }
+    return true;
+}
+
+void copyName(std::string_view src, char* dst, size_t capacity) {
+    size_t n = src.size() < capacity - 1 ? src.size() : capacity - 1;
+    std::memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+uint64_t monotonicNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+bool parseCpuTimes(std::string_view fields, CpuTimes& out) {
+    uint64_t* slots[] = {&out.user, &out.nice, &out.system, &out.idle,
+                         &out.iowait, &out.irq, &out.softirq, &out.steal};
+    int parsed = 0;
+    for (uint64_t* slot : slots) {
+        std::string_view token = nextToken(fields);
+        if (token.empty()) {
+            break;  // older kernels report fewer columns
+        }
+        if (!ProcParser::parseUnsigned(token, *slot)) {
+            return false;
+        }
+        parsed++;
+    }
+    return parsed >= 4;
+}
+
+struct MemInfoField {
+    std::string_view key;
+    uint64_t MemInfo::* member;
+};
+
+const MemInfoField kMemInfoFields[] = {
+    {"MemTotal", &MemInfo::memTotal},
+    {"MemFree", &MemInfo::memFree},
+    {"MemAvailable", &MemInfo::memAvailable},
+    {"Buffers", &MemInfo::buffers},
+    {"Cached", &MemInfo::cached},
+    {"SwapCached", &MemInfo::swapCached},
+    {"Active", &MemInfo::active},
+    {"Inactive", &MemInfo::inactive},
+    {"Active(file)", &MemInfo::activeFile},
+    {"Inactive(file)", &MemInfo::inactiveFile},
+    {"SwapTotal", &MemInfo::swapTotal},
+    {"SwapFree", &MemInfo::swapFree},
+    {"Dirty", &MemInfo::dirty},
+    {"Shmem", &MemInfo::shmem},
+    {"SReclaimable", &MemInfo::sReclaimable},
+};
+
+struct StatusField {
+    std::string_view key;
+    uint64_t TaskStatus::* member;
+};
+
+const StatusField kStatusKbFields[] = {
+    {"VmRSS", &TaskStatus::vmRss},
+    {"VmHWM", &TaskStatus::vmHwm},
+    {"RssAnon", &TaskStatus::rssAnon},
+    {"RssFile", &TaskStatus::rssFile},
+    {"RssShmem", &TaskStatus::rssShmem},
+    {"VmSwap", &TaskStatus::vmSwap},
+    {"voluntary_ctxt_switches", &TaskStatus::voluntaryCtxtSwitches},
+    {"nonvoluntary_ctxt_switches", &TaskStatus::nonvoluntaryCtxtSwitches},
+};
+
+struct SmapsField {
+    std::string_view key;
+    uint64_t SmapsRollup::* member;
+};
+
+const SmapsField kSmapsRollupFields[] = {
+    {"Rss", &SmapsRollup::rss},
+    {"Pss", &SmapsRollup::pss},
+    {"Pss_Anon", &SmapsRollup::pssAnon},
+    {"Pss_File", &SmapsRollup::pssFile},
+    {"Pss_Shmem", &SmapsRollup::pssShmem},
+    {"Shared_Clean", &SmapsRollup::sharedClean},
+    {"Shared_Dirty", &SmapsRollup::sharedDirty},
+    {"Private_Clean", &SmapsRollup::privateClean},
+    {"Private_Dirty", &SmapsRollup::privateDirty},
+    {"Anonymous", &SmapsRollup::anonymous},
+    {"Swap", &SmapsRollup::swap},
+    {"SwapPss", &SmapsRollup::swapPss},
+    {"Locked", &SmapsRollup::locked},
+};
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// ProcFile
+
+ProcFile::ProcFile() : fd(-1) {}
+
+ProcFile::ProcFile(const std::string& path, size_t initialCapacity) : fd(-1) {
+    open(path, initialCapacity);
+}
+
+ProcFile::~ProcFile() {
+    close();
+}
+
+ProcFile::ProcFile(ProcFile&& other) noexcept : fd(other.fd), buffer(std::move(other.buffer)) {
+    other.fd = -1;
+}
+
+ProcFile& ProcFile::operator=(ProcFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd = other.fd;
+        buffer = std::move(other.buffer);
+        other.fd = -1;
+    }
+    return *this;
+}
+
+bool ProcFile::open(const std::string& path, size_t initialCapacity) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    if (fd < 0) {
+        return false;
+    }
+    if (buffer.size() < initialCapacity) {
+        buffer.resize(initialCapacity);
+    }
+    return true;
+}
+
+void ProcFile::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+std::string_view ProcFile::read() {
+    if (fd < 0) {
+        return {};
+    }
+    for (;;) {
+        ssize_t n = ::pread(fd, buffer.data(), buffer.size(), 0);
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return {};
+        }
+        // A full buffer means the file may be larger; grow once and re-read
+        // from offset 0 so the snapshot stays consistent.
+        if (static_cast<size_t>(n) == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+            continue;
+        }
+        PROFILE_COUNT(ProfileCounter::BytesRead, static_cast<uint64_t>(n));
+        return std::string_view(buffer.data(), static_cast<size_t>(n));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ProcParser
+
+bool ProcParser::parseUnsigned(std::string_view text, uint64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc();
+}
+
+bool ProcParser::parseSigned(std::string_view text, int64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc();
+}
+
+std::string_view ProcParser::trimLine(std::string_view text) {
+    while (!text.empty() && (text.back() == '\n' || text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    return text;
+}
+
+bool ProcParser::parseSysfsUnsigned(std::string_view text, uint64_t& value) {
+    return parseUnsigned(trimLine(text), value);
+}
+
+bool ProcParser::parseMemInfo(std::string_view text, MemInfo& out) {
+    out = MemInfo();
+    bool sawTotal = false;
+    while (!text.empty()) {
+        std::string_view line = nextLine(text);
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view key = line.substr(0, colon);
+        for (const auto& field : kMemInfoFields) {
+            if (field.key == key) {
+                if (!parseKbValue(line.substr(colon + 1), out.*(field.member))) {
+                    return false;
+                }
+                sawTotal |= (field.member == &MemInfo::memTotal);
+                break;
+            }
+        }
+    }
+    // Kernels before 3.14 lack MemAvailable; approximate it the way
+    // userspace tools did before the kernel exported it.
+    if (sawTotal && out.memAvailable == 0) {
+        out.memAvailable = out.memFree + out.activeFile + out.inactiveFile + out.sReclaimable;
+    }
+    return sawTotal;
+}
+
+bool ProcParser::parseCpuStat(std::string_view text, CpuStat& out) {
+    out.cpuCount = 0;
+    out.contextSwitches = 0;
+    out.processesCreated = 0;
+    out.procsRunning = 0;
+    out.procsBlocked = 0;
+    bool sawAggregate = false;
+
+    while (!text.empty()) {
+        std::string_view line = nextLine(text);
+        std::string_view key = nextToken(line);
+        if (key.size() >= 3 && key.compare(0, 3, "cpu") == 0) {
+            if (key.size() == 3) {
+                if (!parseCpuTimes(line, out.aggregate)) {
+                    return false;
+                }
+                sawAggregate = true;
+                continue;
+            }
+            uint64_t index = 0;
+            if (!parseUnsigned(key.substr(3), index) || index >= kMaxTrackedCpus) {
+                continue;
+            }
+            // Offline CPUs are omitted from /proc/stat, so index can skip.
+            if (!parseCpuTimes(line, out.perCpu[index])) {
+                return false;
+            }
+            if (static_cast<int>(index) + 1 > out.cpuCount) {
+                out.cpuCount = static_cast<int>(index) + 1;
+            }
+        } else if (key == "ctxt") {
+            parseUnsigned(nextToken(line), out.contextSwitches);
+        } else if (key == "processes") {
+            parseUnsigned(nextToken(line), out.processesCreated);
+        } else if (key == "procs_running") {
+            uint64_t v = 0;
+            parseUnsigned(nextToken(line), v);
+            out.procsRunning = static_cast<uint32_t>(v);
+        } else if (key == "procs_blocked") {
+            uint64_t v = 0;
+            parseUnsigned(nextToken(line), v);
+            out.procsBlocked = static_cast<uint32_t>(v);
+        }
+    }
+    return sawAggregate;
+}
+
+bool ProcParser::parseTaskStat(std::string_view text, TaskStat& out) {
+    // comm may contain spaces and parentheses: take the first '(' and the
+    // last ')' as its delimiters, then split the remainder on spaces.
+    size_t open = text.find('(');
+    size_t close = text.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close < open) {
+        return false;
+    }
+
+    int64_t pid = 0;
+    if (!parseSigned(trimLine(text.substr(0, open)), pid)) {
+        return false;
+    }
+    out.pid = static_cast<int32_t>(pid);
+    copyName(text.substr(open + 1, close - open - 1), out.comm, sizeof(out.comm));
+
+    std::string_view rest = text.substr(close + 1);
+    // Field numbers follow proc(5); field 3 is the first after comm.
+    int field = 3;
+    int64_t sv = 0;
+    uint64_t uv = 0;
+    while (field <= 39) {
+        std::string_view token = nextToken(rest);
+        if (token.empty()) {
+            break;
+        }
+        switch (field) {
+        case 3:  out.state = token[0]; break;
+        case 4:  if (parseSigned(token, sv)) out.ppid = static_cast<int32_t>(sv); break;
+        case 10: parseUnsigned(token, out.minorFaults); break;
+        case 12: parseUnsigned(token, out.majorFaults); break;
+        case 14: parseUnsigned(token, out.utime); break;
+        case 15: parseUnsigned(token, out.stime); break;
+        case 18: if (parseSigned(token, sv)) out.priority = static_cast<int32_t>(sv); break;
+        case 19: if (parseSigned(token, sv)) out.nice = static_cast<int32_t>(sv); break;
+        case 20: if (parseSigned(token, sv)) out.numThreads = static_cast<int32_t>(sv); break;
+        case 22: parseUnsigned(token, out.startTime); break;
+        case 23: parseUnsigned(token, out.vsize); break;
+        case 24: if (parseUnsigned(token, uv)) out.rssPages = uv; break;
+        case 39: if (parseSigned(token, sv)) out.processor = static_cast<int32_t>(sv); break;
+        default: break;
+        }
+        field++;
+    }
+    // Everything up to starttime is present on every supported kernel.
+    return field > 22;
+}
+
+bool ProcParser::parseTaskStatus(std::string_view text, TaskStatus& out) {
+    out = TaskStatus();
+    bool sawName = false;
+    while (!text.empty()) {
+        std::string_view line = nextLine(text);
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view key = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        int64_t sv = 0;
+        uint64_t uv = 0;
+
+        if (key == "Name") {
+            copyName(trimLine(value), out.name, sizeof(out.name));
+            sawName = true;
+        } else if (key == "Tgid") {
+            if (parseSigned(nextToken(value), sv)) out.tgid = static_cast<int32_t>(sv);
+        } else if (key == "PPid") {
+            if (parseSigned(nextToken(value), sv)) out.ppid = static_cast<int32_t>(sv);
+        } else if (key == "Uid") {
+            if (parseUnsigned(nextToken(value), uv)) out.uid = static_cast<uint32_t>(uv);
+        } else if (key == "Threads") {
+            if (parseSigned(nextToken(value), sv)) out.threads = static_cast<int32_t>(sv);
+        } else {
+            for (const auto& field : kStatusKbFields) {
+                if (field.key == key) {
+                    parseKbValue(value, out.*(field.member));
+                    break;
+                }
+            }
+        }
+    }
+    return sawName;
+}
+
+bool ProcParser::parseTaskStatm(std::string_view text, TaskStatm& out) {
+    out = TaskStatm();
+    uint64_t* slots[] = {&out.sizePages, &out.residentPages, &out.sharedPages, &out.textPages};
+    for (uint64_t* slot : slots) {
+        if (!parseUnsigned(nextToken(text), *slot)) {
+            return false;
+        }
+    }
+    nextToken(text);  // lib, always 0 since 2.6
+    return parseUnsigned(nextToken(text), out.dataPages);
+}
+
+bool ProcParser::parseSchedstat(std::string_view text, TaskSchedstat& out) {
+    out = TaskSchedstat();
+    return parseUnsigned(nextToken(text), out.runNs) &&
+           parseUnsigned(nextToken(text), out.waitNs) &&
+           parseUnsigned(nextToken(text), out.timeslices);
+}
+
+bool ProcParser::parseSmapsRollup(std::string_view text, SmapsRollup& out) {
+    out = SmapsRollup();
+    // The first line is the synthetic "[rollup]" mapping header.
+    if (nextLine(text).find("[rollup]") == std::string_view::npos) {
+        return false;
+    }
+    bool sawRss = false;
+    while (!text.empty()) {
+        std::string_view line = nextLine(text);
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string_view key = line.substr(0, colon);
+        for (const auto& field : kSmapsRollupFields) {
+            if (field.key == key) {
+                if (!parseKbValue(line.substr(colon + 1), out.*(field.member))) {
+                    return false;
+                }
+                sawRss |= (field.member == &SmapsRollup::rss);
+                break;
+            }
+        }
+    }
+    return sawRss;
+}
+
+// ---------------------------------------------------------------------------
+// ProcFsReader
+
+ProcFsReader::ProcFsReader(const std::string& rootPrefix)
+    : root(rootPrefix), cpuFreqProbed(false), thermalProbed(false) {
+    memInfoFile.open(root + "/proc/meminfo", 8192);
+    statFile.open(root + "/proc/stat", 8192);
+}
+
+void ProcFsReader::probeCpuFreq() {
+    cpuFreqProbed = true;
+    cpuFreqFiles.clear();
+    for (int cpu = 0; cpu < kMaxTrackedCpus; cpu++) {
+        std::string cpuDir = root + "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        if (access(cpuDir.c_str(), F_OK) != 0) {
+            break;
+        }
+        std::string base = cpuDir + "/cpufreq/";
+        CpuFreqFiles files;
+        files.cur.open(base + "scaling_cur_freq", 64);
+        files.min.open(base + "scaling_min_freq", 64);
+        files.max.open(base + "scaling_max_freq", 64);
+        files.infoMin.open(base + "cpuinfo_min_freq", 64);
+        files.infoMax.open(base + "cpuinfo_max_freq", 64);
+        files.governor.open(base + "scaling_governor", 64);
+        cpuFreqFiles.push_back(std::move(files));
+    }
+}
+
+int ProcFsReader::cpuFreqCount() {
+    if (!cpuFreqProbed) {
+        probeCpuFreq();
+    }
+    return static_cast<int>(cpuFreqFiles.size());
+}
+
+void ProcFsReader::probeThermal() {
+    static const char* const kSkippedTypes[] = {"battery", "charger", "bms", "pmic", "usb"};
+    thermalProbed = true;
+    thermalFiles.clear();
+    for (int zone = 0;; zone++) {
+        std::string zoneDir = root + "/sys/class/thermal/thermal_zone" + std::to_string(zone);
+        ProcFile typeFile;
+        if (!typeFile.open(zoneDir + "/type", 64)) {
+            break;
+        }
+        std::string_view type = ProcParser::trimLine(typeFile.read());
+        bool skipped = false;
+        for (const char* skippedType : kSkippedTypes) {
+            if (type.find(skippedType) != std::string_view::npos) {
+                skipped = true;
+                break;
+            }
+        }
+        ProcFile tempFile;
+        if (!skipped && tempFile.open(zoneDir + "/temp", 64)) {
+            thermalFiles.push_back(std::move(tempFile));
+        }
+    }
+}
+
+int ProcFsReader::thermalZoneCount() {
+    if (!thermalProbed) {
+        probeThermal();
+    }
+    return static_cast<int>(thermalFiles.size());
+}
+
+bool ProcFsReader::readMaxThermal(int32_t& milliCelsius) {
+    bool found = false;
+    int64_t hottest = 0;
+    for (int zone = 0; zone < thermalZoneCount(); zone++) {
+        // Disabled zones fail the read (EINVAL/ENODATA); skip them.
+        int64_t value = 0;
+        std::string_view text = ProcParser::trimLine(thermalFiles[zone].read());
+        if (text.empty() || !ProcParser::parseSigned(text, value)) {
+            continue;
+        }
+        if (!found || value > hottest) {
+            hottest = value;
+            found = true;
+        }
+    }
+    milliCelsius = static_cast<int32_t>(hottest);
+    return found;
+}
+
+bool ProcFsReader::readMemInfo(MemInfo& out) {
+    std::string_view text = memInfoFile.read();
+    return !text.empty() && ProcParser::parseMemInfo(text, out);
+}
+
+bool ProcFsReader::readCpuStat(CpuStat& out) {
+    std::string_view text = statFile.read();
+    return !text.empty() && ProcParser::parseCpuStat(text, out);
+}
+
+bool ProcFsReader::readCpuFreq(int cpu, CpuFreqInfo& out) {
+    out = CpuFreqInfo();
+    if (cpu < 0 || cpu >= cpuFreqCount()) {
+        return false;
+    }
+    CpuFreqFiles& files = cpuFreqFiles[cpu];
+    uint64_t value = 0;
+    // scaling_cur_freq disappears (or fails with EBUSY) while a CPU is
+    // hotplugged out; treat that as offline rather than an error.
+    if (!ProcParser::parseSysfsUnsigned(files.cur.read(), value)) {
+        return true;
+    }
+    out.online = true;
+    out.curFreq = static_cast<uint32_t>(value);
+    if (ProcParser::parseSysfsUnsigned(files.min.read(), value)) out.minFreq = static_cast<uint32_t>(value);
+    if (ProcParser::parseSysfsUnsigned(files.max.read(), value)) out.maxFreq = static_cast<uint32_t>(value);
+    if (ProcParser::parseSysfsUnsigned(files.infoMin.read(), value)) out.cpuinfoMinFreq = static_cast<uint32_t>(value);
+    if (ProcParser::parseSysfsUnsigned(files.infoMax.read(), value)) out.cpuinfoMaxFreq = static_cast<uint32_t>(value);
+    std::string_view governor = ProcParser::trimLine(files.governor.read());
+    copyName(governor, out.governor, sizeof(out.governor));
+    return true;
+}
+
+bool ProcFsReader::readSnapshot(SystemSnapshot& out) {
+    out.timestampNs = monotonicNanos();
+    bool ok = readMemInfo(out.memory);
+    ok &= readCpuStat(out.cpu);
+    out.freqCount = cpuFreqCount();
+    for (int cpu = 0; cpu < out.freqCount; cpu++) {
+        readCpuFreq(cpu, out.freq[cpu]);
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// ProcessStatReader
+
+ProcessStatReader::ProcessStatReader() : pid(0) {}
+
+ProcessStatReader::ProcessStatReader(pid_t processId, const std::string& rootPrefix) : pid(0) {
+    attach(processId, rootPrefix);
+}
+
+bool ProcessStatReader::attach(pid_t processId, const std::string& rootPrefix) {
+    detach();
+    std::string base = rootPrefix + "/proc/" + std::to_string(processId);
+    if (!statFile.open(base + "/stat", 1024)) {
+        return false;
+    }
+    statusFile.open(base + "/status", 4096);
+    pid = processId;
+    return true;
+}
+
+void ProcessStatReader::detach() {
+    statFile.close();
+    statusFile.close();
+    pid = 0;
+}
+
+bool ProcessStatReader::readStat(TaskStat& out) {
+    // Once the process exits, reads on the held fd fail with ESRCH.
+    std::string_view text = statFile.read();
+    return !text.empty() && ProcParser::parseTaskStat(text, out);
+}
+
+bool ProcessStatReader::readStatus(TaskStatus& out) {
+    std::string_view text = statusFile.read();
+    return !text.empty() && ProcParser::parseTaskStatus(text, out);
+}
+
+#endif // __linux__
@@ -0,0 +1,512 @@
+// src/common/ProcTrace.cpp - Record/replay of procfs/sysfs inputs
+#if defined(__linux__)
+#include "ProcTrace.h"
+#include "SelfProfiler.h"
+
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kTraceMagic[8] = {'R', 'B', 'X', 'T', 'R', 'C', '1', '\0'};
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+// Files under each cpuN that the readers, CpuTopology and the cpufreq
+// controller look at. Unchanged files cost nothing after the first frame.
+const char* const kCpuFiles[] = {
+    "cpufreq/scaling_cur_freq", "cpufreq/scaling_min_freq", "cpufreq/scaling_max_freq",
+    "cpufreq/cpuinfo_min_freq", "cpufreq/cpuinfo_max_freq", "cpufreq/scaling_governor",
+    "cpufreq/related_cpus", "cpu_capacity", "topology/cluster_id", "topology/physical_package_id",
+};
+const char* const kPolicyFiles[] = {
+    "scaling_cur_freq", "scaling_min_freq", "scaling_max_freq", "cpuinfo_min_freq",
+    "cpuinfo_max_freq", "scaling_governor", "scaling_available_governors", "related_cpus",
+};
+const char* const kPressureFiles[] = {"/proc/pressure/memory", "/proc/pressure/cpu", "/proc/pressure/io"};
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putString(std::string& out, const char* data, size_t length) {
+    putVarint(out, length);
+    out.append(data, length);
+}
+
+// Line boundaries, each line keeping its '\n'.
+void splitLines(const std::string& text, std::vector<std::pair<size_t, size_t>>& lines) {
+    lines.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        end = end == std::string::npos ? text.size() : end + 1;
+        lines.emplace_back(start, end - start);
+        start = end;
+    }
+}
+
+// Appends a 'D' record if both versions have the same number of lines,
+// otherwise returns false so the caller writes the whole file.
+bool encodeLineDelta(std::string& out, uint32_t id, const std::string& before, const std::string& after) {
+    std::vector<std::pair<size_t, size_t>> oldLines;
+    std::vector<std::pair<size_t, size_t>> newLines;
+    splitLines(before, oldLines);
+    splitLines(after, newLines);
+    if (oldLines.size() != newLines.size()) {
+        return false;
+    }
+    std::string body;
+    uint64_t changed = 0;
+    size_t previous = 0;
+    for (size_t i = 0; i < newLines.size(); i++) {
+        const char* a = before.data() + oldLines[i].first;
+        const char* b = after.data() + newLines[i].first;
+        size_t lengthA = oldLines[i].second;
+        size_t lengthB = newLines[i].second;
+        if (lengthA == lengthB && std::memcmp(a, b, lengthA) == 0) {
+            continue;
+        }
+        size_t prefix = 0;
+        size_t limit = std::min(lengthA, lengthB);
+        while (prefix < limit && a[prefix] == b[prefix]) {
+            prefix++;
+        }
+        size_t suffix = 0;
+        while (suffix < limit - prefix && a[lengthA - 1 - suffix] == b[lengthB - 1 - suffix]) {
+            suffix++;
+        }
+        putVarint(body, i - previous);
+        putVarint(body, prefix);
+        putVarint(body, suffix);
+        putString(body, b + prefix, lengthB - prefix - suffix);
+        previous = i;
+        changed++;
+    }
+    out.push_back('D');
+    putVarint(out, id);
+    putVarint(out, changed);
+    out += body;
+    return true;
+}
+
+bool makeParents(const std::string& path) {
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        std::string dir = path.substr(0, slash);
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// TraceRecorder
+
+TraceRecorder::TraceRecorder(const std::string& rootPrefix)
+    : root(rootPrefix), out(nullptr), nextId(0), lastTimestampMs(0), gamePid(0), frames(0), bytesWritten(0) {}
+
+TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+bool TraceRecorder::open(const std::string& tracePath) {
+    close();
+    out = std::fopen(tracePath.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+    std::fwrite(kTraceMagic, 1, sizeof(kTraceMagic), out);
+    std::fwrite(&kByteOrderMark, sizeof(kByteOrderMark), 1, out);
+    bytesWritten = sizeof(kTraceMagic) + sizeof(kByteOrderMark);
+    sources.clear();
+    nextId = 0;
+    lastTimestampMs = 0;
+    frames = 0;
+    discoverStatic();
+    return true;
+}
+
+void TraceRecorder::close() {
+    if (out) {
+        std::fclose(out);
+        out = nullptr;
+    }
+}
+
+void TraceRecorder::addSource(const std::string& path) {
+    auto& slot = sources[path];
+    if (!slot) {
+        slot.reset(new Source());
+        slot->id = nextId++;
+        frameBuffer.push_back('P');
+        putString(frameBuffer, path.data(), path.size());
+    }
+    slot->seen = true;
+}
+
+void TraceRecorder::discoverStatic() {
+    addSource("/proc/meminfo");
+    addSource("/proc/stat");
+    for (const char* path : kPressureFiles) {
+        if (access((root + path).c_str(), R_OK) == 0) {
+            addSource(path);
+        }
+    }
+    addSource("/sys/devices/system/cpu/online");
+    for (int cpu = 0; cpu < kMaxTrackedCpus; cpu++) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        if (access((root + dir).c_str(), F_OK) != 0) {
+            break;
+        }
+        for (const char* file : kCpuFiles) {
+            if (access((root + dir + "/" + file).c_str(), R_OK) == 0) {
+                addSource(dir + "/" + file);
+            }
+        }
+    }
+    for (int policy = 0; policy < kMaxTrackedCpus; policy++) {
+        std::string dir = "/sys/devices/system/cpu/cpufreq/policy" + std::to_string(policy);
+        if (access((root + dir).c_str(), F_OK) != 0) {
+            continue;   // policy ids follow the first cpu of each cluster
+        }
+        for (const char* file : kPolicyFiles) {
+            if (access((root + dir + "/" + file).c_str(), R_OK) == 0) {
+                addSource(dir + "/" + file);
+            }
+        }
+    }
+    for (int zone = 0;; zone++) {
+        std::string dir = "/sys/class/thermal/thermal_zone" + std::to_string(zone);
+        if (access((root + dir + "/type").c_str(), R_OK) != 0) {
+            break;
+        }
+        addSource(dir + "/type");
+        addSource(dir + "/temp");
+    }
+}
+
+void TraceRecorder::setGamePid(pid_t pid) {
+    gamePid = pid;
+}
+
+void TraceRecorder::refreshTaskSources() {
+    if (gamePid <= 0) {
+        return;
+    }
+    std::string base = "/proc/" + std::to_string(gamePid);
+    addSource(base + "/stat");
+    addSource(base + "/status");
+    DIR* dir = opendir((root + base + "/task").c_str());
+    if (!dir) {
+        return;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] >= '1' && entry->d_name[0] <= '9') {
+            addSource(base + "/task/" + entry->d_name + "/stat");
+        }
+    }
+    closedir(dir);
+}
+
+void TraceRecorder::captureSource(const std::string& path, Source& source) {
+    std::string_view text;
+    bool ok = source.file.isOpen() || source.file.open(root + path, 1024);
+    if (ok) {
+        errno = 0;
+        text = source.file.read();
+        ok = !text.empty() || errno == 0;
+    }
+    if (!ok) {
+        // Gone (exited task) or unreadable right now (disabled zone).
+        source.file.close();
+        if (source.present) {
+            frameBuffer.push_back('X');
+            putVarint(frameBuffer, source.id);
+            source.content.clear();
+            source.present = false;
+        }
+        return;
+    }
+    if (source.present && text.size() == source.content.size() &&
+        std::memcmp(text.data(), source.content.data(), text.size()) == 0) {
+        return;
+    }
+    std::string next(text);
+    if (!source.present || !encodeLineDelta(frameBuffer, source.id, source.content, next)) {
+        frameBuffer.push_back('R');
+        putVarint(frameBuffer, source.id);
+        putString(frameBuffer, next.data(), next.size());
+    }
+    source.content.swap(next);
+    source.present = true;
+}
+
+bool TraceRecorder::capture(uint64_t timestampMs) {
+    PROFILE_SCOPE("trace.capture");
+    if (!out) {
+        return false;
+    }
+    // Per-process files are only kept while their pid/tid is listed.
+    for (auto& entry : sources) {
+        const std::string& path = entry.first;
+        if (path.compare(0, 6, "/proc/") == 0 && path.size() > 6 && path[6] >= '0' && path[6] <= '9') {
+            entry.second->seen = false;
+        }
+    }
+    refreshTaskSources();
+
+    std::string records;
+    records.swap(frameBuffer);   // 'P' records from discovery come first
+    records.push_back('F');
+    putVarint(records, timestampMs >= lastTimestampMs ? timestampMs - lastTimestampMs : 0);
+    putVarint(records, static_cast<uint64_t>(gamePid > 0 ? gamePid : 0));
+    frameBuffer.swap(records);
+
+    for (auto it = sources.begin(); it != sources.end();) {
+        Source& source = *it->second;
+        if (!source.seen) {
+            if (source.present) {
+                frameBuffer.push_back('X');
+                putVarint(frameBuffer, source.id);
+            }
+            it = sources.erase(it);
+            continue;
+        }
+        captureSource(it->first, source);
+        ++it;
+    }
+    frameBuffer.push_back('E');
+
+    bool ok = std::fwrite(frameBuffer.data(), 1, frameBuffer.size(), out) == frameBuffer.size();
+    bytesWritten += frameBuffer.size();
+    frameBuffer.clear();
+    std::fflush(out);
+    lastTimestampMs = timestampMs;
+    frames++;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// TraceReader
+
+TraceReader::TraceReader() : in(nullptr), timestampMs(0), corrupt(false) {}
+
+TraceReader::~TraceReader() {
+    close();
+}
+
+bool TraceReader::open(const std::string& tracePath) {
+    close();
+    in = std::fopen(tracePath.c_str(), "rb");
+    if (!in) {
+        return false;
+    }
+    char magic[sizeof(kTraceMagic)];
+    uint32_t byteOrder = 0;
+    if (std::fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+        std::memcmp(magic, kTraceMagic, sizeof(magic)) != 0 ||
+        std::fread(&byteOrder, sizeof(byteOrder), 1, in) != 1 || byteOrder != kByteOrderMark) {
+        close();
+        return false;
+    }
+    paths.clear();
+    contents.clear();
+    present.clear();
+    timestampMs = 0;
+    corrupt = false;
+    return true;
+}
+
+void TraceReader::close() {
+    if (in) {
+        std::fclose(in);
+        in = nullptr;
+    }
+}
+
+bool TraceReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = std::fgetc(in);
+        if (c == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TraceReader::readString(std::string& value) {
+    uint64_t length = 0;
+    if (!readVarint(length) || length > (64u << 20)) {
+        return false;
+    }
+    value.resize(length);
+    return length == 0 || std::fread(&value[0], 1, length, in) == length;
+}
+
+bool TraceReader::applyDelta(uint32_t id) {
+    uint64_t count = 0;
+    if (!readVarint(count)) {
+        return false;
+    }
+    std::vector<std::pair<size_t, size_t>> lines;
+    splitLines(contents[id], lines);
+    std::string result;
+    result.reserve(contents[id].size() + 16);
+    size_t copied = 0;          // lines of the old content already emitted
+    uint64_t index = 0;
+    std::string middle;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t delta = 0, prefix = 0, suffix = 0;
+        if (!readVarint(delta) || !readVarint(prefix) || !readVarint(suffix) || !readString(middle)) {
+            return false;
+        }
+        index += delta;
+        if (index >= lines.size() || index < copied) {
+            return false;
+        }
+        const std::string& old = contents[id];
+        for (; copied < index; copied++) {
+            result.append(old, lines[copied].first, lines[copied].second);
+        }
+        const auto& line = lines[index];
+        if (prefix + suffix > line.second) {
+            return false;
+        }
+        result.append(old, line.first, prefix);
+        result += middle;
+        result.append(old, line.first + line.second - suffix, suffix);
+        copied = index + 1;
+    }
+    for (; copied < lines.size(); copied++) {
+        result.append(contents[id], lines[copied].first, lines[copied].second);
+    }
+    contents[id].swap(result);
+    return true;
+}
+
+bool TraceReader::next(TraceFrame& frame) {
+    if (!in) {
+        return false;
+    }
+    frame = TraceFrame();
+    bool inFrame = false;
+    for (;;) {
+        int tag = std::fgetc(in);
+        if (tag == EOF) {
+            // A frame cut short by a crash is dropped, not reported corrupt.
+            return false;
+        }
+        uint64_t value = 0;
+        switch (tag) {
+        case 'P': {
+            std::string path;
+            if (!readString(path)) {
+                return false;
+            }
+            paths.push_back(path);
+            contents.emplace_back();
+            present.push_back(false);
+            break;
+        }
+        case 'F': {
+            uint64_t pid = 0;
+            if (inFrame || !readVarint(value) || !readVarint(pid)) {
+                corrupt = true;
+                return false;
+            }
+            timestampMs += value;
+            frame.timestampMs = timestampMs;
+            frame.gamePid = static_cast<int32_t>(pid);
+            inFrame = true;
+            break;
+        }
+        case 'R':
+        case 'D':
+        case 'X': {
+            if (!inFrame || !readVarint(value) || value >= paths.size()) {
+                corrupt = true;
+                return false;
+            }
+            uint32_t id = static_cast<uint32_t>(value);
+            bool ok = true;
+            if (tag == 'R') {
+                ok = readString(contents[id]);
+                present[id] = true;
+                frame.changed.push_back(id);
+            } else if (tag == 'D') {
+                ok = present[id] && applyDelta(id);
+                frame.changed.push_back(id);
+            } else {
+                present[id] = false;
+                contents[id].clear();
+                frame.removed.push_back(id);
+            }
+            if (!ok) {
+                corrupt = true;
+                return false;
+            }
+            break;
+        }
+        case 'E':
+            if (!inFrame) {
+                corrupt = true;
+                return false;
+            }
+            return true;
+        default:
+            corrupt = true;
+            return false;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// TraceReplayer
+
+TraceReplayer::TraceReplayer(const std::string& rootDir) : root(rootDir) {}
+
+bool TraceReplayer::writeFile(const std::string& path, const std::string& content) {
+    std::string full = root + path;
+    int fd = ::open(full.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == ENOENT && makeParents(full)) {
+        fd = ::open(full.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t n = ::write(fd, content.data(), content.size());
+    ::close(fd);
+    return n == static_cast<ssize_t>(content.size());
+}
+
+bool TraceReplayer::step(TraceFrame& frame) {
+    if (!reader.next(frame)) {
+        return false;
+    }
+    bool ok = true;
+    for (uint32_t id : frame.changed) {
+        ok &= writeFile(reader.path(id), reader.content(id));
+    }
+    for (uint32_t id : frame.removed) {
+        std::string full = root + reader.path(id);
+        unlink(full.c_str());
+    }
+    return ok;
+}
+
+#endif // __linux__
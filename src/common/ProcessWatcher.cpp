@@ -0,0 +1,403 @@
+// src/common/ProcessWatcher.cpp - Event-driven process discovery
+#if defined(__linux__)
+#include "ProcessWatcher.h"
+#include "ProcFs.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+namespace {
+
+// TASK_COMM_LEN - 1: comm is truncated to 15 characters
+constexpr size_t kCommLength = 15;
+
+// exec() keeps the first 15 characters of a long name, but Android names
+// app processes after the package and keeps the last 15 ("m.roblox.client").
+bool commMatches(std::string_view comm, std::string_view wanted) {
+    if (wanted.size() <= kCommLength) {
+        return comm == wanted;
+    }
+    return comm == wanted.substr(wanted.size() - kCommLength) || comm == wanted.substr(0, kCommLength);
+}
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool parsePid(const char* name, pid_t& pid) {
+    if (*name < '1' || *name > '9') {
+        return false;
+    }
+    long value = 0;
+    for (const char* p = name; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    pid = static_cast<pid_t>(value);
+    return true;
+}
+
+// Names a process carries between fork and its final identity: Android
+// apps are forked from the zygote (or an unspecialized app process) and
+// only take their package name after specialization.
+bool isTransientName(std::string_view comm) {
+    return comm == "zygote" || comm == "zygote64" || comm == "usap32" || comm == "usap64" ||
+           comm == "<pre-initialized>";
+}
+
+std::string_view baseName(std::string_view path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+ProcessWatcher::ProcessWatcher(const std::string& rootPrefix)
+    : mode(Mode::Stopped), running(false), netlinkFd(-1), wakePipe{-1, -1},
+      scanIntervalMs(1000), eventLoop(nullptr), loopTask(0), root(rootPrefix) {}
+
+ProcessWatcher::~ProcessWatcher() {
+    stop();
+}
+
+void ProcessWatcher::addTarget(const std::string& name) {
+    targets.push_back(name);
+}
+
+void ProcessWatcher::setCallbacks(StartCallback started, ExitCallback exited) {
+    onStart = std::move(started);
+    onExit = std::move(exited);
+}
+
+bool ProcessWatcher::openNetlink() {
+    netlinkFd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (netlinkFd < 0) {
+        return false;
+    }
+
+    sockaddr_nl addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    addr.nl_pid = 0;  // let the kernel pick a unique port id
+    if (bind(netlinkFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        closeNetlink();  // EPERM without CAP_NET_ADMIN
+        return false;
+    }
+
+    alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))];
+    std::memset(buffer, 0, sizeof(buffer));
+    auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = 0;
+    auto* message = reinterpret_cast<cn_msg*>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(proc_cn_mcast_op);
+    proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(message->data, &op, sizeof(op));
+
+    if (send(netlinkFd, header, header->nlmsg_len, 0) < 0) {
+        closeNetlink();
+        return false;
+    }
+    return true;
+}
+
+void ProcessWatcher::closeNetlink() {
+    if (netlinkFd >= 0) {
+        close(netlinkFd);
+        netlinkFd = -1;
+    }
+}
+
+bool ProcessWatcher::start(bool allowNetlink) {
+    if (isRunning()) {
+        return false;
+    }
+    if (pipe2(wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return false;
+    }
+    // Subscribe before the initial scan so nothing launched in between is missed.
+    bool netlink = allowNetlink && root.empty() && openNetlink();
+    mode.store(netlink ? Mode::Netlink : Mode::ProcScan, std::memory_order_release);
+    scanOnce();
+
+    running.store(true, std::memory_order_release);
+    worker = std::thread(&ProcessWatcher::run, this);
+    return true;
+}
+
+bool ProcessWatcher::start(EventLoop& loop, bool allowNetlink) {
+    if (isRunning()) {
+        return false;
+    }
+    bool netlink = allowNetlink && root.empty() && openNetlink();
+    mode.store(netlink ? Mode::Netlink : Mode::ProcScan, std::memory_order_release);
+    scanOnce();
+
+    running.store(true, std::memory_order_release);
+    eventLoop = &loop;
+    if (netlink) {
+        loopTask = loop.addFd("process.netlink", netlinkFd, EPOLLIN, [this](uint32_t) { drainNetlink(); });
+    }
+    if (!loopTask) {
+        closeNetlink();
+        mode.store(Mode::ProcScan, std::memory_order_release);
+        loopTask = loop.addPeriodic("process.scan", static_cast<uint32_t>(scanIntervalMs),
+                                    [this](uint64_t) { scanOnce(); });
+    }
+    return true;
+}
+
+void ProcessWatcher::stop() {
+    if (running.exchange(false) && wakePipe[1] >= 0) {
+        char byte = 0;
+        (void)write(wakePipe[1], &byte, 1);
+    }
+    if (loopTask) {
+        eventLoop->remove(loopTask);
+        loopTask = 0;
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    closeNetlink();
+    for (int& fd : wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    mode.store(Mode::Stopped, std::memory_order_release);
+}
+
+void ProcessWatcher::run() {
+    while (isRunning()) {
+        pollfd fds[2];
+        int count = 0;
+        fds[count++] = {wakePipe[0], POLLIN, 0};
+        if (netlinkFd >= 0) {
+            fds[count++] = {netlinkFd, POLLIN, 0};
+        }
+        int timeout = netlinkFd >= 0 ? -1 : scanIntervalMs;
+        int ready = poll(fds, count, timeout);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (!isRunning()) {
+            break;
+        }
+        if (netlinkFd < 0) {
+            scanOnce();
+        } else if (count > 1 && (fds[1].revents & (POLLIN | POLLERR))) {
+            drainNetlink();
+        }
+    }
+}
+
+void ProcessWatcher::drainNetlink() {
+    alignas(nlmsghdr) char buffer[8192];
+    for (;;) {
+        sockaddr_nl from;
+        socklen_t fromLength = sizeof(from);
+        ssize_t length = recvfrom(netlinkFd, buffer, sizeof(buffer), MSG_DONTWAIT,
+                                  reinterpret_cast<sockaddr*>(&from), &fromLength);
+        if (length < 0) {
+            if (errno == ENOBUFS) {
+                // Socket overran and events were lost; resynchronize from /proc.
+                scanOnce();
+                continue;
+            }
+            return;  // EAGAIN: drained
+        }
+        if (from.nl_pid != 0) {
+            continue;  // only trust messages from the kernel
+        }
+
+        auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+        for (; NLMSG_OK(header, static_cast<unsigned int>(length)); header = NLMSG_NEXT(header, length)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) {
+                continue;
+            }
+            auto* message = reinterpret_cast<cn_msg*>(NLMSG_DATA(header));
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+                continue;
+            }
+            auto* event = reinterpret_cast<proc_event*>(message->data);
+            switch (event->what) {
+            case proc_event::PROC_EVENT_EXEC:
+                handleCandidate(event->event_data.exec.process_tgid, true);
+                break;
+            case proc_event::PROC_EVENT_COMM:
+                // Zygote children are renamed (not exec'd) into their package
+                if (event->event_data.comm.process_pid == event->event_data.comm.process_tgid) {
+                    handleCandidate(event->event_data.comm.process_tgid, true);
+                }
+                break;
+            case proc_event::PROC_EVENT_EXIT:
+                if (event->event_data.exit.process_pid == event->event_data.exit.process_tgid) {
+                    handleExit(event->event_data.exit.process_tgid);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+bool ProcessWatcher::matchProcess(pid_t pid, std::string& name, bool& provisional) const {
+    provisional = false;
+    std::string base = root + "/proc/" + std::to_string(pid);
+
+    ProcFile commFile(base + "/comm", 64);
+    std::string_view comm = ProcParser::trimLine(commFile.read());
+    if (comm.empty()) {
+        return false;  // already gone
+    }
+    if (isTransientName(comm)) {
+        provisional = true;
+        return false;
+    }
+
+    ProcFile cmdlineFile(base + "/cmdline", 512);
+    std::string_view cmdline = cmdlineFile.read();
+    std::string_view argv0 = cmdline.substr(0, cmdline.find('\0'));
+
+    for (const auto& target : targets) {
+        std::string_view wanted(target);
+        if (argv0 == wanted || (!argv0.empty() && baseName(argv0) == wanted) ||
+            commMatches(comm, wanted)) {
+            name = target;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProcessWatcher::handleCandidate(pid_t pid, bool reclassify) {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (!reclassify && classified.count(pid)) {
+            return;
+        }
+    }
+
+    std::string name;
+    bool provisional = false;
+    bool isMatch = matchProcess(pid, name, provisional);
+
+    bool fire = false;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (!provisional) {
+            classified.insert(pid);
+        }
+        if (isMatch && matched.find(pid) == matched.end()) {
+            matched.emplace(pid, name);
+            fire = true;
+        }
+    }
+    if (fire && onStart) {
+        onStart(pid, name);
+    }
+}
+
+void ProcessWatcher::handleExit(pid_t pid) {
+    bool fire = false;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        classified.erase(pid);
+        fire = matched.erase(pid) > 0;
+    }
+    if (fire && onExit) {
+        onExit(pid);
+    }
+}
+
+void ProcessWatcher::scanOnce() {
+    PROFILE_SCOPE("watcher.scan");
+    std::lock_guard<std::mutex> scanLock(scanMutex);
+    std::string procPath = root + "/proc";
+    int procFd = open(procPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0) {
+        return;
+    }
+
+    presentPids.clear();
+    alignas(8) char buffer[16384];
+    for (;;) {
+        long n = syscall(SYS_getdents64, procFd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            pid_t pid = 0;
+            if (parsePid(entry->d_name, pid)) {
+                presentPids.push_back(pid);
+                handleCandidate(pid, false);
+            }
+        }
+    }
+    close(procFd);
+
+    // Anything matched or classified that vanished since the last pass has exited.
+    std::sort(presentPids.begin(), presentPids.end());
+    std::vector<pid_t> exited;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        for (auto it = classified.begin(); it != classified.end();) {
+            if (!std::binary_search(presentPids.begin(), presentPids.end(), *it)) {
+                it = classified.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (const auto& entry : matched) {
+            if (!std::binary_search(presentPids.begin(), presentPids.end(), entry.first)) {
+                exited.push_back(entry.first);
+            }
+        }
+    }
+    for (pid_t pid : exited) {
+        handleExit(pid);
+    }
+}
+
+std::vector<pid_t> ProcessWatcher::matchedPids() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    std::vector<pid_t> pids;
+    pids.reserve(matched.size());
+    for (const auto& entry : matched) {
+        pids.push_back(entry.first);
+    }
+    return pids;
+}
+
+bool ProcessWatcher::isMatched(pid_t pid) const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return matched.count(pid) > 0;
+}
+
+#endif // __linux__
@@ -0,0 +1,427 @@
+// src/common/ReclaimEngine.cpp - Proactive reclaim of background processes
+#if defined(__linux__)
+#include "ReclaimEngine.h"
+#include "PrivilegedHelper.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Syscalls added after 5.1 share one number on every architecture; older
+// NDK and libc headers lack them.
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_process_madvise
+#define SYS_process_madvise 440
+#endif
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT 21
+#endif
+
+namespace {
+
+// iovecs per process_madvise call (UIO_MAXIOV is 1024).
+constexpr size_t kMaxIovecs = 512;
+
+std::string_view nextField(std::string_view& line) {
+    while (!line.empty() && line.front() == ' ') {
+        line.remove_prefix(1);
+    }
+    size_t end = line.find(' ');
+    std::string_view field = line.substr(0, end);
+    line.remove_prefix(end == std::string_view::npos ? line.size() : end);
+    return field;
+}
+
+bool parseHex(std::string_view text, uint64_t& value) {
+    value = 0;
+    if (text.empty()) {
+        return false;
+    }
+    for (char c : text) {
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (digit < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint64_t>(digit);
+    }
+    return true;
+}
+
+// Private mappings worth paging out: guard pages have nothing resident,
+// the vdso family can't be reclaimed, and the stack is about to be used.
+bool pageOutCandidate(std::string_view perms, std::string_view path) {
+    if (perms.size() < 4 || perms[3] != 'p' || perms.substr(0, 3) == "---") {
+        return false;
+    }
+    return path != "[vvar]" && path != "[vdso]" && path != "[vsyscall]" && path != "[stack]";
+}
+
+} // namespace
+
+ReclaimEngine::ReclaimEngine(MemoryAccountant& memoryAccountant, const std::string& rootPrefix)
+    : accountant(memoryAccountant), root(rootPrefix), protectedPid(0), meminfoReader(rootPrefix),
+      pageSize(static_cast<uint64_t>(sysconf(_SC_PAGESIZE))), madviseUnavailable(false),
+      cgroupReclaimUnavailable(false) {}
+
+void ReclaimEngine::setOptions(const Options& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+}
+
+void ReclaimEngine::setProtectedPid(pid_t pid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    protectedPid = pid;
+    protectedCgroup = pid > 0 ? cgroupOf(pid) : std::string();
+}
+
+void ReclaimEngine::setExcludedPids(const std::vector<pid_t>& pids) {
+    std::lock_guard<std::mutex> lock(mutex);
+    excludedPids = std::unordered_set<pid_t>(pids.begin(), pids.end());
+}
+
+double ReclaimEngine::score(const ProcessMemory& memory, uint64_t nowMs) {
+    // RSS is what can be won; a higher oom_score_adj and a longer idle
+    // stretch make it less likely the pages are needed back soon.
+    double idleMs = memory.lastActiveMs && nowMs > memory.lastActiveMs ? static_cast<double>(nowMs - memory.lastActiveMs) : 0.0;
+    double adjFactor = 1.0 + std::max(memory.oomScoreAdj, 0) / 100.0;
+    double idleFactor = 1.0 + std::min(idleMs, 600000.0) / 60000.0;
+    return memory.rss / (1024.0 * 1024.0) * adjFactor * idleFactor;
+}
+
+std::vector<ReclaimCandidate> ReclaimEngine::rankCandidates(uint64_t nowMs) {
+    Options current;
+    pid_t game;
+    std::unordered_set<pid_t> excluded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = options;
+        game = protectedPid;
+        excluded = excludedPids;
+    }
+    std::vector<ReclaimCandidate> candidates;
+    for (const ProcessMemory& memory : accountant.snapshot()) {
+        // oom_score_adj only arrives with the detail tier; unmeasured
+        // processes wait for it rather than being assumed expendable.
+        if (memory.pid == game || memory.pid == getpid() || excluded.count(memory.pid) || !memory.hasDetail ||
+            memory.oomScoreAdj < current.minOomScoreAdj || memory.uid < current.minUid ||
+            memory.rss < current.minRssBytes) {
+            continue;
+        }
+        ReclaimCandidate candidate;
+        candidate.pid = memory.pid;
+        candidate.name = memory.name;
+        candidate.oomScoreAdj = memory.oomScoreAdj;
+        candidate.rss = memory.rss;
+        candidate.idleMs = memory.lastActiveMs && nowMs > memory.lastActiveMs ? nowMs - memory.lastActiveMs : 0;
+        candidate.score = score(memory, nowMs);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = history.find(memory.pid);
+        if (it != history.end() && it->second.startTime == memory.startTime &&
+            nowMs - it->second.reclaimedMs < current.cooldownMs &&
+            memory.rss < std::max(it->second.rssAfter, current.minRssBytes) * (1.0 + current.regrowPercent / 100.0)) {
+            continue;
+        }
+        candidates.push_back(candidate);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const ReclaimCandidate& a, const ReclaimCandidate& b) { return a.score > b.score; });
+    return candidates;
+}
+
+bool ReclaimEngine::readAvailablePercent(double& percent) {
+    MemInfo memory;
+    if (!meminfoReader.readMemInfo(memory) || memory.memTotal == 0) {
+        return false;
+    }
+    percent = 100.0 * memory.memAvailable / memory.memTotal;
+    return true;
+}
+
+bool ReclaimEngine::readResident(pid_t pid, uint64_t& bytes) {
+    TaskStatm statm;
+    if (!scratchFile.open(root + "/proc/" + std::to_string(pid) + "/statm", 256) ||
+        !ProcParser::parseTaskStatm(scratchFile.read(), statm)) {
+        scratchFile.close();
+        return false;
+    }
+    scratchFile.close();
+    bytes = statm.residentPages * pageSize;
+    return true;
+}
+
+std::string ReclaimEngine::cgroupOf(pid_t pid) {
+    // cgroup v2 is the "0::<path>" line; v1-only systems have none.
+    if (!scratchFile.open(root + "/proc/" + std::to_string(pid) + "/cgroup", 1024)) {
+        return std::string();
+    }
+    std::string_view text = scratchFile.read();
+    std::string path;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        if (line.compare(0, 3, "0::") == 0) {
+            path.assign(line.substr(3));
+            break;
+        }
+    }
+    scratchFile.close();
+    return path;
+}
+
+bool ReclaimEngine::soleMember(const std::string& cgroup, pid_t pid) {
+    if (cgroup.empty() || cgroup == "/") {
+        return false;
+    }
+    // Reclaiming an ancestor of the game's cgroup would reclaim the game.
+    if (!protectedCgroup.empty() && protectedCgroup.compare(0, cgroup.size(), cgroup) == 0 &&
+        (protectedCgroup.size() == cgroup.size() || protectedCgroup[cgroup.size()] == '/')) {
+        return false;
+    }
+    if (!scratchFile.open(root + "/sys/fs/cgroup" + cgroup + "/cgroup.procs", 256)) {
+        return false;
+    }
+    std::string_view text = ProcParser::trimLine(scratchFile.read());
+    uint64_t member = 0;
+    bool sole = text.find('\n') == std::string_view::npos && ProcParser::parseUnsigned(text, member) &&
+                member == static_cast<uint64_t>(pid);
+    scratchFile.close();
+    return sole;
+}
+
+bool ReclaimEngine::reclaimCgroup(const std::string& cgroup, uint64_t bytes) {
+    std::string path = root + "/sys/fs/cgroup" + cgroup + "/memory.reclaim";
+    std::string value = std::to_string(bytes);
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            cgroupReclaimUnavailable = true;   // kernel < 5.19 or memcg v1
+            return false;
+        }
+        if ((errno == EACCES || errno == EPERM) && options.allowHelper) {
+            return PrivilegedHelper::getInstance()->execute(HelperCommand::writeFile(path, value)).success;
+        }
+        return false;
+    }
+    // Blocks while the kernel reclaims; EAGAIN means it fell short of the
+    // full amount, which still counts - the RSS drop is measured after.
+    ssize_t n = write(fd, value.data(), value.size());
+    int error = errno;
+    close(fd);
+    PROFILE_COUNT(ProfileCounter::Syscalls, 2);
+    stats.cgroupReclaims++;
+    return n >= 0 || error == EAGAIN;
+}
+
+bool ReclaimEngine::pageOut(pid_t pid, uint64_t maxBytes, uint64_t deadlineNs) {
+    if (madviseUnavailable) {
+        return false;
+    }
+    if (!scratchFile.open(root + "/proc/" + std::to_string(pid) + "/maps", 64 * 1024)) {
+        return false;
+    }
+    std::string_view text = scratchFile.read();
+    int pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+    if (pidfd < 0) {
+        madviseUnavailable = errno == ENOSYS;
+        scratchFile.close();
+        return false;
+    }
+
+    // Whole mappings are advised: a mapping's span says nothing about how
+    // much of it is resident (ART and the JIT reserve far more than they
+    // touch), so progress is measured instead. statm is re-read after
+    // every batch, and a batch ends once its span could cover maxBytes.
+    ProcFile statm(root + "/proc/" + std::to_string(pid) + "/statm", 256);
+    auto resident = [&]() -> uint64_t {
+        TaskStatm usage;
+        return ProcParser::parseTaskStatm(statm.read(), usage) ? usage.residentPages * pageSize : 0;
+    };
+    uint64_t before = resident();
+    iovec ranges[kMaxIovecs];
+    size_t count = 0;
+    uint64_t batchSpan = 0;
+    bool advised = false;
+    bool failed = false;
+    bool done = false;
+    auto flush = [&]() {
+        if (count == 0) {
+            return;
+        }
+        long n = syscall(SYS_process_madvise, pidfd, ranges, count, MADV_PAGEOUT, 0);
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        stats.madviseCalls++;
+        if (n < 0) {
+            // ENOSYS/EINVAL: no process_madvise or no MADV_PAGEOUT; EPERM:
+            // no CAP_SYS_NICE. None of them change while we run.
+            if (errno == ENOSYS || errno == EINVAL || errno == EPERM) {
+                madviseUnavailable = true;
+            }
+            failed = true;
+        } else {
+            advised = true;
+            uint64_t now = resident();
+            done = before > now && before - now >= maxBytes;
+        }
+        count = 0;
+        batchSpan = 0;
+    };
+
+    while (!text.empty() && !failed && !done) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+        // start-end perms offset dev inode [path]
+        std::string_view range = nextField(line);
+        std::string_view perms = nextField(line);
+        nextField(line);
+        nextField(line);
+        nextField(line);
+        std::string_view path = ProcParser::trimLine(line);
+        size_t dash = range.find('-');
+        uint64_t start = 0;
+        uint64_t stop = 0;
+        if (dash == std::string_view::npos || !parseHex(range.substr(0, dash), start) ||
+            !parseHex(range.substr(dash + 1), stop) || stop <= start || !pageOutCandidate(perms, path)) {
+            continue;
+        }
+        ranges[count].iov_base = reinterpret_cast<void*>(start);
+        ranges[count].iov_len = static_cast<size_t>(stop - start);
+        count++;
+        batchSpan += stop - start;
+        if (count == kMaxIovecs || batchSpan >= maxBytes) {
+            flush();
+            if (SelfProfiler::nowNanos() >= deadlineNs) {
+                break;
+            }
+        }
+    }
+    flush();
+    close(pidfd);
+    scratchFile.close();
+    return advised;
+}
+
+bool ReclaimEngine::reclaimLocked(pid_t pid, uint64_t maxBytes, uint64_t deadlineNs, uint64_t& reclaimed,
+                                  ReclaimMethod& used) {
+    reclaimed = 0;
+    used = ReclaimMethod::None;
+    uint64_t before = 0;
+    if (pid <= 0 || pid == protectedPid || excludedPids.count(pid) || !readResident(pid, before)) {
+        return false;
+    }
+    std::string cgroup = cgroupReclaimUnavailable ? std::string() : cgroupOf(pid);
+    if (!cgroup.empty() && soleMember(cgroup, pid) && reclaimCgroup(cgroup, std::min(maxBytes, before))) {
+        used = ReclaimMethod::CgroupReclaim;
+    } else if (pageOut(pid, maxBytes, deadlineNs)) {
+        used = ReclaimMethod::ProcessMadvise;
+    } else {
+        stats.failures++;
+        return false;
+    }
+    uint64_t after = before;
+    readResident(pid, after);
+    reclaimed = before > after ? before - after : 0;
+    stats.processesReclaimed++;
+    stats.bytesReclaimed += reclaimed;
+    return true;
+}
+
+ReclaimTickResult ReclaimEngine::tick(uint64_t nowMs) {
+    PROFILE_SCOPE("reclaim.tick");
+    ReclaimTickResult result;
+    uint64_t startNs = SelfProfiler::nowNanos();
+    std::vector<ReclaimCandidate> candidates = rankCandidates(nowMs);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.ticks++;
+    uint64_t deadlineNs = startNs + static_cast<uint64_t>(options.maxTickMs) * 1000000;
+    uint64_t budget = options.maxBytesPerTick;
+    for (const ReclaimCandidate& candidate : candidates) {
+        if (readAvailablePercent(result.memAvailablePercent) &&
+            result.memAvailablePercent >= options.targetAvailablePercent) {
+            result.targetMet = true;
+            break;
+        }
+        if (result.processes >= static_cast<int>(options.maxProcessesPerTick) || budget == 0 ||
+            SelfProfiler::nowNanos() >= deadlineNs) {
+            break;
+        }
+        uint64_t request = std::min(budget, candidate.rss);
+        uint64_t reclaimed = 0;
+        ReclaimMethod used = ReclaimMethod::None;
+        if (!reclaimLocked(candidate.pid, request, deadlineNs, reclaimed, used)) {
+            continue;
+        }
+        // What was reclaimed, not what was asked for: a process that gave
+        // up little leaves the budget to the next one.
+        budget -= std::min(budget, reclaimed);
+        result.processes++;
+        result.bytesRequested += request;
+        result.bytesReclaimed += reclaimed;
+
+        ProcessMemory memory;
+        History& entry = history[candidate.pid];
+        entry.startTime = accountant.get(candidate.pid, memory) ? memory.startTime : 0;
+        entry.reclaimedMs = nowMs;
+        entry.rssAfter = candidate.rss > reclaimed ? candidate.rss - reclaimed : 0;
+    }
+    if (!result.targetMet && readAvailablePercent(result.memAvailablePercent)) {
+        result.targetMet = result.memAvailablePercent >= options.targetAvailablePercent;
+    }
+    // Forget processes the accountant no longer tracks.
+    for (auto it = history.begin(); it != history.end();) {
+        ProcessMemory memory;
+        if (!accountant.get(it->first, memory) || memory.startTime != it->second.startTime) {
+            it = history.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    result.elapsedUs = (SelfProfiler::nowNanos() - startNs) / 1000;
+    return result;
+}
+
+bool ReclaimEngine::reclaimProcess(pid_t pid, uint64_t maxBytes, uint64_t& reclaimed, ReclaimMethod* used) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ReclaimMethod method = ReclaimMethod::None;
+    uint64_t deadlineNs = SelfProfiler::nowNanos() + static_cast<uint64_t>(options.maxTickMs) * 1000000;
+    bool ok = reclaimLocked(pid, maxBytes, deadlineNs, reclaimed, method);
+    if (used) {
+        *used = method;
+    }
+    return ok;
+}
+
+ReclaimStats ReclaimEngine::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+bool ReclaimEngine::isAvailable() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !madviseUnavailable || !cgroupReclaimUnavailable;
+}
+
+const char* ReclaimEngine::methodName(ReclaimMethod method) {
+    switch (method) {
+    case ReclaimMethod::CgroupReclaim: return "memory.reclaim";
+    case ReclaimMethod::ProcessMadvise: return "process_madvise";
+    default: return "none";
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,379 @@
+// src/common/RunqueueLatency.cpp - Run-queue delay histograms for a process's threads
+#if defined(__linux__)
+#include "RunqueueLatency.h"
+#include "SelfProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+bool parseTid(const char* name, int32_t& tid) {
+    int32_t value = 0;
+    if (*name == '\0') {
+        return false;
+    }
+    for (const char* p = name; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    tid = value;
+    return true;
+}
+
+uint64_t delta(uint64_t now, uint64_t before) {
+    return now >= before ? now - before : 0;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// LatencyHistogram
+
+LatencyHistogram::LatencyHistogram(uint32_t resolutionBits)
+    : bits(std::min(resolutionBits, kMaxResolutionBits)),
+      buckets(static_cast<size_t>(kMaxExponent - std::min(resolutionBits, kMaxResolutionBits) + 2)
+              << std::min(resolutionBits, kMaxResolutionBits), 0),
+      total(0),
+      maxUs(0),
+      sumUs(0.0) {}
+
+uint32_t LatencyHistogram::bucketIndex(uint64_t valueUs) const {
+    const uint64_t subBuckets = 1ull << bits;
+    if (valueUs < subBuckets) {
+        return static_cast<uint32_t>(valueUs);
+    }
+    uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(valueUs));
+    if (exponent > kMaxExponent) {
+        return static_cast<uint32_t>(buckets.size() - 1);
+    }
+    uint32_t sub = static_cast<uint32_t>(valueUs >> (exponent - bits)) & static_cast<uint32_t>(subBuckets - 1);
+    return (exponent - bits + 1) * static_cast<uint32_t>(subBuckets) + sub;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t index) const {
+    const uint64_t subBuckets = 1ull << bits;
+    if (index < subBuckets) {
+        return index;
+    }
+    uint32_t exponent = static_cast<uint32_t>(index >> bits) + bits - 1;
+    uint64_t sub = index & (subBuckets - 1);
+    return (subBuckets + sub) << (exponent - bits);
+}
+
+void LatencyHistogram::record(uint64_t valueUs, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    buckets[bucketIndex(valueUs)] += count;
+    total += count;
+    sumUs += static_cast<double>(valueUs) * count;
+    maxUs = std::max(maxUs, valueUs);
+}
+
+bool LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.bits != bits) {
+        return false;
+    }
+    for (size_t i = 0; i < buckets.size(); i++) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    sumUs += other.sumUs;
+    maxUs = std::max(maxUs, other.maxUs);
+    return true;
+}
+
+void LatencyHistogram::clear() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    total = 0;
+    maxUs = 0;
+    sumUs = 0.0;
+}
+
+uint64_t LatencyHistogram::quantile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t lower = bucketLowerBound(i);
+            uint64_t upper = i + 1 < buckets.size() ? bucketLowerBound(i + 1) : lower;
+            uint64_t mid = lower + (upper - lower) / 2;
+            return mid < maxUs ? mid : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+// ---------------------------------------------------------------------------
+// RunqueueProbe
+
+RunqueueProbe::RunqueueProbe(const std::string& rootPrefix)
+    : root(rootPrefix),
+      targetPid(0),
+      taskDirFd(-1),
+      lastRescanMs(0),
+      windowStartMs(0),
+      processWindow(options.resolutionBits),
+      processRunMs(0.0),
+      processWaitMs(0.0),
+      overWindows(0),
+      underWindows(0),
+      starved(false),
+      cumulative(options.resolutionBits),
+      cumulativeRunMs(0.0),
+      cumulativeWaitMs(0.0) {}
+
+RunqueueProbe::~RunqueueProbe() {
+    detach();
+}
+
+void RunqueueProbe::setOptions(const Options& newOptions) {
+    options = newOptions;
+    options.windowMs = std::max<uint32_t>(options.windowMs, 100);
+    options.resolutionBits = std::min(options.resolutionBits, LatencyHistogram::kMaxResolutionBits);
+    options.alertWindows = std::max<uint32_t>(options.alertWindows, 1);
+    options.maxThreads = std::max<uint32_t>(options.maxThreads, 1);
+}
+
+bool RunqueueProbe::attach(pid_t pid) {
+    detach();
+    if (pid <= 0) {
+        return false;
+    }
+    std::string taskDir = root + "/proc/" + std::to_string(pid) + "/task";
+    taskDirFd = open(taskDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskDirFd < 0) {
+        return false;
+    }
+    targetPid = pid;
+    processWindow = LatencyHistogram(options.resolutionBits);
+    std::lock_guard<std::mutex> lock(mutex);
+    cumulative = LatencyHistogram(options.resolutionBits);
+    return true;
+}
+
+void RunqueueProbe::detach() {
+    if (taskDirFd >= 0) {
+        close(taskDirFd);
+        taskDirFd = -1;
+    }
+    targetPid = 0;
+    lastRescanMs = 0;
+    windowStartMs = 0;
+    threads.clear();
+    processWindow.clear();
+    processRunMs = 0.0;
+    processWaitMs = 0.0;
+    overWindows = 0;
+    underWindows = 0;
+    starved = false;
+    std::lock_guard<std::mutex> lock(mutex);
+    cumulative.clear();
+    cumulativeRunMs = 0.0;
+    cumulativeWaitMs = 0.0;
+    published = RunqueueReport();
+}
+
+void RunqueueProbe::resetCumulative() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cumulative.clear();
+    cumulativeRunMs = 0.0;
+    cumulativeWaitMs = 0.0;
+}
+
+void RunqueueProbe::rescan(uint64_t nowMs) {
+    PROFILE_SCOPE("runqueue.rescan");
+    lastRescanMs = nowMs;
+    alignas(8) char buffer[4096];
+    lseek(taskDirFd, 0, SEEK_SET);
+    for (;;) {
+        long n = syscall(SYS_getdents64, taskDirFd, buffer, sizeof(buffer));
+        PROFILE_COUNT(ProfileCounter::Syscalls, 1);
+        if (n <= 0) {
+            break;
+        }
+        for (long offset = 0; offset < n && threads.size() < options.maxThreads;) {
+            auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            int32_t tid = 0;
+            if (!parseTid(entry->d_name, tid) ||
+                std::any_of(threads.begin(), threads.end(),
+                            [tid](const std::unique_ptr<ThreadState>& t) { return t->tid == tid; })) {
+                continue;
+            }
+            std::string taskPath = root + "/proc/" + std::to_string(targetPid) + "/task/" + entry->d_name;
+            auto thread = std::make_unique<ThreadState>(options.resolutionBits);
+            thread->tid = tid;
+            // The first read is the baseline; the thread contributes from
+            // the next sample on.
+            if (!thread->file.open(taskPath + "/schedstat", 128) ||
+                !ProcParser::parseSchedstat(thread->file.read(), thread->last)) {
+                continue;
+            }
+            ProcFile comm(taskPath + "/comm", 64);
+            std::string_view name = ProcParser::trimLine(comm.read());
+            std::memcpy(thread->comm, name.data(), std::min(name.size(), sizeof(thread->comm) - 1));
+            threads.push_back(std::move(thread));
+        }
+    }
+}
+
+RunqueueStats RunqueueProbe::summarize(const LatencyHistogram& histogram, double runMs, double waitMs) {
+    RunqueueStats stats;
+    stats.events = histogram.count();
+    stats.runMs = runMs;
+    stats.waitMs = waitMs;
+    stats.waitShare = runMs + waitMs > 0.0 ? waitMs / (runMs + waitMs) : 0.0;
+    stats.meanUs = histogram.mean();
+    stats.p50Us = static_cast<double>(histogram.quantile(0.50));
+    stats.p90Us = static_cast<double>(histogram.quantile(0.90));
+    stats.p99Us = static_cast<double>(histogram.quantile(0.99));
+    stats.maxUs = static_cast<double>(histogram.max());
+    return stats;
+}
+
+void RunqueueProbe::closeWindow(uint64_t nowMs) {
+    RunqueueReport report;
+    report.valid = true;
+    report.timestampMs = nowMs;
+    report.windowMs = static_cast<uint32_t>(nowMs - windowStartMs);
+    report.process = summarize(processWindow, processRunMs, processWaitMs);
+    for (const auto& thread : threads) {
+        if (thread->window.count() == 0) {
+            continue;
+        }
+        RunqueueStats stats = summarize(thread->window, thread->runMs, thread->waitMs);
+        stats.tid = thread->tid;
+        std::memcpy(stats.comm, thread->comm, sizeof(stats.comm));
+        report.threads.push_back(stats);
+        thread->window.clear();
+        thread->runMs = 0.0;
+        thread->waitMs = 0.0;
+    }
+    std::sort(report.threads.begin(), report.threads.end(),
+              [](const RunqueueStats& a, const RunqueueStats& b) { return a.p99Us > b.p99Us; });
+
+    // Too few events and p99 is just the max of a handful of samples.
+    bool changed = false;
+    if (report.process.events >= options.minEvents) {
+        bool over = report.process.p99Us > options.p99ThresholdUs;
+        overWindows = over ? overWindows + 1 : 0;
+        underWindows = over ? 0 : underWindows + 1;
+        if (!starved && overWindows >= options.alertWindows) {
+            starved = changed = true;
+        } else if (starved && underWindows >= options.alertWindows) {
+            starved = false;
+            changed = true;
+        }
+    }
+    report.starved = starved;
+
+    RunqueueAlert alert;
+    if (changed) {
+        alert.starved = starved;
+        alert.pid = targetPid;
+        alert.p99Us = report.process.p99Us;
+        alert.thresholdUs = options.p99ThresholdUs;
+        alert.timestampMs = nowMs;
+        if (!report.threads.empty()) {
+            alert.worstTid = report.threads.front().tid;
+            std::memcpy(alert.worstComm, report.threads.front().comm, sizeof(alert.worstComm));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cumulative.merge(processWindow);
+        cumulativeRunMs += processRunMs;
+        cumulativeWaitMs += processWaitMs;
+        report.cumulative = summarize(cumulative, cumulativeRunMs, cumulativeWaitMs);
+        published = std::move(report);
+    }
+    processWindow.clear();
+    processRunMs = 0.0;
+    processWaitMs = 0.0;
+    windowStartMs = nowMs;
+
+    if (changed && onAlert) {
+        onAlert(alert);
+    }
+}
+
+bool RunqueueProbe::sample(uint64_t nowMs) {
+    PROFILE_SCOPE("runqueue.sample");
+    if (taskDirFd < 0) {
+        return false;
+    }
+    if (windowStartMs == 0) {
+        windowStartMs = nowMs;
+    }
+    if (threads.empty() || nowMs - lastRescanMs >= options.rescanIntervalMs) {
+        rescan(nowMs);
+    }
+
+    for (auto it = threads.begin(); it != threads.end();) {
+        ThreadState& thread = **it;
+        TaskSchedstat now;
+        if (!ProcParser::parseSchedstat(thread.file.read(), now)) {
+            it = threads.erase(it);   // exited; its samples stay in the process window
+            continue;
+        }
+        uint64_t slices = delta(now.timeslices, thread.last.timeslices);
+        uint64_t waitNs = delta(now.waitNs, thread.last.waitNs);
+        double runMs = delta(now.runNs, thread.last.runNs) / 1e6;
+        thread.last = now;
+        thread.runMs += runMs;
+        thread.waitMs += waitNs / 1e6;
+        processRunMs += runMs;
+        processWaitMs += waitNs / 1e6;
+        if (slices > 0) {
+            uint64_t meanUs = (waitNs / slices + 500) / 1000;
+            thread.window.record(meanUs, slices);
+            processWindow.record(meanUs, slices);
+        }
+        ++it;
+    }
+
+    if (nowMs - windowStartMs < options.windowMs) {
+        return false;
+    }
+    closeWindow(nowMs);
+    return true;
+}
+
+RunqueueReport RunqueueProbe::report() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return published;
+}
+
+bool RunqueueProbe::latest(RunqueueStats& out, bool* starvedOut) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!published.valid) {
+        return false;
+    }
+    out = published.process;
+    if (starvedOut) {
+        *starvedOut = published.starved;
+    }
+    return true;
+}
+
+#endif // __linux__
@@ -0,0 +1,276 @@
+// src/common/SelfProfiler.cpp - Self-overhead timers, histograms and counters
+#include "SelfProfiler.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Site {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::atomic<uint64_t> buckets[SelfProfiler::kBucketCount];
+};
+
+// Zero-initialised static storage; untouched sites cost no resident memory.
+Site g_sites[SelfProfiler::kMaxSites];
+std::atomic<uint32_t> g_siteCount{0};
+std::mutex g_registerMutex;
+
+std::atomic<uint64_t> g_counters[static_cast<int>(ProfileCounter::kCount)];
+
+const char* kCounterNames[] = {"syscalls", "forks", "bytes_read", "bytes_written"};
+
+// Uptime counts from library load.
+const uint64_t g_startNs = SelfProfiler::nowNanos();
+std::atomic<double> g_budgetPercent{0.0};
+
+uint64_t quantile(const Site& site, uint64_t total, double fraction, uint64_t maxNs) {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < SelfProfiler::kBucketCount; i++) {
+        seen += site.buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Midpoint of the bucket, never past the largest sample seen.
+            uint64_t lower = SelfProfiler::bucketLowerBound(i);
+            uint64_t upper = i + 1 < SelfProfiler::kBucketCount ? SelfProfiler::bucketLowerBound(i + 1) : lower;
+            uint64_t mid = lower + (upper - lower) / 2;
+            return mid < maxNs ? mid : maxNs;
+        }
+    }
+    return maxNs;
+}
+
+void fillStats(const Site& site, const char* name, ProfileSiteStats& out) {
+    out.name = name;
+    out.count = site.count.load(std::memory_order_relaxed);
+    out.totalNs = site.totalNs.load(std::memory_order_relaxed);
+    out.maxNs = site.maxNs.load(std::memory_order_relaxed);
+    // Buckets and count are updated independently; quantiles use the
+    // buckets' own total so a concurrent record() can't skew the rank.
+    uint64_t bucketTotal = 0;
+    for (uint32_t i = 0; i < SelfProfiler::kBucketCount; i++) {
+        bucketTotal += site.buckets[i].load(std::memory_order_relaxed);
+    }
+    out.p50Ns = quantile(site, bucketTotal, 0.50, out.maxNs);
+    out.p90Ns = quantile(site, bucketTotal, 0.90, out.maxNs);
+    out.p99Ns = quantile(site, bucketTotal, 0.99, out.maxNs);
+}
+
+void formatDuration(char* buffer, size_t size, uint64_t ns) {
+    if (ns < 10000) {
+        std::snprintf(buffer, size, "%" PRIu64 "ns", ns);
+    } else if (ns < 10000000) {
+        std::snprintf(buffer, size, "%.1fus", ns / 1e3);
+    } else {
+        std::snprintf(buffer, size, "%.1fms", ns / 1e6);
+    }
+}
+
+} // namespace
+
+uint32_t SelfProfiler::registerSite(const char* name) {
+    std::lock_guard<std::mutex> lock(g_registerMutex);
+    uint32_t existing = g_siteCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < existing; i++) {
+        if (std::strcmp(g_sites[i].name.load(std::memory_order_relaxed), name) == 0) {
+            return i;
+        }
+    }
+    if (existing >= kMaxSites) {
+        return kInvalidSite;
+    }
+    g_sites[existing].name.store(name, std::memory_order_relaxed);
+    g_siteCount.store(existing + 1, std::memory_order_release);
+    return existing;
+}
+
+uint32_t SelfProfiler::bucketIndex(uint64_t valueNs) {
+    if (valueNs < kSubBuckets) {
+        return static_cast<uint32_t>(valueNs);
+    }
+    uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(valueNs));
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    uint32_t sub = static_cast<uint32_t>(valueNs >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t SelfProfiler::bucketLowerBound(uint32_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    uint32_t exponent = index / kSubBuckets + kSubBucketBits - 1;
+    uint64_t sub = index % kSubBuckets;
+    return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+}
+
+void SelfProfiler::record(uint32_t site, uint64_t elapsedNs) {
+    if (site >= kMaxSites) {
+        return;
+    }
+    Site& s = g_sites[site];
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.totalNs.fetch_add(elapsedNs, std::memory_order_relaxed);
+    s.buckets[bucketIndex(elapsedNs)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t previous = s.maxNs.load(std::memory_order_relaxed);
+    while (elapsedNs > previous &&
+           !s.maxNs.compare_exchange_weak(previous, elapsedNs, std::memory_order_relaxed)) {
+    }
+}
+
+void SelfProfiler::count(ProfileCounter counter, uint64_t amount) {
+    g_counters[static_cast<int>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t SelfProfiler::counterValue(ProfileCounter counter) {
+    return g_counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+}
+
+bool SelfProfiler::siteStats(const char* name, ProfileSiteStats& out) {
+    uint32_t sites = g_siteCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < sites; i++) {
+        const char* siteName = g_sites[i].name.load(std::memory_order_relaxed);
+        if (std::strcmp(siteName, name) == 0) {
+            fillStats(g_sites[i], siteName, out);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SelfProfiler::sampleUsage(SelfUsage& out, UsageBaseline& baseline) {
+    out = SelfUsage();
+#if defined(__linux__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return false;
+    }
+    out.cpuTimeUs = static_cast<uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+                    static_cast<uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+    out.maxRssBytes = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    out.voluntarySwitches = static_cast<uint64_t>(usage.ru_nvcsw);
+    out.involuntarySwitches = static_cast<uint64_t>(usage.ru_nivcsw);
+
+    // statm: size resident shared ... in pages
+    int fd = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        char buffer[128];
+        ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (n > 0) {
+            buffer[n] = '\0';
+            unsigned long long size = 0;
+            unsigned long long resident = 0;
+            if (std::sscanf(buffer, "%llu %llu", &size, &resident) == 2) {
+                out.rssBytes = resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+            }
+        }
+    }
+
+    uint64_t now = nowNanos();
+    uint64_t uptimeNs = now - g_startNs;
+    out.uptimeMs = uptimeNs / 1000000;
+    if (uptimeNs > 0) {
+        out.cpuPercent = 100.0 * (out.cpuTimeUs * 1000.0) / uptimeNs;
+    }
+    uint64_t sinceNs = now - (baseline.sampleNs ? baseline.sampleNs : g_startNs);
+    uint64_t cpuDeltaUs = out.cpuTimeUs - (baseline.sampleNs ? baseline.cpuTimeUs : 0);
+    out.recentCpuPercent = sinceNs ? 100.0 * (cpuDeltaUs * 1000.0) / sinceNs : 0.0;
+    baseline.sampleNs = now;
+    baseline.cpuTimeUs = out.cpuTimeUs;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SelfProfiler::snapshot(ProfileReport& out, UsageBaseline& baseline) {
+    out.sites.clear();
+    uint32_t sites = g_siteCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < sites; i++) {
+        if (g_sites[i].count.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        ProfileSiteStats stats;
+        fillStats(g_sites[i], g_sites[i].name.load(std::memory_order_relaxed), stats);
+        out.sites.push_back(stats);
+    }
+    for (int i = 0; i < static_cast<int>(ProfileCounter::kCount); i++) {
+        out.counters[i] = g_counters[i].load(std::memory_order_relaxed);
+    }
+    sampleUsage(out.usage, baseline);
+    out.budgetPercent = g_budgetPercent.load(std::memory_order_relaxed);
+    out.overBudget = out.budgetPercent > 0.0 && out.usage.recentCpuPercent > out.budgetPercent;
+}
+
+void SelfProfiler::setCpuBudgetPercent(double percent) {
+    g_budgetPercent.store(percent, std::memory_order_relaxed);
+}
+
+double SelfProfiler::getCpuBudgetPercent() {
+    return g_budgetPercent.load(std::memory_order_relaxed);
+}
+
+std::string SelfProfiler::formatReport(const ProfileReport& report) {
+    std::string text;
+    char line[256];
+    std::snprintf(line, sizeof(line), "Self CPU: %.2f%% of a core (recent %.2f%%), RSS %.1f MB\n",
+                  report.usage.cpuPercent, report.usage.recentCpuPercent, report.usage.rssBytes / (1024.0 * 1024.0));
+    text += line;
+    if (report.budgetPercent > 0.0) {
+        std::snprintf(line, sizeof(line), "Budget: %.2f%% of a core (%s)\n", report.budgetPercent,
+                      report.overBudget ? "exceeded" : "ok");
+        text += line;
+    }
+    for (const ProfileSiteStats& site : report.sites) {
+        char p50[16], p99[16], max[16];
+        formatDuration(p50, sizeof(p50), site.p50Ns);
+        formatDuration(p99, sizeof(p99), site.p99Ns);
+        formatDuration(max, sizeof(max), site.maxNs);
+        std::snprintf(line, sizeof(line), "%s: n=%" PRIu64 " p50=%s p99=%s max=%s total=%.1fms\n",
+                      site.name.c_str(), site.count, p50, p99, max, site.totalNs / 1e6);
+        text += line;
+    }
+    for (int i = 0; i < static_cast<int>(ProfileCounter::kCount); i++) {
+        std::snprintf(line, sizeof(line), "%s%s=%" PRIu64, i ? " " : "", kCounterNames[i], report.counters[i]);
+        text += line;
+    }
+    text += "\n";
+    return text;
+}
+
+void SelfProfiler::reset() {
+    uint32_t sites = g_siteCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < sites; i++) {
+        Site& s = g_sites[i];
+        s.count.store(0, std::memory_order_relaxed);
+        s.totalNs.store(0, std::memory_order_relaxed);
+        s.maxNs.store(0, std::memory_order_relaxed);
+        for (auto& bucket : s.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (auto& counter : g_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* SelfProfiler::counterName(ProfileCounter counter) {
+    int index = static_cast<int>(counter);
+    return index >= 0 && index < static_cast<int>(ProfileCounter::kCount) ? kCounterNames[index] : "unknown";
+}
@@ -1,35 +1,176 @@
-// src/common/Utils.cpp - Basic implementation
-#include <string>
-#include <vector>
+// src/common/Utils.cpp - Utility functions
+#include "Utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
 #include <sstream>
 
-class Utils {
-public:
-    static std::string trim(const std::string& str) {
-        size_t first = str.find_first_not_of(' ');
-        if (first == std::string::npos) return "";
-        size_t last = str.find_last_not_of(' ');
-        return str.substr(first, (last - first + 1));
-    }
-    
-    static std::vector<std::string> split(const std::string& str, char delimiter) {
-        std::vector<std::string> tokens;
-        std::stringstream ss(str);
-        std::string token;
-        while (std::getline(ss, token, delimiter)) {
-            tokens.push_back(token);
-        }
-        return tokens;
-    }
-    
-    static std::string formatBytes(uint64_t bytes) {
-        const char* units[] = {"B", "KB", "MB", "GB"};
-        int unit = 0;
-        double size = static_cast<double>(bytes);
-        while (size >= 1024 && unit < 3) {
-            size /= 1024;
-            unit++;
+#if defined(WINDOWS_BUILD)
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include "ProcFs.h"
+#endif
+
+namespace {
+
+const char kWhitespace[] = " \t\r\n\f\v";
+
+} // namespace
+
+std::string Utils::trim(const std::string& str) {
+    size_t first = str.find_first_not_of(kWhitespace);
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = str.find_last_not_of(kWhitespace);
+    return str.substr(first, last - first + 1);
+}
+
+// Same tokens as a std::getline loop (a trailing delimiter does not yield an
+// empty last token) without the stringstream and per-token reallocation.
+std::vector<std::string> Utils::split(const std::string& str, char delimiter) {
+    std::vector<std::string> tokens;
+    size_t start = 0;
+    const size_t length = str.size();
+    while (start < length) {
+        size_t end = str.find(delimiter, start);
+        if (end == std::string::npos) {
+            end = length;
         }
-        return std::to_string((int)size) + " " + units[unit];
+        tokens.emplace_back(str, start, end - start);
+        start = end + 1;
+    }
+    return tokens;
+}
+
+std::string Utils::toLowerCase(const std::string& str) {
+    std::string result(str);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::string Utils::toUpperCase(const std::string& str) {
+    std::string result(str);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return result;
+}
+
+bool Utils::fileExists(const std::string& path) {
+#if defined(WINDOWS_BUILD)
+    return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+#endif
+}
+
+std::string Utils::readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return "";
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+bool Utils::writeFile(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return static_cast<bool>(file);
+}
+
+std::string Utils::getCurrentTimestamp() {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    int millis = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+    std::tm local;
+#if defined(WINDOWS_BUILD)
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char buffer[32];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    std::snprintf(buffer + length, sizeof(buffer) - length, ".%03d", millis);
+    return buffer;
+}
+
+uint64_t Utils::getCurrentTimeMillis() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+std::string Utils::getExecutablePath() {
+#if defined(WINDOWS_BUILD)
+    char buffer[MAX_PATH];
+    DWORD length = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
+    return std::string(buffer, length);
+#else
+    char buffer[4096];
+    ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    if (length <= 0) {
+        return "";
+    }
+    return std::string(buffer, static_cast<size_t>(length));
+#endif
+}
+
+std::string Utils::getConfigDirectory() {
+#if defined(WINDOWS_BUILD)
+    const char* appData = std::getenv("APPDATA");
+    return std::string(appData ? appData : ".") + "\\RobloxOptimizer";
+#elif defined(ANDROID_BUILD)
+    return "/data/local/tmp";
+#else
+    const char* configHome = std::getenv("XDG_CONFIG_HOME");
+    if (configHome && *configHome) {
+        return std::string(configHome) + "/roblox-optimizer";
+    }
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.config/roblox-optimizer";
+#endif
+}
+
+std::string Utils::formatBytes(uint64_t bytes) {
+    const char* units[] = {"B", "KB", "MB", "GB"};
+    int unit = 0;
+    double size = static_cast<double>(bytes);
+    while (size >= 1024 && unit < 3) {
+        size /= 1024;
+        unit++;
+    }
+    return std::to_string(static_cast<int>(size)) + " " + units[unit];
+}
+
+uint64_t Utils::getAvailableMemory() {
+#if defined(WINDOWS_BUILD)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? status.ullAvailPhys : 0;
+#elif defined(__linux__)
+    MemInfo info;
+    if (!ProcFsReader().readMemInfo(info)) {
+        return 0;
     }
-};
+    return info.memAvailable;
+#else
+    return 0;
+#endif
+}
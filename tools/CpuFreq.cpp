@@ -0,0 +1,145 @@
+// tools/CpuFreq.cpp - Show, apply and restore cpufreq policies through CpuFreqController
+//
+//   RobloxOptimizerCpuFreq show
+//   RobloxOptimizerCpuFreq apply --governor performance --floor 30,60 --hold-s 10
+//   RobloxOptimizerCpuFreq apply --governor schedutil --root /tmp/fake-sysfs --keep --state /tmp/cpufreq.state
+//   RobloxOptimizerCpuFreq recover --root /tmp/fake-sysfs --state /tmp/cpufreq.state
+//
+// apply prints every policy before, while and after the change: the
+// targets go in as one transaction, are held for --hold-s, then
+// restored. --keep skips the restore and leaves the baseline in --state,
+// as a killed optimizer would, for recover to undo. --floor takes one
+// minimum-frequency percentage per cluster, the last repeated for the
+// rest. --root runs everything against a fake sysfs tree, e.g. one
+// made of policyN directories with scaling_governor, scaling_min_freq,
+// scaling_max_freq, cpuinfo_min_freq, cpuinfo_max_freq and related_cpus.
+#include "CpuFreqController.h"
+#include "Utils.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+void printPolicies(const char* label, const CpuFreqController& controller) {
+    std::printf("%s\n", label);
+    const std::vector<CpuFreqPolicy>& policies = controller.getPolicies();
+    for (size_t i = 0; i < policies.size(); i++) {
+        const CpuFreqPolicy& policy = policies[i];
+        std::string cpus;
+        for (int cpu : policy.cpus) {
+            cpus += (cpus.empty() ? "" : " ") + std::to_string(cpu);
+        }
+        CpuFreqPolicyState state;
+        if (!controller.readPolicyState(static_cast<int>(i), state)) {
+            std::printf("  policy%-2d cpus %-12s unreadable\n", policy.id, cpus.c_str());
+            continue;
+        }
+        std::printf("  policy%-2d cpus %-12s %-12s %8u - %8u kHz  (hardware %u - %u)\n", policy.id, cpus.c_str(),
+                    state.governor.c_str(), state.minFreq, state.maxFreq, policy.cpuinfoMinFreq,
+                    policy.cpuinfoMaxFreq);
+    }
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s show [--root DIR]\n"
+                 "       %s apply [--governor NAME] [--floor PCT[,PCT...]] [--hold-s N] [--keep]\n"
+                 "             [--root DIR] [--state FILE]\n"
+                 "       %s recover --state FILE [--root DIR]\n",
+                 argv0, argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::string command = argv[1];
+    std::string root;
+    std::string stateFile;
+    std::string governor;
+    std::vector<int> floors;
+    uint32_t holdSec = 5;
+    bool keep = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--keep") keep = true;
+        else if (arg == "--root" && hasValue) root = argv[++i];
+        else if (arg == "--state" && hasValue) stateFile = argv[++i];
+        else if (arg == "--governor" && hasValue) governor = argv[++i];
+        else if (arg == "--hold-s" && hasValue) holdSec = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        else if (arg == "--floor" && hasValue) {
+            for (const std::string& part : Utils::split(argv[++i], ',')) {
+                floors.push_back(std::max(0, std::min(100, std::atoi(part.c_str()))));
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((command != "show" && command != "apply" && command != "recover") ||
+        (command == "recover" && stateFile.empty()) || (keep && stateFile.empty())) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    CpuFreqController controller(root, stateFile);
+    if (controller.discover() <= 0) {
+        std::fprintf(stderr, "no cpufreq policies under %s/sys/devices/system/cpu\n", root.c_str());
+        return 1;
+    }
+    if (command == "show") {
+        printPolicies("policies:", controller);
+        return 0;
+    }
+    if (command == "recover") {
+        printPolicies("before:", controller);
+        if (!controller.recoverFromStateFile()) {
+            std::fprintf(stderr, "nothing recovered from %s\n", stateFile.c_str());
+            return 1;
+        }
+        printPolicies("recovered:", controller);
+        return 0;
+    }
+
+    std::vector<CpuFreqTarget> targets(std::max<size_t>(1, floors.size()));
+    for (size_t i = 0; i < targets.size(); i++) {
+        targets[i].governor = governor;
+        targets[i].minFreqPercent = i < floors.size() ? floors[i] : 0;
+    }
+    printPolicies("before:", controller);
+    std::string error;
+    if (!controller.apply(targets, &error)) {
+        std::fprintf(stderr, "apply failed, rolled back: %s\n", error.c_str());
+        printPolicies("after rollback:", controller);
+        return 1;
+    }
+    printPolicies("applied:", controller);
+    if (keep) {
+        std::printf("left in place; baseline in %s\n", stateFile.c_str());
+        return 0;
+    }
+    for (uint32_t waited = 0; waited < holdSec * 10 && !g_stop; waited++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    bool restored = controller.restore();
+    printPolicies(restored ? "restored:" : "restore failed:", controller);
+    return restored ? 0 : 1;
+}
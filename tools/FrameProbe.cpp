@@ -0,0 +1,250 @@
+// tools/FrameProbe.cpp - Watch a process's estimated frame cadence, or validate the estimator
+//
+//   RobloxOptimizerFrameProbe --name RobloxPlayer --duration-s 30 --all
+//   RobloxOptimizerFrameProbe --synthetic 60 --work-ms 4 --jitter-ms 1
+//
+// --synthetic starts a render loop at a known rate inside this process,
+// alongside decoys the estimator has to reject (a 100 Hz poll thread with
+// no work, an irregular job thread and a spinning worker), then attaches
+// FrameCadenceEstimator to itself. Exit status 0 means the loop thread
+// was picked and its rate came out within --tolerance percent.
+#include "EventLoop.h"
+#include "FrameCadence.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+pid_t findProcess(const std::string& name) {
+    DIR* dir = opendir("/proc");
+    if (!dir) {
+        return 0;
+    }
+    pid_t found = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9') {
+            continue;
+        }
+        std::ifstream cmdline(std::string("/proc/") + entry->d_name + "/cmdline");
+        std::string argv0;
+        std::getline(cmdline, argv0, '\0');
+        size_t slash = argv0.rfind('/');
+        if ((slash == std::string::npos ? argv0 : argv0.substr(slash + 1)) == name) {
+            found = static_cast<pid_t>(std::atoi(entry->d_name));
+            break;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+void printCadence(const FrameCadence& cadence) {
+    if (!cadence.valid) {
+        std::printf("  tid %-6d %-15s  no plausible cadence\n", cadence.tid, cadence.comm);
+        return;
+    }
+    std::printf("  tid %-6d %-15s  %6.1f fps  %6.2f ms  jitter %5.2f ms  cpu %5.2f ms  wait %5.2f ms  conf %.2f\n",
+                cadence.tid, cadence.comm, cadence.fps, cadence.frameTimeMs, cadence.jitterMs,
+                cadence.cpuPerFrameMs, cadence.waitPerFrameMs, cadence.confidence);
+}
+
+void spinFor(double ms) {
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (;;) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double elapsed = (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_nsec - start.tv_nsec) / 1e6;
+        if (elapsed >= ms) {
+            return;
+        }
+    }
+}
+
+void addMs(timespec& ts, double ms) {
+    long long ns = ts.tv_nsec + static_cast<long long>(ms * 1e6);
+    ts.tv_sec += static_cast<time_t>(ns / 1000000000);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000);
+}
+
+// Sleeps to absolute deadlines, so the cadence holds however long the
+// work takes, as long as it fits in the frame.
+void periodicLoop(const char* name, double periodMs, double workMs, double jitterMs,
+                  const std::atomic<bool>& stop, std::atomic<pid_t>* tid) {
+    prctl(PR_SET_NAME, name);
+    if (tid) {
+        tid->store(static_cast<pid_t>(syscall(SYS_gettid)));
+    }
+    std::mt19937 random(static_cast<uint32_t>(periodMs * 1000));
+    std::uniform_real_distribution<double> spread(-jitterMs, jitterMs);
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (workMs > 0.0) {
+            spinFor(std::max(0.0, workMs + spread(random)));
+        }
+        addMs(deadline, periodMs);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+    }
+}
+
+int synthetic(double targetFps, double workMs, double jitterMs, uint32_t durationSec, double tolerancePercent,
+              bool showAll) {
+    std::atomic<bool> stop(false);
+    std::atomic<pid_t> renderTid(0);
+    std::vector<std::thread> threads;
+    threads.emplace_back(periodicLoop, "synth-frame", 1000.0 / targetFps, workMs, jitterMs, std::cref(stop), &renderTid);
+    threads.emplace_back(periodicLoop, "synth-poll", 10.0, 0.0, 0.0, std::cref(stop), nullptr);
+    threads.emplace_back([&stop]() {
+        prctl(PR_SET_NAME, "synth-jobs");
+        std::mt19937 random(7);
+        std::uniform_int_distribution<int> gap(2, 40);
+        while (!stop.load(std::memory_order_relaxed)) {
+            spinFor(1.5);
+            std::this_thread::sleep_for(std::chrono::milliseconds(gap(random)));
+        }
+    });
+    threads.emplace_back([&stop]() {
+        prctl(PR_SET_NAME, "synth-busy");
+        while (!stop.load(std::memory_order_relaxed)) {
+            spinFor(50.0);
+        }
+    });
+
+    FrameCadenceEstimator estimator;
+    estimator.attach(getpid());
+    uint64_t start = EventLoop::nowMs();
+    uint64_t lastPrint = start;
+    while (!g_stop && EventLoop::nowMs() - start < durationSec * 1000ull) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        uint64_t now = EventLoop::nowMs();
+        estimator.sample(now);
+        if (now - lastPrint >= 1000) {
+            lastPrint = now;
+            std::printf("t=%.1fs\n", (now - start) / 1000.0);
+            if (showAll) {
+                for (const FrameCadence& cadence : estimator.candidates()) {
+                    printCadence(cadence);
+                }
+            } else {
+                printCadence(estimator.current());
+            }
+        }
+    }
+    stop.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    FrameCadence result = estimator.current();
+    double errorPercent = result.valid ? std::fabs(result.fps - targetFps) * 100.0 / targetFps : 100.0;
+    bool picked = result.valid && result.tid == renderTid.load();
+    bool pass = picked && errorPercent <= tolerancePercent;
+    std::printf("target %.1f fps: estimated %.1f fps on %s (%s), error %.1f%%, jitter %.2f ms -> %s\n",
+                targetFps, result.fps, result.valid ? result.comm : "-",
+                picked ? "render loop" : "wrong thread", errorPercent, result.jitterMs, pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+int probe(pid_t pid, const std::string& name, uint32_t durationSec, bool showAll) {
+    FrameCadenceEstimator estimator;
+    uint64_t start = EventLoop::nowMs();
+    uint64_t lastPrint = start;
+    while (!g_stop && (durationSec == 0 || EventLoop::nowMs() - start < durationSec * 1000ull)) {
+        if (!name.empty() && (pid == 0 || kill(pid, 0) != 0)) {
+            pid = findProcess(name);
+        }
+        if (pid != estimator.pid()) {
+            if (pid > 0 && estimator.attach(pid)) {
+                std::printf("attached to %d\n", pid);
+            } else {
+                estimator.detach();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        uint64_t now = EventLoop::nowMs();
+        estimator.sample(now);
+        if (estimator.pid() > 0 && now - lastPrint >= 1000) {
+            lastPrint = now;
+            std::printf("t=%.1fs\n", (now - start) / 1000.0);
+            if (showAll) {
+                for (const FrameCadence& cadence : estimator.candidates()) {
+                    printCadence(cadence);
+                }
+            } else {
+                printCadence(estimator.current());
+            }
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s --pid PID | --name NAME [--duration-s N] [--all]\n"
+                 "       %s --synthetic FPS [--work-ms MS] [--jitter-ms MS] [--duration-s N] [--tolerance PCT] [--all]\n",
+                 argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    pid_t pid = 0;
+    std::string name;
+    double syntheticFps = 0.0;
+    double workMs = 4.0;
+    double jitterMs = 0.0;
+    double tolerance = 5.0;
+    uint32_t durationSec = 0;
+    bool showAll = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--all") showAll = true;
+        else if (arg == "--pid" && hasValue) pid = static_cast<pid_t>(std::atoi(argv[++i]));
+        else if (arg == "--name" && hasValue) name = argv[++i];
+        else if (arg == "--synthetic" && hasValue) syntheticFps = std::atof(argv[++i]);
+        else if (arg == "--work-ms" && hasValue) workMs = std::atof(argv[++i]);
+        else if (arg == "--jitter-ms" && hasValue) jitterMs = std::atof(argv[++i]);
+        else if (arg == "--duration-s" && hasValue) durationSec = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (arg == "--tolerance" && hasValue) tolerance = std::atof(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (syntheticFps > 0.0) {
+        return synthetic(syntheticFps, workMs, jitterMs, durationSec ? durationSec : 8, tolerance, showAll);
+    }
+    if (pid <= 0 && name.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    return probe(pid, name, durationSec, showAll);
+}
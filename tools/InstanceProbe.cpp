@@ -0,0 +1,236 @@
+// tools/InstanceProbe.cpp - Per-instance metrics and CPU partitions of concurrent clients
+//
+//   RobloxOptimizerInstances --name RobloxPlayer --duration-s 60
+//   RobloxOptimizerInstances --synthetic 8 --churn --duration-s 20
+//   RobloxOptimizerInstances --synthetic 16 --root /tmp/fake-sysfs --dry-run
+//
+// --name tracks every process of that name, starting and stopping with
+// them. --synthetic spawns N busy children of different weights instead;
+// with --churn one exits and a new one starts halfway through. --root
+// reads the CPU topology under another root (the processes stay real),
+// which only makes sense with --dry-run: partitions are planned and
+// printed but no affinity is changed.
+#include "EventLoop.h"
+#include "InstanceManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+std::set<pid_t> findProcesses(const std::string& name) {
+    std::set<pid_t> found;
+    DIR* dir = opendir("/proc");
+    if (!dir) {
+        return found;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9') {
+            continue;
+        }
+        std::ifstream cmdline(std::string("/proc/") + entry->d_name + "/cmdline");
+        std::string argv0;
+        std::getline(cmdline, argv0, '\0');
+        size_t slash = argv0.rfind('/');
+        if ((slash == std::string::npos ? argv0 : argv0.substr(slash + 1)) == name) {
+            found.insert(static_cast<pid_t>(std::atoi(entry->d_name)));
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+// Child i burns (i % 4 + 1) quarters of a core in 10 ms periods, on one
+// thread plus one more for every odd i, so instances differ in demand.
+pid_t spawnChild(int index) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    signal(SIGTERM, SIG_DFL);
+    double duty = (index % 4 + 1) / 4.0;
+    auto burn = [duty]() {
+        for (;;) {
+            auto start = std::chrono::steady_clock::now();
+            auto busyUntil = start + std::chrono::microseconds(static_cast<int>(10000 * duty));
+            while (std::chrono::steady_clock::now() < busyUntil) {
+            }
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(10));
+        }
+    };
+    if (index % 2) {
+        std::thread(burn).detach();
+    }
+    burn();
+    _exit(0);
+}
+
+std::string cpuList(const std::vector<int>& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        out += (out.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (j > i) {
+            out += "-" + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return out.empty() ? "-" : out;
+}
+
+void printPlan(const PartitionPlan& plan) {
+    std::printf("plan: %zu partitions, reserved %s\n", plan.partitions.size(), cpuList(plan.reserved).c_str());
+    for (size_t i = 0; i < plan.partitions.size(); i++) {
+        const CpuPartition& partition = plan.partitions[i];
+        std::string members;
+        for (pid_t pid : partition.members) {
+            members += (members.empty() ? "" : " ") + std::to_string(pid);
+        }
+        std::printf("  [%2zu] cpus %-12s %5.2f cores  demand %5.2f  load %4.2f  pids %s\n", i,
+                    cpuList(partition.cpus).c_str(), partition.capacityCores(), partition.demandCores, partition.load(),
+                    members.c_str());
+    }
+}
+
+void printInstances(const std::vector<InstanceInfo>& instances, uint64_t elapsedMs) {
+    std::printf("+%llu ms\n", static_cast<unsigned long long>(elapsedMs));
+    for (const InstanceInfo& info : instances) {
+        std::printf("  %7d %-16.16s cpu %6.1f%%  demand %5.2f  rss %7.1f MB  %3d thr  wait %5.1f%%  preempt %6.1f/s"
+                    "  part %2d  %s\n",
+                    info.pid, info.name.c_str(), info.cpuPercent, info.demandCores, info.rssBytes / 1048576.0,
+                    info.threads, 100.0 * info.waitShare, info.preemptionsPerSec, info.partition,
+                    cpuList(info.cpus).c_str());
+    }
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s (--name NAME | --synthetic N [--churn]) [--duration-s N] [--interval-ms N]\n"
+                 "          [--root DIR] [--dry-run] [--min-instances N] [--reserved-cpus N]\n",
+                 argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string name;
+    std::string root;
+    int synthetic = 0;
+    bool churn = false;
+    bool dryRun = false;
+    uint32_t durationSec = 10;
+    uint32_t intervalMs = 1000;
+    InstanceManager::Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--churn") churn = true;
+        else if (arg == "--dry-run") dryRun = true;
+        else if (arg == "--name" && hasValue) name = argv[++i];
+        else if (arg == "--root" && hasValue) root = argv[++i];
+        else if (arg == "--synthetic" && hasValue) synthetic = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--duration-s" && hasValue) durationSec = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--interval-ms" && hasValue) intervalMs = static_cast<uint32_t>(std::max(100, std::atoi(argv[++i])));
+        else if (arg == "--min-instances" && hasValue) options.minInstances = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--reserved-cpus" && hasValue) options.planner.reservedCpus = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (name.empty() == (synthetic == 0)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!root.empty() && !dryRun) {
+        std::fprintf(stderr, "--root needs --dry-run: its CPUs are not this machine's\n");
+        return 2;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    CpuTopology topology(root);
+    if (!topology.load()) {
+        std::fprintf(stderr, "cannot read the CPU topology under %s/sys\n", root.c_str());
+        return 1;
+    }
+    InstanceManager manager(topology);
+    manager.setOptions(options);
+    if (dryRun) {
+        manager.setAffinitySetter([](pid_t, const cpu_set_t&) { return true; });
+    }
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < synthetic; i++) {
+        children.push_back(spawnChild(i));
+    }
+    uint64_t startMs = EventLoop::nowMs();
+    uint64_t replans = 0;
+    bool churned = false;
+    while (!g_stop && EventLoop::nowMs() - startMs < durationSec * 1000ull) {
+        uint64_t nowMs = EventLoop::nowMs();
+        if (!name.empty()) {
+            std::set<pid_t> running = findProcesses(name);
+            for (const InstanceInfo& info : manager.snapshot()) {
+                if (!running.count(info.pid)) {
+                    manager.remove(info.pid);
+                }
+            }
+            for (pid_t pid : running) {
+                manager.add(pid, name, nowMs);
+            }
+        } else {
+            if (churn && !churned && nowMs - startMs >= durationSec * 500ull) {
+                kill(children.front(), SIGKILL);
+                waitpid(children.front(), nullptr, 0);
+                manager.remove(children.front());
+                children.erase(children.begin());
+                children.push_back(spawnChild(synthetic));
+                churned = true;
+            }
+            for (size_t i = 0; i < children.size(); i++) {
+                manager.add(children[i], "synthetic-" + std::to_string(i), nowMs);
+            }
+        }
+        size_t pinned = manager.update(nowMs);
+        InstanceStats stats = manager.getStats();
+        if (stats.replans != replans) {
+            replans = stats.replans;
+            printPlan(manager.getPlan());
+        }
+        printInstances(manager.snapshot(), nowMs - startMs);
+        if (pinned > 0) {
+            std::printf("  pinned %zu threads\n", pinned);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    manager.restore();
+    for (pid_t child : children) {
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+    }
+    InstanceStats stats = manager.getStats();
+    std::printf("%llu replans, %llu threads pinned, %llu pin failures\n", static_cast<unsigned long long>(stats.replans),
+                static_cast<unsigned long long>(stats.threadsPinned), static_cast<unsigned long long>(stats.pinFailures));
+    return 0;
+}
@@ -0,0 +1,155 @@
+// tools/IoProbe.cpp - fio-style random-read latency at chosen I/O priority classes
+//
+//   RobloxOptimizerIoProbe --dir /data/local/tmp --class be:0 --class idle --contend 2 --contend-class be:4
+//
+// Runs IoLatencyProbe once per --class, one after the other, while
+// --contend threads keep random-reading their own files at
+// --contend-class. Comparing the game's class against the background's
+// under the same contention shows what the ioprio classes buy on this
+// device's I/O scheduler (printed first; "none" ignores the classes).
+#include "IoPriority.h"
+
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string blockScheduler(const std::string& dir) {
+    struct stat st;
+    if (stat(dir.c_str(), &st) != 0) {
+        return "unknown";
+    }
+    std::string device = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+    // Partitions have no queue of their own; their parent disk does.
+    for (const char* queue : {"/queue/scheduler", "/../queue/scheduler"}) {
+        std::ifstream file(device + queue);
+        std::string line;
+        if (std::getline(file, line)) {
+            return line;
+        }
+    }
+    return "unknown (not a block device)";
+}
+
+void printResult(const char* label, const std::string& priority, const IoLatencyResult& result) {
+    if (!result.success) {
+        std::printf("%-10s %-6s failed: %s\n", label, priority.c_str(), result.error.c_str());
+        return;
+    }
+    std::printf("%-10s %-6s %8llu reads %8.0f IOPS  mean %7.0f us  p50 %7.0f us  p90 %7.0f us  p99 %7.0f us  "
+                "max %7.0f us%s\n",
+                label, priority.c_str(), static_cast<unsigned long long>(result.reads), result.iops, result.meanUs,
+                result.p50Us, result.p90Us, result.p99Us, result.maxUs, result.direct ? "" : "  (buffered)");
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s --dir DIR [--class PRIO]... [--contend N] [--contend-class PRIO]\n"
+                 "          [--size-mb N] [--block-kb N] [--duration-s N] [--buffered] [--keep]\n"
+                 "PRIO is rt:N, be:N, idle or none\n",
+                 argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string dir;
+    std::vector<IoPriority> classes;
+    unsigned contenders = 0;
+    IoPriority contendClass(IoClass::BestEffort, 4);
+    uint64_t sizeMb = 64;
+    uint32_t blockKb = 4;
+    uint32_t durationSec = 3;
+    bool direct = true;
+    bool keep = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        IoPriority priority;
+        if (arg == "--buffered") direct = false;
+        else if (arg == "--keep") keep = true;
+        else if (arg == "--dir" && hasValue) dir = argv[++i];
+        else if (arg == "--class" && hasValue && IoPriority::parse(argv[++i], priority)) classes.push_back(priority);
+        else if (arg == "--contend" && hasValue) contenders = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (arg == "--contend-class" && hasValue && IoPriority::parse(argv[++i], priority)) contendClass = priority;
+        else if (arg == "--size-mb" && hasValue) sizeMb = static_cast<uint64_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--block-kb" && hasValue) blockKb = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--duration-s" && hasValue) durationSec = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (dir.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (classes.empty()) {
+        classes.push_back(IoPriority());
+    }
+    std::printf("I/O scheduler: %s\n", blockScheduler(dir).c_str());
+
+    IoLatencyOptions base;
+    base.fileBytes = sizeMb << 20;
+    base.blockBytes = blockKb * 1024;
+    base.direct = direct;
+    std::vector<std::string> files;
+
+    // Contenders outlast every probe run; their files are prepared before
+    // any timing starts.
+    std::vector<IoLatencyResult> contendResults(contenders);
+    std::vector<std::thread> threads;
+    uint32_t totalMs = static_cast<uint32_t>(classes.size()) * durationSec * 1000 + 500;
+    for (unsigned i = 0; i < contenders; i++) {
+        IoLatencyOptions options = base;
+        options.path = dir + "/ioprobe.contend." + std::to_string(i);
+        options.durationMs = 0;
+        options.maxReads = 1;
+        IoLatencyProbe::run(options);
+        files.push_back(options.path);
+    }
+    IoLatencyOptions probe = base;
+    probe.path = dir + "/ioprobe.dat";
+    probe.durationMs = 0;
+    probe.maxReads = 1;
+    IoLatencyResult prepared = IoLatencyProbe::run(probe);
+    files.push_back(probe.path);
+    if (!prepared.success) {
+        std::fprintf(stderr, "%s\n", prepared.error.c_str());
+        return 1;
+    }
+    for (unsigned i = 0; i < contenders; i++) {
+        IoLatencyOptions options = base;
+        options.path = files[i];
+        options.durationMs = totalMs;
+        options.priority = contendClass;
+        threads.emplace_back([options, &contendResults, i] { contendResults[i] = IoLatencyProbe::run(options); });
+    }
+
+    probe.durationMs = durationSec * 1000;
+    probe.maxReads = 0;
+    for (const IoPriority& priority : classes) {
+        probe.priority = priority;
+        printResult("probe", priority.toString(), IoLatencyProbe::run(probe));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (const IoLatencyResult& result : contendResults) {
+        printResult("contender", contendClass.toString(), result);
+    }
+    if (!keep) {
+        for (const std::string& file : files) {
+            unlink(file.c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+// tools/LogDecode.cpp - Offline decoder for binary optimizer logs
+//
+//   g++ -O2 -std=c++17 -Iinclude/common tools/LogDecode.cpp src/common/Logger.cpp -pthread -o log_decode
+//   ./log_decode optimizer.blog > optimizer.txt
+#include "Logger.h"
+
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <binary-log> [more logs...]" << std::endl;
+        return 2;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!Logger::decodeBinaryLog(argv[i], std::cout)) {
+            std::cerr << argv[i] << ": not a binary optimizer log or truncated" << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,229 @@
+// tools/Prewarm.cpp - Learn, replay and inspect page-cache prewarm profiles
+//
+//   RobloxOptimizerPrewarm learn --name RobloxPlayer --duration-s 30 --out game.pwm --merge
+//   RobloxOptimizerPrewarm warm game.pwm --evict --threads 4 --lock-mb 32
+//   RobloxOptimizerPrewarm report game.pwm --extents
+//
+// learn samples the residency of the process's files until --duration-s
+// has passed or it exits. warm replays a profile; with --evict it first
+// drops the profile's files from the page cache, so the printed timeline
+// (residency every 50 ms until it settles) is that of a cold launch.
+#include "EventLoop.h"
+#include "PageCachePrewarmer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+pid_t findProcess(const std::string& name) {
+    DIR* dir = opendir("/proc");
+    if (!dir) {
+        return 0;
+    }
+    pid_t found = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9') {
+            continue;
+        }
+        std::ifstream cmdline(std::string("/proc/") + entry->d_name + "/cmdline");
+        std::string argv0;
+        std::getline(cmdline, argv0, '\0');
+        size_t slash = argv0.rfind('/');
+        if ((slash == std::string::npos ? argv0 : argv0.substr(slash + 1)) == name) {
+            found = static_cast<pid_t>(std::atoi(entry->d_name));
+            break;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+double mb(uint64_t bytes) {
+    return bytes / 1048576.0;
+}
+
+void printProfile(const PrewarmProfile& profile, bool extents) {
+    std::printf("%u session(s), %zu files, %zu extents, %.1f MB\n", profile.sessions, profile.files.size(),
+                profile.extentCount(), mb(profile.bytes()));
+    PrewarmResidency residency = PageCachePrewarmer::residency(profile);
+    for (size_t i = 0; i < profile.files.size(); i++) {
+        const PrewarmFile& file = profile.files[i];
+        const PrewarmResidency::File& resident = residency.files[i];
+        std::printf("  %7.1f MB %5.1f%% resident  first %6u ms  %4zu extents  %s%s\n", mb(file.bytes()),
+                    file.bytes() ? 100.0 * resident.residentBytes / file.bytes() : 0.0, file.firstSeenMs(),
+                    file.extents.size(), file.path.c_str(), resident.present ? "" : "  (missing or changed)");
+        if (!extents) {
+            continue;
+        }
+        for (const PrewarmExtent& extent : file.extents) {
+            std::printf("      @%-12llu %8llu KB  first %6u ms  heat %3u\n",
+                        static_cast<unsigned long long>(extent.offset),
+                        static_cast<unsigned long long>(extent.length >> 10), extent.firstSeenMs, extent.heat);
+        }
+    }
+    std::printf("resident: %.1f of %.1f MB (%.1f%%)\n", mb(residency.residentBytes), mb(residency.profileBytes),
+                residency.residentPercent());
+}
+
+int learn(pid_t pid, const std::string& out, uint32_t durationSec, uint32_t intervalMs, bool merge) {
+    PrewarmRecorder recorder;
+    PrewarmRecorder::Options options;
+    options.learnMs = durationSec * 1000;
+    recorder.setOptions(options);
+    PrewarmProfile previous;
+    bool merging = merge && previous.load(out);
+    if (!recorder.attach(pid, EventLoop::nowMs(), merging ? &previous : nullptr)) {
+        std::fprintf(stderr, "cannot read /proc/%d/maps\n", pid);
+        return 1;
+    }
+    while (!g_stop && kill(pid, 0) == 0 && recorder.sample(EventLoop::nowMs())) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    uint32_t unreadable = recorder.unreadableFiles();
+    PrewarmProfile profile = recorder.finish();
+    if (unreadable > 0) {
+        std::fprintf(stderr, "%u files skipped: mincore() needs ownership, write access or root\n", unreadable);
+    }
+    if (merging) {
+        profile.merge(previous);
+    }
+    std::string error;
+    if (!profile.save(out, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    printProfile(profile, false);
+    return 0;
+}
+
+int warm(const PrewarmProfile& profile, const PrewarmOptions& options, bool evict, uint32_t holdSec) {
+    PageCachePrewarmer prewarmer;
+    if (evict) {
+        size_t files = PageCachePrewarmer::evict(profile);
+        PrewarmResidency cold = PageCachePrewarmer::residency(profile);
+        std::printf("evicted %zu files: %.1f%% resident\n", files, cold.residentPercent());
+    }
+    uint64_t startMs = EventLoop::nowMs();
+    PrewarmResult result = prewarmer.warm(profile, options);
+    if (!result.success) {
+        std::fprintf(stderr, "%s\n", result.error.c_str());
+        return 1;
+    }
+    std::printf("issued %zu extents of %zu files (%.1f MB) in %llu ms; %zu stale, %zu missing, %llu failed; "
+                "%.1f MB locked\n",
+                result.extents, result.files, mb(result.bytesRequested),
+                static_cast<unsigned long long>(result.elapsedMs), result.staleFiles, result.missingFiles,
+                static_cast<unsigned long long>(result.failures), mb(result.bytesLocked));
+    // Readahead returns once the reads are queued; watch them land.
+    double lastPercent = -1.0;
+    int steady = 0;
+    while (!g_stop && steady < 4 && EventLoop::nowMs() - startMs < 10000) {
+        PrewarmResidency now = PageCachePrewarmer::residency(profile);
+        std::printf("  +%5llu ms  %5.1f%% resident\n", static_cast<unsigned long long>(EventLoop::nowMs() - startMs),
+                    now.residentPercent());
+        steady = now.residentPercent() == lastPercent ? steady + 1 : 0;
+        lastPercent = now.residentPercent();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    for (uint32_t i = 0; !g_stop && i < holdSec * 10; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return 0;
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s learn (--pid N | --name NAME) --out FILE [--duration-s N] [--interval-ms N] [--merge]\n"
+                 "       %s warm FILE [--threads N] [--max-mb N] [--lock-mb N] [--hold-s N] [--class PRIO]\n"
+                 "                    [--fadvise] [--evict]\n"
+                 "       %s report FILE [--extents]\n",
+                 argv0, argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::string command = argv[1];
+    std::string file;
+    pid_t pid = 0;
+    std::string name;
+    uint32_t durationSec = 30;
+    uint32_t intervalMs = 250;
+    bool merge = false;
+    bool extents = false;
+    bool evict = false;
+    uint32_t holdSec = 0;
+    PrewarmOptions options;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--merge") merge = true;
+        else if (arg == "--extents") extents = true;
+        else if (arg == "--evict") evict = true;
+        else if (arg == "--fadvise") options.fadvise = true;
+        else if (arg == "--pid" && hasValue) pid = static_cast<pid_t>(std::atoi(argv[++i]));
+        else if (arg == "--name" && hasValue) name = argv[++i];
+        else if (arg == "--out" && hasValue) file = argv[++i];
+        else if (arg == "--duration-s" && hasValue) durationSec = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--interval-ms" && hasValue) intervalMs = static_cast<uint32_t>(std::max(10, std::atoi(argv[++i])));
+        else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--max-mb" && hasValue) options.maxBytes = static_cast<uint64_t>(std::max(1, std::atoi(argv[++i]))) << 20;
+        else if (arg == "--lock-mb" && hasValue) options.lockBytes = static_cast<uint64_t>(std::max(0, std::atoi(argv[++i]))) << 20;
+        else if (arg == "--hold-s" && hasValue) holdSec = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        else if (arg == "--class" && hasValue && IoPriority::parse(argv[++i], options.priority)) continue;
+        else if (arg[0] != '-' && file.empty()) file = arg;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (command == "learn") {
+        if (pid == 0 && !name.empty()) {
+            pid = findProcess(name);
+        }
+        if (pid == 0 || file.empty()) {
+            std::fprintf(stderr, pid == 0 && !name.empty() ? "no process named %s\n" : "need --pid or --name and --out\n",
+                         name.c_str());
+            return 2;
+        }
+        return learn(pid, file, durationSec, intervalMs, merge);
+    }
+    if ((command != "warm" && command != "report") || file.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    PrewarmProfile profile;
+    std::string error;
+    if (!profile.load(file, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (command == "report") {
+        printProfile(profile, extents);
+        return 0;
+    }
+    return warm(profile, options, evict, holdSec);
+}
@@ -0,0 +1,332 @@
+// tools/TraceTool.cpp - Record procfs/sysfs traces and replay them through the scheduler
+//
+//   RobloxOptimizerTrace record session.trace --name RobloxPlayer --interval-ms 500 --duration-s 600
+//   RobloxOptimizerTrace replay session.trace --decisions decisions.csv --format json
+//   RobloxOptimizerTrace info session.trace
+//
+// Replay materialises every frame into a scratch root and runs the same
+// policies AndroidOptimizer::configureScheduler() installs, ticking on the
+// recorded timestamps instead of the wall clock. Knob actuators only log
+// the decision, so a replay is deterministic and can be diffed between
+// versions; the per-tick cost comes from the scheduler.tick profile site.
+#include "AdaptiveScheduler.h"
+#include "PressureMonitor.h"
+#include "ProcFs.h"
+#include "ProcTrace.h"
+#include "SelfProfiler.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <ftw.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+void onSignal(int) {
+    g_stop = 1;
+}
+
+uint64_t monotonicMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+pid_t findProcess(const std::string& name) {
+    DIR* dir = opendir("/proc");
+    if (!dir) {
+        return 0;
+    }
+    pid_t found = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9') {
+            continue;
+        }
+        std::ifstream cmdline(std::string("/proc/") + entry->d_name + "/cmdline");
+        std::string argv0;
+        std::getline(cmdline, argv0, '\0');
+        size_t slash = argv0.rfind('/');
+        if ((slash == std::string::npos ? argv0 : argv0.substr(slash + 1)) == name) {
+            found = static_cast<pid_t>(std::atoi(entry->d_name));
+            break;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+int record(int argc, char** argv) {
+    if (argc < 1) {
+        return 2;
+    }
+    std::string tracePath = argv[0];
+    std::string name;
+    pid_t pid = 0;
+    uint32_t intervalMs = 500;
+    uint32_t durationSec = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--pid") pid = static_cast<pid_t>(std::atoi(argv[i + 1]));
+        else if (arg == "--name") name = argv[i + 1];
+        else if (arg == "--interval-ms") intervalMs = static_cast<uint32_t>(std::max(10, std::atoi(argv[i + 1])));
+        else if (arg == "--duration-s") durationSec = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+        else return 2;
+    }
+
+    TraceRecorder recorder;
+    if (!recorder.open(tracePath)) {
+        std::cerr << tracePath << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    uint64_t start = monotonicMs();
+    while (!g_stop && (durationSec == 0 || monotonicMs() - start < durationSec * 1000ull)) {
+        if (!name.empty() && (pid == 0 || kill(pid, 0) != 0)) {
+            pid = findProcess(name);
+        }
+        recorder.setGamePid(pid);
+        recorder.capture(monotonicMs());
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    recorder.close();
+    std::cerr << recorder.frameCount() << " frames, " << recorder.bytesRecorded() << " bytes" << std::endl;
+    return 0;
+}
+
+// Mirrors AndroidOptimizer::sampleSignals(), with game CPU taken from the
+// recorded /proc/<pid>/stat instead of the live sampler thread, and memory
+// pressure estimated from the recorded PSI averages.
+class ReplaySignals {
+private:
+    std::string root;
+    std::unique_ptr<ProcFsReader> reader;   // opened once the first frame exists
+    CpuStat lastCpuStat;
+    bool haveCpuStat = false;
+    int32_t lastPid = 0;
+    uint64_t lastGameTicks = 0;
+    uint64_t lastGameMs = 0;
+    std::vector<PressureTrigger> triggers = PressureMonitor::defaultTriggers();
+    PressureMonitor pressure;
+
+public:
+    explicit ReplaySignals(const std::string& rootPrefix) : root(rootPrefix), pressure(rootPrefix) {}
+
+    void sample(const TraceFrame& frame, OptimizerSignals& out) {
+        if (!reader) {
+            reader.reset(new ProcFsReader(root));
+        }
+        out.timestampMs = frame.timestampMs;
+        if (frame.gamePid > 0) {
+            ProcessStatReader game(frame.gamePid, root);
+            TaskStat stat;
+            if (game.readStat(stat)) {
+                uint64_t ticks = stat.utime + stat.stime;
+                if (lastPid == frame.gamePid && frame.timestampMs > lastGameMs) {
+                    double seconds = (frame.timestampMs - lastGameMs) / 1000.0;
+                    out.gameCpuPercent = 100.0 * (ticks - lastGameTicks) / sysconf(_SC_CLK_TCK) / seconds;
+                }
+                out.gameRunning = true;
+                lastPid = frame.gamePid;
+                lastGameTicks = ticks;
+                lastGameMs = frame.timestampMs;
+            }
+        }
+
+        CpuStat stat;
+        if (reader->readCpuStat(stat)) {
+            if (haveCpuStat) {
+                uint64_t total = stat.aggregate.total() - lastCpuStat.aggregate.total();
+                uint64_t busy = stat.aggregate.busy() - lastCpuStat.aggregate.busy();
+                out.systemCpuPercent = total ? 100.0 * busy / total : 0.0;
+            }
+            lastCpuStat = stat;
+            haveCpuStat = true;
+        }
+
+        MemInfo memory;
+        if (reader->readMemInfo(memory) && memory.memTotal != 0) {
+            out.memAvailablePercent = 100.0 * memory.memAvailable / memory.memTotal;
+        }
+
+        int32_t milliCelsius = 0;
+        if (reader->readMaxThermal(milliCelsius)) {
+            out.thermalCelsius = milliCelsius / 1000.0;
+        }
+
+        PressureStats stats;
+        if (pressure.readStats(PressureResource::Memory, stats)) {
+            out.memoryPressure = static_cast<int>(
+                PressureMonitor::estimateLevel(PressureResource::Memory, stats, triggers));
+        }
+    }
+};
+
+int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+int replay(int argc, char** argv) {
+    if (argc < 1) {
+        return 2;
+    }
+    std::string tracePath = argv[0];
+    std::string decisionsPath;
+    std::string format = "text";
+    double thermalLimit = 75.0;
+    uint32_t knobIntervalMs = 3000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--decisions") decisionsPath = argv[i + 1];
+        else if (arg == "--format") format = argv[i + 1];
+        else if (arg == "--thermal-limit") thermalLimit = std::atof(argv[i + 1]);
+        else if (arg == "--knob-min-interval-ms") knobIntervalMs = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+        else return 2;
+    }
+
+    char scratch[] = "/tmp/rbxreplay.XXXXXX";
+    if (!mkdtemp(scratch)) {
+        std::cerr << "mkdtemp: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    TraceReplayer replayer(scratch);
+    if (!replayer.open(tracePath)) {
+        std::cerr << tracePath << ": not a procfs trace" << std::endl;
+        rmdir(scratch);
+        return 1;
+    }
+
+    std::ofstream decisions;
+    if (!decisionsPath.empty()) {
+        decisions.open(decisionsPath, std::ios::trunc);
+        decisions << "timestamp_ms,knob,level\n";
+    }
+
+    // Same policies and knobs as AndroidOptimizer; actuators record only.
+    uint64_t frameMs = 0;
+    uint64_t decisionCount = 0;
+    AdaptiveScheduler scheduler;
+    ReplaySignals signals(scratch);
+    TraceFrame frame;
+    scheduler.setSignalSource([&](OptimizerSignals& out) {
+        signals.sample(frame, out);
+        return true;
+    });
+    scheduler.addPolicy(std::unique_ptr<OptimizationPolicy>(new CpuFloorPolicy(thermalLimit)));
+    scheduler.addPolicy(std::unique_ptr<OptimizationPolicy>(new AffinityPolicy()));
+    scheduler.addPolicy(std::unique_ptr<OptimizationPolicy>(new MemoryTrimPolicy()));
+    for (const char* knob : {"cpufreq.floor", "affinity", "memory.trim"}) {
+        std::string name = knob;
+        scheduler.addKnob(name, [&, name](int level) {
+            decisionCount++;
+            if (decisions.is_open()) {
+                decisions << frameMs << "," << name << "," << level << "\n";
+            }
+            return true;
+        }, knobIntervalMs);
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t frames = 0;
+    uint64_t firstMs = 0;
+    while (replayer.step(frame)) {
+        if (frames++ == 0) {
+            firstMs = frame.timestampMs;
+        }
+        frameMs = frame.timestampMs;
+        scheduler.tick(frame.timestampMs);
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    bool corrupt = replayer.getReader().isCorrupt();
+    nftw(scratch, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+    double sessionMs = frames ? static_cast<double>(frameMs - firstMs) : 0.0;
+    ProfileSiteStats tick;
+    SelfProfiler::siteStats("scheduler.tick", tick);
+    std::vector<AdaptiveScheduler::KnobStatus> knobs = scheduler.getStatus();
+
+    if (format == "json") {
+        std::printf("{\"trace\": \"%s\", \"frames\": %" PRIu64 ", \"session_ms\": %.0f, \"wall_ms\": %.1f, "
+                    "\"speedup\": %.1f, \"decisions\": %" PRIu64 ", \"corrupt\": %s,\n"
+                    " \"tick_ns\": {\"p50\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"max\": %" PRIu64 ", \"mean\": %.0f},\n"
+                    " \"knobs\": [",
+                    tracePath.c_str(), frames, sessionMs, wallMs, wallMs > 0 ? sessionMs / wallMs : 0.0,
+                    decisionCount, corrupt ? "true" : "false", tick.p50Ns, tick.p99Ns, tick.maxNs, tick.meanNs());
+        for (size_t i = 0; i < knobs.size(); i++) {
+            std::printf("%s{\"name\": \"%s\", \"level\": %d, \"changes\": %u}", i ? ", " : "",
+                        knobs[i].name.c_str(), knobs[i].level, knobs[i].changes);
+        }
+        std::printf("]}\n");
+    } else {
+        std::printf("%" PRIu64 " frames, %.1f s of session replayed in %.1f ms (%.0fx)%s\n", frames,
+                    sessionMs / 1000.0, wallMs, wallMs > 0 ? sessionMs / wallMs : 0.0,
+                    corrupt ? " - trace truncated by a malformed record" : "");
+        std::printf("scheduler.tick: p50 %" PRIu64 " ns, p99 %" PRIu64 " ns, max %" PRIu64 " ns\n",
+                    tick.p50Ns, tick.p99Ns, tick.maxNs);
+        for (const auto& knob : knobs) {
+            std::printf("%-14s final level %d, %u changes\n", knob.name.c_str(), knob.level, knob.changes);
+        }
+    }
+    return corrupt ? 1 : 0;
+}
+
+int info(int argc, char** argv) {
+    if (argc < 1) {
+        return 2;
+    }
+    TraceReader reader;
+    if (!reader.open(argv[0])) {
+        std::cerr << argv[0] << ": not a procfs trace" << std::endl;
+        return 1;
+    }
+    TraceFrame frame;
+    uint64_t frames = 0;
+    uint64_t firstMs = 0;
+    uint64_t lastMs = 0;
+    uint64_t changes = 0;
+    while (reader.next(frame)) {
+        if (frames++ == 0) {
+            firstMs = frame.timestampMs;
+        }
+        lastMs = frame.timestampMs;
+        changes += frame.changed.size();
+    }
+    std::printf("%" PRIu64 " frames over %.1f s, %zu paths, %" PRIu64 " file updates%s\n", frames,
+                (lastMs - firstMs) / 1000.0, reader.pathCount(), changes, reader.isCorrupt() ? ", corrupt" : "");
+    return reader.isCorrupt() ? 1 : 0;
+}
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " record <trace> [--pid N | --name NAME] [--interval-ms N] [--duration-s N]\n"
+              << "       " << argv0 << " replay <trace> [--decisions out.csv] [--format text|json]\n"
+              << "              [--thermal-limit C] [--knob-min-interval-ms N]\n"
+              << "       " << argv0 << " info <trace>\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int status = 2;
+    if (argc >= 2) {
+        std::string command = argv[1];
+        if (command == "record") status = record(argc - 2, argv + 2);
+        else if (command == "replay") status = replay(argc - 2, argv + 2);
+        else if (command == "info") status = info(argc - 2, argv + 2);
+    }
+    if (status == 2) {
+        usage(argv[0]);
+    }
+    return status;
+}